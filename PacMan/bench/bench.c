@@ -0,0 +1,1150 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "types.h"
+#include "game.h"
+#include "algorithms.h"
+#include "level.h"
+#include "log.h"
+#include "parallel.h"
+#include "ghost.h"
+#include "exits.h"
+#include "navgraph.h"
+#include "nexthop.h"
+#include "hpa.h"
+#include "bitbfs.h"
+#include "pack.h"
+#include "journal.h"
+#include "clone.h"
+#include "env.h"
+#include "liveshm.h"
+#include "arena.h"
+
+/* PacMan性能基准程序
+ * 用法: pacman_bench [基准名...]，不带参数时运行全部基准 */
+
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*run)(void);
+} BenchCase;
+
+/* 有基准的核对失败时，程序以非零状态退出 */
+static int bench_failed = 0;
+
+/* 获取单调时钟纳秒数 */
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 初始化一局基准用的游戏：停止后台关卡生成，避免干扰计时 */
+static int bench_setup_game(int width, int height, int ghosts) {
+    set_game_seed(12345);
+    set_ghost_count(ghosts);
+    if (init_game_state_with_size(width, height) != 0) {
+        fprintf(stderr, "错误: 无法初始化 %dx%d 的游戏\n", width, height);
+        return -1;
+    }
+    level_pipeline_stop();
+    return 0;
+}
+
+/* 追踪类幽灵（追踪、经典）每个幽灵的开销最多为随机幽灵的倍数：决策只读共享距离场，
+ * 超出说明又出现了逐个幽灵的搜索 */
+#define BENCH_CHASE_COST_LIMIT 10.0
+
+/* 幽灵tick开销随幽灵数和线程数的变化：每个tick所有幽灵都移动一次 */
+static void bench_ghosts(void) {
+    static const int counts[] = {64, 256, 1024, 4096, 16384};
+    const int width = 512, height = 512;
+    const long moves_target = 2000000;
+    int thread_configs[2] = {1, 0};
+    double random_cost[sizeof(counts) / sizeof(counts[0])];
+
+    printf("%-14s %8s %8s %8s %14s %12s\n", "algorithm", "threads", "ghosts", "ticks",
+           "ns/tick", "ns/ghost");
+    for (int tc = 0; tc < 2; tc++) {
+        int threads = parallel_init(thread_configs[tc]);
+        if (tc == 1 && threads == 1) break;
+
+        for (int algo = ALGO_RANDOM; algo <= ALGO_CLASSIC; algo++) {
+            for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+                if (bench_setup_game(width, height, counts[c]) != 0) return;
+
+                set_ghost_move_interval(SIM_TICK_MS);
+                set_algorithm(algo);
+                int ghosts = g_game_state->ghosts.count;
+                long ticks = moves_target / (ghosts > 0 ? ghosts : 1);
+                if (ticks < 20) ticks = 20;
+
+                /* 预热 */
+                for (int t = 0; t < 10; t++) update_ghost_movement();
+
+                double start = bench_now_ns();
+                for (long t = 0; t < ticks; t++) {
+                    update_ghost_movement();
+                }
+                double elapsed = bench_now_ns() - start;
+
+                double per_ghost = elapsed / ticks / (ghosts > 0 ? ghosts : 1);
+                printf("%-14s %8d %8d %8ld %14.0f %12.1f\n", get_algorithm_name(), threads,
+                       ghosts, ticks, elapsed / ticks, per_ghost);
+                if (algo == ALGO_RANDOM) {
+                    random_cost[c] = per_ghost;
+                } else if ((algo == ALGO_DFS || algo == ALGO_CLASSIC) &&
+                           per_ghost > random_cost[c] * BENCH_CHASE_COST_LIMIT) {
+                    fprintf(stderr, "错误: %s 每个幽灵 %.1f ns，超过随机幽灵的 %.0f 倍\n",
+                            get_algorithm_name(), per_ghost, BENCH_CHASE_COST_LIMIT);
+                    bench_failed = 1;
+                }
+                stop_algorithm();
+                cleanup_game_state();
+            }
+        }
+    }
+    parallel_shutdown();
+}
+
+/* 对幽灵位置和棋盘内容做哈希 */
+static unsigned long long bench_state_hash(void) {
+    unsigned long long h = 1469598103934665603ULL;
+    const GhostRegistry *g = &g_game_state->ghosts;
+    for (int i = 0; i < g->count; i++) {
+        h = (h ^ (unsigned long long)(g->y[i] * 65536 + g->x[i])) * 1099511628211ULL;
+    }
+    for (int y = 0; y < get_board_height(); y++) {
+        for (int x = 0; x < get_board_width(); x++) {
+            h = (h ^ (unsigned long long)g_game_state->board[y][x]) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/* 验证两阶段更新的结果与线程数无关 */
+static void bench_ghost_determinism(void) {
+    int thread_configs[3] = {1, 2, 0};
+    unsigned long long reference = 0;
+    int ok = 1;
+
+    for (int tc = 0; tc < 3; tc++) {
+        int threads = parallel_init(thread_configs[tc]);
+        if (bench_setup_game(256, 256, 4096) != 0) return;
+        set_ghost_move_interval(SIM_TICK_MS);
+        set_algorithm(ALGO_ZIGZAG);
+        for (int t = 0; t < 500; t++) {
+            update_ghost_movement();
+        }
+        unsigned long long hash = bench_state_hash();
+        if (tc == 0) reference = hash;
+        ok &= hash == reference;
+        printf("threads %2d: state hash %016llx\n", threads, hash);
+        stop_algorithm();
+        cleanup_game_state();
+    }
+    parallel_shutdown();
+    printf("deterministic: %s\n", ok ? "yes" : "NO");
+}
+
+/* 只保留少量豆子，让最近豆子的搜索有一定距离 */
+static void bench_thin_dots(unsigned int seed) {
+    int total = get_board_width() * get_board_height();
+    CellType *cells = g_game_state->board[0];
+    for (int i = 0; i < total; i++) {
+        if (cells[i] == CELL_EMPTY || cells[i] == CELL_DOT || cells[i] == CELL_POWER_DOT) {
+            cells[i] = level_rand(&seed) % 4096 == 0 ? CELL_DOT : CELL_EMPTY;
+        }
+    }
+    rebuild_board_indexes();
+}
+
+/* 把当前棋盘改成迷宫（随机深度优先挖通道） */
+static void bench_make_maze(unsigned int seed) {
+    int width = get_board_width(), height = get_board_height();
+    CellType *cells = g_game_state->board[0];
+    int *stack = (int*)malloc(sizeof(int) * (size_t)width * height);
+    int top = 0;
+
+    for (int i = 0; i < width * height; i++) cells[i] = CELL_WALL;
+    cells[width + 1] = CELL_EMPTY;
+    stack[top++] = width + 1;
+    while (top > 0) {
+        int cell = stack[top - 1];
+        int x = cell % width, y = cell / width;
+        int dirs[4], n = 0;
+        if (y > 2 && cells[cell - 2 * width] == CELL_WALL) dirs[n++] = -width;
+        if (y < height - 3 && cells[cell + 2 * width] == CELL_WALL) dirs[n++] = width;
+        if (x > 2 && cells[cell - 2] == CELL_WALL) dirs[n++] = -1;
+        if (x < width - 3 && cells[cell + 2] == CELL_WALL) dirs[n++] = 1;
+        if (n == 0) {
+            top--;
+            continue;
+        }
+        int step = dirs[level_rand(&seed) % n];
+        cells[cell + step] = CELL_EMPTY;
+        cells[cell + 2 * step] = CELL_EMPTY;
+        stack[top++] = cell + 2 * step;
+    }
+    cells[width + 1] = CELL_PLAYER;
+    g_game_state->player_pos.x = 1;
+    g_game_state->player_pos.y = 1;
+    free(stack);
+}
+
+/* 逐格广度优先搜索（对照组）：返回最近目标的步数，target为0时遍历整个连通区 */
+static int bench_grid_bfs(int start, int target, int *queue, unsigned int *seen, unsigned int round) {
+    int width = get_board_width();
+    const CellType *cells = g_game_state->board[0];
+    const unsigned char *exits = g_game_state->exits;
+    const int offset[4] = {-width, width, -1, 1};
+    int head = 0, tail = 0, depth = 0, level_end = 1;
+
+    seen[start] = round;
+    queue[tail++] = start;
+    while (head < tail) {
+        int cell = queue[head++];
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+        for (int k = 0; k < list->count; k++) {
+            int next = cell + offset[list->dirs[k]];
+            if (seen[next] == round || is_ghost_cell(cells[next])) continue;
+            seen[next] = round;
+            if (target && (cells[next] == CELL_DOT || cells[next] == CELL_POWER_DOT)) {
+                return depth + 1;
+            }
+            queue[tail++] = next;
+        }
+        if (head == level_end) {
+            depth++;
+            level_end = tail;
+        }
+    }
+    return target ? -1 : depth;
+}
+
+/* 路口图：节点/边规模、建图与增量更新开销，以及与逐格搜索的对比 */
+static void bench_navgraph(void) {
+    static const int sizes[] = {128, 512, 1024};
+    const int queries = 200;
+
+    printf("%-6s %6s %9s %9s %8s %8s %10s %10s %12s %12s %12s %12s\n", "board", "size", "open",
+           "nodes", "edges", "compact", "build ms", "update us", "bfs-dot us", "nav-dot us",
+           "bfs-all us", "nav-all us");
+    for (int kind = 0; kind < 2; kind++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            int size = sizes[s];
+            if (bench_setup_game(size, size, 0) != 0) return;
+            if (kind == 1) bench_make_maze(777);
+            bench_thin_dots(555);
+
+            NavGraph *nav = g_game_state->nav;
+            CellType *cells = g_game_state->board[0];
+            int total = size * size, open = 0;
+            for (int i = 0; i < total; i++) open += cells[i] != CELL_WALL;
+
+            double start = bench_now_ns();
+            navgraph_build(nav, g_game_state->board, g_game_state->exits);
+            double build = bench_now_ns() - start;
+
+            /* 随机选可走格作为查询起点 */
+            int *queue = (int*)malloc(sizeof(int) * (size_t)total);
+            unsigned int *seen = (unsigned int*)calloc((size_t)total, sizeof(unsigned int));
+            int *points = (int*)malloc(sizeof(int) * queries);
+            unsigned int rng = 99;
+            for (int q = 0; q < queries; q++) {
+                do {
+                    points[q] = (int)(level_rand(&rng) % (unsigned int)total);
+                } while (cells[points[q]] != CELL_EMPTY);
+            }
+
+            double t_bfs_dot = 0, t_nav_dot = 0, t_bfs_all = 0, t_nav_all = 0;
+            unsigned int round = 0;
+            for (int q = 0; q < queries; q++) {
+                int x = points[q] % size, y = points[q] / size;
+                start = bench_now_ns();
+                bench_grid_bfs(points[q], 1, queue, seen, ++round);
+                t_bfs_dot += bench_now_ns() - start;
+                start = bench_now_ns();
+                navgraph_autopilot(nav, g_game_state->board, g_game_state->exits, x, y);
+                t_nav_dot += bench_now_ns() - start;
+                if (q % 10 == 0) {
+                    start = bench_now_ns();
+                    bench_grid_bfs(points[q], 0, queue, seen, ++round);
+                    t_bfs_all += bench_now_ns() - start;
+                    start = bench_now_ns();
+                    navgraph_chase_field(nav, g_game_state->exits, x, y, 0x3FFFFFFF);
+                    t_nav_all += bench_now_ns() - start;
+                }
+            }
+
+            /* 增量更新：在查询点上反复放置和移除墙壁 */
+            start = bench_now_ns();
+            for (int q = 0; q < queries; q++) {
+                int x = points[q] % size, y = points[q] / size;
+                set_board_cell(x, y, CELL_WALL);
+                set_board_cell(x, y, CELL_EMPTY);
+            }
+            double update = (bench_now_ns() - start) / (2.0 * queries);
+
+            printf("%-6s %6d %9d %9d %8d %8s %10.2f %10.2f %12.1f %12.1f %12.1f %12.1f\n",
+                   kind ? "maze" : "level", size, open, navgraph_node_count(nav),
+                   navgraph_edge_count(nav), navgraph_is_compact(nav) ? "yes" : "no", build / 1e6, update / 1e3,
+                   t_bfs_dot / queries / 1e3, t_nav_dot / queries / 1e3,
+                   t_bfs_all / (queries / 10) / 1e3, t_nav_all / (queries / 10) / 1e3);
+
+            free(queue);
+            free(seen);
+            free(points);
+            cleanup_game_state();
+        }
+    }
+}
+
+/* 下一步表：建表开销（单线程与全部线程）、表大小、查表与逐格搜索的对比，
+ * 以及追踪幽灵在开关下一步表时的tick开销 */
+static void bench_nexthop(void) {
+    static const int sizes[][2] = {{20, 15}, {35, 28}, {50, 40}};
+    const int queries = 2000, ticks = 2000, ghosts = 64;
+
+    printf("%-8s %8s %8s %12s %12s %12s %12s %14s %14s\n", "size", "threads", "table KB",
+           "build 1t ms", "build ms", "lookup ns", "bfs-all ns", "hunt-off ns", "hunt-on ns");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        int total = width * height;
+        double build_ms[2] = {0, 0};
+        int threads = 1;
+
+        /* 建表：先单线程，再使用全部线程 */
+        for (int tc = 0; tc < 2; tc++) {
+            threads = parallel_init(tc == 0 ? 1 : 0);
+            if (bench_setup_game(width, height, 0) != 0) return;
+            double start = bench_now_ns();
+            for (int r = 0; r < 10; r++) {
+                nexthop_build(g_game_state->nexthop, g_game_state->board, g_game_state->exits);
+            }
+            build_ms[tc] = (bench_now_ns() - start) / 10 / 1e6;
+            if (tc == 0) cleanup_game_state();
+        }
+
+        /* 查表与一次逐格广度优先搜索的对比，起点终点都是随机可走格 */
+        CellType *cells = g_game_state->board[0];
+        int *queue = (int*)malloc(sizeof(int) * (size_t)total);
+        unsigned int *seen = (unsigned int*)calloc((size_t)total, sizeof(unsigned int));
+        int *points = (int*)malloc(sizeof(int) * (size_t)queries * 2);
+        unsigned int rng = 42, round = 0;
+        for (int q = 0; q < queries * 2; q++) {
+            do {
+                points[q] = (int)(level_rand(&rng) % (unsigned int)total);
+            } while (cells[points[q]] == CELL_WALL);
+        }
+        volatile int sink = 0;
+        double start = bench_now_ns();
+        for (int q = 0; q < queries; q++) {
+            sink += nexthop_direction(g_game_state->nexthop, points[2 * q], points[2 * q + 1]);
+        }
+        double lookup = (bench_now_ns() - start) / queries;
+        start = bench_now_ns();
+        for (int q = 0; q < queries; q++) {
+            sink += bench_grid_bfs(points[2 * q], 0, queue, seen, ++round);
+        }
+        double bfs = (bench_now_ns() - start) / queries;
+        (void)sink;
+        free(queue);
+        free(seen);
+        free(points);
+        cleanup_game_state();
+
+        /* 追踪幽灵的tick开销，下一步表关闭时退回路口图或贪心追踪 */
+        double hunt[2] = {0, 0};
+        for (int enabled = 0; enabled < 2; enabled++) {
+            set_nexthop_enabled(enabled);
+            if (bench_setup_game(width, height, ghosts) != 0) return;
+            set_ghost_move_interval(SIM_TICK_MS);
+            set_algorithm(ALGO_DFS);
+            for (int t = 0; t < 10; t++) update_ghost_movement();
+            start = bench_now_ns();
+            for (int t = 0; t < ticks; t++) update_ghost_movement();
+            hunt[enabled] = (bench_now_ns() - start) / ticks;
+            stop_algorithm();
+            cleanup_game_state();
+        }
+        set_nexthop_enabled(1);
+        parallel_shutdown();
+
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", width, height);
+        printf("%-8s %8d %8.1f %12.3f %12.3f %12.1f %12.1f %14.0f %14.0f\n", label, threads,
+               nexthop_bytes(width, height) / 1024.0, build_ms[0], build_ms[1], lookup, bfs,
+               hunt[0], hunt[1]);
+    }
+}
+
+/* 重新开始时调用线程的开销：流水线停止时同步生成棋盘并建立全部索引；流水线运行时换入
+ * 后台建好的棋盘、下一步表和分层图（每次之前留出时间让后台线程准备好下一关） */
+static void bench_restart(void) {
+    static const int sizes[][2] = {{20, 15}, {35, 28}, {50, 40}, {512, 512}, {1024, 1024}};
+    const int resets = 5;
+
+    printf("%-10s %12s %12s %14s\n", "size", "index KB", "sync ms", "pipeline ms");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        double cost[2] = {0, 0};
+        size_t index_bytes = 0;
+        for (int pipelined = 0; pipelined < 2; pipelined++) {
+            set_game_seed(12345);
+            if (init_game_state_with_size(width, height) != 0) return;
+            if (!pipelined) level_pipeline_stop();
+            index_bytes = (g_game_state->nexthop ? nexthop_bytes(width, height) : 0) +
+                          (g_game_state->hpa ? hpa_bytes(width, height) : 0);
+            for (int r = 0; r < resets; r++) {
+                if (pipelined) {
+                    /* 后台线程生成并建立索引的时间：同步重置开销的数倍 */
+                    long wait_ms = (long)(cost[0] * 4) + 20;
+                    struct timespec pause = { wait_ms / 1000, (wait_ms % 1000) * 1000000L };
+                    nanosleep(&pause, NULL);
+                }
+                /* 只计调用线程的CPU时间：单核机器上被唤醒的后台线程会抢占墙钟时间 */
+                struct timespec t0, t1;
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+                reset_game_state();
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+                cost[pipelined] += (t1.tv_sec - t0.tv_sec) * 1e3 +
+                                   (t1.tv_nsec - t0.tv_nsec) / 1e6;
+            }
+            cost[pipelined] /= resets;
+            cleanup_game_state();
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", width, height);
+        printf("%-10s %12.1f %12.3f %14.3f\n", label, index_bytes / 1024.0, cost[0], cost[1]);
+    }
+}
+
+/* 逐格广度优先搜索两格之间的步数（对照组，只看墙壁），不可达时返回-1 */
+static int bench_grid_distance(int start, int goal, int *queue, int *dist) {
+    int width = get_board_width(), total = width * get_board_height();
+    const unsigned char *exits = g_game_state->exits;
+    const int offset[4] = {-width, width, -1, 1};
+    int head = 0, tail = 0;
+
+    for (int i = 0; i < total; i++) dist[i] = -1;
+    dist[start] = 0;
+    queue[tail++] = start;
+    while (head < tail && dist[goal] < 0) {
+        int cell = queue[head++];
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+        for (int k = 0; k < list->count; k++) {
+            int next = cell + offset[list->dirs[k]];
+            if (dist[next] >= 0) continue;
+            dist[next] = dist[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+    return dist[goal];
+}
+
+/* 分层寻路：分簇和节点规模、建图与局部重建开销、两点查询与逐格搜索的对比（含路径长度比），
+ * 以及追踪距离场和单个幽灵查询的开销 */
+static void bench_hpa(void) {
+    static const int sizes[] = {512, 1024, 2048};
+    const int queries = 50, ghosts = 2000;
+
+    printf("%-6s %6s %8s %8s %10s %10s %10s %10s %8s %10s %10s\n", "board", "size", "clusters",
+           "nodes", "build ms", "update us", "bfs us", "hpa us", "ratio", "field ms", "ghost us");
+    for (int kind = 0; kind < 2; kind++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            int size = sizes[s];
+            if (bench_setup_game(size, size, 0) != 0) return;
+            if (kind == 1) {
+                bench_make_maze(777);
+                rebuild_board_indexes();
+            }
+
+            HpaGraph *hpa = g_game_state->hpa;
+            CellType **board = g_game_state->board;
+            const unsigned char *exits = g_game_state->exits;
+            int total = size * size;
+
+            double start = bench_now_ns();
+            hpa_build(hpa, board, exits);
+            double build = bench_now_ns() - start;
+
+            /* 随机选可走格作为查询端点 */
+            int *queue = (int*)malloc(sizeof(int) * (size_t)total);
+            int *dist = (int*)malloc(sizeof(int) * (size_t)total);
+            int *points = (int*)malloc(sizeof(int) * (size_t)queries * 2);
+            unsigned int rng = 99;
+            for (int q = 0; q < queries * 2; q++) {
+                do {
+                    points[q] = (int)(level_rand(&rng) % (unsigned int)total);
+                } while (board[0][points[q]] != CELL_EMPTY && board[0][points[q]] != CELL_DOT);
+            }
+
+            double t_bfs = 0, t_hpa = 0, ratio = 0;
+            int found = 0;
+            for (int q = 0; q < queries; q++) {
+                int a = points[2 * q], b = points[2 * q + 1];
+                start = bench_now_ns();
+                int exact = bench_grid_distance(a, b, queue, dist);
+                t_bfs += bench_now_ns() - start;
+                start = bench_now_ns();
+                int approx = hpa_distance(hpa, board, exits, a % size, a / size, b % size, b / size);
+                t_hpa += bench_now_ns() - start;
+                if (exact > 0 && approx > 0) {
+                    ratio += (double)approx / exact;
+                    found++;
+                }
+            }
+
+            /* 追踪：每次换一个玩家位置重新计算距离场，幽灵查询分布在各个查询端点上 */
+            int player = points[0];
+            start = bench_now_ns();
+            for (int q = 0; q < queries; q++) {
+                player = points[q];
+                hpa_chase_field(hpa, board, exits, player % size, player / size);
+            }
+            double field = (bench_now_ns() - start) / queries;
+            volatile int sink = 0;
+            int *ghost_x = (int*)malloc(sizeof(int) * (size_t)queries * 2);
+            int *ghost_y = (int*)malloc(sizeof(int) * (size_t)queries * 2);
+            for (int q = 0; q < queries * 2; q++) {
+                ghost_x[q] = points[q] % size;
+                ghost_y[q] = points[q] / size;
+            }
+            /* 幽灵查询的开销含展开它们所在分簇的份额 */
+            start = bench_now_ns();
+            hpa_chase_resolve(hpa, ghost_x, ghost_y, queries * 2);
+            for (int k = 0; k < ghosts; k++) {
+                int cell = points[k % (queries * 2)];
+                sink += hpa_chase_direction(hpa, cell % size, cell / size, 0xFu);
+            }
+            double ghost = (bench_now_ns() - start) / ghosts;
+            (void)sink;
+
+            /* 局部重建：在查询点上放置和移除墙壁，每次之后做一次查询触发重建 */
+            start = bench_now_ns();
+            for (int q = 0; q < queries; q++) {
+                int x = points[q] % size, y = points[q] / size;
+                CellType old = get_board_cell(x, y);
+                set_board_cell(x, y, CELL_WALL);
+                hpa_distance(hpa, board, exits, x, y, x, y);
+                set_board_cell(x, y, old);
+                hpa_distance(hpa, board, exits, x, y, x, y);
+            }
+            double update = (bench_now_ns() - start) / (2.0 * queries);
+
+            printf("%-6s %6d %8d %8d %10.1f %10.1f %10.1f %10.1f %8.3f %10.2f %10.2f\n",
+                   kind ? "maze" : "level", size, hpa_cluster_count(hpa), hpa_node_count(hpa),
+                   build / 1e6, update / 1e3, t_bfs / queries / 1e3, t_hpa / queries / 1e3,
+                   found ? ratio / found : 0.0, field / 1e6, ghost / 1e3);
+
+            free(queue);
+            free(dist);
+            free(points);
+            free(ghost_x);
+            free(ghost_y);
+            cleanup_game_state();
+        }
+    }
+}
+
+/* 逐格广度优先搜索的距离场（对照组）：只看墙壁，radius小于0时不限半径，返回到达的格子数 */
+static int bench_grid_field(int start, int radius, int *queue, int *dist,
+                            unsigned int *seen, unsigned int round) {
+    int width = get_board_width();
+    const unsigned char *exits = g_game_state->exits;
+    const int offset[4] = {-width, width, -1, 1};
+    int head = 0, tail = 0;
+
+    seen[start] = round;
+    dist[start] = 0;
+    queue[tail++] = start;
+    while (head < tail) {
+        int cell = queue[head++];
+        if (radius >= 0 && dist[cell] >= radius) continue;
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+        for (int k = 0; k < list->count; k++) {
+            int next = cell + offset[list->dirs[k]];
+            if (seen[next] == round) continue;
+            seen[next] = round;
+            dist[next] = dist[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+    return tail;
+}
+
+/* 位并行搜索：与逐格搜索在整张棋盘和追踪半径内的距离场开销对比，并逐格核对距离 */
+static void bench_bitbfs(void) {
+    static const int sizes[] = {64, 256, 1024, 2048};
+    const int sources = 20;
+
+    printf("%-6s %6s %9s %10s %10s %8s %10s %10s %8s %9s\n", "board", "size", "reached",
+           "bfs ms", "bit ms", "speedup", "r-bfs us", "r-bit us", "speedup", "mismatch");
+    for (int kind = 0; kind < 2; kind++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            int size = sizes[s];
+            if (bench_setup_game(size, size, 0) != 0) return;
+            if (kind == 1) {
+                bench_make_maze(777);
+                rebuild_board_indexes();
+            }
+
+            BitBoard *bits = g_game_state->bits;
+            const CellType *cells = g_game_state->board[0];
+            int total = size * size;
+            int *queue = (int*)malloc(sizeof(int) * (size_t)total);
+            int *dist = (int*)malloc(sizeof(int) * (size_t)total);
+            unsigned int *seen = (unsigned int*)calloc((size_t)total, sizeof(unsigned int));
+            unsigned int round = 0;
+
+            /* 随机选可走格作为起点 */
+            int points[20];
+            unsigned int rng = 4242;
+            for (int q = 0; q < sources; q++) {
+                do {
+                    points[q] = (int)(level_rand(&rng) % (unsigned int)total);
+                } while (cells[points[q]] == CELL_WALL);
+            }
+
+            double t_bfs[2] = {0, 0}, t_bit[2] = {0, 0};
+            long reached = 0, mismatch = 0;
+            for (int pass = 0; pass < 2; pass++) {
+                int radius = pass ? BITBFS_CHASE_RADIUS : -1;
+                for (int q = 0; q < sources; q++) {
+                    int x = points[q] % size, y = points[q] / size;
+                    double start = bench_now_ns();
+                    int count = bench_grid_field(points[q], radius, queue, dist, seen, ++round);
+                    t_bfs[pass] += bench_now_ns() - start;
+                    start = bench_now_ns();
+                    int bit_count = bitbfs_field(bits, x, y, radius);
+                    t_bit[pass] += bench_now_ns() - start;
+                    if (!pass) reached += count;
+
+                    /* 到达的格子和距离都必须一致 */
+                    mismatch += count != bit_count;
+                    for (int i = 0; i < total; i++) {
+                        int expect = seen[i] == round ? dist[i] : -1;
+                        mismatch += bitbfs_distance(bits, i % size, i / size) != expect;
+                    }
+                }
+            }
+
+            printf("%-6s %6d %9ld %10.3f %10.3f %8.2f %10.1f %10.1f %8.2f %9ld\n",
+                   kind ? "maze" : "level", size, reached / sources,
+                   t_bfs[0] / sources / 1e6, t_bit[0] / sources / 1e6, t_bfs[0] / t_bit[0],
+                   t_bfs[1] / sources / 1e3, t_bit[1] / sources / 1e3, t_bfs[1] / t_bit[1],
+                   mismatch);
+
+            free(queue);
+            free(dist);
+            free(seen);
+            cleanup_game_state();
+        }
+    }
+}
+
+/* 受惊模式的幽灵tick开销：玩家不动时沿用距离场，每tick移动一步时每tick重算一次，
+ * 两种情况下幽灵都只查表，不为单个幽灵搜索 */
+static void bench_frightened(void) {
+    static const int counts[] = {64, 256, 1024, 4096, 16384};
+    const int width = 512, height = 512;
+    const long moves_target = 2000000;
+
+    parallel_init(1);
+    printf("%-8s %8s %8s %14s %12s\n", "player", "ghosts", "ticks", "ns/tick", "ns/ghost");
+    for (int moving = 0; moving < 2; moving++) {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            if (bench_setup_game(width, height, counts[c]) != 0) return;
+
+            set_ghost_move_interval(SIM_TICK_MS);
+            set_algorithm(ALGO_DFS);
+            int ghosts = g_game_state->ghosts.count;
+            long ticks = moves_target / (ghosts > 0 ? ghosts : 1);
+            if (ticks < 20) ticks = 20;
+
+            double elapsed = 0;
+            for (long t = 0; t < ticks; t++) {
+                /* 计时器保持不为0，玩家左右往返（不计入时间） */
+                g_game_state->frightened_ticks = FRIGHTENED_MOVES;
+                if (moving && !step_player((t & 1) ? DIR_LEFT : DIR_RIGHT)) {
+                    step_player((t & 1) ? DIR_RIGHT : DIR_LEFT);
+                }
+                double start = bench_now_ns();
+                update_ghost_movement();
+                elapsed += bench_now_ns() - start;
+            }
+
+            printf("%-8s %8d %8ld %14.0f %12.1f\n", moving ? "moving" : "still", ghosts, ticks,
+                   elapsed / ticks, elapsed / ticks / (ghosts > 0 ? ghosts : 1));
+            stop_algorithm();
+            cleanup_game_state();
+        }
+    }
+    parallel_shutdown();
+}
+
+/* 换关时取棋盘的开销：现场生成（level_generate）与从棋盘包复制（pack_fill_board）对比 */
+static void bench_pack(void) {
+    static const int sizes[][2] = {{20, 15}, {50, 40}, {256, 256}};
+    const int boards = 256;
+    const char *path = "/tmp/pacman_bench.ppak";
+
+    printf("%-10s %8s %14s %14s %10s\n", "size", "boards", "generate(us)", "pack(us)", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        size_t cells = (size_t)width * height;
+        Arena arena;
+        if (arena_init(&arena, level_board_bytes(width, height) +
+                               level_scratch_bytes(width, height)) != 0) {
+            return;
+        }
+        CellType **board = level_board_carve(&arena, width, height);
+        LevelScratch scratch;
+        unsigned char *bytes = (unsigned char*)malloc(cells);
+        PackWriter *writer = pack_writer_open(path, width, height, DEFAULT_GHOST_COUNT, boards);
+        if (!board || level_scratch_carve(&arena, &scratch, width, height) != 0 || !bytes ||
+            !writer) {
+            pack_writer_close(writer);
+            free(bytes);
+            arena_destroy(&arena);
+            return;
+        }
+
+        double start = bench_now_ns();
+        for (int i = 0; i < boards; i++) {
+            level_generate(board, width, height, DEFAULT_GHOST_COUNT, 1000u + i, &scratch);
+        }
+        double generate_ns = (bench_now_ns() - start) / boards;
+
+        for (int i = 0; i < boards; i++) {
+            level_generate(board, width, height, DEFAULT_GHOST_COUNT, 1000u + i, &scratch);
+            for (size_t c = 0; c < cells; c++) bytes[c] = (unsigned char)board[c / width][c % width];
+            pack_writer_add(writer, bytes, 1000u + i);
+        }
+        BoardPack pack;
+        if (pack_writer_close(writer) != 0 || pack_open(path, &pack) != 0) {
+            free(bytes);
+            arena_destroy(&arena);
+            return;
+        }
+        const int rounds = 8;
+        start = bench_now_ns();
+        for (int i = 0; i < boards * rounds; i++) {
+            pack_fill_board(&pack, i % boards, board);
+        }
+        double pack_ns = (bench_now_ns() - start) / (boards * rounds);
+
+        printf("%4dx%-5d %8d %14.2f %14.2f %9.1fx\n", width, height, boards, generate_ns / 1000,
+               pack_ns / 1000, generate_ns / pack_ns);
+        pack_close(&pack);
+        free(bytes);
+        arena_destroy(&arena);
+    }
+    unlink(path);
+}
+
+/* 回退核对用的哈希：棋盘、幽灵位置和随机数、计数器 */
+static unsigned long long bench_full_hash(void) {
+    unsigned long long h = bench_state_hash();
+    const GhostRegistry *g = &g_game_state->ghosts;
+    const int values[] = {
+        g_game_state->player_pos.x, g_game_state->player_pos.y, g_game_state->score,
+        g_game_state->lives, g_game_state->dots_collected, g_game_state->moves_count,
+        g_game_state->frightened_ticks, g_game_state->game_over, get_ghost_timer_phase()
+    };
+    for (int i = 0; i < g->count; i++) {
+        h = (h ^ g->rng[i] ^ (unsigned long long)g->state[i] << 32) * 1099511628211ULL;
+    }
+    for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+        h = (h ^ (unsigned int)values[v]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/* 一个完整的模拟tick：幽灵移动、自动驾驶走一步、提交回退记录 */
+static void bench_rewind_tick(void) {
+    update_ghost_movement();
+    Direction dir = autopilot_next_direction();
+    if (dir != DIR_COUNT) step_player(dir);
+    commit_game_tick();
+}
+
+/* 回退与重做：开销与回退的tick数成正比，对比复制整块棋盘；
+ * 核对回退和重做后的状态哈希，以及回退后重新模拟得到相同的结果 */
+static void bench_rewind(void) {
+    static const int configs[][3] = {{50, 40, 8}, {256, 256, 1024}, {1024, 1024, 4096}};
+    static const int steps[] = {1, 10, 100, 900};
+    const int ticks = 1000;
+
+    parallel_init(1);
+    set_journal_ticks(ticks);
+    printf("%-10s %7s %6s %12s %12s %12s %6s\n", "size", "ghosts", "back", "rewind(us)",
+           "forward(us)", "copy(us)", "ok");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        int width = configs[c][0], height = configs[c][1];
+        if (bench_setup_game(width, height, configs[c][2]) != 0) break;
+        set_ghost_move_interval(SIM_TICK_MS);
+        set_algorithm(ALGO_RANDOM);
+
+        size_t cells = (size_t)width * height;
+        unsigned long long *hashes = (unsigned long long*)malloc((ticks + 1) * sizeof(*hashes));
+        CellType *copy = (CellType*)malloc(cells * sizeof(CellType));
+        if (!hashes || !copy) {
+            free(hashes);
+            free(copy);
+            cleanup_game_state();
+            break;
+        }
+        hashes[0] = bench_full_hash();
+        for (int t = 1; t <= ticks; t++) {
+            bench_rewind_tick();
+            hashes[t] = bench_full_hash();
+        }
+
+        /* 对照：整块复制恢复棋盘，出口掩码含幽灵位置，也要重新计算 */
+        const int copies = 20;
+        memcpy(copy, g_game_state->board[0], cells * sizeof(CellType));
+        double start = bench_now_ns();
+        for (int k = 0; k < copies; k++) {
+            memcpy(g_game_state->board[0], copy, cells * sizeof(CellType));
+            exits_build(g_game_state->exits, g_game_state->board, width, height);
+        }
+        double copy_us = (bench_now_ns() - start) / copies / 1000;
+
+        for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++) {
+            start = bench_now_ns();
+            int back = rewind_game(steps[s]);
+            double rewind_us = (bench_now_ns() - start) / 1000;
+            int ok = hashes[ticks - back] == bench_full_hash();
+            start = bench_now_ns();
+            int forward = replay_game(back);
+            double forward_us = (bench_now_ns() - start) / 1000;
+            ok &= forward == back && hashes[ticks] == bench_full_hash();
+            printf("%4dx%-5d %7d %6d %12.1f %12.1f %12.1f %6s\n", width, height,
+                   g_game_state->ghosts.count, back, rewind_us, forward_us, copy_us,
+                   ok ? "yes" : "NO");
+        }
+
+        /* 回退后重新模拟：随机数等状态都已恢复，结果与第一次相同 */
+        int back = rewind_game(ticks / 2);
+        for (int t = 0; t < back; t++) bench_rewind_tick();
+        printf("replay after rewinding %d ticks: %s\n", back,
+               hashes[ticks] == bench_full_hash() ? "identical" : "DIFFERENT");
+
+        free(hashes);
+        free(copy);
+        stop_algorithm();
+        cleanup_game_state();
+    }
+    set_journal_ticks(0);
+    parallel_shutdown();
+}
+
+/* 状态克隆：保存、恢复、克隆之间复制的速率（次/秒）；
+ * 核对恢复后的状态哈希，以及恢复后重新模拟得到与第一次相同的结果 */
+static void bench_clone(void) {
+    static const int configs[][3] = {{50, 40, 8}, {256, 256, 1024}, {1024, 1024, 4096}};
+    const int ticks = 100;
+
+    parallel_init(1);
+    printf("%-10s %7s %10s %12s %12s %12s %6s\n", "size", "ghosts", "bytes", "save/s",
+           "restore/s", "copy/s", "ok");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        int width = configs[c][0], height = configs[c][1];
+        if (bench_setup_game(width, height, configs[c][2]) != 0) break;
+        set_ghost_move_interval(SIM_TICK_MS);
+        set_algorithm(ALGO_RANDOM);
+        for (int t = 0; t < ticks; t++) bench_rewind_tick();
+
+        GameClone *saved = game_clone_create();
+        GameClone *copy = game_clone_create();
+        if (!saved || !copy) {
+            game_clone_destroy(saved);
+            game_clone_destroy(copy);
+            cleanup_game_state();
+            break;
+        }
+        game_clone_into(saved);
+        unsigned long long before = bench_full_hash();
+        for (int t = 0; t < ticks; t++) bench_rewind_tick();
+        unsigned long long after = bench_full_hash();
+
+        int rounds = (int)(200000000 / game_clone_bytes(saved)) + 1;
+        double start = bench_now_ns();
+        for (int k = 0; k < rounds; k++) game_clone_into(copy);
+        double save_rate = rounds / ((bench_now_ns() - start) / 1e9);
+        start = bench_now_ns();
+        for (int k = 0; k < rounds; k++) game_clone_copy(copy, saved);
+        double copy_rate = rounds / ((bench_now_ns() - start) / 1e9);
+        start = bench_now_ns();
+        for (int k = 0; k < rounds; k++) game_restore_from(copy);
+        double restore_rate = rounds / ((bench_now_ns() - start) / 1e9);
+
+        int ok = bench_full_hash() == before;
+        for (int t = 0; t < ticks; t++) bench_rewind_tick();
+        ok &= bench_full_hash() == after;
+        printf("%4dx%-5d %7d %10zu %12.0f %12.0f %12.0f %6s\n", width, height,
+               g_game_state->ghosts.count, game_clone_bytes(saved), save_rate, restore_rate,
+               copy_rate, ok ? "yes" : "NO");
+
+        game_clone_destroy(saved);
+        game_clone_destroy(copy);
+        stop_algorithm();
+        cleanup_game_state();
+    }
+    parallel_shutdown();
+}
+
+/* 观测缓冲区的哈希 */
+static unsigned long long bench_bytes_hash(const unsigned char *bytes, size_t size,
+                                           unsigned long long h) {
+    for (size_t i = 0; i < size; i++) h = (h ^ bytes[i]) * 1099511628211ULL;
+    return h;
+}
+
+/* 跑steps步随机动作，返回观测、奖励和done的哈希；*rate为每秒环境步数 */
+static unsigned long long bench_env_run(const EnvConfig *config, int steps, double *rate) {
+    EnvBatch *env = env_create(config);
+    if (!env) return 0;
+    int batch = env_batch_size(env);
+    size_t obs_bytes = env_observation_bytes(env) * (size_t)batch;
+    unsigned char *obs = (unsigned char*)malloc(obs_bytes);
+    unsigned char *actions = (unsigned char*)malloc((size_t)batch);
+    unsigned char *dones = (unsigned char*)malloc((size_t)batch);
+    float *rewards = (float*)malloc((size_t)batch * sizeof(float));
+    unsigned long long h = 1469598103934665603ULL;
+    if (!obs || !actions || !dones || !rewards || env_reset(env, 7, obs) != 0) {
+        free(obs);
+        free(actions);
+        free(dones);
+        free(rewards);
+        env_destroy(env);
+        return 0;
+    }
+
+    unsigned int rng = 99;
+    double elapsed = 0;
+    for (int t = 0; t < steps; t++) {
+        for (int i = 0; i < batch; i++) actions[i] = (unsigned char)(level_rand(&rng) % 5);
+        double start = bench_now_ns();
+        env_step(env, actions, obs, rewards, dones);
+        elapsed += bench_now_ns() - start;
+        h = bench_bytes_hash((const unsigned char*)rewards, (size_t)batch * sizeof(float), h);
+        h = bench_bytes_hash(dones, (size_t)batch, h);
+    }
+    h = bench_bytes_hash(obs, obs_bytes, h);
+    *rate = (double)steps * batch / (elapsed / 1e9);
+
+    free(obs);
+    free(actions);
+    free(dones);
+    free(rewards);
+    env_destroy(env);
+    return h;
+}
+
+/* 强化学习环境：批量步进（含观测编码）的速率，以及相同种子和动作得到相同的结果 */
+static void bench_env(void) {
+    static const int configs[][3] = {{20, 15, 4}, {50, 40, 8}, {128, 128, 64}};
+    static const int batches[] = {1, 64, 256};
+
+    printf("%-10s %7s %6s %14s %6s\n", "size", "ghosts", "batch", "steps/s", "same");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+            EnvConfig config;
+            env_default_config(&config);
+            config.width = configs[c][0];
+            config.height = configs[c][1];
+            config.ghosts = configs[c][2];
+            config.batch = batches[b];
+            config.max_steps = 500;
+            int steps = (int)(2000000 / ((size_t)config.width * config.height * config.batch)) + 10;
+            double rate = 0, again = 0;
+            unsigned long long h = bench_env_run(&config, steps, &rate);
+            int same = h != 0 && h == bench_env_run(&config, steps, &again);
+            printf("%4dx%-5d %7d %6d %14.0f %6s\n", config.width, config.height, config.ghosts,
+                   config.batch, rate > again ? rate : again, same ? "yes" : "NO");
+        }
+    }
+}
+
+/* 共享内存读者线程：不停地取快照并核对棋盘校验和 */
+typedef struct {
+    const char *name;
+    int stop;
+    unsigned long snapshots, failed, mismatched;
+} BenchShmReader;
+
+static void *bench_shm_reader(void *arg) {
+    BenchShmReader *r = (BenchShmReader*)arg;
+    LiveShmReader *reader = live_shm_open(r->name);
+    if (!reader) return NULL;
+    size_t count = (size_t)live_shm_width(reader) * live_shm_height(reader);
+    unsigned char *cells = (unsigned char*)malloc(count);
+    LiveShmStats stats;
+    while (cells && !__atomic_load_n(&r->stop, __ATOMIC_RELAXED)) {
+        if (live_shm_snapshot(reader, &stats, cells, count) != 0) {
+            r->failed++;
+            continue;
+        }
+        uint32_t sum = 0;
+        for (size_t i = 0; i < count; i++) sum += (uint32_t)cells[i] * (uint32_t)(i + 1);
+        r->snapshots++;
+        if (sum != stats.board_sum) r->mismatched++;
+    }
+    free(cells);
+    live_shm_close(reader);
+    return NULL;
+}
+
+/* 共享内存状态导出：每tick发布（只写变化的格子）与整块复制的开销，
+ * 同时一个读者线程不停取快照，核对每个快照的棋盘校验和 */
+static void bench_liveshm(void) {
+    static const int configs[][3] = {{50, 40, 8}, {256, 256, 1024}, {1024, 1024, 4096}};
+    const int ticks = 1000;
+    char name[64];
+    snprintf(name, sizeof(name), "/pacman-bench-%d", (int)getpid());
+
+    parallel_init(1);
+    printf("%-10s %7s %14s %14s %10s %8s %10s\n", "size", "ghosts", "publish us", "full us",
+           "snapshots", "failed", "mismatch");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        int width = configs[c][0], height = configs[c][1];
+        set_live_shm_name(name);
+        int setup = bench_setup_game(width, height, configs[c][2]);
+        set_live_shm_name(NULL);
+        if (setup != 0) break;
+        if (!g_game_state->live_shm) {
+            cleanup_game_state();
+            break;
+        }
+        set_ghost_move_interval(SIM_TICK_MS);
+        set_algorithm(ALGO_RANDOM);
+        commit_game_tick();
+
+        BenchShmReader r;
+        memset(&r, 0, sizeof(r));
+        r.name = name;
+        pthread_t thread;
+        int started = pthread_create(&thread, NULL, bench_shm_reader, &r) == 0;
+
+        /* 只计提交tick（没有回退日志和观战时就是发布）的时间 */
+        double publish_ns = 0, full_ns = 0;
+        for (int t = 0; t < ticks; t++) {
+            update_ghost_movement();
+            Direction dir = autopilot_next_direction();
+            if (dir != DIR_COUNT) step_player(dir);
+            double start = bench_now_ns();
+            commit_game_tick();
+            publish_ns += bench_now_ns() - start;
+        }
+        int full_rounds = ticks / 10;
+        for (int t = 0; t < full_rounds; t++) {
+            live_shm_resync(g_game_state->live_shm);
+            double start = bench_now_ns();
+            commit_game_tick();
+            full_ns += bench_now_ns() - start;
+        }
+
+        if (started) {
+            __atomic_store_n(&r.stop, 1, __ATOMIC_RELAXED);
+            pthread_join(thread, NULL);
+        }
+        printf("%4dx%-5d %7d %14.2f %14.2f %10lu %8lu %10lu\n", width, height,
+               g_game_state->ghosts.count, publish_ns / ticks / 1000.0,
+               full_ns / full_rounds / 1000.0, r.snapshots, r.failed, r.mismatched);
+
+        stop_algorithm();
+        cleanup_game_state();
+    }
+    parallel_shutdown();
+}
+
+/* 重置和tick路径不访问堆：打开日志（线程首次写日志时注册缓冲区）反复重置并模拟，
+ * 前后的堆分配次数必须相同。普通构建只统计heap_alloc，make alloc_check构建统计所有malloc */
+static void bench_alloc(void) {
+    static const int configs[][3] = {{50, 40, 8}, {256, 256, 64}};
+    const int resets = 5, ticks = 200;
+
+    parallel_init(2);
+    printf("%-10s %7s %7s %7s %12s %6s\n", "size", "ghosts", "resets", "ticks", "allocations",
+           "ok");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        int width = configs[c][0], height = configs[c][1];
+        if (bench_setup_game(width, height, configs[c][2]) != 0) break;
+        set_ghost_move_interval(SIM_TICK_MS);
+        set_algorithm(ALGO_CLASSIC);
+        fflush(stdout);
+        log_init();
+        log_set_level(LOG_LEVEL_INFO);
+
+        unsigned long before = heap_alloc_count();
+        for (int r = 0; r < resets; r++) {
+            reset_game_state();
+            set_algorithm(ALGO_CLASSIC);
+            for (int t = 0; t < ticks && !is_game_over(); t++) bench_rewind_tick();
+        }
+        unsigned long allocations = heap_alloc_count() - before;
+
+        log_set_level(LOG_LEVEL_OFF);
+        log_shutdown();
+        printf("%4dx%-5d %7d %7d %7d %12lu %6s\n", width, height, g_game_state->ghosts.count,
+               resets, ticks, allocations, allocations == 0 ? "yes" : "NO");
+        if (allocations != 0) bench_failed = 1;
+        stop_algorithm();
+        cleanup_game_state();
+    }
+    parallel_shutdown();
+}
+
+static const BenchCase bench_cases[] = {
+    {"ghosts", "幽灵tick开销与幽灵数、线程数的关系", bench_ghosts},
+    {"determinism", "并行幽灵更新的结果与线程数无关", bench_ghost_determinism},
+    {"navgraph", "路口图与逐格搜索的开销对比", bench_navgraph},
+    {"nexthop", "下一步表的建表、查表开销与追踪幽灵tick开销", bench_nexthop},
+    {"hpa", "分层寻路与逐格搜索的开销对比", bench_hpa},
+    {"restart", "重新开始时同步重建索引与换入流水线预建索引的开销", bench_restart},
+    {"bitbfs", "位并行搜索与逐格搜索的距离场开销对比", bench_bitbfs},
+    {"frightened", "受惊模式共享距离场的幽灵tick开销", bench_frightened},
+    {"pack", "换关时现场生成与从棋盘包复制棋盘的开销对比", bench_pack},
+    {"rewind", "回退日志的回退、重做开销与整块复制对比", bench_rewind},
+    {"clone", "状态克隆的保存、恢复和复制速率", bench_clone},
+    {"env", "强化学习环境批量步进的速率", bench_env},
+    {"liveshm", "共享内存状态导出的每tick开销与读者快照的一致性", bench_liveshm},
+    {"alloc", "重置和tick路径上没有堆分配", bench_alloc},
+};
+
+#define BENCH_CASE_COUNT (int)(sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+int main(int argc, char *argv[]) {
+    log_set_level(LOG_LEVEL_OFF);
+
+    for (int i = 0; i < BENCH_CASE_COUNT; i++) {
+        int selected = argc < 2;
+        for (int a = 1; a < argc && !selected; a++) {
+            selected = strcmp(argv[a], bench_cases[i].name) == 0;
+        }
+        if (!selected) continue;
+
+        printf("== %s: %s ==\n", bench_cases[i].name, bench_cases[i].description);
+        bench_cases[i].run();
+        printf("\n");
+    }
+
+    for (int a = 1; a < argc; a++) {
+        int known = 0;
+        for (int i = 0; i < BENCH_CASE_COUNT; i++) {
+            known |= strcmp(argv[a], bench_cases[i].name) == 0;
+        }
+        if (!known) {
+            fprintf(stderr, "未知的基准: %s\n", argv[a]);
+            return 1;
+        }
+    }
+    return bench_failed;
+}
@@ -1,18 +1,23 @@
 #ifndef ALGORITHMS_H
 #define ALGORITHMS_H
 
+#include <stddef.h>
 #include "types.h"
+#include "arena.h"
 
 /* 算法类型常量 */
 #define ALGO_NONE 0
 #define ALGO_RANDOM 1
 #define ALGO_ZIGZAG 2
 #define ALGO_DFS 3
+#define ALGO_CLASSIC 4   /* 按幽灵颜色区分个性：追击、伏击、包抄、胆小 */
 
 /* 算法控制函数 */
 void set_algorithm(int algorithm_type);
 void stop_algorithm(void);
 int is_algorithm_enabled(void);
+int get_algorithm(void);
+void resume_algorithm(int algorithm_type);
 
 /* 幽灵移动函数 */
 void update_ghost_movement(void);
@@ -23,5 +28,14 @@ const char* get_algorithm_name(void);
 /* 幽灵移动间隔控制 */
 void set_ghost_move_interval(int interval_ms);
 int get_ghost_move_interval(void);
+int get_ghost_timer_phase(void);
+void set_ghost_timer_phase(int phase);
+
+/* 算法模块的内存（寻路缓冲区来自游戏内存区） */
+size_t algorithms_arena_bytes(int width, int height);
+int algorithms_init_arena(Arena *arena, int width, int height);
+
+/* 玩家自动驾驶（无界面模式使用） */
+Direction autopilot_next_direction(void);
 
 #endif /* ALGORITHMS_H */
\ No newline at end of file
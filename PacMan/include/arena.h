@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* 线性内存区：启动时一次性分配，游戏期间只在其中切分，不再访问堆 */
+typedef struct {
+    unsigned char *base;
+    size_t size;
+    size_t used;
+} Arena;
+
+/* 内存区管理函数 */
+int arena_init(Arena *arena, size_t size);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+size_t arena_mark(const Arena *arena);
+void arena_reset(Arena *arena, size_t mark);
+size_t arena_align(size_t size);
+
+/* 堆分配计数钩子：引擎代码的堆分配统一经过这里，便于验证重置和tick路径无堆分配。
+ * 普通构建只统计经过heap_alloc/heap_calloc的分配；分配检查构建（make alloc_check）
+ * 在链接时包装malloc/calloc/realloc，统计所有目标文件中的真实分配 */
+void *heap_alloc(size_t size);
+void *heap_calloc(size_t count, size_t size);
+void heap_free(void *ptr);
+unsigned long heap_alloc_count(void);
+void heap_alloc_check(unsigned long start_count, const char *path);
+
+/* 编译时定义PACMAN_ALLOC_CHECK（并按上面的方式链接）后，在指定路径前后检查是否发生了堆分配 */
+#ifdef PACMAN_ALLOC_CHECK
+#define ALLOC_CHECK_BEGIN() unsigned long alloc_check_start_ = heap_alloc_count()
+#define ALLOC_CHECK_END(path) heap_alloc_check(alloc_check_start_, (path))
+#else
+#define ALLOC_CHECK_BEGIN() ((void)0)
+#define ALLOC_CHECK_END(path) ((void)0)
+#endif
+
+#endif /* ARENA_H */
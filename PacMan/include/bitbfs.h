@@ -0,0 +1,40 @@
+#ifndef BITBFS_H
+#define BITBFS_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 位并行广度优先搜索：每行的可走格和已访问格各用一组64位字存放，
+ * 每一层把波前的字左右移位、上下平移，再与 (可走 & ~已访问) 相与，一次处理64格。
+ * 只处理波前所在的字，开销与波前所占的字数成正比；横向展开的波前（开阔区域）收益最大，
+ * 只有一两格宽的迷宫走廊上逐格搜索更快。
+ * 只看墙壁，得到的距离与逐格队列搜索完全相同。 */
+
+/* 候选字的编号把列放在低6位，棋盘宽度不超过此值时才能使用 */
+#define BITBFS_MAX_WIDTH 4096
+
+/* 追踪距离场的最大半径，超出范围的幽灵按其他方式接近 */
+#define BITBFS_CHASE_RADIUS 256
+
+typedef struct BitBoard BitBoard;
+
+size_t bitbfs_bytes(int width, int height);
+BitBoard *bitbfs_carve(Arena *arena, int width, int height);
+void bitbfs_build(BitBoard *bits, CellType **board);
+void bitbfs_cell_changed(BitBoard *bits, int x, int y, CellType old_type, CellType new_type);
+
+/* 从(x, y)出发计算距离场，radius小于0时不限半径；返回到达的格子数 */
+int bitbfs_field(BitBoard *bits, int x, int y, int radius);
+
+/* 最近一次距离场中(x, y)的距离，未到达时返回-1 */
+int bitbfs_distance(const BitBoard *bits, int x, int y);
+
+/* 追踪：玩家位置和墙壁不变、半径也够用时沿用上一次的距离场，之后各幽灵只读查询（可并行） */
+void bitbfs_chase_field(BitBoard *bits, int player_x, int player_y, int radius);
+void bitbfs_discard_field(BitBoard *bits);
+/* 只使用从(player_x, player_y)算出的距离场，其他来源的距离场视为过期 */
+Direction bitbfs_chase_direction(const BitBoard *bits, int player_x, int player_y, int x, int y,
+                                 unsigned int allowed);
+
+#endif /* BITBFS_H */
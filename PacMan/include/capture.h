@@ -0,0 +1,25 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "types.h"
+
+/* 帧捕获：无需X服务器，把棋盘光栅化为RGB帧缓冲区并输出编号的图片序列
+ * 模拟线程只复制视口内的格子，光栅化和压缩由编码线程池完成 */
+
+/* 输出格式 */
+#define CAPTURE_FORMAT_PPM 0
+#define CAPTURE_FORMAT_PNG 1
+
+/* 视口上限（格子数），更大的棋盘只输出玩家附近的区域 */
+#define CAPTURE_MAX_COLS 64
+#define CAPTURE_MAX_ROWS 40
+/* 编码线程数上限 */
+#define CAPTURE_MAX_WORKERS 16
+
+int capture_start(const char *directory, int format, int workers);
+int capture_frame(CellType **board, int width, int height, int focus_x, int focus_y);
+void capture_stop(void);
+unsigned long capture_frames_written(void);
+int capture_parse_format(const char *name);
+
+#endif /* CAPTURE_H */
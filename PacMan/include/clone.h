@@ -0,0 +1,40 @@
+#ifndef CLONE_H
+#define CLONE_H
+
+#include <stddef.h>
+#include "types.h"
+
+/* 状态克隆：把整个模拟状态（计数器、棋盘、幽灵表和出口掩码、路口图和分层图的计数、
+ * 幽灵计时和当前算法）保存到预先分配的克隆对象，或从克隆对象恢复，供前瞻搜索和
+ * "如果这样走会怎样"的模拟使用。
+ *
+ * 棋盘格子连续存放，幽灵表的各字段数组和出口掩码在内存区中紧挨着切分，
+ * 保存和恢复都是两次整块复制加上几段很小的计数数组；只取决于墙壁的索引
+ * （路口图结构、下一步表、分层图的簇内距离、可走位集）不复制，因此克隆只在
+ * 同一关内有效，换关之后恢复返回-1，需要重新创建。
+ *
+ * 克隆对象内部只有偏移没有指针，克隆之间的复制是一次memcpy。
+ * 恢复时清空回退日志（回退不跨越恢复）。 */
+
+typedef struct GameClone GameClone;
+
+/* 按当前游戏（棋盘大小、幽灵容量、当前关的路口图）分配克隆对象，失败返回NULL；
+ * 只在开局或换关之后调用一次，保存和恢复不再访问堆 */
+GameClone *game_clone_create(void);
+void game_clone_destroy(GameClone *clone);
+size_t game_clone_bytes(const GameClone *clone);
+/* 保存的棋盘格子（按行连续）和计数器等标量（其中的指针字段无效），尚未保存时返回NULL */
+const CellType *game_clone_board(const GameClone *clone);
+const GameState *game_clone_state(const GameClone *clone);
+
+/* 保存当前状态到dst；dst不是为当前关创建的（容量不足）时返回-1 */
+int game_clone_into(GameClone *dst);
+/* 用src恢复当前状态；src不是在当前关保存的返回-1，状态不变 */
+int game_restore_from(const GameClone *src);
+/* 在调用线程上建立src所在关的游戏状态副本并恢复src（如批量环境的工作线程），
+ * 调用线程原有的游戏状态须已清理；失败返回-1 */
+int game_clone_instantiate(const GameClone *src);
+/* 克隆之间复制；dst容量不足时返回-1 */
+int game_clone_copy(GameClone *dst, const GameClone *src);
+
+#endif /* CLONE_H */
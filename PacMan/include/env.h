@@ -0,0 +1,55 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stddef.h>
+#include "types.h"
+
+/* 强化学习环境：一批B个环境共用同一关的棋盘（由reset的种子生成），各环境的状态
+ * 保存在状态克隆中（见clone.h），一次step推进全部环境。调用线程和线程池的每个工作线程
+ * 各有一份本关的游戏状态，step按环境在线程池上并行，每个环境在分到它的线程上换入、
+ * 走一步再存回，其中的幽灵决策在该线程内依次进行；观测编码同样按环境并行。
+ *
+ * 观测：每个环境ENV_PLANES个平面，每个平面宽x高个uint8，按[环境][平面][y][x]连续
+ * 写入调用者提供的缓冲区（每个环境env_observation_bytes字节），不经过中间复制。
+ * 动作：每个环境一个字节，取Direction的值，ENV_ACTION_NONE表示不动。
+ * 奖励是本步的得分增量；游戏结束（胜利或失败）或达到步数上限时done为1，
+ * 该环境自动重置为新的一局，返回的观测是新一局的第一帧。每局开始时
+ * 各幽灵的随机数按种子、环境序号和局数重新播种，同一批环境的走向互不相同。
+ *
+ * 环境批次独占全局游戏状态和线程池，同一时间只能有一个批次，且不能与图形界面同时运行。 */
+
+#define ENV_PLANES 5
+enum {
+    ENV_PLANE_WALL = 0,
+    ENV_PLANE_DOT,                  /* 豆子和水果 */
+    ENV_PLANE_POWER,
+    ENV_PLANE_GHOST,                /* 幽灵所在格为1，受惊模式下为2 */
+    ENV_PLANE_PLAYER
+};
+#define ENV_ACTION_NONE DIR_COUNT
+
+typedef struct {
+    int width, height;
+    int ghosts;                     /* 每个环境的幽灵数 */
+    int batch;                      /* 环境数 */
+    int algorithm;                  /* 幽灵算法（ALGO_*） */
+    int threads;                    /* 线程数，0为CPU核数 */
+    int max_steps;                  /* 每局最多步数，0表示不限 */
+} EnvConfig;
+
+typedef struct EnvBatch EnvBatch;
+
+void env_default_config(EnvConfig *config);
+EnvBatch *env_create(const EnvConfig *config);
+void env_destroy(EnvBatch *env);
+
+int env_batch_size(const EnvBatch *env);
+size_t env_observation_bytes(const EnvBatch *env);
+
+/* 用seed生成新的关卡，全部环境从第一局开始，observations可为NULL；失败返回-1 */
+int env_reset(EnvBatch *env, unsigned int seed, unsigned char *observations);
+/* 每个环境执行actions[i]走一步；observations、rewards、dones可为NULL */
+void env_step(EnvBatch *env, const unsigned char *actions, unsigned char *observations,
+              float *rewards, unsigned char *dones);
+
+#endif /* ENV_H */
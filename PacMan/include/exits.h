@@ -0,0 +1,30 @@
+#ifndef EXITS_H
+#define EXITS_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 每格的出口掩码（一个字节）：
+ * 低4位：相邻格在棋盘内且不是墙（玩家可走）
+ * 高4位：相邻格幽灵可走（不是墙、幽灵或水果）
+ * 位号为Direction；换入棋盘时整体计算，之后只在格子类别变化时更新相邻格 */
+#define EXIT_BIT(dir) (1u << (dir))
+#define EXIT_PLAYER_MASK(m) ((m) & 0x0Fu)
+#define EXIT_GHOST_MASK(m) ((m) >> 4)
+
+/* 掩码到方向列表的查找表 */
+typedef struct {
+    unsigned char count;
+    unsigned char dirs[4];
+} ExitDirList;
+
+extern const ExitDirList exit_dir_lists[16];
+
+size_t exits_bytes(int width, int height);
+unsigned char *exits_carve(Arena *arena, int width, int height);
+void exits_build(unsigned char *exits, CellType **board, int width, int height);
+void exits_update_cell(unsigned char *exits, int width, int height, int x, int y,
+                       CellType old_type, CellType new_type);
+
+#endif /* EXITS_H */
@@ -2,17 +2,35 @@
 #define GAME_H
 
 #include "types.h"
+#include "arena.h"
+#include "map.h"
+#include "pack.h"
 
 /* 游戏初始化和清理函数 */
 int init_game_state(void);
 int init_game_state_with_size(int width, int height);
+int init_game_state_copy(const CellType *cells, unsigned int serial);
 void cleanup_game_state(void);
 void reset_game_state(void);
+Arena *get_game_arena(void);
+int advance_level(void);
+unsigned int get_board_serial(void);
 
 /* 网格大小管理函数 */
 void set_board_size(int width, int height);
 int get_board_width(void);
 int get_board_height(void);
+void set_ghost_count(int count);
+int get_ghost_count(void);
+void set_game_seed(unsigned int seed);
+void set_nexthop_enabled(int enabled);
+void set_hpa_enabled(int enabled);
+void set_game_map(const GameMap *map);
+void set_game_pack(const BoardPack *pack);
+void set_level_cache_dir(const char *dir);
+void set_journal_ticks(int ticks);
+void set_spectate_socket(const char *path);
+void set_live_shm_name(const char *name);
 
 /* 棋盘管理函数 */
 void init_board(void);
@@ -22,10 +40,12 @@ void add_power_dots(void);
 void clear_board_cell(int x, int y);
 CellType get_board_cell(int x, int y);
 void set_board_cell(int x, int y, CellType type);
+void rebuild_board_indexes(void);
 
 /* 玩家移动和位置管理 */
 int is_valid_move(int x, int y);
 int move_player_to(int new_x, int new_y);
+int step_player(Direction dir);
 void update_player_position(int x, int y);
 PlayerPosition get_player_position(void);
 
@@ -48,12 +68,21 @@ int is_game_won(void);
 void increment_moves(void);
 void collect_dot(void);
 void collect_power_dot(void);
+int is_frightened(void);
+void eat_ghost(int index);
+void update_frightened_mode(void);
 void check_win_condition(void);
 void update_game_statistics(void);
 
+/* 回退：每个模拟tick结束时提交（同时向观战客户端发出本tick的帧），
+ * 之后可回退或重做（需先用set_journal_ticks启用） */
+void commit_game_tick(void);
+int rewind_game(int ticks);
+int replay_game(int ticks);
 
 
-/* 全局游戏状态访问 */
-extern GameState *g_game_state;
+
+/* 全局游戏状态访问（每个线程一份） */
+extern __thread GameState *g_game_state;
 
 #endif /* GAME_H */
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef GHOST_H
+#define GHOST_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 幽灵表管理：容量在开局时从内存区切分，之后只在原地增删，tick路径不扫描棋盘 */
+size_t ghost_registry_bytes(int capacity);
+int ghost_registry_carve(Arena *arena, GhostRegistry *ghosts, int capacity);
+void ghost_registry_clear(GhostRegistry *ghosts);
+int ghost_registry_add(GhostRegistry *ghosts, int x, int y, CellType type, int algorithm);
+int ghost_registry_load(GhostRegistry *ghosts, CellType **board, int width, int height,
+                        int algorithm);
+void ghost_registry_set_algorithm(GhostRegistry *ghosts, int algorithm);
+int ghost_registry_find(const GhostRegistry *ghosts, int x, int y);
+
+/* 第index个幽灵的显示颜色 */
+CellType ghost_type_for_index(int index);
+int is_ghost_cell(CellType cell);
+
+#endif /* GHOST_H */
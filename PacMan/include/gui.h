@@ -20,6 +20,9 @@
 #define DFS_BUTTON 13
 #define STOP_ALGO_BUTTON 14
 
+/* 渲染按显示刷新率进行，与模拟步长SIM_TICK_MS解耦 */
+#define RENDER_FRAME_MS 16   /* 渲染帧间隔（毫秒），约60Hz */
+
 /* GUI初始化和销毁函数 */
 int init_gui(int argc, char *argv[]);
 void cleanup_gui(void);
@@ -29,6 +32,8 @@ void draw_board(Widget w, int width, int height, void *data);
 void update_display(void);
 void update_status_display(void);
 void show_victory_message(void);
+void timer_callback(void *data);
+void render_timer_callback(void *data);
 
 /* 游戏逻辑函数 */
 void move_player(Direction dir);
@@ -48,6 +53,7 @@ void button_quit_callback(Widget w, void *data);
 void button_random_callback(Widget w, void *data);
 void button_zigzag_callback(Widget w, void *data);
 void button_dfs_callback(Widget w, void *data);
+void button_classic_callback(Widget w, void *data);
 void button_stop_algo_callback(Widget w, void *data);
 
 /* 胜利提示框回调函数 */
@@ -57,7 +63,7 @@ void button_stop_algo_callback(Widget w, void *data);
 void key_press_callback(Widget w, char *input, int up_or_down, void *data);
 
 /* 全局变量声明 */
-extern GameState *g_game_state;
+extern __thread GameState *g_game_state;
 extern Widget g_main_window;
 extern Widget g_drawing_area;
 extern Widget g_status_label;
@@ -0,0 +1,22 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+/* 无界面运行参数 */
+typedef struct {
+    long ticks;         /* 最多运行的tick数，0表示不限 */
+    int tick_ms;        /* 每个tick之间的休眠毫秒数，0表示全速运行 */
+    int algorithm;      /* 幽灵算法（ALGO_*） */
+    int games;          /* 运行的局数，游戏结束后自动重新开始 */
+    int term;           /* 是否使用ANSI终端渲染 */
+    int frame_every;    /* 终端渲染时每隔多少个tick输出一帧 */
+    const char *capture_dir;    /* 帧捕获输出目录，NULL表示不捕获 */
+    int capture_format;         /* CAPTURE_FORMAT_PPM 或 CAPTURE_FORMAT_PNG */
+    int capture_every;          /* 每隔多少个tick捕获一帧 */
+    int capture_workers;        /* 编码线程数 */
+} HeadlessOptions;
+
+/* 无界面模式函数 */
+void headless_default_options(HeadlessOptions *options);
+int run_headless(const HeadlessOptions *options);
+
+#endif /* HEADLESS_H */
@@ -0,0 +1,57 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 分层寻路（HPA*）：把大棋盘切成 HPA_CLUSTER_SIZE 见方的分簇，相邻分簇边界上
+ * 通往同一对簇内连通区域的开口合并为入口，入口两侧的格子是抽象图的节点，
+ * 同一分簇内节点之间的距离预先算好（能由更短的两段拼出的不保留）。查询时只在起点（和终点）所在的分簇内逐格搜索，
+ * 其余部分在抽象图上搜索，最后换算成格子上的第一步。
+ * 图只取决于墙壁：墙壁变化时只把受影响的分簇标记为待重建，下一次查询前重建。
+ * 得到的路径可能比真正的最短路略长。 */
+
+#define HPA_CLUSTER_SIZE 32
+
+/* 格子数不少于此值的棋盘才建立分层图，更小的棋盘逐格搜索足够快 */
+#define HPA_MIN_CELLS (256 * 256)
+
+typedef struct HpaGraph HpaGraph;
+
+size_t hpa_bytes(int width, int height);
+HpaGraph *hpa_carve(Arena *arena, int width, int height);
+void hpa_build(HpaGraph *graph, CellType **board, const unsigned char *exits);
+void hpa_cell_changed(HpaGraph *graph, int x, int y, CellType old_type, CellType new_type);
+
+/* 建好的图的映像（分簇、边界、簇内掩码和连通分量、节点和簇内边），供关卡缓存保存和载入；
+ * 只能在没有待重建分簇时保存，载入时大小必须与当前图一致，否则返回-1 */
+size_t hpa_image_bytes(const HpaGraph *graph);
+void hpa_save_image(const HpaGraph *graph, unsigned char *image);
+int hpa_load_image(HpaGraph *graph, const unsigned char *image, size_t size);
+
+/* 各分簇的豆子数，供状态克隆保存和恢复；只在墙壁相同（同一关）的图之间有效 */
+size_t hpa_counts_bytes(const HpaGraph *graph);
+void hpa_save_counts(const HpaGraph *graph, void *counts);
+void hpa_load_counts(HpaGraph *graph, const void *counts);
+
+/* 统计信息 */
+int hpa_cluster_count(const HpaGraph *graph);
+int hpa_node_count(const HpaGraph *graph);
+
+/* 两格之间的路径长度（只看墙壁），不可达时返回-1 */
+int hpa_distance(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                 int x0, int y0, int x1, int y1);
+
+/* 玩家自动驾驶：最近的豆子/能量豆/水果；找不到时返回DIR_COUNT */
+Direction hpa_autopilot(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                        int x, int y);
+
+/* 追踪：先从玩家位置计算抽象图上的距离场，再把距离场展开到有幽灵的分簇
+ * （每个分簇每次距离场只展开一次），之后各幽灵只读查询（可并行） */
+void hpa_chase_field(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                     int player_x, int player_y);
+void hpa_chase_resolve(HpaGraph *graph, const int *xs, const int *ys, int count);
+Direction hpa_chase_direction(const HpaGraph *graph, int x, int y, unsigned int allowed);
+
+#endif /* HPA_H */
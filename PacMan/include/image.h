@@ -0,0 +1,26 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stddef.h>
+
+/* 图像编码器：把RGB帧缓冲区（每像素3字节，逐行排列）写成PPM或PNG文件
+ * PNG使用zlib格式的固定哈夫曼deflate压缩，不依赖外部库 */
+
+/* PNG编码的工作缓冲区，每个编码线程一份，可重复使用 */
+typedef struct {
+    unsigned char *filtered;    /* 加上行过滤字节后的原始数据 */
+    unsigned char *compressed;  /* deflate输出 */
+    size_t raw_cap;
+    size_t out_cap;
+    int *hash_head;             /* LZ77哈希链表头 */
+    int *hash_prev;             /* LZ77哈希链表（按窗口位置索引） */
+} ImageEncoder;
+
+int image_encoder_init(ImageEncoder *encoder, int max_width, int max_height);
+void image_encoder_destroy(ImageEncoder *encoder);
+
+int image_write_ppm(const char *path, const unsigned char *rgb, int width, int height);
+int image_write_png(const char *path, const unsigned char *rgb, int width, int height,
+                    ImageEncoder *encoder);
+
+#endif /* IMAGE_H */
@@ -0,0 +1,52 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "arena.h"
+
+/* 回退日志：每次棋盘格变化、幽灵状态变化和计数器变化都记成一条增量（原值和新值），
+ * 存在环形缓冲区里，每个tick提交一次。回退N个tick按相反顺序恢复原值，
+ * 前进按顺序写回新值，开销与这段时间内的变化数成正比，不复制整个状态。
+ * 每隔一段tick保存一个完整的关键帧（棋盘、幽灵表和计数器）：缓冲区写满时
+ * 按关键帧整段丢弃最旧的历史；回退很远时先恢复关键帧再前进，开销不超过
+ * 格子数加一段关键帧间隔内的变化数。
+ *
+ * 只在一关之内有效：换入棋盘和切换幽灵算法时清空历史。
+ * 回退之后又有新的变化时，被回退的那段未来被丢弃（从回退点分支）。
+ * 导航索引只取决于墙壁，tick路径上墙壁不变，回退时只经set_board_cell更新出口掩码等。 */
+
+#define JOURNAL_KEYFRAMES 4
+/* 环形缓冲区的记录数上限（每条12字节），幽灵很多时历史按此缩短 */
+#define JOURNAL_MAX_ENTRIES (1u << 21)
+/* 图形界面默认保留的历史tick数（1分钟）和每次按键回退的tick数 */
+#define JOURNAL_DEFAULT_TICKS 600
+#define JOURNAL_GUI_STEP_TICKS 20
+
+typedef struct Journal Journal;
+
+size_t journal_bytes(int width, int height, int ghost_capacity, int ticks);
+Journal *journal_carve(Arena *arena, int width, int height, int ghost_capacity, int ticks);
+
+/* 清空历史，以g_game_state的当前状态作为第一个关键帧 */
+void journal_reset(Journal *journal);
+
+/* 变化记录：格子在set_board_cell中记录；幽灵在修改其字段之前暂存原值（每tick一次），
+ * 提交时只记录与原值不同的字 */
+void journal_cell(Journal *journal, int index, CellType before, CellType after);
+void journal_ghost(Journal *journal, const GhostRegistry *ghosts, int index);
+void journal_active_ghosts(Journal *journal, const GhostRegistry *ghosts);
+
+/* 一个tick结束：比较计数器和本tick暂存的幽灵，记录变化，按需保存关键帧 */
+void journal_commit_tick(Journal *journal);
+
+/* 可回退、可前进的tick数 */
+int journal_history(const Journal *journal);
+int journal_future(const Journal *journal);
+
+/* 回退或前进最多ticks个tick，返回实际移动的tick数 */
+int journal_rewind(Journal *journal, int ticks);
+int journal_forward(Journal *journal, int ticks);
+
+#endif /* JOURNAL_H */
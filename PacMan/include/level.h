@@ -0,0 +1,84 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 预生成队列深度：后台线程最多提前准备的棋盘数 */
+#define LEVEL_PIPELINE_DEPTH 2
+/* 流水线棋盘池大小：就绪队列 + 正在生成的一个 */
+#define LEVEL_PIPELINE_POOL (LEVEL_PIPELINE_DEPTH + 1)
+
+/* 生成算法的版本：生成结果会因此改变时递增，关卡缓存以此区分 */
+#define LEVEL_GENERATOR_VERSION 1
+/* 内部墙壁占内部格子的千分比 */
+#define LEVEL_WALL_DENSITY_PERMILLE 200
+
+/* 每关的能量豆数 */
+#define LEVEL_POWER_DOT_COUNT 4
+/* 出生点安全距离：玩家出生点这么多步以内不能有幽灵 */
+#define LEVEL_SAFE_SPAWN_DISTANCE 4
+
+/* 棋盘校验结果 */
+typedef enum {
+    LEVEL_VALID = 0,
+    LEVEL_BAD_SPAWN,        /* 玩家不在(1, 1)或不止一个 */
+    LEVEL_UNREACHABLE,      /* 有豆子、幽灵或水果从出生点走不到 */
+    LEVEL_BAD_DOTS,         /* 没有豆子或能量豆数不对 */
+    LEVEL_BAD_GHOSTS,       /* 幽灵数与要求不符 */
+    LEVEL_UNSAFE_SPAWN,     /* 出生点附近有幽灵 */
+    LEVEL_CHECK_COUNT
+} LevelCheck;
+
+/* 生成棋盘用的临时缓冲区（洪水填充的访问标记和显式栈） */
+typedef struct {
+    unsigned char *visited;
+    int *stack;
+} LevelScratch;
+
+/* 棋盘内存管理：棋盘从内存区切分，行指针指向连续的格子数据 */
+size_t level_board_bytes(int width, int height);
+CellType** level_board_carve(Arena *arena, int width, int height);
+size_t level_scratch_bytes(int width, int height);
+int level_scratch_carve(Arena *arena, LevelScratch *scratch, int width, int height);
+
+/* 关卡生成函数：只操作传入的棋盘和随机数状态，可在任意线程调用 */
+unsigned int level_rand(unsigned int *state);
+void level_generate_walls_and_dots(CellType **board, int width, int height, unsigned int *rng,
+                                   LevelScratch *scratch);
+void level_place_ghosts(CellType **board, int width, int height, int count, unsigned int *rng);
+void level_place_power_dots(CellType **board, int width, int height, unsigned int *rng);
+int level_count_dots(CellType **board, int width, int height);
+int level_generate(CellType **board, int width, int height, int ghost_count,
+                   unsigned int seed, LevelScratch *scratch);
+/* 同上，但随机数状态由调用者持有，生成后的状态留在*rng中 */
+int level_generate_rng(CellType **board, int width, int height, int ghost_count,
+                       unsigned int *rng, LevelScratch *scratch);
+
+/* 流水线依次生成的关卡种子：第一个由启动时的种子得到，之后逐个递推 */
+unsigned int level_pipeline_first_seed(unsigned int seed);
+unsigned int level_next_seed(unsigned int seed);
+
+/* 校验生成的棋盘：出生点、连通性、豆子数、幽灵数和出生点安全距离，可在任意线程调用 */
+LevelCheck level_validate(CellType **board, int width, int height, int ghost_count,
+                          LevelScratch *scratch);
+const char *level_check_name(LevelCheck check);
+
+/* 棋盘附带的索引：只依赖墙壁、建立较慢的索引（如下一步表、分层图）由后台线程在
+ * 生成棋盘之后调用build建立，与棋盘一起换入换出。indexes是调用者的不透明对象，
+ * 池中每个棋盘一个（LEVEL_PIPELINE_POOL个），build为NULL时不附带索引 */
+typedef void (*LevelIndexFn)(CellType **board, void *indexes, void *context);
+
+/* 关卡预生成流水线 */
+size_t level_pipeline_bytes(int width, int height);
+int level_pipeline_start(Arena *arena, int width, int height, int ghost_count, int depth,
+                         unsigned int seed, void *const *indexes, LevelIndexFn build,
+                         void *context);
+void level_pipeline_stop(void);
+/* 取出棋盘时*indexes为与之一起建立的索引；归还时连同换下的索引一起交还 */
+CellType** level_pipeline_acquire(int width, int height, int *total_dots, void **indexes,
+                                  int wait);
+void level_pipeline_release(CellType **board, void *indexes);
+
+#endif /* LEVEL_H */
@@ -0,0 +1,80 @@
+#ifndef LEVELCACHE_H
+#define LEVELCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/* 关卡缓存：生成器版本、种子、大小、墙壁密度和幽灵数相同时生成的棋盘总是相同，
+ * 棋盘上的出口掩码、路口图、下一步表和分层图也相同。缓存目录下每个关卡一个文件，
+ * 文件名是键的散列值，内容是棋盘和这些索引的映像。开局和换关时先查缓存：
+ * 命中时映射文件直接复制，不再生成和重建；未命中时照常生成，建好索引后写入缓存。
+ *
+ * 文件布局（.plc）：文件头（含段表），之后是各段的数据，每段按64字节对齐。 */
+
+#define LEVEL_CACHE_MAGIC "PLVC"
+#define LEVEL_CACHE_VERSION 1
+#define LEVEL_CACHE_ALIGN 64
+
+/* 缓存键 */
+typedef struct {
+    uint32_t generator_version;     /* LEVEL_GENERATOR_VERSION */
+    uint32_t seed;
+    uint32_t width, height;
+    uint32_t wall_density;          /* 千分比，LEVEL_WALL_DENSITY_PERMILLE */
+    uint32_t ghost_count;
+} LevelCacheKey;
+
+/* 段号，没有建立的索引段大小为0 */
+enum {
+    LEVEL_CACHE_BOARD = 0,          /* 每格一个字节（CellType值） */
+    LEVEL_CACHE_EXITS,              /* 出口掩码 */
+    LEVEL_CACHE_NAVGRAPH,           /* 路口图映像 */
+    LEVEL_CACHE_NEXTHOP,            /* 下一步表映像 */
+    LEVEL_CACHE_HPA,                /* 分层图映像 */
+    LEVEL_CACHE_SECTIONS
+};
+
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+} LevelCacheSection;
+
+/* 文件头 */
+typedef struct {
+    char magic[4];                  /* "PLVC" */
+    uint32_t version;               /* LEVEL_CACHE_VERSION */
+    uint32_t byte_order;            /* MAP_BYTE_ORDER */
+    LevelCacheKey key;
+    uint32_t rng_state;             /* 生成之后的随机数状态 */
+    uint32_t total_dots;
+    uint64_t checksum;              /* 各段数据的校验和（见map_checksum） */
+    LevelCacheSection sections[LEVEL_CACHE_SECTIONS];
+} LevelCacheHeader;
+
+/* 打开的缓存条目：整个文件的映射 */
+typedef struct {
+    const LevelCacheHeader *header;
+    void *mapping;
+    size_t mapping_size;
+} LevelCacheEntry;
+
+void level_cache_key(LevelCacheKey *key, unsigned int seed, int width, int height,
+                     int ghost_count);
+
+/* 查找并映射缓存条目，校验文件头、键和校验和；命中返回0，未命中或文件无效返回-1 */
+int level_cache_open(const char *dir, const LevelCacheKey *key, LevelCacheEntry *entry);
+void level_cache_close(LevelCacheEntry *entry);
+
+/* 把缓存的棋盘写入棋盘，*rng_state为生成之后的随机数状态，返回豆子总数 */
+int level_cache_fill_board(const LevelCacheEntry *entry, CellType **board,
+                           unsigned int *rng_state);
+/* 载入出口掩码和state中已建立的索引（为NULL的跳过），幽灵表和位集由调用者重建；
+ * 缓存里缺少需要的索引或大小不符时返回-1 */
+int level_cache_load_indexes(const LevelCacheEntry *entry, GameState *state);
+
+/* 把刚生成并建好索引的关卡写入缓存，先写临时文件再改名，失败时返回-1 */
+int level_cache_store(const char *dir, const LevelCacheKey *key, const GameState *state,
+                      unsigned int rng_state, int total_dots);
+
+#endif /* LEVELCACHE_H */
@@ -0,0 +1,80 @@
+#ifndef LIVESHM_H
+#define LIVESHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/* 共享内存状态导出：把当前棋盘和计数器发布到POSIX共享内存段（shm_open），
+ * 其他进程的可视化和监控程序直接映射读取，不经过套接字，也不锁游戏循环。
+ *
+ * 一致性用顺序锁（seqlock）：写者（游戏）在修改前把sequence加一成为奇数，改完再加一
+ * 成为偶数；读者先读sequence，为奇数时重试，复制数据后再读一次，两次相同才算一致的快照。
+ * 写者从不等待读者，读者在写者写的同时读到的残缺数据会被丢弃重读。
+ *
+ * 写入只处理本tick变化的格子：set_board_cell记录变化的下标，tick结束时（commit_game_tick）
+ * 在顺序锁内只写这些格子和计数器，每tick的开销与变化的格子数成正比，与棋盘大小无关。
+ * 换关、恢复克隆、变化超过四分之一时整块复制棋盘。
+ *
+ * 段布局（整数都是本机字节序，版本不同时读者应拒绝）：
+ *   偏移0：LiveShmHeader（大小见header_bytes）
+ *   偏移board_offset：width * height 字节，按行排列，每格一个CellType值
+ * board_sum是格子的校验和 Σ cell[i] * (i + 1)（模2^32），读者可据此核对复制出的棋盘。
+ * 新版本只在结构末尾追加字段；已有字段的含义或位置变化时提高LIVE_SHM_VERSION。 */
+
+#define LIVE_SHM_MAGIC "PLIV"
+#define LIVE_SHM_VERSION 1
+
+/* 计数器，与棋盘在同一次顺序锁内更新 */
+typedef struct {
+    uint32_t tick;                  /* 导出开始后的tick数 */
+    uint32_t board_serial;          /* 换入新棋盘时变化 */
+    uint32_t board_sum;             /* 棋盘校验和 */
+    int32_t level, score, lives;
+    int32_t dots_collected, total_dots;
+    int32_t player_x, player_y;
+    int32_t frightened_ticks;
+    int32_t game_over, game_won;
+    int32_t ghost_count;
+} LiveShmStats;
+
+typedef struct {
+    char magic[4];                  /* "PLIV" */
+    uint32_t version;               /* LIVE_SHM_VERSION */
+    uint32_t header_bytes;          /* 本结构的大小 */
+    uint32_t board_offset;          /* 棋盘相对段首的偏移，按64字节对齐 */
+    uint32_t width, height;
+    uint32_t writer_pid;
+    uint32_t sequence;              /* 顺序锁计数：奇数表示正在写 */
+    LiveShmStats stats;
+} LiveShmHeader;
+
+typedef struct LiveShm LiveShm;
+
+/* 写者：创建（已存在则覆盖）名为name的共享内存段（如 "/pacman"），失败返回NULL */
+LiveShm *live_shm_create(const char *name, int width, int height);
+/* 删除共享内存段，已映射的读者仍可读到最后发布的状态 */
+void live_shm_destroy(LiveShm *shm);
+
+/* 格子变化（由set_board_cell调用） */
+void live_shm_cell(LiveShm *shm, int index);
+/* 棋盘被整块替换（恢复克隆），下一次发布复制整个棋盘 */
+void live_shm_resync(LiveShm *shm);
+/* tick结束：在顺序锁内写入变化的格子和计数器，board_serial变化时复制整个棋盘 */
+void live_shm_publish(LiveShm *shm, const GameState *state, unsigned int board_serial);
+
+/* 读者：以只读方式映射共享内存段，段不存在、版本不符时返回NULL */
+typedef struct LiveShmReader LiveShmReader;
+
+LiveShmReader *live_shm_open(const char *name);
+void live_shm_close(LiveShmReader *reader);
+int live_shm_width(const LiveShmReader *reader);
+int live_shm_height(const LiveShmReader *reader);
+/* 写者进程号，观察程序据此判断游戏是否已退出 */
+unsigned int live_shm_writer_pid(const LiveShmReader *reader);
+/* 复制一致的快照：cells至少width * height字节（可为NULL，只取计数器）；
+ * 写者一直在写、重试多次仍失败时返回-1 */
+int live_shm_snapshot(LiveShmReader *reader, LiveShmStats *stats, unsigned char *cells,
+                      size_t size);
+
+#endif /* LIVESHM_H */
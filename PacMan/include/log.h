@@ -0,0 +1,65 @@
+#ifndef LOG_H
+#define LOG_H
+
+/* 日志级别 */
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+/* 编译期日志级别：低于该级别的日志调用在编译时被完全移除
+ * 例如 make CFLAGS+=-DLOG_COMPILE_LEVEL=LOG_LEVEL_OFF 关闭所有日志 */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/* 日志系统控制函数 */
+int log_init(void);
+void log_shutdown(void);
+void log_set_level(int level);
+int log_get_level(void);
+unsigned long log_dropped_count(void);
+
+/* 写入一条日志（一般通过下方的宏调用） */
+void log_write(int level, const char *fmt, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/* 运行期日志级别，宏中先行判断以避免无用的格式化开销 */
+extern int g_log_level;
+
+#define LOG_AT(level, ...) \
+    do { if ((level) >= g_log_level) log_write((level), __VA_ARGS__); } while (0)
+
+/* 编译期移除的日志：参数仍参与类型检查并算作已使用，但不会生成代码 */
+#define LOG_NEVER(level, ...) \
+    do { if (0) log_write((level), __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_NEVER(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_NEVER(LOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_NEVER(LOG_LEVEL_WARN, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_NEVER(LOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
+
+#endif /* LOG_H */
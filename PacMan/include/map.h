@@ -0,0 +1,64 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/* 固定地图：代替随机生成的棋盘，用于可复现的性能测试。两种格式：
+ *
+ * 文本格式：每行一行棋盘，每个字符一格，字符与终端渲染相同（见tiles.c）：
+ *   ' ' 空通道  '#' 墙壁  '.' 豆子  'o' 能量豆  'F' 水果
+ *   'P' 玩家出生点（必须恰好一个）  'R' 'B' 'V' 'O' 红/蓝/紫/橙幽灵出生点
+ * 以';'开头的行是注释；宽度取最长的行，较短的行在末尾补空通道。
+ *
+ * 二进制格式（.pmap）：固定的文件头加上按行排列的格子，每格一个字节（CellType值）。
+ * 加载时整个文件映射到内存，只在映射上校验，不复制。 */
+
+#define MAP_MAGIC "PMAP"
+#define MAP_VERSION 1
+#define MAP_BYTE_ORDER 0x01020304u   /* 按本机字节序写入，读入的值不同说明字节序不符 */
+
+/* 二进制文件头，共48字节，格子数据紧跟其后 */
+typedef struct {
+    char magic[4];              /* "PMAP" */
+    uint32_t version;           /* MAP_VERSION */
+    uint32_t byte_order;        /* MAP_BYTE_ORDER */
+    uint32_t width, height;
+    uint32_t player_x, player_y;
+    uint32_t ghost_count;       /* 幽灵出生点数 */
+    uint32_t dot_count;         /* 豆子和能量豆数 */
+    uint32_t reserved;          /* 写0 */
+    uint64_t checksum;          /* 格子数据按8字节一组的FNV-1a校验和 */
+} MapFileHeader;
+
+/* 已加载的地图：格子指向文件映射（二进制）或解析出的缓冲区（文本） */
+typedef struct {
+    int width, height;
+    int player_x, player_y;
+    int ghost_count;
+    int dot_count;
+    const unsigned char *cells;     /* width * height 个CellType值，按行排列 */
+    void *mapping;                  /* 二进制格式：整个文件的映射 */
+    size_t mapping_size;
+    unsigned char *owned;           /* 文本格式：解析出的格子 */
+} GameMap;
+
+/* 加载地图：文件以MAP_MAGIC开头时按二进制格式映射，否则按文本格式解析
+ * 失败时打印错误并返回-1 */
+int map_load(const char *path, GameMap *map);
+int map_load_text(const char *path, GameMap *map);
+int map_load_binary(const char *path, GameMap *map);
+void map_close(GameMap *map);
+
+/* 保存地图，失败时打印错误并返回-1 */
+int map_save_text(const GameMap *map, const char *path);
+int map_save_binary(const GameMap *map, const char *path);
+
+/* 格子数据的校验和，棋盘包（pack.h）也使用 */
+uint64_t map_checksum(const unsigned char *cells, size_t count);
+
+/* 把地图写入棋盘（大小必须相同），返回豆子总数 */
+int map_fill_board(const GameMap *map, CellType **board);
+
+#endif /* MAP_H */
@@ -0,0 +1,55 @@
+#ifndef NAVGRAPH_H
+#define NAVGRAPH_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 路口图：迷宫中大部分格子是只有两个出口的走廊，把路口和死路作为节点，
+ * 走廊压缩成带长度的边，寻路在节点上进行，再换算回格子上的第一步方向。
+ * 图只取决于墙壁：换入棋盘时整体建立，墙壁变化时只重建变化格附近的节点和边。
+ * 相邻的两个节点之间没有走廊格，视为长度为1的隐式边，不占用边记录。 */
+
+/* 追踪距离场的最大搜索半径（步数），更远的幽灵退回到贪心追踪 */
+#define NAVGRAPH_CHASE_RADIUS 128
+
+/* 可走格数至少是节点数的这么多倍时才在图上搜索；随机墙壁生成的开阔棋盘
+ * 大部分格子都是路口，压缩不了多少，逐格搜索反而更快（见 make bench 的 navgraph） */
+#define NAVGRAPH_MIN_COMPRESSION 4
+
+typedef struct NavGraph NavGraph;
+
+size_t navgraph_bytes(int width, int height);
+NavGraph *navgraph_carve(Arena *arena, int width, int height);
+void navgraph_build(NavGraph *graph, CellType **board, const unsigned char *exits);
+void navgraph_cell_changed(NavGraph *graph, CellType **board, const unsigned char *exits,
+                           int x, int y, CellType old_type, CellType new_type);
+
+/* 建好的图的映像（每格归属、节点和边），供关卡缓存保存和载入；
+ * 载入时与当前图的大小不符返回-1 */
+size_t navgraph_image_bytes(const NavGraph *graph);
+void navgraph_save_image(const NavGraph *graph, unsigned char *image);
+int navgraph_load_image(NavGraph *graph, const unsigned char *image, size_t size);
+
+/* 走廊计数（边上的目标数和幽灵数），供状态克隆保存和恢复；
+ * 只在墙壁相同（同一关）的图之间有效，大小为navgraph_counts_bytes */
+size_t navgraph_counts_bytes(const NavGraph *graph);
+void navgraph_save_counts(const NavGraph *graph, void *counts);
+void navgraph_load_counts(NavGraph *graph, const void *counts);
+
+/* 统计信息 */
+int navgraph_node_count(const NavGraph *graph);
+int navgraph_edge_count(const NavGraph *graph);
+int navgraph_is_compact(const NavGraph *graph);
+
+/* 玩家自动驾驶：最近的豆子/能量豆/水果，路上不能有幽灵；找不到时返回DIR_COUNT */
+Direction navgraph_autopilot(NavGraph *graph, CellType **board, const unsigned char *exits,
+                             int x, int y);
+
+/* 追踪：先从玩家位置计算距离场，之后各幽灵只读查询（可并行） */
+void navgraph_chase_field(NavGraph *graph, const unsigned char *exits, int player_x, int player_y,
+                          int radius);
+Direction navgraph_chase_direction(const NavGraph *graph, const unsigned char *exits,
+                                   int x, int y, unsigned int allowed);
+
+#endif /* NAVGRAPH_H */
@@ -0,0 +1,31 @@
+#ifndef NEXTHOP_H
+#define NEXTHOP_H
+
+#include <stddef.h>
+#include "types.h"
+#include "arena.h"
+
+/* 全源最短路下一步表：对每一对(起点, 终点)记录从起点出发的第一步方向，
+ * 每项2位，按终点分行存放。追踪等决策只需一次查表。
+ * 表大小为 格子数² / 4 字节，只在格子数不超过NEXTHOP_MAX_CELLS时建立
+ * （图形界面最大的50 x 40棋盘约1MB），更大的棋盘退回到按需搜索 */
+#define NEXTHOP_MAX_CELLS 2000
+
+typedef struct NextHopTable NextHopTable;
+
+size_t nexthop_bytes(int width, int height);
+NextHopTable *nexthop_carve(Arena *arena, int width, int height);
+void nexthop_build(NextHopTable *table, CellType **board, const unsigned char *exits);
+void nexthop_invalidate(NextHopTable *table);
+int nexthop_is_valid(const NextHopTable *table);
+
+/* 建好的表的映像（连通分量和下一步），供关卡缓存保存和载入；
+ * 载入时大小必须与当前表一致，否则返回-1 */
+size_t nexthop_image_bytes(const NextHopTable *table);
+void nexthop_save_image(const NextHopTable *table, unsigned char *image);
+int nexthop_load_image(NextHopTable *table, const unsigned char *image, size_t size);
+
+/* 从from格走向to格的第一步（只看墙壁）；相同格、不连通或表失效时返回DIR_COUNT */
+Direction nexthop_direction(const NextHopTable *table, int from, int to);
+
+#endif /* NEXTHOP_H */
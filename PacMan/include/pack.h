@@ -0,0 +1,65 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/* 棋盘包：批量预生成并校验过的棋盘存成一个文件，基准测试和批量运行直接载入，
+ * 不再花时间生成。由tools/mapgen.c写出。
+ *
+ * 文件布局（.ppak）：文件头，之后是board_count条索引，最后是各棋盘的格子，
+ * 每格一个字节（CellType值），按行排列。所有棋盘大小和幽灵数相同。
+ * 载入时整个文件映射到内存，校验文件头、索引、每个棋盘的校验和与格子内容，不复制。 */
+
+#define PACK_MAGIC "PPAK"
+#define PACK_VERSION 1
+
+/* 文件头，共32字节 */
+typedef struct {
+    char magic[4];              /* "PPAK" */
+    uint32_t version;           /* PACK_VERSION */
+    uint32_t byte_order;        /* MAP_BYTE_ORDER */
+    uint32_t width, height;
+    uint32_t ghost_count;
+    uint32_t board_count;
+    uint32_t reserved;          /* 写0 */
+} PackFileHeader;
+
+/* 索引项，共24字节 */
+typedef struct {
+    uint64_t offset;            /* 格子数据在文件中的偏移 */
+    uint64_t checksum;          /* 格子数据的校验和（见map_checksum） */
+    uint32_t seed;              /* 生成该棋盘的种子，用level_generate可重新生成 */
+    uint32_t dot_count;         /* 豆子和能量豆数 */
+} PackEntry;
+
+/* 已载入的棋盘包 */
+typedef struct {
+    int width, height;
+    int ghost_count;
+    int board_count;
+    const PackEntry *entries;
+    void *mapping;              /* 整个文件的映射 */
+    size_t mapping_size;
+} BoardPack;
+
+/* 载入棋盘包，失败时打印错误并返回-1 */
+int pack_open(const char *path, BoardPack *pack);
+void pack_close(BoardPack *pack);
+
+/* 第index个棋盘的格子 */
+const unsigned char *pack_board_cells(const BoardPack *pack, int index);
+/* 把第index个棋盘写入棋盘（大小必须相同），返回豆子总数 */
+int pack_fill_board(const BoardPack *pack, int index, CellType **board);
+
+/* 顺序写出棋盘包：先打开，按顺序添加board_count个棋盘，关闭时写入文件头和索引
+ * 失败时打印错误并返回NULL/-1 */
+typedef struct PackWriter PackWriter;
+
+PackWriter *pack_writer_open(const char *path, int width, int height, int ghost_count,
+                             int board_count);
+int pack_writer_add(PackWriter *writer, const unsigned char *cells, unsigned int seed);
+int pack_writer_close(PackWriter *writer);
+
+#endif /* PACK_H */
@@ -0,0 +1,136 @@
+#ifndef PACMAN_H
+#define PACMAN_H
+
+#include <stddef.h>
+
+/* libpacman：把模拟核心（规则、幽灵算法、寻路索引、状态克隆和强化学习环境）
+ * 编成不依赖图形库的 libpacman.so / libpacman.a，供测试框架在进程内嵌入。
+ *
+ * 只有本头文件中的函数是导出的ABI：库内部以 -fvisibility=hidden 编译，
+ * 共享库再用版本脚本（libpacman.map）只导出 pacman_ 前缀的符号并打上版本节点，
+ * 静态库把全部目标文件合并后隐藏其余符号，不会与宿主程序的同名函数冲突。
+ * 句柄都是不透明的；结构体布局属于ABI，改变时提高主版本号（共享库soname随之改变）。
+ *
+ * 引擎只有一个全局状态：同一进程同一时间只能有一个游戏或一批环境。 */
+
+#define PACMAN_VERSION_MAJOR 1
+#define PACMAN_VERSION_MINOR 0
+
+#if defined(PACMAN_BUILD_LIBRARY) && defined(__GNUC__)
+#define PACMAN_API __attribute__((visibility("default")))
+#else
+#define PACMAN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 动作：四个方向、不动、由自动驾驶决定 */
+#define PACMAN_ACTION_UP 0
+#define PACMAN_ACTION_DOWN 1
+#define PACMAN_ACTION_LEFT 2
+#define PACMAN_ACTION_RIGHT 3
+#define PACMAN_ACTION_NONE 4
+#define PACMAN_ACTION_AUTOPILOT 5
+
+/* 幽灵算法 */
+#define PACMAN_GHOSTS_NONE 0
+#define PACMAN_GHOSTS_RANDOM 1
+#define PACMAN_GHOSTS_ZIGZAG 2
+#define PACMAN_GHOSTS_DFS 3
+#define PACMAN_GHOSTS_CLASSIC 4
+
+/* 单元格（pacman_game_cells的取值） */
+#define PACMAN_CELL_EMPTY 0
+#define PACMAN_CELL_WALL 1
+#define PACMAN_CELL_DOT 2
+#define PACMAN_CELL_PLAYER 3
+#define PACMAN_CELL_GHOST_RED 4
+#define PACMAN_CELL_GHOST_BLUE 5
+#define PACMAN_CELL_GHOST_PURPLE 6
+#define PACMAN_CELL_GHOST_ORANGE 7
+#define PACMAN_CELL_POWER_DOT 8
+#define PACMAN_CELL_FRUIT 9
+
+/* 环境观测的平面 */
+#define PACMAN_PLANES 5
+#define PACMAN_PLANE_WALL 0
+#define PACMAN_PLANE_DOT 1
+#define PACMAN_PLANE_POWER 2
+#define PACMAN_PLANE_GHOST 3
+#define PACMAN_PLANE_PLAYER 4
+
+/* 日志级别 */
+#define PACMAN_LOG_DEBUG 0
+#define PACMAN_LOG_INFO 1
+#define PACMAN_LOG_WARN 2
+#define PACMAN_LOG_ERROR 3
+#define PACMAN_LOG_OFF 4
+
+typedef struct PacmanGame PacmanGame;
+typedef struct PacmanSnapshot PacmanSnapshot;
+typedef struct PacmanEnv PacmanEnv;
+
+/* 创建参数，先用pacman_config_init填入默认值 */
+typedef struct {
+    int width, height;
+    int ghosts;
+    int algorithm;                  /* PACMAN_GHOSTS_* */
+    int threads;                    /* 线程数：游戏中并行幽灵决策，环境中按环境并行步进；0为CPU核数 */
+    unsigned int seed;
+    int batch;                      /* 仅环境：环境数 */
+    int max_steps;                  /* 仅环境：每局最多步数，0表示不限 */
+} PacmanConfig;
+
+/* 计数器 */
+typedef struct {
+    int score, lives, level;
+    int dots_collected, total_dots;
+    int moves;
+    int player_x, player_y;
+    int frightened_ticks;
+    int game_over, game_won;
+} PacmanStats;
+
+/* (主版本 << 16) | 次版本，调用者据此检查运行时载入的库 */
+PACMAN_API unsigned int pacman_version(void);
+PACMAN_API void pacman_set_log_level(int level);
+PACMAN_API void pacman_config_init(PacmanConfig *config);
+
+/* 游戏：每步幽灵和玩家各走一次；游戏已结束时返回1
+ * 参数超出范围（网格10 x 8到2048 x 2048，幽灵0到65536个，算法为PACMAN_GHOSTS_*之一；
+ * 环境另需batch >= 1、max_steps >= 0）或内存不足时，创建返回NULL，不向stderr输出，
+ * 诊断信息经日志输出，受pacman_set_log_level控制 */
+PACMAN_API PacmanGame *pacman_game_create(const PacmanConfig *config);
+PACMAN_API void pacman_game_destroy(PacmanGame *game);
+PACMAN_API int pacman_game_step(PacmanGame *game, int action);
+PACMAN_API void pacman_game_reset(PacmanGame *game);
+/* 胜利后进入下一关，没有胜利时返回0 */
+PACMAN_API int pacman_game_next_level(PacmanGame *game);
+PACMAN_API int pacman_game_width(const PacmanGame *game);
+PACMAN_API int pacman_game_height(const PacmanGame *game);
+PACMAN_API void pacman_game_stats(const PacmanGame *game, PacmanStats *stats);
+/* 按行写出每格的PACMAN_CELL_*值，size小于格子数时返回-1 */
+PACMAN_API int pacman_game_cells(const PacmanGame *game, unsigned char *cells, size_t size);
+
+/* 快照：同一关内保存和恢复整个模拟状态（见clone.h），换关后恢复返回-1 */
+PACMAN_API PacmanSnapshot *pacman_snapshot_create(PacmanGame *game);
+PACMAN_API void pacman_snapshot_destroy(PacmanSnapshot *snapshot);
+PACMAN_API int pacman_snapshot_save(PacmanGame *game, PacmanSnapshot *snapshot);
+PACMAN_API int pacman_snapshot_restore(PacmanGame *game, const PacmanSnapshot *snapshot);
+
+/* 强化学习环境（见env.h）：观测每个环境PACMAN_PLANES个宽x高的uint8平面 */
+PACMAN_API PacmanEnv *pacman_env_create(const PacmanConfig *config);
+PACMAN_API void pacman_env_destroy(PacmanEnv *env);
+PACMAN_API size_t pacman_env_observation_bytes(const PacmanEnv *env);
+PACMAN_API int pacman_env_reset(PacmanEnv *env, unsigned int seed, unsigned char *observations);
+PACMAN_API void pacman_env_step(PacmanEnv *env, const unsigned char *actions,
+                                unsigned char *observations, float *rewards,
+                                unsigned char *dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PACMAN_H */
@@ -0,0 +1,22 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/* 线程池并行循环：把[0, count)切成大小为chunk的块，由工作线程和调用线程一起处理
+ * 同一时间只允许一个线程调用parallel_for（模拟线程）；其他后台线程先调用
+ * parallel_serial_thread，之后它的parallel_for直接在本线程串行执行。
+ * 任务中嵌套的parallel_for（如批量环境中每个环境的幽灵决策）在所在线程串行执行 */
+
+#define PARALLEL_MAX_THREADS 64
+
+typedef void (*ParallelRangeFn)(int begin, int end, void *context);
+typedef void (*ParallelWorkerFn)(void *context);
+
+int parallel_init(int threads);
+void parallel_shutdown(void);
+int parallel_thread_count(void);
+void parallel_for(int count, int chunk, ParallelRangeFn fn, void *context);
+void parallel_serial_thread(void);
+/* 在每个工作线程上各执行一次fn（不含调用线程），用于建立或释放线程局部状态 */
+void parallel_each_worker(ParallelWorkerFn fn, void *context);
+
+#endif /* PARALLEL_H */
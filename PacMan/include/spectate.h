@@ -0,0 +1,46 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <stddef.h>
+#include "types.h"
+
+/* 观战服务器：在Unix域套接字上监听，把运行中的游戏（图形界面或无界面）广播给观战客户端。
+ * 连接后先收到流头和一个关键帧（整块棋盘），之后每个tick只收到变化的格子和计数器。
+ * 变化的格子在set_board_cell中记录（没有客户端时不记录），tick结束（commit_game_tick）时
+ * 编码成一帧，所有客户端共用同一份编码。变化的格子超过四分之一时改发关键帧。
+ *
+ * 写入不阻塞：每个客户端有一个预先分配的发送缓冲区，套接字写不进去的数据留在缓冲区里，
+ * 下一个tick再写。缓冲区放不下新的一帧时丢弃这一帧，该客户端改为等缓冲区
+ * 腾出足够空间后重新收到关键帧，慢客户端不会拖慢模拟，也不会收到残缺的流。
+ *
+ * 流格式（整数都是LEB128变长编码，有符号数先做zigzag变换）：
+ *   流头：4字节 "PSPC"，1字节版本 SPECTATE_VERSION
+ *   帧：  帧长度（不含自身），之后是帧内容
+ *   帧内容：类型字节 'K'（关键帧）或 'D'（增量帧），之后是
+ *          tick、关卡、分数、生命、已吃豆子数、豆子总数、玩家x、玩家y、受惊剩余、游戏结束
+ *   关键帧：宽、高，之后是按行排列的格子游程：(游程长度, 1字节CellType) 直到覆盖全部格子
+ *   增量帧：变化格数，之后每格为 (与上一格下标之差（有符号，首格相对-1）, 1字节CellType) */
+
+#define SPECTATE_MAGIC "PSPC"
+#define SPECTATE_VERSION 1
+#define SPECTATE_MAX_CLIENTS 4
+#define SPECTATE_STATS 10
+
+typedef struct Spectator Spectator;
+
+/* 在path上监听（已存在的套接字文件先删除），失败返回NULL */
+Spectator *spectator_create(const char *path, int width, int height);
+void spectator_destroy(Spectator *spectator);
+
+/* 格子变化（由set_board_cell调用） */
+void spectator_cell(Spectator *spectator, int index);
+/* 棋盘被整块替换（换关、恢复克隆），所有客户端下一帧改发关键帧 */
+void spectator_resync(Spectator *spectator);
+/* tick结束：接受新连接，编码本tick的帧并尽量写给各客户端，不阻塞；
+ * board_serial变化（换入了新棋盘）时改发关键帧 */
+void spectator_publish(Spectator *spectator, const GameState *state, unsigned int board_serial);
+
+/* 客户端用：变长整数解码，成功返回读取的字节数，数据不完整返回0 */
+size_t spectate_read_varint(const unsigned char *data, size_t size, unsigned int *value);
+
+#endif /* SPECTATE_H */
@@ -0,0 +1,15 @@
+#ifndef TERM_RENDER_H
+#define TERM_RENDER_H
+
+#include "types.h"
+
+/* ANSI终端渲染器：与上一帧比较，只输出变化的格子，每帧一次write()
+ * 棋盘大于终端时以(focus_x, focus_y)为中心显示一个视口 */
+
+int term_render_init(int fd);
+void term_render_frame(CellType **board, int width, int height,
+                       int focus_x, int focus_y, const char *status_text);
+void term_render_invalidate(void);
+void term_render_shutdown(void);
+
+#endif /* TERM_RENDER_H */
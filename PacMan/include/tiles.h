@@ -0,0 +1,61 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include "types.h"
+
+/* 单元格外观：所有渲染器共用的单元格到字符/颜色映射 */
+typedef struct {
+    char glyph;             /* 终端和文本中使用的字符 */
+    const char *ansi;       /* 终端ANSI SGR颜色参数 */
+    const char *color_name; /* 图形界面使用的颜色名 */
+} TileStyle;
+
+/* 单元格类型数量 */
+#define TILE_TYPE_COUNT (CELL_FRUIT + 1)
+
+/* 调色板：图形界面按名称取色，离屏渲染使用RGB值 */
+typedef enum {
+    TILE_COLOR_BLACK = 0,
+    TILE_COLOR_WHITE,
+    TILE_COLOR_BLUE,
+    TILE_COLOR_YELLOW,
+    TILE_COLOR_RED,
+    TILE_COLOR_PINK,
+    TILE_COLOR_CYAN,
+    TILE_COLOR_PURPLE,
+    TILE_COLOR_ORANGE,
+    TILE_COLOR_DARK_BLUE,
+    TILE_COLOR_LIGHT_BLUE,
+    TILE_COLOR_GREEN,
+    TILE_COLOR_COUNT
+} TileColor;
+
+/* 图块绘制图元：相对格子左上角的实心或空心矩形 */
+typedef struct {
+    unsigned char filled;   /* 1为实心矩形，0为边框 */
+    unsigned char color;    /* TileColor */
+    unsigned char x, y, w, h;
+} TilePrimitive;
+
+#define TILE_MAX_PRIMITIVES 5
+
+/* 单元格的绘制方式：按顺序执行的图元列表 */
+typedef struct {
+    int count;
+    TilePrimitive prims[TILE_MAX_PRIMITIVES];
+} TileShape;
+
+/* 获取单元格类型对应的外观 */
+const TileStyle *get_tile_style(CellType type);
+
+/* 调色板查询 */
+const char *get_tile_color_name(TileColor color);
+const unsigned char *get_tile_color_rgb(TileColor color);
+
+/* 图块形状：静态层（墙壁、豆子、背景）和实体精灵（玩家、幽灵） */
+int tile_is_entity(CellType type);
+const TileShape *get_tile_static_shape(CellType type);
+const TileShape *get_tile_sprite_shape(CellType type);
+const TileShape *get_tile_frightened_shape(void);
+
+#endif /* TILES_H */
@@ -10,6 +10,18 @@
 #define MIN_BOARD_HEIGHT 8
 #define CELL_SIZE 30
 
+/* 无界面模式下允许的最大网格（不受窗口大小限制） */
+#define MAX_HEADLESS_BOARD_WIDTH 2048
+#define MAX_HEADLESS_BOARD_HEIGHT 2048
+
+/* 幽灵数量：无界面模式支持大量幽灵，图形界面受插值渲染表大小限制 */
+#define DEFAULT_GHOST_COUNT 4
+#define MAX_GHOST_COUNT 65536
+#define MAX_GUI_GHOST_COUNT 64
+
+/* 模拟按固定步长推进 */
+#define SIM_TICK_MS 100      /* 模拟tick间隔（毫秒） */
+
 /* 全局变量声明 - 动态网格大小 */
 extern int BOARD_WIDTH;
 extern int BOARD_HEIGHT;
@@ -45,10 +57,44 @@ typedef struct {
     int y;
 } PlayerPosition;
 
+/* 幽灵状态 */
+#define GHOST_STATE_INACTIVE 0
+#define GHOST_STATE_ACTIVE 1
+#define GHOST_STATE_EATEN 2     /* 受惊时被玩家吃掉，暂时离开棋盘，受惊结束后回到出生格 */
+
+/* 受惊模式：吃到能量豆后持续的幽灵移动次数，以及吃掉第一只幽灵的得分（之后每只翻倍） */
+#define FRIGHTENED_MOVES 30
+#define GHOST_EAT_SCORE 200
+
+/* 幽灵表：按字段分开存放（结构体数组转为数组结构体），逐幽灵的循环只访问需要的字段
+ * 所有数组从游戏内存区切分，容量在开局时确定 */
+typedef struct {
+    int count;                      /* 当前幽灵数 */
+    int capacity;                   /* 数组容量 */
+    int *x;
+    int *y;
+    unsigned char *dir;             /* 上一次移动方向（Direction） */
+    unsigned char *algo;            /* 移动算法（ALGO_*） */
+    unsigned char *state;           /* GHOST_STATE_* */
+    unsigned char *type;            /* 棋盘上显示的颜色（CELL_GHOST_*） */
+    unsigned char *under;           /* 幽灵下方的原始单元格类型 */
+    int *home_x;                    /* 出生格，被吃掉后回到这里 */
+    int *home_y;
+    unsigned char *zigzag_steps;    /* 之字形算法：当前方向已走步数 */
+    unsigned char *zigzag_dir;      /* 之字形算法：当前方向 */
+    unsigned char *next_dir;        /* 决策阶段选出的方向，DIR_COUNT表示不动 */
+    unsigned int *rng;              /* 每个幽灵独立的随机数状态，保证并行决策可复现 */
+} GhostRegistry;
+
 /* 游戏状态结构体 */
 typedef struct {
     CellType **board;  /* 改为动态分配的二维数组 */
     PlayerPosition player_pos;
+    PlayerPosition player_spawn;    /* 玩家出生点，开局、换关和死亡后回到这里 */
+    Direction player_dir;           /* 玩家最近一次移动的方向 */
+    int frightened_ticks;           /* 受惊模式剩余的幽灵移动次数，0表示未受惊 */
+    int frightened_combo;           /* 本次受惊已吃掉的幽灵数，决定下一只的得分 */
+    int ghosts_eaten;               /* 被吃掉、等待回到出生格的幽灵数 */
     int dots_collected;
     int total_dots;
     int moves_count;
@@ -60,6 +106,15 @@ typedef struct {
     Direction auto_move_direction;  /* 自动移动方向 */
     int auto_move_enabled;          /* 是否启用自动移动 */
     long last_move_time;            /* 上次移动的时间戳（毫秒） */
+    GhostRegistry ghosts;           /* 幽灵表 */
+    unsigned char *exits;           /* 每格的出口掩码（见exits.h） */
+    struct NavGraph *nav;           /* 路口图（见navgraph.h） */
+    struct NextHopTable *nexthop;   /* 小棋盘的全源下一步表，未启用时为NULL（见nexthop.h） */
+    struct HpaGraph *hpa;           /* 大棋盘的分层寻路图，未启用时为NULL（见hpa.h） */
+    struct BitBoard *bits;          /* 位并行搜索的可走位集，棋盘过宽时为NULL（见bitbfs.h） */
+    struct Journal *journal;        /* 回退日志，未启用时为NULL（见journal.h） */
+    struct Spectator *spectator;    /* 观战服务器，未启用时为NULL（见spectate.h） */
+    struct LiveShm *live_shm;       /* 共享内存状态导出，未启用时为NULL（见liveshm.h） */
 } GameState;
 
 #endif /* TYPES_H */
\ No newline at end of file
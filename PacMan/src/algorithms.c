@@ -1,184 +1,181 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <time.h>
 #include "game.h"
 #include "types.h"
+#include "arena.h"
+#include "algorithms.h"
+#include "ghost.h"
+#include "level.h"
+#include "parallel.h"
+#include "exits.h"
+#include "navgraph.h"
+#include "nexthop.h"
+#include "hpa.h"
+#include "bitbfs.h"
+#include "journal.h"
 
-/* 算法类型枚举 */
-typedef enum {
-    ALGO_NONE = 0,
-    ALGO_RANDOM,
-    ALGO_ZIGZAG,
-    ALGO_DFS
-} AlgorithmType;
+/* 算法类型（取值见algorithms.h中的ALGO_*常量） */
+typedef int AlgorithmType;
 
-/* 幽灵位置结构体 */
-typedef struct {
-    int x, y;
-    CellType type;
-    CellType original_cell; /* 幽灵下方的原始单元格类型 */
-    Direction last_direction;
-    int zigzag_steps;
-    Direction zigzag_direction;
-} GhostInfo;
-
-/* 全局算法状态 */
-static AlgorithmType current_algorithm = ALGO_NONE;
-static GhostInfo ghosts[4];
-static int ghost_count = 0;
-static long last_move_time = 0;
+/* 算法状态：与游戏状态一样每个线程一份，只有移动间隔是全局设置 */
+static __thread AlgorithmType current_algorithm = ALGO_NONE;
+static __thread long last_move_time = 0;
 static int move_interval = 500; /* 幽灵移动间隔（毫秒） */
 
+/* 寻路缓冲区（来自游戏内存区，tick路径上不分配内存） */
+static __thread int *path_queue = NULL;
+static __thread unsigned char *path_first_dir = NULL;  /* 从起点出发到达该格的第一步方向 */
+static __thread unsigned int *path_stamp = NULL;       /* 访问标记，按轮次递增避免每次清空 */
+static __thread unsigned int path_round = 0;
+static __thread int path_width = 0, path_height = 0;
+
+/* 提交阶段的格子占用表：本轮已被某个幽灵占用的格子记为claim_round */
+static __thread unsigned int *claim_stamp = NULL;
+static __thread unsigned int claim_round = 0;
+
+/* 决策阶段每块处理的幽灵数，幽灵数不超过一块时串行决策 */
+#define GHOST_DECIDE_CHUNK 256
+
+/* 经典个性：距离玩家不超过此步数的幽灵改为瞄准各自的目标格，更远的幽灵一律追击玩家 */
+#define CLASSIC_NEAR_RADIUS 8
+#define CLASSIC_AMBUSH_LEAD 4   /* 伏击幽灵瞄准玩家前方的格数 */
+#define CLASSIC_FLANK_LEAD 2    /* 包抄幽灵以玩家前方此格数处为支点 */
+
+/* 受惊模式：距离玩家不超过此步数的幽灵沿共享距离场后退，更远的幽灵随机游荡 */
+#define FRIGHTENED_FLEE_RADIUS 64
+
+/* 决策阶段的共享参数：每个tick在决策前计算一次，决策阶段只读 */
+typedef struct {
+    GhostRegistry *ghosts;
+    PlayerPosition player_pos;
+    PlayerPosition ambush_target;   /* 伏击幽灵的目标格 */
+    PlayerPosition flank_target;    /* 包抄幽灵的目标格 */
+    int frightened;                 /* 受惊模式：所有幽灵后退，不按各自算法 */
+} GhostDecideContext;
+
+/* 方向对应的坐标偏移，下标为Direction */
+static const int dir_dx[4] = {0, 0, -1, 1};
+static const int dir_dy[4] = {-1, 1, 0, 0};
+
+/* 模拟时钟（毫秒） */
+static __thread long sim_clock = 0;
+
 /* 获取当前时间（毫秒） - 简化版本 */
 static long get_current_time_ms(void) {
-    static int counter = 0;
-    counter += 100; /* 每次调用增加100ms，模拟定时器间隔 */
-    return counter;
+    sim_clock += 100; /* 每次调用增加100ms，模拟定时器间隔 */
+    return sim_clock;
 }
 
-/* 初始化幽灵信息 */
-static void init_ghosts_info(void) {
-    ghost_count = 0;
-    
-    for (int y = 0; y < get_board_height(); y++) {
-        for (int x = 0; x < get_board_width(); x++) {
-            CellType cell = get_board_cell(x, y);
-            if (cell == CELL_GHOST_RED || cell == CELL_GHOST_BLUE ||
-                cell == CELL_GHOST_PURPLE || cell == CELL_GHOST_ORANGE) {
-                if (ghost_count < 4) {
-                    ghosts[ghost_count].x = x;
-                    ghosts[ghost_count].y = y;
-                    ghosts[ghost_count].type = cell;
-                    ghosts[ghost_count].original_cell = CELL_EMPTY;
-                    ghosts[ghost_count].last_direction = DIR_RIGHT;
-                    ghosts[ghost_count].zigzag_steps = 0;
-                    ghosts[ghost_count].zigzag_direction = DIR_RIGHT;
-                    ghost_count++;
-                }
-            }
-        }
-    }
+/* 幽灵移动计时的相位：距上一次移动的模拟毫秒数，回退日志据此恢复移动节奏 */
+int get_ghost_timer_phase(void) {
+    return (int)(sim_clock - last_move_time);
 }
 
-/* 检查位置是否有效（幽灵可以移动到的位置） */
-static int is_valid_ghost_move(int x, int y) {
-    if (!is_within_bounds(x, y)) return 0;
-    
-    CellType cell = get_board_cell(x, y);
-    /* 幽灵可以移动到空地、豆子、能量豆和玩家位置，但不能移动到墙壁或其他幽灵 */
-    return (cell == CELL_EMPTY || cell == CELL_DOT || 
-            cell == CELL_POWER_DOT || cell == CELL_PLAYER);
+void set_ghost_timer_phase(int phase) {
+    last_move_time = sim_clock - phase;
 }
 
-/* 获取幽灵的有效移动方向 */
-static int get_ghost_valid_directions(int ghost_x, int ghost_y, Direction *valid_dirs) {
-    int count = 0;
-    Direction dirs[4] = {DIR_UP, DIR_DOWN, DIR_LEFT, DIR_RIGHT};
-    int dx[4] = {0, 0, -1, 1};
-    int dy[4] = {-1, 1, 0, 0};
-    
-    for (int i = 0; i < 4; i++) {
-        int new_x = ghost_x + dx[i];
-        int new_y = ghost_y + dy[i];
-        
-        if (is_valid_ghost_move(new_x, new_y)) {
-            valid_dirs[count++] = dirs[i];
-        }
-    }
-    
-    return count;
+/* 幽灵可走方向的掩码：出口掩码高4位，已排除墙壁、其他幽灵和水果 */
+static unsigned int ghost_exit_mask(const GhostRegistry *g, int i) {
+    return EXIT_GHOST_MASK(g_game_state->exits[g->y[i] * path_width + g->x[i]]);
 }
 
-/* Random算法 - 随机移动幽灵 */
-static Direction random_ghost_algorithm(int ghost_index) {
-    Direction valid_dirs[4];
-    int count = get_ghost_valid_directions(ghosts[ghost_index].x, ghosts[ghost_index].y, valid_dirs);
+/* Random算法 - 随机移动幽灵：在可走方向列表中查表选取 */
+static Direction random_ghost_algorithm(GhostRegistry *g, int i) {
+    const ExitDirList *list = &exit_dir_lists[ghost_exit_mask(g, i)];
     
-    if (count == 0) {
-        return ghosts[ghost_index].last_direction;
+    if (list->count == 0) {
+        return DIR_COUNT;
     }
     
-    int index = rand() % count;
-    return valid_dirs[index];
+    return (Direction)list->dirs[level_rand(&g->rng[i]) % list->count];
 }
 
-/* Zig-Zag算法 - 之字形移动 */
-static Direction zigzag_ghost_algorithm(int ghost_index) {
-    Direction valid_dirs[4];
-    int count = get_ghost_valid_directions(ghosts[ghost_index].x, ghosts[ghost_index].y, valid_dirs);
+/* Zig-Zag算法 - 之字形移动：方向是否可走由掩码位直接判断 */
+static Direction zigzag_ghost_algorithm(GhostRegistry *g, int i) {
+    unsigned int mask = ghost_exit_mask(g, i);
     
-    if (count == 0) {
-        return ghosts[ghost_index].last_direction;
-    }
-    
-    /* 检查当前方向是否有效 */
-    int current_valid = 0;
-    for (int i = 0; i < count; i++) {
-        if (valid_dirs[i] == ghosts[ghost_index].zigzag_direction) {
-            current_valid = 1;
-            break;
-        }
+    if (mask == 0) {
+        return DIR_COUNT;
     }
     
     /* 如果当前方向有效且未达到最大步数，继续当前方向 */
-    if (current_valid && ghosts[ghost_index].zigzag_steps < 5) {
-        ghosts[ghost_index].zigzag_steps++;
-        return ghosts[ghost_index].zigzag_direction;
+    if ((mask & EXIT_BIT(g->zigzag_dir[i])) && g->zigzag_steps[i] < 5) {
+        g->zigzag_steps[i]++;
+        return (Direction)g->zigzag_dir[i];
     }
     
     /* 需要改变方向 */
-    ghosts[ghost_index].zigzag_steps = 1;
+    g->zigzag_steps[i] = 1;
     
     /* 尝试垂直方向切换 */
+    unsigned int coin = level_rand(&g->rng[i]) % 2;
     Direction new_direction;
-    if (ghosts[ghost_index].zigzag_direction == DIR_RIGHT || 
-        ghosts[ghost_index].zigzag_direction == DIR_LEFT) {
-        new_direction = (rand() % 2) ? DIR_UP : DIR_DOWN;
+    if (g->zigzag_dir[i] == DIR_RIGHT || g->zigzag_dir[i] == DIR_LEFT) {
+        new_direction = coin ? DIR_UP : DIR_DOWN;
     } else {
-        new_direction = (rand() % 2) ? DIR_LEFT : DIR_RIGHT;
+        new_direction = coin ? DIR_LEFT : DIR_RIGHT;
     }
     
-    /* 检查新方向是否有效 */
-    for (int i = 0; i < count; i++) {
-        if (valid_dirs[i] == new_direction) {
-            ghosts[ghost_index].zigzag_direction = new_direction;
-            return new_direction;
-        }
+    /* 如果新方向无效，随机选择一个有效方向 */
+    if (!(mask & EXIT_BIT(new_direction))) {
+        const ExitDirList *list = &exit_dir_lists[mask];
+        new_direction = (Direction)list->dirs[level_rand(&g->rng[i]) % list->count];
     }
     
-    /* 如果新方向无效，随机选择一个有效方向 */
-    int index = rand() % count;
-    ghosts[ghost_index].zigzag_direction = valid_dirs[index];
-    return valid_dirs[index];
+    g->zigzag_dir[i] = (unsigned char)new_direction;
+    return new_direction;
 }
 
-/* DFS算法 - 追踪玩家 */
-static Direction dfs_ghost_algorithm(int ghost_index) {
-    PlayerPosition player_pos = get_player_position();
-    int ghost_x = ghosts[ghost_index].x;
-    int ghost_y = ghosts[ghost_index].y;
+/* DFS算法 - 追踪玩家：小棋盘直接查下一步表；大棋盘沿分层图距离场接近；
+ * 走廊较多的棋盘上沿路口图距离场走最短路；其余棋盘沿位并行搜索的逐格距离场接近；
+ * 都不适用时按曼哈顿距离贪心接近 */
+static Direction dfs_ghost_algorithm(const GhostRegistry *g, int i, PlayerPosition player_pos) {
+    int ghost_x = g->x[i];
+    int ghost_y = g->y[i];
+    unsigned int mask = ghost_exit_mask(g, i);
+    const ExitDirList *list = &exit_dir_lists[mask];
+    
+    if (list->count == 0) {
+        return DIR_COUNT;
+    }
+    
+    /* 最短路的第一步被其他幽灵挡住时按贪心另选方向 */
+    int width = get_board_width();
+    Direction hop = nexthop_direction(g_game_state->nexthop, ghost_y * width + ghost_x,
+                                      player_pos.y * width + player_pos.x);
+    if (hop != DIR_COUNT && (mask & EXIT_BIT(hop))) {
+        return hop;
+    }
+    
+    Direction path = hpa_chase_direction(g_game_state->hpa, ghost_x, ghost_y, mask);
+    if (path != DIR_COUNT) {
+        return path;
+    }
     
-    Direction valid_dirs[4];
-    int count = get_ghost_valid_directions(ghost_x, ghost_y, valid_dirs);
+    Direction chase = navgraph_chase_direction(g_game_state->nav, g_game_state->exits,
+                                               ghost_x, ghost_y, mask);
+    if (chase != DIR_COUNT) {
+        return chase;
+    }
     
-    if (count == 0) {
-        return ghosts[ghost_index].last_direction;
+    Direction step = bitbfs_chase_direction(g_game_state->bits, player_pos.x, player_pos.y,
+                                            ghost_x, ghost_y, mask);
+    if (step != DIR_COUNT) {
+        return step;
     }
     
     /* 计算到玩家的距离，选择最接近玩家的方向 */
-    Direction best_dir = valid_dirs[0];
+    Direction best_dir = (Direction)list->dirs[0];
     int min_distance = 9999;
     
-    int dx[4] = {0, 0, -1, 1};
-    int dy[4] = {-1, 1, 0, 0};
-    
-    for (int i = 0; i < count; i++) {
-        Direction dir = valid_dirs[i];
-        int dir_index = (dir == DIR_UP) ? 0 : (dir == DIR_DOWN) ? 1 : 
-                       (dir == DIR_LEFT) ? 2 : 3;
-        
-        int new_x = ghost_x + dx[dir_index];
-        int new_y = ghost_y + dy[dir_index];
+    for (int k = 0; k < list->count; k++) {
+        Direction dir = (Direction)list->dirs[k];
+        int new_x = ghost_x + dir_dx[dir];
+        int new_y = ghost_y + dir_dy[dir];
         
         int distance = abs(new_x - player_pos.x) + abs(new_y - player_pos.y);
         
@@ -191,89 +188,232 @@ static Direction dfs_ghost_algorithm(int ghost_index) {
     return best_dir;
 }
 
-/* 移动单个幽灵 */
-static void move_ghost(int ghost_index) {
-    if (ghost_index >= ghost_count) return;
+/* 朝目标格贪心移动：在可走方向中选直线距离最近的一格（与原版街机的目标格规则相同） */
+static Direction steer_to_target(int x, int y, unsigned int mask, PlayerPosition target) {
+    const ExitDirList *list = &exit_dir_lists[mask];
+    Direction best = DIR_COUNT;
+    long best_distance = 0;
+    
+    for (int k = 0; k < list->count; k++) {
+        Direction dir = (Direction)list->dirs[k];
+        long ddx = x + dir_dx[dir] - target.x;
+        long ddy = y + dir_dy[dir] - target.y;
+        long distance = ddx * ddx + ddy * ddy;
+        if (best == DIR_COUNT || distance < best_distance) {
+            best = dir;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+/* 朝目标格移动：有下一步表时查表走最短路的第一步；目标是墙、不连通或第一步被其他幽灵
+ * 挡住时退回贪心 */
+static Direction route_to_target(int x, int y, unsigned int mask, PlayerPosition target) {
+    int width = get_board_width();
+    Direction hop = nexthop_direction(g_game_state->nexthop, y * width + x,
+                                      target.y * width + target.x);
+    if (hop != DIR_COUNT && (mask & EXIT_BIT(hop))) {
+        return hop;
+    }
+    return steer_to_target(x, y, mask, target);
+}
+
+/* 幽灵到玩家的步数，取自本tick的共享距离场；超出距离场半径或不可达时返回-1 */
+static int player_field_distance(int x, int y) {
+    return g_game_state->bits ? bitbfs_distance(g_game_state->bits, x, y) : -1;
+}
+
+/* 后退：选离玩家最远的相邻格，距离场之外的格子视为最远 */
+static Direction flee_player(int x, int y, unsigned int mask) {
+    const ExitDirList *list = &exit_dir_lists[mask];
+    Direction best = DIR_COUNT;
+    int best_distance = -1;
+    
+    for (int k = 0; k < list->count; k++) {
+        Direction dir = (Direction)list->dirs[k];
+        int distance = player_field_distance(x + dir_dx[dir], y + dir_dy[dir]);
+        if (distance < 0) distance = INT_MAX;
+        if (distance > best_distance) {
+            best = dir;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+/* 经典个性：红色直接追击；紫色瞄准玩家前方伏击；蓝色以红色幽灵为参照从另一侧包抄；
+ * 橙色靠近玩家时后退。远处的幽灵都按追踪算法接近，靠近后才按个性行动
+ * （伏击和包抄有下一步表时沿最短路走向目标格），
+ * 所有距离和方向都来自本tick共享的距离场（分层图的分簇展开也在决策前完成），
+ * 决策时只读共享状态，不为单个幽灵搜索 */
+static Direction classic_ghost_algorithm(const GhostRegistry *g, int i,
+                                         const GhostDecideContext *ctx) {
+    int x = g->x[i], y = g->y[i];
+    unsigned int mask = ghost_exit_mask(g, i);
+    if (mask == 0) return DIR_COUNT;
+    
+    int distance = player_field_distance(x, y);
+    if (g->type[i] == CELL_GHOST_RED || distance < 0 || distance > CLASSIC_NEAR_RADIUS) {
+        return dfs_ghost_algorithm(g, i, ctx->player_pos);
+    }
     
-    Direction move_dir;
+    switch (g->type[i]) {
+        case CELL_GHOST_PURPLE:
+            return route_to_target(x, y, mask, ctx->ambush_target);
+        case CELL_GHOST_BLUE:
+            return route_to_target(x, y, mask, ctx->flank_target);
+        case CELL_GHOST_ORANGE:
+            return flee_player(x, y, mask);
+        default:
+            return dfs_ghost_algorithm(g, i, ctx->player_pos);
+    }
+}
+
+/* 把目标格限制在棋盘内 */
+static PlayerPosition clamp_target(int x, int y) {
+    PlayerPosition target;
+    target.x = x < 0 ? 0 : (x >= path_width ? path_width - 1 : x);
+    target.y = y < 0 ? 0 : (y >= path_height ? path_height - 1 : y);
+    return target;
+}
+
+/* 每个tick计算一次经典个性的共享目标：伏击目标在玩家朝向前方；包抄目标以玩家前方的
+ * 支点为中心，与离玩家最近的红色幽灵对称（没有红色幽灵时就是支点本身） */
+static void classic_prepare_targets(GhostDecideContext *ctx) {
+    const GhostRegistry *g = ctx->ghosts;
+    PlayerPosition p = ctx->player_pos;
+    Direction dir = g_game_state->player_dir;
+    
+    ctx->ambush_target = clamp_target(p.x + dir_dx[dir] * CLASSIC_AMBUSH_LEAD,
+                                      p.y + dir_dy[dir] * CLASSIC_AMBUSH_LEAD);
+    
+    int pivot_x = p.x + dir_dx[dir] * CLASSIC_FLANK_LEAD;
+    int pivot_y = p.y + dir_dy[dir] * CLASSIC_FLANK_LEAD;
+    int red = -1, red_distance = 0;
+    for (int i = 0; i < g->count; i++) {
+        if (g->type[i] != CELL_GHOST_RED || g->state[i] != GHOST_STATE_ACTIVE) continue;
+        int distance = abs(g->x[i] - p.x) + abs(g->y[i] - p.y);
+        if (red < 0 || distance < red_distance) {
+            red = i;
+            red_distance = distance;
+        }
+    }
+    ctx->flank_target = red < 0 ? clamp_target(pivot_x, pivot_y)
+                                : clamp_target(2 * pivot_x - g->x[red], 2 * pivot_y - g->y[red]);
+}
+
+/* 受惊：距离场内的幽灵远离玩家，距离场外的幽灵随机游荡 */
+static Direction frightened_ghost_algorithm(GhostRegistry *g, int i) {
+    unsigned int mask = ghost_exit_mask(g, i);
+    if (mask == 0) return DIR_COUNT;
+    if (player_field_distance(g->x[i], g->y[i]) < 0) return random_ghost_algorithm(g, i);
+    return flee_player(g->x[i], g->y[i], mask);
+}
+
+/* 为单个幽灵选择下一步方向：只读棋盘，只写该幽灵自己的字段 */
+static Direction decide_ghost(GhostRegistry *g, int i, const GhostDecideContext *ctx) {
+    if (ctx->frightened) return frightened_ghost_algorithm(g, i);
     
-    switch (current_algorithm) {
+    switch (g->algo[i]) {
         case ALGO_RANDOM:
-            move_dir = random_ghost_algorithm(ghost_index);
-            break;
+            return random_ghost_algorithm(g, i);
         case ALGO_ZIGZAG:
-            move_dir = zigzag_ghost_algorithm(ghost_index);
-            break;
+            return zigzag_ghost_algorithm(g, i);
         case ALGO_DFS:
-            move_dir = dfs_ghost_algorithm(ghost_index);
-            break;
+            return dfs_ghost_algorithm(g, i, ctx->player_pos);
+        case ALGO_CLASSIC:
+            return classic_ghost_algorithm(g, i, ctx);
         default:
-            return;
+            return DIR_COUNT;
     }
-    
-    /* 计算新位置 */
-    int dx = (move_dir == DIR_RIGHT) ? 1 : (move_dir == DIR_LEFT) ? -1 : 0;
-    int dy = (move_dir == DIR_DOWN) ? 1 : (move_dir == DIR_UP) ? -1 : 0;
-    
-    int old_x = ghosts[ghost_index].x;
-    int old_y = ghosts[ghost_index].y;
-    int new_x = old_x + dx;
-    int new_y = old_y + dy;
-    
-    /* 验证移动是否有效 */
-    if (!is_valid_ghost_move(new_x, new_y)) {
-        return;
+}
+
+/* 决策阶段：对一段幽灵并行计算方向，此时棋盘保持本tick开始时的状态 */
+static void decide_ghost_range(int begin, int end, void *context) {
+    GhostDecideContext *ctx = (GhostDecideContext*)context;
+    GhostRegistry *g = ctx->ghosts;
+    
+    for (int i = begin; i < end; i++) {
+        g->next_dir[i] = (g->state[i] == GHOST_STATE_ACTIVE)
+                         ? (unsigned char)decide_ghost(g, i, ctx)
+                         : (unsigned char)DIR_COUNT;
     }
-    
-    /* 检查新位置是否与玩家碰撞 */
-    PlayerPosition player_pos = get_player_position();
-    if (new_x == player_pos.x && new_y == player_pos.y) {
-        /* 幽灵抓到玩家，触发游戏结束 */
-        handle_player_death();
-        return;
+}
+
+/* 提交阶段：按幽灵编号顺序执行移动，目标格已被编号更小的幽灵占用时原地不动
+ * 决策阶段已排除墙壁和其他幽灵所在格，这里只需处理幽灵之间的目标冲突 */
+static void commit_ghost_moves(GhostRegistry *g) {
+    if (++claim_round == 0) {
+        memset(claim_stamp, 0, (size_t)path_width * path_height * sizeof(unsigned int));
+        claim_round = 1;
     }
     
-    /* 移动幽灵 */
-    CellType new_cell = get_board_cell(new_x, new_y);
-    
-    /* 恢复旧位置的原始内容 */
-    set_board_cell(old_x, old_y, ghosts[ghost_index].original_cell);
-    
-    /* 保存新位置的原始内容 */
-    ghosts[ghost_index].original_cell = new_cell;
-    
-    /* 设置新位置为幽灵 */
-    set_board_cell(new_x, new_y, ghosts[ghost_index].type);
-    
-    /* 更新幽灵信息 */
-    ghosts[ghost_index].x = new_x;
-    ghosts[ghost_index].y = new_y;
-    ghosts[ghost_index].last_direction = move_dir;
+    for (int i = 0; i < g->count; i++) {
+        Direction move_dir = (Direction)g->next_dir[i];
+        if (move_dir == DIR_COUNT) continue;
+        
+        int old_x = g->x[i];
+        int old_y = g->y[i];
+        int new_x = old_x + dir_dx[move_dir];
+        int new_y = old_y + dir_dy[move_dir];
+        
+        unsigned int *claim = &claim_stamp[new_y * path_width + new_x];
+        if (*claim == claim_round) continue;
+        *claim = claim_round;
+        
+        /* 检查新位置是否与玩家碰撞（玩家可能已在本轮复位） */
+        PlayerPosition player_pos = get_player_position();
+        if (new_x == player_pos.x && new_y == player_pos.y) {
+            /* 受惊的幽灵撞上玩家被吃掉，否则幽灵抓到玩家 */
+            if (is_frightened()) eat_ghost(i);
+            else handle_player_death();
+            continue;
+        }
+        
+        /* 移动幽灵 */
+        CellType new_cell = get_board_cell(new_x, new_y);
+        
+        /* 恢复旧位置的原始内容（玩家复活在幽灵所在格时保留玩家） */
+        if (get_board_cell(old_x, old_y) == (CellType)g->type[i]) {
+            set_board_cell(old_x, old_y, (CellType)g->under[i]);
+        }
+        
+        /* 保存新位置的原始内容 */
+        g->under[i] = (unsigned char)new_cell;
+        
+        /* 设置新位置为幽灵 */
+        set_board_cell(new_x, new_y, (CellType)g->type[i]);
+        
+        /* 更新幽灵信息 */
+        g->x[i] = new_x;
+        g->y[i] = new_y;
+        g->dir[i] = (unsigned char)move_dir;
+    }
 }
 
 /* 设置当前算法 */
 void set_algorithm(int algorithm_type) {
     current_algorithm = (AlgorithmType)algorithm_type;
     
-    /* 初始化幽灵信息 */
-    init_ghosts_info();
-    
-    /* 重置算法状态 */
-    for (int i = 0; i < ghost_count; i++) {
-        ghosts[i].zigzag_steps = 0;
-        ghosts[i].zigzag_direction = DIR_RIGHT;
+    /* 所有幽灵切换到新算法并重置算法状态 */
+    if (g_game_state) {
+        ghost_registry_set_algorithm(&g_game_state->ghosts, current_algorithm);
     }
     
-    /* 初始化随机数种子 */
-    srand((unsigned int)time(NULL));
-    
     /* 重置移动时间 */
     last_move_time = get_current_time_ms();
+    
+    /* 上一个算法留下的距离场（如经典个性的近距离场）不再更新，丢弃 */
+    if (g_game_state) bitbfs_discard_field(g_game_state->bits);
+    
+    /* 算法状态整体改变，回退不跨越此处 */
+    if (g_game_state && g_game_state->journal) journal_reset(g_game_state->journal);
 }
 
 /* 更新幽灵移动（由定时器调用） */
 void update_ghost_movement(void) {
-    if (current_algorithm == ALGO_NONE) {
+    if (current_algorithm == ALGO_NONE || !g_game_state) {
         return;
     }
     
@@ -282,14 +422,58 @@ void update_ghost_movement(void) {
     
     /* 检查是否到了移动时间 */
     if (time_diff >= move_interval) {
-        /* 重新初始化幽灵信息（防止幽灵丢失） */
-        init_ghosts_info();
+        GhostDecideContext ctx;
+        ctx.ghosts = &g_game_state->ghosts;
+        ctx.player_pos = get_player_position();
+        ctx.frightened = is_frightened();
+        
+        /* 墙壁变化后在决策之前重建下一步表 */
+        if (g_game_state->nexthop && !nexthop_is_valid(g_game_state->nexthop)) {
+            nexthop_build(g_game_state->nexthop, g_game_state->board, g_game_state->exits);
+        }
+        
+        /* 有追踪幽灵时先从玩家位置计算一次距离场，决策阶段只读 */
+        size_t count = (size_t)ctx.ghosts->count;
+        int classic = !ctx.frightened && memchr(ctx.ghosts->algo, ALGO_CLASSIC, count) != NULL;
+        if (ctx.frightened) {
+            /* 受惊模式：所有幽灵共用一个距离场后退，玩家不动时沿用上一次的结果 */
+            if (g_game_state->bits) {
+                bitbfs_chase_field(g_game_state->bits, ctx.player_pos.x, ctx.player_pos.y,
+                                   FRIGHTENED_FLEE_RADIUS);
+            }
+        } else if (classic || memchr(ctx.ghosts->algo, ALGO_DFS, count)) {
+            if (g_game_state->hpa) {
+                hpa_chase_field(g_game_state->hpa, g_game_state->board, g_game_state->exits,
+                                ctx.player_pos.x, ctx.player_pos.y);
+                hpa_chase_resolve(g_game_state->hpa, ctx.ghosts->x, ctx.ghosts->y,
+                                  ctx.ghosts->count);
+            } else if (!g_game_state->nexthop && navgraph_is_compact(g_game_state->nav)) {
+                navgraph_chase_field(g_game_state->nav, g_game_state->exits,
+                                     ctx.player_pos.x, ctx.player_pos.y, NAVGRAPH_CHASE_RADIUS);
+                bitbfs_discard_field(g_game_state->bits);
+            } else if (!g_game_state->nexthop && g_game_state->bits) {
+                bitbfs_chase_field(g_game_state->bits, ctx.player_pos.x, ctx.player_pos.y,
+                                   BITBFS_CHASE_RADIUS);
+            }
+        }
         
-        /* 移动所有幽灵 */
-        for (int i = 0; i < ghost_count; i++) {
-            move_ghost(i);
+        /* 经典个性：共享的目标格，以及判断远近、胆小幽灵后退用的近距离场
+         * （上面已算出更大半径的距离场时直接沿用） */
+        if (classic) {
+            classic_prepare_targets(&ctx);
+            if (g_game_state->bits) {
+                bitbfs_chase_field(g_game_state->bits, ctx.player_pos.x, ctx.player_pos.y,
+                                   CLASSIC_NEAR_RADIUS);
+            }
         }
         
+        /* 两阶段更新：先基于同一棋盘快照并行决策，再按编号顺序串行提交，
+         * 结果与线程数无关 */
+        if (g_game_state->journal) journal_active_ghosts(g_game_state->journal, ctx.ghosts);
+        parallel_for(ctx.ghosts->count, GHOST_DECIDE_CHUNK, decide_ghost_range, &ctx);
+        commit_ghost_moves(ctx.ghosts);
+        update_frightened_mode();
+        
         last_move_time = current_time;
     }
 }
@@ -299,10 +483,22 @@ int is_algorithm_enabled(void) {
     return current_algorithm != ALGO_NONE;
 }
 
+/* 获取当前算法 */
+int get_algorithm(void) {
+    return current_algorithm;
+}
+
 /* 停止算法 */
 void stop_algorithm(void) {
     current_algorithm = ALGO_NONE;
-    ghost_count = 0;
+    if (g_game_state) {
+        ghost_registry_set_algorithm(&g_game_state->ghosts, ALGO_NONE);
+    }
+}
+
+/* 恢复当前算法，不改动幽灵表和计时（由调用者连同幽灵状态一起恢复） */
+void resume_algorithm(int algorithm_type) {
+    current_algorithm = (AlgorithmType)algorithm_type;
 }
 
 /* 获取当前算法名称 */
@@ -314,6 +510,8 @@ const char* get_algorithm_name(void) {
             return "Zig-Zag Ghost";
         case ALGO_DFS:
             return "Hunting Ghost";
+        case ALGO_CLASSIC:
+            return "Classic Ghosts";
         default:
             return "None";
     }
@@ -327,4 +525,90 @@ void set_ghost_move_interval(int interval_ms) {
 /* 获取幽灵移动间隔 */
 int get_ghost_move_interval(void) {
     return move_interval;
+}
+
+/* 算法模块所需的内存区字节数 */
+size_t algorithms_arena_bytes(int width, int height) {
+    size_t cells = (size_t)width * height;
+    return arena_align(cells * sizeof(int)) +
+           arena_align(cells) +
+           2 * arena_align(cells * sizeof(unsigned int));
+}
+
+/* 从游戏内存区切分算法模块的缓冲区 */
+int algorithms_init_arena(Arena *arena, int width, int height) {
+    size_t cells = (size_t)width * height;
+    path_queue = (int*)arena_alloc(arena, cells * sizeof(int));
+    path_first_dir = (unsigned char*)arena_alloc(arena, cells);
+    path_stamp = (unsigned int*)arena_alloc(arena, cells * sizeof(unsigned int));
+    claim_stamp = (unsigned int*)arena_alloc(arena, cells * sizeof(unsigned int));
+    path_round = 0;
+    claim_round = 0;
+    path_width = width;
+    path_height = height;
+    return (path_queue && path_first_dir && path_stamp && claim_stamp) ? 0 : -1;
+}
+
+/* 判断单元格是否是玩家要收集的目标 */
+static int is_autopilot_target(CellType cell) {
+    return cell == CELL_DOT || cell == CELL_POWER_DOT || cell == CELL_FRUIT;
+}
+
+/* 玩家自动驾驶：搜索最近的豆子，避开墙壁和幽灵，返回第一步方向
+ * 大棋盘在分层图上搜索，走廊较多的棋盘在路口图上搜索，开阔棋盘逐格广度优先搜索
+ * 找不到可达的豆子时返回DIR_COUNT */
+Direction autopilot_next_direction(void) {
+    if (!g_game_state || !path_queue ||
+        path_width != get_board_width() || path_height != get_board_height()) {
+        return DIR_COUNT;
+    }
+
+    PlayerPosition start = get_player_position();
+    if (g_game_state->hpa) {
+        return hpa_autopilot(g_game_state->hpa, g_game_state->board, g_game_state->exits,
+                             start.x, start.y);
+    }
+    if (navgraph_is_compact(g_game_state->nav)) {
+        return navgraph_autopilot(g_game_state->nav, g_game_state->board, g_game_state->exits,
+                                  start.x, start.y);
+    }
+
+    /* 轮次计数回绕时清空访问标记 */
+    if (++path_round == 0) {
+        memset(path_stamp, 0, (size_t)path_width * path_height * sizeof(unsigned int));
+        path_round = 1;
+    }
+
+    /* 棋盘格子连续存放，按下标直接访问；相邻格下标偏移，下标为Direction */
+    const CellType *cells = g_game_state->board[0];
+    const unsigned char *exits = g_game_state->exits;
+    const int offset[4] = {-path_width, path_width, -1, 1};
+
+    int head = 0, tail = 0;
+    int start_index = start.y * path_width + start.x;
+    path_stamp[start_index] = path_round;
+    path_queue[tail++] = start_index;
+
+    while (head < tail) {
+        int index = path_queue[head++];
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[index])];
+
+        for (int k = 0; k < list->count; k++) {
+            int dir = list->dirs[k];
+            int next = index + offset[dir];
+            if (path_stamp[next] == path_round) continue;
+
+            CellType cell = cells[next];
+            if (is_ghost_cell(cell)) continue;
+
+            path_stamp[next] = path_round;
+            path_first_dir[next] = (index == start_index) ? (unsigned char)dir : path_first_dir[index];
+            if (is_autopilot_target(cell)) {
+                return (Direction)path_first_dir[next];
+            }
+            path_queue[tail++] = next;
+        }
+    }
+
+    return DIR_COUNT;
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "log.h"
+
+/* 对齐粒度 */
+#define ARENA_ALIGNMENT 64
+
+/* 引擎代码累计的堆分配次数 */
+static unsigned long alloc_count = 0;
+
+/* 将大小向上对齐到缓存行 */
+size_t arena_align(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/* 一次性分配整块内存 */
+int arena_init(Arena *arena, size_t size) {
+    arena->size = arena_align(size);
+    arena->used = 0;
+    arena->base = (unsigned char*)heap_alloc(arena->size + ARENA_ALIGNMENT);
+    if (!arena->base) {
+        arena->size = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/* 释放整块内存 */
+void arena_destroy(Arena *arena) {
+    heap_free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+/* 从内存区切分一块清零的内存，空间不足时返回NULL */
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t offset = arena_align(arena->used);
+    size_t aligned = arena_align(size);
+    if (!arena->base || offset + aligned > arena->size) {
+        return NULL;
+    }
+
+    /* 基址按缓存行对齐，保证切分出的每块都对齐 */
+    unsigned char *aligned_base = (unsigned char*)
+        (((size_t)arena->base + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1));
+    void *ptr = aligned_base + offset;
+    memset(ptr, 0, aligned);
+    arena->used = offset + aligned;
+    return ptr;
+}
+
+/* 记录当前使用位置 */
+size_t arena_mark(const Arena *arena) {
+    return arena->used;
+}
+
+/* 回退到之前记录的位置 */
+void arena_reset(Arena *arena, size_t mark) {
+    if (mark <= arena->used) {
+        arena->used = mark;
+    }
+}
+
+#ifdef PACMAN_ALLOC_CHECK
+/* 分配检查构建用 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc 链接（见 make alloc_check）：
+ * 各目标文件中的malloc/calloc/realloc调用都改为调用这里的包装，绕过heap_alloc的直接调用也会计数 */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+/* 计数的malloc（分配检查构建中由malloc的包装计数） */
+void *heap_alloc(size_t size) {
+#ifndef PACMAN_ALLOC_CHECK
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+#endif
+    return malloc(size);
+}
+
+/* 计数的calloc */
+void *heap_calloc(size_t count, size_t size) {
+#ifndef PACMAN_ALLOC_CHECK
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+#endif
+    return calloc(count, size);
+}
+
+/* 释放堆内存 */
+void heap_free(void *ptr) {
+    free(ptr);
+}
+
+/* 获取累计堆分配次数 */
+unsigned long heap_alloc_count(void) {
+    return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+/* 报告指定路径上发生的堆分配 */
+void heap_alloc_check(unsigned long start_count, const char *path) {
+    unsigned long count = heap_alloc_count() - start_count;
+    if (count != 0) {
+        LOG_ERROR("分配检查失败: %s 发生了 %lu 次堆分配", path, count);
+    }
+}
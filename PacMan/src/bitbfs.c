@@ -0,0 +1,233 @@
+#include <stdint.h>
+#include <string.h>
+#include "bitbfs.h"
+#include "exits.h"
+
+static const int bitbfs_dx[4] = {0, 0, -1, 1};
+static const int bitbfs_dy[4] = {-1, 1, 0, 0};
+
+struct BitBoard {
+    int width, height;
+    int words;                  /* 每行的字数 */
+    uint64_t *open;             /* 可走格（非墙），行尾多余的位恒为0 */
+    uint64_t *visited;          /* 最近一次搜索到达的格子 */
+    uint64_t *grow;             /* 下一层候选格的累积，不用时全为0 */
+    int *touched;               /* 本层候选格非零的字，(行 << 6) | 列 */
+    int *frontier[2];           /* 当前波前和下一层波前的字，格式同上，交替使用 */
+    uint64_t *frontier_bits[2]; /* 波前各字中的格子 */
+    int *dist;                  /* 距离，只有已访问格有效 */
+    int seen_top, seen_bottom;  /* 已访问位可能非零的行范围，下一次搜索前清空 */
+    int source_x, source_y, radius;
+    int ready;                  /* 距离场与当前墙壁一致 */
+};
+
+/* 最低位的1的位置，v不为0 */
+static int bitbfs_lowest(uint64_t v) {
+#ifdef __GNUC__
+    return __builtin_ctzll(v);
+#else
+    static const unsigned char table[64] = {
+         0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+    };
+    return table[((v & (~v + 1)) * 0x03F79D71B4CB0A89ULL) >> 58];
+#endif
+}
+
+/* 位集所需的内存区字节数，棋盘过宽时为0 */
+size_t bitbfs_bytes(int width, int height) {
+    if (width > BITBFS_MAX_WIDTH) return 0;
+    size_t words = (size_t)((width + 63) / 64) * height;
+    return arena_align(sizeof(BitBoard)) +
+           5 * arena_align(words * sizeof(uint64_t)) +
+           3 * arena_align(words * sizeof(int)) +
+           arena_align((size_t)width * height * sizeof(int));
+}
+
+/* 从内存区切分位集，棋盘过宽或分配失败时返回NULL */
+BitBoard *bitbfs_carve(Arena *arena, int width, int height) {
+    if (width > BITBFS_MAX_WIDTH) return NULL;
+
+    BitBoard *b = (BitBoard*)arena_alloc(arena, sizeof(BitBoard));
+    if (!b) return NULL;
+    b->width = width;
+    b->height = height;
+    b->words = (width + 63) / 64;
+    size_t words = (size_t)b->words * height;
+    b->open = (uint64_t*)arena_alloc(arena, words * sizeof(uint64_t));
+    b->visited = (uint64_t*)arena_alloc(arena, words * sizeof(uint64_t));
+    b->grow = (uint64_t*)arena_alloc(arena, words * sizeof(uint64_t));
+    b->frontier_bits[0] = (uint64_t*)arena_alloc(arena, words * sizeof(uint64_t));
+    b->frontier_bits[1] = (uint64_t*)arena_alloc(arena, words * sizeof(uint64_t));
+    b->touched = (int*)arena_alloc(arena, words * sizeof(int));
+    b->frontier[0] = (int*)arena_alloc(arena, words * sizeof(int));
+    b->frontier[1] = (int*)arena_alloc(arena, words * sizeof(int));
+    b->dist = (int*)arena_alloc(arena, (size_t)width * height * sizeof(int));
+    if (!b->open || !b->visited || !b->grow || !b->frontier_bits[0] || !b->frontier_bits[1] ||
+        !b->touched || !b->frontier[0] || !b->frontier[1] || !b->dist) {
+        return NULL;
+    }
+    b->seen_top = 0;
+    b->seen_bottom = -1;
+    return b;
+}
+
+/* 根据棋盘重建可走位集 */
+void bitbfs_build(BitBoard *bits, CellType **board) {
+    memset(bits->open, 0, (size_t)bits->words * bits->height * sizeof(uint64_t));
+    for (int y = 0; y < bits->height; y++) {
+        uint64_t *row = bits->open + (size_t)y * bits->words;
+        for (int x = 0; x < bits->width; x++) {
+            if (board[y][x] != CELL_WALL) row[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+    }
+    bits->ready = 0;
+}
+
+/* 单格变化：只有墙与非墙之间的变化影响位集 */
+void bitbfs_cell_changed(BitBoard *bits, int x, int y, CellType old_type, CellType new_type) {
+    if ((old_type == CELL_WALL) == (new_type == CELL_WALL)) return;
+
+    uint64_t *word = bits->open + (size_t)y * bits->words + (x >> 6);
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if (new_type == CELL_WALL) *word &= ~bit;
+    else *word |= bit;
+    bits->ready = 0;
+}
+
+/* 把一个字的候选格并入累积，第一次变为非零时记入本层的候选列表 */
+#define BITBFS_GROW(bits, row, col, value, touched, count)                      \
+    do {                                                                         \
+        uint64_t *slot_ = (bits)->grow + (size_t)(row) * (bits)->words + (col);  \
+        if (!*slot_) (touched)[(count)++] = ((row) << 6) | (col);                \
+        *slot_ |= (value);                                                       \
+    } while (0)
+
+/* 从(x, y)出发逐层展开。每一层分两步：
+ * 1. 波前的每个字左右移位（跨字的一位补到相邻字）、上下原样，并入候选累积；
+ * 2. 每个候选字与 (可走 & ~已访问) 相与得到下一层波前，同时写入距离并清零累积。
+ * 只处理波前所在的字，开销与波前所占的字数成正比，与棋盘宽度无关 */
+int bitbfs_field(BitBoard *bits, int x, int y, int radius) {
+    const int words = bits->words, height = bits->height, width = bits->width;
+    const uint64_t *open = bits->open;
+    uint64_t *visited = bits->visited;
+    int *touched = bits->touched;
+    int *dist = bits->dist;
+
+    /* 只清空上一次搜索到过的行 */
+    if (bits->seen_top <= bits->seen_bottom) {
+        memset(visited + (size_t)bits->seen_top * words, 0,
+               (size_t)(bits->seen_bottom - bits->seen_top + 1) * words * sizeof(uint64_t));
+    }
+    bits->source_x = x;
+    bits->source_y = y;
+    bits->radius = radius;
+    bits->ready = 1;
+    bits->seen_top = y;
+    bits->seen_bottom = y;
+
+    size_t source = (size_t)y * words + (x >> 6);
+    uint64_t source_bit = (uint64_t)1 << (x & 63);
+    if (!(open[source] & source_bit)) {
+        bits->seen_bottom = y - 1;
+        return 0;
+    }
+
+    int current = 0, count = 1;
+    bits->frontier[current][0] = (y << 6) | (x >> 6);
+    bits->frontier_bits[current][0] = source_bit;
+    visited[source] = source_bit;
+    dist[y * width + x] = 0;
+
+    int reached = 1;
+    for (int level = 1; count > 0 && (radius < 0 || level <= radius); level++) {
+        const int *frontier = bits->frontier[current];
+        const uint64_t *frontier_bits = bits->frontier_bits[current];
+        int candidates = 0;
+
+        for (int i = 0; i < count; i++) {
+            int r = frontier[i] >> 6, w = frontier[i] & 63;
+            uint64_t f = frontier_bits[i];
+            BITBFS_GROW(bits, r, w, (f << 1) | (f >> 1), touched, candidates);
+            if ((f & 1) && w > 0) BITBFS_GROW(bits, r, w - 1, (uint64_t)1 << 63, touched, candidates);
+            if ((f >> 63) && w < words - 1) BITBFS_GROW(bits, r, w + 1, (uint64_t)1, touched, candidates);
+            if (r > 0) BITBFS_GROW(bits, r - 1, w, f, touched, candidates);
+            if (r < height - 1) BITBFS_GROW(bits, r + 1, w, f, touched, candidates);
+        }
+
+        int *next = bits->frontier[current ^ 1];
+        uint64_t *next_bits = bits->frontier_bits[current ^ 1];
+        int next_count = 0;
+        for (int i = 0; i < candidates; i++) {
+            int r = touched[i] >> 6, w = touched[i] & 63;
+            size_t index = (size_t)r * words + w;
+            uint64_t fresh = bits->grow[index] & open[index] & ~visited[index];
+            bits->grow[index] = 0;
+            if (!fresh) continue;
+
+            visited[index] |= fresh;
+            next[next_count] = touched[i];
+            next_bits[next_count++] = fresh;
+            if (r < bits->seen_top) bits->seen_top = r;
+            if (r > bits->seen_bottom) bits->seen_bottom = r;
+
+            int *out = dist + r * width + w * 64;
+            while (fresh) {
+                out[bitbfs_lowest(fresh)] = level;
+                fresh &= fresh - 1;
+                reached++;
+            }
+        }
+
+        current ^= 1;
+        count = next_count;
+    }
+    return reached;
+}
+
+/* 最近一次距离场中(x, y)的距离，未到达时返回-1 */
+int bitbfs_distance(const BitBoard *bits, int x, int y) {
+    if (x < 0 || y < 0 || x >= bits->width || y >= bits->height) return -1;
+    uint64_t word = bits->visited[(size_t)y * bits->words + (x >> 6)];
+    if (!((word >> (x & 63)) & 1)) return -1;
+    return bits->dist[y * bits->width + x];
+}
+
+/* 追踪距离场：玩家位置和墙壁不变、已有的距离场半径也够用时无需重算 */
+void bitbfs_chase_field(BitBoard *bits, int player_x, int player_y, int radius) {
+    if (bits->ready && bits->source_x == player_x && bits->source_y == player_y &&
+        (bits->radius < 0 || (radius >= 0 && bits->radius >= radius))) {
+        return;
+    }
+    bitbfs_field(bits, player_x, player_y, radius);
+}
+
+/* 本回合改用其他方式追踪时丢弃距离场，避免幽灵读到过期的结果 */
+void bitbfs_discard_field(BitBoard *bits) {
+    if (bits) bits->ready = 0;
+}
+
+/* 在允许的方向中选择距离最小的相邻格；距离场不是从玩家当前位置算出的（别的模式留下的），
+ * 或幽灵不在距离场内时返回DIR_COUNT */
+Direction bitbfs_chase_direction(const BitBoard *bits, int player_x, int player_y, int x, int y,
+                                 unsigned int allowed) {
+    if (!bits || !bits->ready || bits->source_x != player_x || bits->source_y != player_y ||
+        bitbfs_distance(bits, x, y) < 0) {
+        return DIR_COUNT;
+    }
+
+    Direction best = DIR_COUNT;
+    int best_distance = 0;
+    const ExitDirList *list = &exit_dir_lists[allowed & 0x0Fu];
+    for (int k = 0; k < list->count; k++) {
+        int dir = list->dirs[k];
+        int d = bitbfs_distance(bits, x + bitbfs_dx[dir], y + bitbfs_dy[dir]);
+        if (d >= 0 && (best == DIR_COUNT || d < best_distance)) {
+            best = (Direction)dir;
+            best_distance = d;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "capture.h"
+#include "tiles.h"
+#include "image.h"
+#include "arena.h"
+#include "log.h"
+
+#define CAPTURE_PATH_MAX 1024
+/* 每个编码线程对应的待处理帧数，模拟线程只在全部占满时等待 */
+#define CAPTURE_SLOTS_PER_WORKER 4
+#define CAPTURE_MAX_SLOTS (CAPTURE_MAX_WORKERS * CAPTURE_SLOTS_PER_WORKER)
+
+/* 一帧待编码的数据：只保存视口内的格子，光栅化在编码线程中进行 */
+typedef struct {
+    unsigned long index;
+    int cols;
+    int rows;
+    unsigned char cells[CAPTURE_MAX_COLS * CAPTURE_MAX_ROWS];
+} CaptureJob;
+
+/* 捕获状态 */
+static struct {
+    char directory[CAPTURE_PATH_MAX];
+    int format;
+    int active;
+    int stopping;
+    int worker_count;
+    pthread_t workers[CAPTURE_MAX_WORKERS];
+    ImageEncoder encoders[CAPTURE_MAX_WORKERS];
+    unsigned char *framebuffers[CAPTURE_MAX_WORKERS];
+
+    CaptureJob *jobs;
+    int slot_count;
+    int free_slots[CAPTURE_MAX_SLOTS];     /* 空闲槽位栈 */
+    int free_count;
+    int queue[CAPTURE_MAX_SLOTS];          /* 待编码槽位的先进先出队列 */
+    int queue_head;
+    int queue_count;
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    pthread_cond_t slot_free;
+
+    unsigned long next_index;
+    unsigned long written;
+    unsigned long failed;
+} cap;
+
+/* 解析格式名，未知格式返回-1 */
+int capture_parse_format(const char *name) {
+    if (strcmp(name, "ppm") == 0) return CAPTURE_FORMAT_PPM;
+    if (strcmp(name, "png") == 0) return CAPTURE_FORMAT_PNG;
+    return -1;
+}
+
+/* 填充矩形，超出帧缓冲区的部分被裁掉 */
+static void fill_rect(unsigned char *fb, int fb_w, int fb_h, int x, int y, int w, int h,
+                      const unsigned char *rgb) {
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + w > fb_w ? fb_w : x + w;
+    int y1 = y + h > fb_h ? fb_h : y + h;
+
+    for (int py = y0; py < y1; py++) {
+        unsigned char *p = fb + ((size_t)py * fb_w + x0) * 3;
+        for (int px = x0; px < x1; px++) {
+            p[0] = rgb[0];
+            p[1] = rgb[1];
+            p[2] = rgb[2];
+            p += 3;
+        }
+    }
+}
+
+/* 按libsx的DrawBox语义绘制空心矩形：覆盖(w+1)x(h+1)个像素 */
+static void outline_rect(unsigned char *fb, int fb_w, int fb_h, int x, int y, int w, int h,
+                         const unsigned char *rgb) {
+    fill_rect(fb, fb_w, fb_h, x, y, w + 1, 1, rgb);
+    fill_rect(fb, fb_w, fb_h, x, y + h, w + 1, 1, rgb);
+    fill_rect(fb, fb_w, fb_h, x, y, 1, h + 1, rgb);
+    fill_rect(fb, fb_w, fb_h, x + w, y, 1, h + 1, rgb);
+}
+
+/* 执行图块的绘制图元，与图形界面的draw_tile_shape一致 */
+static void raster_shape(unsigned char *fb, int fb_w, int fb_h, const TileShape *shape,
+                         int x, int y) {
+    for (int i = 0; i < shape->count; i++) {
+        const TilePrimitive *p = &shape->prims[i];
+        const unsigned char *rgb = get_tile_color_rgb((TileColor)p->color);
+        if (p->filled) {
+            fill_rect(fb, fb_w, fb_h, x + p->x, y + p->y, p->w, p->h, rgb);
+        } else {
+            outline_rect(fb, fb_w, fb_h, x + p->x, y + p->y, p->w, p->h, rgb);
+        }
+    }
+}
+
+/* 把一帧光栅化到帧缓冲区：先画静态层，再画实体精灵 */
+static void raster_job(const CaptureJob *job, unsigned char *fb) {
+    int fb_w = job->cols * CELL_SIZE;
+    int fb_h = job->rows * CELL_SIZE;
+
+    for (int cy = 0; cy < job->rows; cy++) {
+        for (int cx = 0; cx < job->cols; cx++) {
+            CellType type = (CellType)job->cells[cy * job->cols + cx];
+            raster_shape(fb, fb_w, fb_h, get_tile_static_shape(type),
+                         cx * CELL_SIZE, cy * CELL_SIZE);
+        }
+    }
+    for (int cy = 0; cy < job->rows; cy++) {
+        for (int cx = 0; cx < job->cols; cx++) {
+            CellType type = (CellType)job->cells[cy * job->cols + cx];
+            if (tile_is_entity(type)) {
+                raster_shape(fb, fb_w, fb_h, get_tile_sprite_shape(type),
+                             cx * CELL_SIZE, cy * CELL_SIZE);
+            }
+        }
+    }
+}
+
+/* 编码线程：取出待处理帧，光栅化、压缩并写文件 */
+static void *capture_worker(void *arg) {
+    int worker = (int)(long)arg;
+    unsigned char *fb = cap.framebuffers[worker];
+    char path[CAPTURE_PATH_MAX + 32];
+
+    for (;;) {
+        pthread_mutex_lock(&cap.lock);
+        while (cap.queue_count == 0 && !cap.stopping) {
+            pthread_cond_wait(&cap.job_ready, &cap.lock);
+        }
+        if (cap.queue_count == 0) {
+            pthread_mutex_unlock(&cap.lock);
+            break;
+        }
+        int slot = cap.queue[cap.queue_head];
+        cap.queue_head = (cap.queue_head + 1) % cap.slot_count;
+        cap.queue_count--;
+        pthread_mutex_unlock(&cap.lock);
+
+        const CaptureJob *job = &cap.jobs[slot];
+        int width = job->cols * CELL_SIZE;
+        int height = job->rows * CELL_SIZE;
+        int result;
+
+        raster_job(job, fb);
+        if (cap.format == CAPTURE_FORMAT_PNG) {
+            snprintf(path, sizeof(path), "%s/frame_%06lu.png", cap.directory, job->index);
+            result = image_write_png(path, fb, width, height, &cap.encoders[worker]);
+        } else {
+            snprintf(path, sizeof(path), "%s/frame_%06lu.ppm", cap.directory, job->index);
+            result = image_write_ppm(path, fb, width, height);
+        }
+        __atomic_fetch_add(result == 0 ? &cap.written : &cap.failed, 1, __ATOMIC_RELAXED);
+
+        pthread_mutex_lock(&cap.lock);
+        cap.free_slots[cap.free_count++] = slot;
+        pthread_cond_signal(&cap.slot_free);
+        pthread_mutex_unlock(&cap.lock);
+    }
+    return NULL;
+}
+
+/* 释放捕获用的缓冲区 */
+static void capture_release_buffers(void) {
+    for (int i = 0; i < CAPTURE_MAX_WORKERS; i++) {
+        heap_free(cap.framebuffers[i]);
+        cap.framebuffers[i] = NULL;
+        image_encoder_destroy(&cap.encoders[i]);
+    }
+    heap_free(cap.jobs);
+    cap.jobs = NULL;
+}
+
+/* 开始捕获：创建输出目录并启动编码线程池 */
+int capture_start(const char *directory, int format, int workers) {
+    if (cap.active) return 0;
+
+    if (strlen(directory) >= sizeof(cap.directory)) {
+        fprintf(stderr, "错误: 捕获目录路径过长\n");
+        return -1;
+    }
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "错误: 无法创建捕获目录 %s\n", directory);
+        return -1;
+    }
+
+    if (workers < 1) workers = 1;
+    if (workers > CAPTURE_MAX_WORKERS) workers = CAPTURE_MAX_WORKERS;
+
+    memset(&cap, 0, sizeof(cap));
+    snprintf(cap.directory, sizeof(cap.directory), "%s", directory);
+    cap.format = format;
+    cap.slot_count = workers * CAPTURE_SLOTS_PER_WORKER;
+
+    size_t fb_bytes = (size_t)CAPTURE_MAX_COLS * CELL_SIZE * CAPTURE_MAX_ROWS * CELL_SIZE * 3;
+    cap.jobs = (CaptureJob*)heap_alloc(sizeof(CaptureJob) * cap.slot_count);
+    if (!cap.jobs) {
+        fprintf(stderr, "错误: 无法分配捕获缓冲区\n");
+        return -1;
+    }
+    for (int i = 0; i < workers; i++) {
+        cap.framebuffers[i] = (unsigned char*)heap_alloc(fb_bytes);
+        if (!cap.framebuffers[i] ||
+            (format == CAPTURE_FORMAT_PNG &&
+             image_encoder_init(&cap.encoders[i], CAPTURE_MAX_COLS * CELL_SIZE,
+                                CAPTURE_MAX_ROWS * CELL_SIZE) != 0)) {
+            fprintf(stderr, "错误: 无法分配捕获缓冲区\n");
+            capture_release_buffers();
+            return -1;
+        }
+    }
+    for (int i = 0; i < cap.slot_count; i++) {
+        cap.free_slots[i] = i;
+    }
+    cap.free_count = cap.slot_count;
+
+    pthread_mutex_init(&cap.lock, NULL);
+    pthread_cond_init(&cap.job_ready, NULL);
+    pthread_cond_init(&cap.slot_free, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&cap.workers[i], NULL, capture_worker, (void*)(long)i) != 0) {
+            fprintf(stderr, "警告: 只启动了 %d 个编码线程\n", i);
+            break;
+        }
+        cap.worker_count++;
+    }
+    if (cap.worker_count == 0) {
+        capture_release_buffers();
+        return -1;
+    }
+
+    cap.active = 1;
+    LOG_INFO("帧捕获已启动: 目录 %s, 格式 %s, %d 个编码线程", directory,
+             format == CAPTURE_FORMAT_PNG ? "png" : "ppm", cap.worker_count);
+    return 0;
+}
+
+/* 捕获一帧：复制以焦点为中心的视口，交给编码线程
+ * 所有槽位都在编码时等待，保证帧序列完整 */
+int capture_frame(CellType **board, int width, int height, int focus_x, int focus_y) {
+    if (!cap.active || !board) return -1;
+
+    int cols = width < CAPTURE_MAX_COLS ? width : CAPTURE_MAX_COLS;
+    int rows = height < CAPTURE_MAX_ROWS ? height : CAPTURE_MAX_ROWS;
+    int origin_x = focus_x - cols / 2;
+    int origin_y = focus_y - rows / 2;
+    if (origin_x > width - cols) origin_x = width - cols;
+    if (origin_y > height - rows) origin_y = height - rows;
+    if (origin_x < 0) origin_x = 0;
+    if (origin_y < 0) origin_y = 0;
+
+    pthread_mutex_lock(&cap.lock);
+    while (cap.free_count == 0) {
+        pthread_cond_wait(&cap.slot_free, &cap.lock);
+    }
+    int slot = cap.free_slots[--cap.free_count];
+    pthread_mutex_unlock(&cap.lock);
+
+    CaptureJob *job = &cap.jobs[slot];
+    job->index = cap.next_index++;
+    job->cols = cols;
+    job->rows = rows;
+    for (int y = 0; y < rows; y++) {
+        const CellType *row = board[origin_y + y] + origin_x;
+        unsigned char *out = job->cells + y * cols;
+        for (int x = 0; x < cols; x++) {
+            out[x] = (unsigned char)row[x];
+        }
+    }
+
+    pthread_mutex_lock(&cap.lock);
+    cap.queue[(cap.queue_head + cap.queue_count) % cap.slot_count] = slot;
+    cap.queue_count++;
+    pthread_cond_signal(&cap.job_ready);
+    pthread_mutex_unlock(&cap.lock);
+    return 0;
+}
+
+/* 结束捕获：等待队列中的帧全部写完后退出编码线程 */
+void capture_stop(void) {
+    if (!cap.active) return;
+
+    pthread_mutex_lock(&cap.lock);
+    cap.stopping = 1;
+    pthread_cond_broadcast(&cap.job_ready);
+    pthread_mutex_unlock(&cap.lock);
+
+    for (int i = 0; i < cap.worker_count; i++) {
+        pthread_join(cap.workers[i], NULL);
+    }
+    pthread_mutex_destroy(&cap.lock);
+    pthread_cond_destroy(&cap.job_ready);
+    pthread_cond_destroy(&cap.slot_free);
+    capture_release_buffers();
+    cap.active = 0;
+
+    if (cap.failed > 0) {
+        LOG_WARN("帧捕获: %lu 帧写入失败", cap.failed);
+    }
+    LOG_INFO("帧捕获结束: 共写出 %lu 帧到 %s", cap.written, cap.directory);
+}
+
+/* 已成功写出的帧数 */
+unsigned long capture_frames_written(void) {
+    return __atomic_load_n(&cap.written, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,175 @@
+#include <stddef.h>
+#include <string.h>
+#include "clone.h"
+#include "arena.h"
+#include "game.h"
+#include "algorithms.h"
+#include "navgraph.h"
+#include "hpa.h"
+#include "journal.h"
+#include "spectate.h"
+#include "liveshm.h"
+
+/* 克隆对象：对象头之后依次是棋盘、幽灵表和出口掩码、分层图计数、路口图计数，
+ * 各段按缓存行对齐，位置由段大小算出 */
+struct GameClone {
+    size_t capacity;                /* 整个对象的字节数 */
+    size_t used;                    /* 已保存的字节数（含对象头） */
+    unsigned int board_serial;      /* 保存时的棋盘编号，0表示尚未保存 */
+    int algorithm;
+    int timer_phase;
+    GameState state;                /* 计数器等标量，指针字段不使用 */
+    size_t board_bytes, block_bytes, hpa_bytes, nav_bytes;
+    unsigned char data[];
+};
+
+#define CLONE_ALIGN 64
+
+static size_t clone_align(size_t bytes) {
+    return (bytes + CLONE_ALIGN - 1) & ~(size_t)(CLONE_ALIGN - 1);
+}
+
+/* 幽灵表的各字段数组和出口掩码在内存区中依次切分（见init_game_state_with_size），
+ * 从第一个字段数组到出口掩码末尾是一整块 */
+static unsigned char *clone_block(size_t *bytes) {
+    const GameState *s = g_game_state;
+    unsigned char *start = (unsigned char*)s->ghosts.x;
+    *bytes = (size_t)(s->exits + (size_t)get_board_width() * get_board_height() - start);
+    return start;
+}
+
+/* 当前状态各段的大小 */
+static void clone_sizes(size_t sizes[4]) {
+    sizes[0] = (size_t)get_board_width() * get_board_height() * sizeof(CellType);
+    clone_block(&sizes[1]);
+    sizes[2] = g_game_state->hpa ? hpa_counts_bytes(g_game_state->hpa) : 0;
+    sizes[3] = g_game_state->nav ? navgraph_counts_bytes(g_game_state->nav) : 0;
+}
+
+static size_t clone_total(const size_t sizes[4]) {
+    size_t total = 0;
+    for (int s = 0; s < 4; s++) total += clone_align(sizes[s]);
+    return offsetof(GameClone, data) + total;
+}
+
+GameClone *game_clone_create(void) {
+    if (!g_game_state) return NULL;
+    size_t sizes[4];
+    clone_sizes(sizes);
+    size_t total = clone_total(sizes);
+    GameClone *clone = (GameClone*)heap_calloc(1, total);
+    if (!clone) return NULL;
+    clone->capacity = total;
+    return clone;
+}
+
+void game_clone_destroy(GameClone *clone) {
+    heap_free(clone);
+}
+
+size_t game_clone_bytes(const GameClone *clone) {
+    return clone ? clone->capacity : 0;
+}
+
+const CellType *game_clone_board(const GameClone *clone) {
+    return clone && clone->board_serial != 0 ? (const CellType*)clone->data : NULL;
+}
+
+const GameState *game_clone_state(const GameClone *clone) {
+    return clone && clone->board_serial != 0 ? &clone->state : NULL;
+}
+
+int game_clone_into(GameClone *dst) {
+    if (!g_game_state || !dst) return -1;
+    size_t sizes[4];
+    clone_sizes(sizes);
+    size_t total = clone_total(sizes);
+    if (total > dst->capacity) return -1;
+
+    size_t block_bytes;
+    const unsigned char *block = clone_block(&block_bytes);
+    unsigned char *data = dst->data;
+    memcpy(data, g_game_state->board[0], sizes[0]);
+    data += clone_align(sizes[0]);
+    memcpy(data, block, block_bytes);
+    data += clone_align(sizes[1]);
+    if (sizes[2] > 0) hpa_save_counts(g_game_state->hpa, data);
+    data += clone_align(sizes[2]);
+    if (sizes[3] > 0) navgraph_save_counts(g_game_state->nav, data);
+
+    dst->used = total;
+    dst->board_serial = get_board_serial();
+    dst->algorithm = get_algorithm();
+    dst->timer_phase = get_ghost_timer_phase();
+    dst->state = *g_game_state;
+    dst->board_bytes = sizes[0];
+    dst->block_bytes = sizes[1];
+    dst->hpa_bytes = sizes[2];
+    dst->nav_bytes = sizes[3];
+    return 0;
+}
+
+int game_restore_from(const GameClone *src) {
+    if (!g_game_state || !src || src->board_serial == 0 ||
+        src->board_serial != get_board_serial()) {
+        return -1;
+    }
+    size_t sizes[4];
+    clone_sizes(sizes);
+    if (sizes[0] != src->board_bytes || sizes[1] != src->block_bytes ||
+        sizes[2] != src->hpa_bytes || sizes[3] != src->nav_bytes) {
+        return -1;
+    }
+
+    size_t block_bytes;
+    unsigned char *block = clone_block(&block_bytes);
+    const unsigned char *data = src->data;
+    memcpy(g_game_state->board[0], data, sizes[0]);
+    data += clone_align(sizes[0]);
+    memcpy(block, data, block_bytes);
+    data += clone_align(sizes[1]);
+    if (sizes[2] > 0) hpa_load_counts(g_game_state->hpa, data);
+    data += clone_align(sizes[2]);
+    if (sizes[3] > 0) navgraph_load_counts(g_game_state->nav, data);
+
+    /* 标量整体换成保存的值，指针字段保持当前状态的 */
+    GameState live = *g_game_state;
+    *g_game_state = src->state;
+    g_game_state->board = live.board;
+    g_game_state->exits = live.exits;
+    g_game_state->nav = live.nav;
+    g_game_state->nexthop = live.nexthop;
+    g_game_state->hpa = live.hpa;
+    g_game_state->bits = live.bits;
+    g_game_state->journal = live.journal;
+    g_game_state->spectator = live.spectator;
+    g_game_state->live_shm = live.live_shm;
+    live.ghosts.count = src->state.ghosts.count;
+    g_game_state->ghosts = live.ghosts;
+
+    resume_algorithm(src->algorithm);
+    set_ghost_timer_phase(src->timer_phase);
+    if (g_game_state->journal) journal_reset(g_game_state->journal);
+    if (g_game_state->spectator) spectator_resync(g_game_state->spectator);
+    if (g_game_state->live_shm) live_shm_resync(g_game_state->live_shm);
+    return 0;
+}
+
+/* 在调用线程上按src所在的关建立游戏状态的副本（棋盘取自src，索引重新建立），再恢复src；
+ * 调用线程原有的游戏状态须已清理。网格大小与src不符或内存不足时返回-1 */
+int game_clone_instantiate(const GameClone *src) {
+    if (!src || src->board_serial == 0 ||
+        src->board_bytes != (size_t)get_board_width() * get_board_height() * sizeof(CellType) ||
+        init_game_state_copy((const CellType*)src->data, src->board_serial) != 0) {
+        return -1;
+    }
+    return game_restore_from(src);
+}
+
+int game_clone_copy(GameClone *dst, const GameClone *src) {
+    if (!dst || !src || src->used > dst->capacity) return -1;
+    size_t capacity = dst->capacity;
+    memcpy(dst, src, src->used > 0 ? src->used : offsetof(GameClone, data));
+    dst->capacity = capacity;
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <string.h>
+#include "env.h"
+#include "arena.h"
+#include "game.h"
+#include "algorithms.h"
+#include "clone.h"
+#include "level.h"
+#include "parallel.h"
+#include "log.h"
+
+/* 环境批次：每局开始的状态和各环境的当前状态都是克隆对象。
+ * 调用线程和每个工作线程各有一份本关的游戏状态，step按环境并行，
+ * 每个环境在分到它的线程的游戏状态中换入、走一步、存回 */
+struct EnvBatch {
+    EnvConfig config;
+    unsigned int seed;
+    GameClone *start;               /* 每局开始时的状态 */
+    GameClone **states;             /* 各环境的当前状态 */
+    const int **writer;             /* 最后存回各环境状态的线程（其env_thread_current的地址） */
+    int *steps;                     /* 本局已走的步数 */
+    unsigned int *episodes;         /* 已开始的局数 */
+    int failed;                     /* 有工作线程未能建立游戏状态 */
+};
+
+/* 本线程的游戏状态中正是这个环境的状态，-1表示都不是；
+ * 只有writer也指向本线程时才成立，否则该环境已被其他线程走过 */
+static __thread int env_thread_current = -1;
+
+/* 单元格所属的观测平面，-1表示空格 */
+static const signed char env_plane_of[CELL_FRUIT + 1] = {
+    -1,                             /* CELL_EMPTY */
+    ENV_PLANE_WALL,
+    ENV_PLANE_DOT,
+    ENV_PLANE_PLAYER,
+    ENV_PLANE_GHOST, ENV_PLANE_GHOST, ENV_PLANE_GHOST, ENV_PLANE_GHOST,
+    ENV_PLANE_POWER,
+    ENV_PLANE_DOT                   /* CELL_FRUIT */
+};
+
+/* 默认参数：与无界面模式相同的棋盘和幽灵数 */
+void env_default_config(EnvConfig *config) {
+    config->width = DEFAULT_BOARD_WIDTH;
+    config->height = DEFAULT_BOARD_HEIGHT;
+    config->ghosts = DEFAULT_GHOST_COUNT;
+    config->batch = 1;
+    config->algorithm = ALGO_RANDOM;
+    config->threads = 0;
+    config->max_steps = 0;
+}
+
+/* 释放各环境的克隆对象，换关之前调用 */
+static void env_release_states(EnvBatch *env) {
+    for (int i = 0; i < env->config.batch; i++) {
+        game_clone_destroy(env->states[i]);
+        env->states[i] = NULL;
+    }
+    game_clone_destroy(env->start);
+    env->start = NULL;
+    env_thread_current = -1;
+}
+
+EnvBatch *env_create(const EnvConfig *config) {
+    if (config->batch < 1 || config->ghosts < 0 ||
+        config->width < MIN_BOARD_WIDTH || config->height < MIN_BOARD_HEIGHT) {
+        LOG_ERROR("无效的环境参数");
+        return NULL;
+    }
+    EnvBatch *env = (EnvBatch*)heap_calloc(1, sizeof(EnvBatch));
+    if (!env) return NULL;
+    env->config = *config;
+    env->states = (GameClone**)heap_calloc((size_t)config->batch, sizeof(GameClone*));
+    env->writer = (const int**)heap_calloc((size_t)config->batch, sizeof(int*));
+    env->steps = (int*)heap_calloc((size_t)config->batch, sizeof(int));
+    env->episodes = (unsigned int*)heap_calloc((size_t)config->batch, sizeof(unsigned int));
+    if (!env->states || !env->writer || !env->steps || !env->episodes) {
+        env_destroy(env);
+        return NULL;
+    }
+    parallel_init(config->threads);
+    return env;
+}
+
+/* 工作线程：释放本线程的游戏状态 */
+static void env_detach_worker(void *context) {
+    (void)context;
+    cleanup_game_state();
+    env_thread_current = -1;
+}
+
+/* 工作线程：释放上一关的游戏状态，按本关的开局状态建立新的一份 */
+static void env_attach_worker(void *context) {
+    EnvBatch *env = (EnvBatch*)context;
+    env_detach_worker(NULL);
+    if (game_clone_instantiate(env->start) != 0) {
+        __atomic_store_n(&env->failed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void env_destroy(EnvBatch *env) {
+    if (!env) return;
+    if (env->states) env_release_states(env);
+    parallel_each_worker(env_detach_worker, NULL);
+    cleanup_game_state();
+    parallel_shutdown();
+    heap_free(env->states);
+    heap_free(env->writer);
+    heap_free(env->steps);
+    heap_free(env->episodes);
+    heap_free(env);
+}
+
+int env_batch_size(const EnvBatch *env) {
+    return env->config.batch;
+}
+
+size_t env_observation_bytes(const EnvBatch *env) {
+    return (size_t)ENV_PLANES * env->config.width * env->config.height;
+}
+
+/* 记下本线程的游戏状态中正是环境i的状态 */
+static void env_hold(EnvBatch *env, int i) {
+    env_thread_current = i;
+    env->writer[i] = &env_thread_current;
+}
+
+/* 环境i开始新的一局：换入开局状态，按种子、环境序号和局数给幽灵重新播种后存回 */
+static void env_begin_episode(EnvBatch *env, int i) {
+    game_restore_from(env->start);
+    unsigned int rng = env->seed ^ (unsigned int)i * 0x9E3779B9u ^
+                       env->episodes[i] * 0x85EBCA6Bu;
+    GhostRegistry *g = &g_game_state->ghosts;
+    for (int k = 0; k < g->count; k++) g->rng[k] = level_rand(&rng);
+    game_clone_into(env->states[i]);
+    env->steps[i] = 0;
+    env->episodes[i]++;
+    env_hold(env, i);
+}
+
+/* 观测编码：按环境并行，只读各环境的克隆对象 */
+typedef struct {
+    const EnvBatch *env;
+    unsigned char *observations;
+} EnvEncodeContext;
+
+static void env_encode_range(int begin, int end, void *context) {
+    const EnvEncodeContext *ctx = (const EnvEncodeContext*)context;
+    size_t cells = (size_t)ctx->env->config.width * ctx->env->config.height;
+    for (int i = begin; i < end; i++) {
+        const GameClone *state = ctx->env->states[i];
+        const CellType *board = game_clone_board(state);
+        unsigned char ghost = game_clone_state(state)->frightened_ticks > 0 ? 2 : 1;
+        unsigned char *obs = ctx->observations + (size_t)i * ENV_PLANES * cells;
+        memset(obs, 0, ENV_PLANES * cells);
+        for (size_t c = 0; c < cells; c++) {
+            int plane = env_plane_of[board[c]];
+            if (plane >= 0) obs[(size_t)plane * cells + c] = plane == ENV_PLANE_GHOST ? ghost : 1;
+        }
+    }
+}
+
+/* 按环境划分的块大小：大棋盘每个环境的工作量已足够摊薄调度开销 */
+static int env_chunk(const EnvBatch *env) {
+    return env->config.width * env->config.height >= 4096 ? 1 : 8;
+}
+
+static void env_encode(const EnvBatch *env, unsigned char *observations) {
+    EnvEncodeContext ctx = {env, observations};
+    parallel_for(env->config.batch, env_chunk(env), env_encode_range, &ctx);
+}
+
+int env_reset(EnvBatch *env, unsigned int seed, unsigned char *observations) {
+    const EnvConfig *config = &env->config;
+    env_release_states(env);
+    cleanup_game_state();
+
+    set_game_seed(seed);
+    set_ghost_count(config->ghosts);
+    set_journal_ticks(0);
+    if (init_game_state_with_size(config->width, config->height) != 0) return -1;
+    level_pipeline_stop();
+    set_ghost_move_interval(SIM_TICK_MS);
+    if (config->algorithm != ALGO_NONE) {
+        set_algorithm(config->algorithm);
+    } else {
+        stop_algorithm();
+    }
+
+    env->seed = seed;
+    env->start = game_clone_create();
+    if (!env->start || game_clone_into(env->start) != 0) return -1;
+    env->failed = 0;
+    parallel_each_worker(env_attach_worker, env);
+    if (env->failed) {
+        LOG_ERROR("工作线程无法建立游戏状态");
+        env_release_states(env);
+        return -1;
+    }
+    for (int i = 0; i < config->batch; i++) {
+        env->states[i] = game_clone_create();
+        if (!env->states[i]) {
+            env_release_states(env);
+            return -1;
+        }
+        env->episodes[i] = 0;
+        env_begin_episode(env, i);
+    }
+    if (observations) env_encode(env, observations);
+    return 0;
+}
+
+/* 步进：按环境并行，每个环境在本线程的游戏状态中走一步（其中幽灵决策在本线程内依次进行） */
+typedef struct {
+    EnvBatch *env;
+    const unsigned char *actions;
+    float *rewards;
+    unsigned char *dones;
+} EnvStepContext;
+
+static void env_step_range(int begin, int end, void *context) {
+    const EnvStepContext *ctx = (const EnvStepContext*)context;
+    EnvBatch *env = ctx->env;
+    for (int i = begin; i < end; i++) {
+        if (env_thread_current != i || env->writer[i] != &env_thread_current) {
+            game_restore_from(env->states[i]);
+        }
+        int score = g_game_state->score;
+
+        if (is_algorithm_enabled()) update_ghost_movement();
+        if (ctx->actions[i] < DIR_COUNT && !is_game_over()) step_player((Direction)ctx->actions[i]);
+        env->steps[i]++;
+
+        int done = is_game_over() ||
+                   (env->config.max_steps > 0 && env->steps[i] >= env->config.max_steps);
+        if (ctx->rewards) ctx->rewards[i] = (float)(g_game_state->score - score);
+        if (ctx->dones) ctx->dones[i] = (unsigned char)done;
+        if (done) {
+            env_begin_episode(env, i);
+        } else {
+            game_clone_into(env->states[i]);
+            env_hold(env, i);
+        }
+    }
+}
+
+void env_step(EnvBatch *env, const unsigned char *actions, unsigned char *observations,
+              float *rewards, unsigned char *dones) {
+    if (!env->start) {
+        LOG_WARN("环境尚未重置，忽略本步");
+        return;
+    }
+
+    /* 步进路径不访问堆 */
+    EnvStepContext ctx = {env, actions, rewards, dones};
+    ALLOC_CHECK_BEGIN();
+    parallel_for(env->config.batch, env_chunk(env), env_step_range, &ctx);
+    ALLOC_CHECK_END("env step");
+
+    if (observations) env_encode(env, observations);
+}
@@ -0,0 +1,91 @@
+#include "exits.h"
+
+/* 方向偏移与反方向，下标为Direction */
+static const int exit_dx[4] = {0, 0, -1, 1};
+static const int exit_dy[4] = {-1, 1, 0, 0};
+static const int exit_opposite[4] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+
+/* 掩码到方向列表：方向按UP、DOWN、LEFT、RIGHT顺序排列 */
+#define DL(n, a, b, c, d) {n, {a, b, c, d}}
+const ExitDirList exit_dir_lists[16] = {
+    /* 0000 */ DL(0, 0, 0, 0, 0),
+    /* 0001 */ DL(1, DIR_UP, 0, 0, 0),
+    /* 0010 */ DL(1, DIR_DOWN, 0, 0, 0),
+    /* 0011 */ DL(2, DIR_UP, DIR_DOWN, 0, 0),
+    /* 0100 */ DL(1, DIR_LEFT, 0, 0, 0),
+    /* 0101 */ DL(2, DIR_UP, DIR_LEFT, 0, 0),
+    /* 0110 */ DL(2, DIR_DOWN, DIR_LEFT, 0, 0),
+    /* 0111 */ DL(3, DIR_UP, DIR_DOWN, DIR_LEFT, 0),
+    /* 1000 */ DL(1, DIR_RIGHT, 0, 0, 0),
+    /* 1001 */ DL(2, DIR_UP, DIR_RIGHT, 0, 0),
+    /* 1010 */ DL(2, DIR_DOWN, DIR_RIGHT, 0, 0),
+    /* 1011 */ DL(3, DIR_UP, DIR_DOWN, DIR_RIGHT, 0),
+    /* 1100 */ DL(2, DIR_LEFT, DIR_RIGHT, 0, 0),
+    /* 1101 */ DL(3, DIR_UP, DIR_LEFT, DIR_RIGHT, 0),
+    /* 1110 */ DL(3, DIR_DOWN, DIR_LEFT, DIR_RIGHT, 0),
+    /* 1111 */ DL(4, DIR_UP, DIR_DOWN, DIR_LEFT, DIR_RIGHT)
+};
+#undef DL
+
+/* 格子的通行类别：第0位表示挡住玩家，第1位表示挡住幽灵 */
+static unsigned int cell_blocks(CellType type) {
+    switch (type) {
+        case CELL_WALL:
+            return 3;
+        case CELL_GHOST_RED:
+        case CELL_GHOST_BLUE:
+        case CELL_GHOST_PURPLE:
+        case CELL_GHOST_ORANGE:
+        case CELL_FRUIT:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+/* 出口掩码数组所需的内存区字节数 */
+size_t exits_bytes(int width, int height) {
+    return arena_align((size_t)width * height);
+}
+
+/* 从内存区切分出口掩码数组 */
+unsigned char *exits_carve(Arena *arena, int width, int height) {
+    return (unsigned char*)arena_alloc(arena, (size_t)width * height);
+}
+
+/* 根据整块棋盘计算所有格子的出口掩码 */
+void exits_build(unsigned char *exits, CellType **board, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned int mask = 0;
+            for (int d = 0; d < 4; d++) {
+                int nx = x + exit_dx[d];
+                int ny = y + exit_dy[d];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                unsigned int blocks = cell_blocks(board[ny][nx]);
+                if (!(blocks & 1)) mask |= EXIT_BIT(d);
+                if (!(blocks & 2)) mask |= EXIT_BIT(d) << 4;
+            }
+            exits[y * width + x] = (unsigned char)mask;
+        }
+    }
+}
+
+/* 格子(x, y)的类型改变后更新四个相邻格指向它的出口位 */
+void exits_update_cell(unsigned char *exits, int width, int height, int x, int y,
+                       CellType old_type, CellType new_type) {
+    unsigned int blocks = cell_blocks(new_type);
+    if (blocks == cell_blocks(old_type)) return;
+
+    for (int d = 0; d < 4; d++) {
+        int nx = x + exit_dx[d];
+        int ny = y + exit_dy[d];
+        if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+
+        unsigned int back = EXIT_BIT(exit_opposite[d]);
+        unsigned int mask = exits[ny * width + nx];
+        mask = (blocks & 1) ? (mask & ~back) : (mask | back);
+        mask = (blocks & 2) ? (mask & ~(back << 4)) : (mask | (back << 4));
+        exits[ny * width + nx] = (unsigned char)mask;
+    }
+}
@@ -1,11 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "game.h"
 #include "types.h"
-
-/* 全局游戏状态 */
-GameState *g_game_state = NULL;
+#include "log.h"
+#include "level.h"
+#include "arena.h"
+#include "algorithms.h"
+#include "ghost.h"
+#include "exits.h"
+#include "navgraph.h"
+#include "nexthop.h"
+#include "hpa.h"
+#include "bitbfs.h"
+#include "map.h"
+#include "pack.h"
+#include "levelcache.h"
+#include "journal.h"
+#include "spectate.h"
+#include "liveshm.h"
+
+/* 全局游戏状态：每个线程一份，批量环境的工作线程各自持有同一关的副本（见init_game_state_copy），
+ * 下面标为__thread的内存区、随机数和棋盘编号也随之各有一份 */
+__thread GameState *g_game_state = NULL;
 
 /* 全局变量定义 - 动态网格大小 */
 int BOARD_WIDTH = DEFAULT_BOARD_WIDTH;
@@ -21,6 +39,103 @@ void set_board_size(int width, int height) {
     WINDOW_HEIGHT = height * CELL_SIZE + 150; /* 额外空间给状态栏 */
 }
 
+/* 每关的幽灵数 */
+static int ghost_count = DEFAULT_GHOST_COUNT;
+
+/* 设置幽灵数（在初始化游戏状态之前调用） */
+void set_ghost_count(int count) {
+    if (count < 0) count = 0;
+    if (count > MAX_GHOST_COUNT) count = MAX_GHOST_COUNT;
+    ghost_count = count;
+}
+
+/* 获取幽灵数 */
+int get_ghost_count(void) {
+    return ghost_count;
+}
+
+/* 固定地图：设置后开局、重新开始和换关都从地图复制棋盘，不再随机生成 */
+static const GameMap *game_map = NULL;
+
+/* 设置固定地图（在初始化游戏状态之前调用），网格大小和幽灵数随地图确定 */
+void set_game_map(const GameMap *map) {
+    game_map = map;
+    if (map) {
+        set_board_size(map->width, map->height);
+        set_ghost_count(map->ghost_count);
+    }
+}
+
+/* 棋盘包：设置后开局、重新开始和换关依次取包里预生成的棋盘，用完从头循环 */
+static const BoardPack *game_pack = NULL;
+static int pack_next = 0;
+
+/* 设置棋盘包（在初始化游戏状态之前调用），网格大小和幽灵数随棋盘包确定 */
+void set_game_pack(const BoardPack *pack) {
+    game_pack = pack;
+    pack_next = 0;
+    if (pack) {
+        set_board_size(pack->width, pack->height);
+        set_ghost_count(pack->ghost_count);
+    }
+}
+
+/* 取棋盘包里的下一个棋盘，返回豆子总数 */
+static int fill_from_pack(void) {
+    int total = pack_fill_board(game_pack, pack_next, g_game_state->board);
+    pack_next = (pack_next + 1) % game_pack->board_count;
+    return total;
+}
+
+/* 关卡缓存目录：设置后随机关卡先查缓存，命中时直接载入棋盘和导航索引 */
+static const char *level_cache_dir = NULL;
+static unsigned int cache_seed = 0;         /* 下一关的种子，与流水线的种子序列相同 */
+static LevelCacheKey cache_key;
+static LevelCacheEntry cache_entry;         /* cached_board命中后保持映射，直到载入索引 */
+
+/* 设置关卡缓存目录（在初始化游戏状态之前调用），NULL表示不使用缓存 */
+void set_level_cache_dir(const char *dir) {
+    level_cache_dir = dir;
+}
+
+/* 是否为小棋盘建立全源下一步表 */
+static int nexthop_enabled = 1;
+
+/* 启用或关闭下一步表（在初始化游戏状态之前调用） */
+void set_nexthop_enabled(int enabled) {
+    nexthop_enabled = enabled;
+}
+
+/* 是否为大棋盘建立分层寻路图 */
+static int hpa_enabled = 1;
+
+/* 启用或关闭分层寻路图（在初始化游戏状态之前调用） */
+void set_hpa_enabled(int enabled) {
+    hpa_enabled = enabled;
+}
+
+/* 回退日志保留的tick数，0表示不记录 */
+static int journal_ticks = 0;
+
+/* 设置回退日志的长度（在初始化游戏状态之前调用），0表示关闭 */
+void set_journal_ticks(int ticks) {
+    journal_ticks = ticks > 0 ? ticks : 0;
+}
+
+/* 观战服务器的套接字路径，NULL表示不启用 */
+static const char *spectate_path = NULL;
+
+void set_spectate_socket(const char *path) {
+    spectate_path = path;
+}
+
+/* 状态导出的共享内存名，NULL表示不启用 */
+static const char *live_shm_name = NULL;
+
+void set_live_shm_name(const char *name) {
+    live_shm_name = name;
+}
+
 /* 获取网格宽度 */
 int get_board_width(void) {
     return BOARD_WIDTH;
@@ -31,32 +146,134 @@ int get_board_height(void) {
     return BOARD_HEIGHT;
 }
 
-/* 分配二维数组内存 */
-static CellType** allocate_board(int width, int height) {
-    CellType **board = (CellType**)malloc(height * sizeof(CellType*));
-    if (!board) return NULL;
-    
-    for (int i = 0; i < height; i++) {
-        board[i] = (CellType*)malloc(width * sizeof(CellType));
-        if (!board[i]) {
-            /* 释放已分配的内存 */
-            for (int j = 0; j < i; j++) {
-                free(board[j]);
+/* 棋盘生成使用的随机数状态 */
+static __thread unsigned int board_rng = 1;
+static unsigned int game_seed = 0;
+static int game_seed_set = 0;
+
+/* 指定随机种子（在初始化游戏状态之前调用），相同种子生成相同的关卡序列 */
+void set_game_seed(unsigned int seed) {
+    game_seed = seed;
+    game_seed_set = 1;
+}
+
+/* 棋盘的墙壁编号：开局和每次换入棋盘时递增，状态克隆据此判断是否属于同一关 */
+static __thread unsigned int board_serial = 0;
+
+unsigned int get_board_serial(void) {
+    return board_serial;
+}
+
+/* 单局游戏的全部内存（状态、棋盘、流水线棋盘池、生成缓冲区）都来自这个内存区 */
+static __thread Arena game_arena;
+static __thread LevelScratch board_scratch;
+
+/* 只依赖墙壁、建立较慢的索引：流水线池中的每个棋盘各带一份，由后台线程在生成棋盘后
+ * 建好，换关时与棋盘一起换入，GUI线程不再同步重建 */
+typedef struct {
+    NextHopTable *nexthop;
+    HpaGraph *hpa;
+} WallIndexes;
+
+static WallIndexes wall_indexes[LEVEL_PIPELINE_POOL + 1];  /* [0]开局时属于当前棋盘 */
+static WallIndexes *live_indexes = NULL;                  /* 当前棋盘的索引 */
+static unsigned char *pipeline_exits;                     /* 后台线程建立索引用的出口掩码 */
+
+/* 使用关卡预生成流水线：固定地图和棋盘包不需要，使用缓存时逐关查缓存 */
+static int pipeline_enabled(void) {
+    return !game_map && !game_pack && !level_cache_dir;
+}
+
+/* 一份只依赖墙壁的索引所需的内存区字节数 */
+static size_t wall_indexes_bytes(int width, int height) {
+    return (nexthop_enabled ? nexthop_bytes(width, height) : 0) +
+           (hpa_enabled ? hpa_bytes(width, height) : 0);
+}
+
+/* 流水线后台线程：为刚生成的棋盘建立出口掩码、下一步表和分层图 */
+static void build_wall_indexes(CellType **board, void *indexes, void *context) {
+    WallIndexes *w = (WallIndexes*)indexes;
+    unsigned char *exits = (unsigned char*)context;
+    exits_build(exits, board, BOARD_WIDTH, BOARD_HEIGHT);
+    if (w->nexthop) nexthop_build(w->nexthop, board, exits);
+    if (w->hpa) hpa_build(w->hpa, board, exits);
+}
+
+/* 为流水线池中的棋盘切分索引并启动流水线；内存不足时启动不带索引的流水线 */
+static void start_pipeline(void) {
+    void *indexes[LEVEL_PIPELINE_POOL];
+    LevelIndexFn build = NULL;
+    wall_indexes[0].nexthop = g_game_state->nexthop;
+    wall_indexes[0].hpa = g_game_state->hpa;
+    live_indexes = &wall_indexes[0];
+    if (g_game_state->nexthop || g_game_state->hpa) {
+        build = build_wall_indexes;
+        pipeline_exits = exits_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT);
+        if (!pipeline_exits) build = NULL;
+        for (int i = 0; i < LEVEL_PIPELINE_POOL && build; i++) {
+            WallIndexes *w = &wall_indexes[i + 1];
+            w->nexthop = g_game_state->nexthop ?
+                         nexthop_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT) : NULL;
+            w->hpa = g_game_state->hpa ? hpa_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT) : NULL;
+            if ((g_game_state->nexthop && !w->nexthop) || (g_game_state->hpa && !w->hpa)) {
+                LOG_WARN("关卡预生成: 内存区空间不足，换关时同步建立导航索引");
+                build = NULL;
             }
-            free(board);
-            return NULL;
+            indexes[i] = w;
         }
     }
-    return board;
+    level_pipeline_start(&game_arena, BOARD_WIDTH, BOARD_HEIGHT, ghost_count,
+                         LEVEL_PIPELINE_DEPTH, level_rand(&board_rng), indexes, build,
+                         pipeline_exits);
 }
 
-/* 释放二维数组内存 */
-static void free_board(CellType **board, int height) {
-    if (!board) return;
-    for (int i = 0; i < height; i++) {
-        free(board[i]);
+/* 生成或从缓存取出以*rng为种子的关卡，*rng更新为生成之后的状态，返回豆子总数 */
+static int cached_board(unsigned int *rng) {
+    level_cache_key(&cache_key, *rng, BOARD_WIDTH, BOARD_HEIGHT, ghost_count);
+    if (level_cache_open(level_cache_dir, &cache_key, &cache_entry) == 0) {
+        return level_cache_fill_board(&cache_entry, g_game_state->board, rng);
+    }
+    return level_generate_rng(g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT, ghost_count, rng,
+                              &board_scratch);
+}
+
+/* 为cached_board取出的关卡建立索引：命中时载入映像，只重建幽灵表和位集；
+ * 未命中或映像不可用时完整重建，再写入缓存 */
+static void cached_indexes(unsigned int rng_state, int total) {
+    int loaded = cache_entry.mapping && level_cache_load_indexes(&cache_entry, g_game_state) == 0;
+    level_cache_close(&cache_entry);
+    if (loaded) {
+        ghost_registry_load(&g_game_state->ghosts, g_game_state->board, BOARD_WIDTH,
+                            BOARD_HEIGHT, get_algorithm());
+        if (g_game_state->bits) bitbfs_build(g_game_state->bits, g_game_state->board);
+        return;
     }
-    free(board);
+    rebuild_board_indexes();
+    level_cache_store(level_cache_dir, &cache_key, g_game_state, rng_state, total);
+}
+
+/* 计算指定网格大小所需的内存区大小；副本不带流水线和回退日志 */
+static size_t game_arena_size(int width, int height, int copy) {
+    return arena_align(sizeof(GameState)) +
+           level_board_bytes(width, height) +
+           level_scratch_bytes(width, height) +
+           level_pipeline_bytes(width, height) +
+           algorithms_arena_bytes(width, height) +
+           ghost_registry_bytes(ghost_count) +
+           exits_bytes(width, height) +
+           navgraph_bytes(width, height) +
+           wall_indexes_bytes(width, height) +
+           (pipeline_enabled() && !copy ?
+            LEVEL_PIPELINE_POOL * wall_indexes_bytes(width, height) + exits_bytes(width, height) :
+            0) +
+           bitbfs_bytes(width, height) +
+           (journal_ticks > 0 && !copy ?
+            journal_bytes(width, height, ghost_count, journal_ticks) : 0);
+}
+
+/* 获取游戏内存区 */
+Arena *get_game_arena(void) {
+    return &game_arena;
 }
 
 /* 初始化游戏状态 */
@@ -64,35 +281,101 @@ int init_game_state(void) {
     return init_game_state_with_size(BOARD_WIDTH, BOARD_HEIGHT);
 }
 
+/* 按当前网格大小分配内存区，切分状态、棋盘和各索引；路口图、分层图和回退日志先不挂到
+ * 状态上，由调用者在棋盘填好之后挂上。失败时返回-1，g_game_state为NULL */
+static int carve_game_state(int copy, NavGraph **nav_out, HpaGraph **hpa_out,
+                            Journal **journal_out) {
+    /* 一次性分配整局游戏所需的内存区 */
+    if (arena_init(&game_arena, game_arena_size(BOARD_WIDTH, BOARD_HEIGHT, copy)) != 0) {
+        LOG_ERROR("无法为游戏状态分配内存");
+        return -1;
+    }
+    g_game_state = (GameState*)arena_alloc(&game_arena, sizeof(GameState));
+    g_game_state->nav = NULL;
+    g_game_state->nexthop = NULL;
+    g_game_state->hpa = NULL;
+    g_game_state->bits = NULL;
+    g_game_state->journal = NULL;
+    g_game_state->spectator = NULL;
+    g_game_state->live_shm = NULL;
+    NavGraph *nav = NULL;
+    HpaGraph *hpa = NULL;
+    Journal *journal = NULL;
+    
+    /* 从内存区切分棋盘和生成缓冲区 */
+    g_game_state->board = level_board_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT);
+    if (!g_game_state->board ||
+        level_scratch_carve(&game_arena, &board_scratch, BOARD_WIDTH, BOARD_HEIGHT) != 0 ||
+        algorithms_init_arena(&game_arena, BOARD_WIDTH, BOARD_HEIGHT) != 0 ||
+        ghost_registry_carve(&game_arena, &g_game_state->ghosts, ghost_count) != 0 ||
+        !(g_game_state->exits = exits_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT)) ||
+        !(nav = navgraph_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT)) ||
+        (nexthop_enabled && nexthop_bytes(BOARD_WIDTH, BOARD_HEIGHT) > 0 &&
+         !(g_game_state->nexthop = nexthop_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT))) ||
+        (hpa_enabled && hpa_bytes(BOARD_WIDTH, BOARD_HEIGHT) > 0 &&
+         !(hpa = hpa_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT))) ||
+        (bitbfs_bytes(BOARD_WIDTH, BOARD_HEIGHT) > 0 &&
+         !(g_game_state->bits = bitbfs_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT))) ||
+        (journal_ticks > 0 && !copy &&
+         !(journal = journal_carve(&game_arena, BOARD_WIDTH, BOARD_HEIGHT, ghost_count,
+                                   journal_ticks)))) {
+        LOG_ERROR("无法为棋盘分配内存");
+        arena_destroy(&game_arena);
+        g_game_state = NULL;
+        return -1;
+    }
+    *nav_out = nav;
+    *hpa_out = hpa;
+    *journal_out = journal;
+    return 0;
+}
+
+static void build_board_indexes(int walls_ready);
+
 /* 使用指定大小初始化游戏状态 */
 int init_game_state_with_size(int width, int height) {
+    NavGraph *nav = NULL;
+    HpaGraph *hpa = NULL;
+    Journal *journal = NULL;
+    
     /* 设置网格大小 */
     set_board_size(width, height);
-    g_game_state = (GameState*)malloc(sizeof(GameState));
-    if (!g_game_state) {
-        fprintf(stderr, "Error: Unable to allocate memory for game state\n");
-        return -1;
-    }
+    if (carve_game_state(0, &nav, &hpa, &journal) != 0) return -1;
+    
+    /* 初始化随机数种子 */
+    srand(game_seed_set ? game_seed : (unsigned int)time(NULL));
+    board_rng = (unsigned int)rand();
     
-    /* 分配棋盘内存 */
-    g_game_state->board = allocate_board(BOARD_WIDTH, BOARD_HEIGHT);
-    if (!g_game_state->board) {
-        fprintf(stderr, "Error: Unable to allocate memory for game board\n");
-        free(g_game_state);
+    if (game_map && (game_map->width != BOARD_WIDTH || game_map->height != BOARD_HEIGHT)) {
+        LOG_ERROR("地图大小 %dx%d 与棋盘不符", game_map->width, game_map->height);
+        arena_destroy(&game_arena);
         g_game_state = NULL;
         return -1;
     }
     
-    /* 初始化随机数种子 */
-    srand((unsigned int)time(NULL));
-    
     /* 初始化棋盘 */
-    init_board();
+    if (game_map) {
+        map_fill_board(game_map, g_game_state->board);
+        g_game_state->player_spawn.x = game_map->player_x;
+        g_game_state->player_spawn.y = game_map->player_y;
+    } else if (game_pack) {
+        fill_from_pack();
+        g_game_state->player_spawn.x = 1;
+        g_game_state->player_spawn.y = 1;
+    } else if (level_cache_dir) {
+        cached_board(&board_rng);
+        g_game_state->player_spawn.x = 1;
+        g_game_state->player_spawn.y = 1;
+    } else {
+        init_board();
+        g_game_state->player_spawn.x = 1;
+        g_game_state->player_spawn.y = 1;
+    }
     
     /* 设置玩家初始位置 */
-    g_game_state->player_pos.x = 1;
-    g_game_state->player_pos.y = 1;
-    set_board_cell(1, 1, CELL_PLAYER);
+    g_game_state->player_pos = g_game_state->player_spawn;
+    g_game_state->player_dir = DIR_RIGHT;
+    set_board_cell(g_game_state->player_pos.x, g_game_state->player_pos.y, CELL_PLAYER);
     
     /* 初始化游戏统计 */
     g_game_state->dots_collected = 0;
@@ -106,13 +389,14 @@ int init_game_state_with_size(int width, int height) {
     g_game_state->auto_move_enabled = 0;           /* 默认关闭自动移动 */
     g_game_state->last_move_time = 0;
     
-    /* 豆子已在init_board中生成，无需额外生成 */
-    
-    /* 添加一些幽灵 */
-    add_ghosts();
-    
-    /* 添加能量豆 */
-    add_power_dots();
+    /* 豆子已在init_board中生成，无需额外生成；地图、棋盘包和缓存的关卡自带幽灵和能量豆 */
+    if (!game_map && !game_pack && !level_cache_dir) {
+        /* 添加幽灵 */
+        add_ghosts();
+        
+        /* 添加能量豆 */
+        add_power_dots();
+    }
     
     /* 计算总豆子数（包括能量豆） */
     int total = 0;
@@ -125,43 +409,154 @@ int init_game_state_with_size(int width, int height) {
     }
     g_game_state->total_dots = total;
     
+    board_serial++;
+    
+    /* 路口图和分层图建好之后才挂到状态上，此前的set_board_cell不更新它们 */
+    g_game_state->nav = nav;
+    g_game_state->hpa = hpa;
+    if (!game_map && !game_pack && level_cache_dir) {
+        cached_indexes(board_rng, total);
+        cache_seed = level_pipeline_first_seed(level_rand(&board_rng));
+    } else {
+        rebuild_board_indexes();
+    }
+    
+    /* 回退日志从建好的初始状态开始记录 */
+    g_game_state->journal = journal;
+    if (journal) journal_reset(journal);
+    
+    /* 观战服务器启动失败不影响游戏 */
+    if (spectate_path &&
+        !(g_game_state->spectator = spectator_create(spectate_path, BOARD_WIDTH, BOARD_HEIGHT))) {
+        LOG_WARN("观战服务器未启动");
+    }
+    if (live_shm_name &&
+        !(g_game_state->live_shm = live_shm_create(live_shm_name, BOARD_WIDTH, BOARD_HEIGHT))) {
+        LOG_WARN("共享内存状态导出未启动");
+    }
+    
+    /* 启动后台关卡预生成，重新开始和进入下一关时直接换入
+     * （固定地图和棋盘包不需要；使用缓存时按同样的种子序列逐关查缓存） */
+    if (pipeline_enabled()) start_pipeline();
+    
+    return 0;
+}
+
+/* 在调用线程上建立同一关的副本：棋盘从cells（同一网格大小）复制，索引重新建立，
+ * 棋盘编号沿用serial，之后可以恢复该关保存的克隆（批量环境的工作线程用）。
+ * 副本只用于走步和恢复克隆：不换关，不带流水线、回退日志和状态导出 */
+int init_game_state_copy(const CellType *cells, unsigned int serial) {
+    NavGraph *nav = NULL;
+    HpaGraph *hpa = NULL;
+    Journal *journal = NULL;
+    
+    if (carve_game_state(1, &nav, &hpa, &journal) != 0) return -1;
+    memcpy(g_game_state->board[0], cells, (size_t)BOARD_WIDTH * BOARD_HEIGHT * sizeof(CellType));
+    g_game_state->nav = nav;
+    g_game_state->hpa = hpa;
+    build_board_indexes(0);
+    board_serial = serial;
     return 0;
 }
 
 /* 清理游戏状态 */
 void cleanup_game_state(void) {
+    level_pipeline_stop();
+    
     if (g_game_state) {
-        if (g_game_state->board) {
-            free_board(g_game_state->board, BOARD_HEIGHT);
-        }
-        free(g_game_state);
+        spectator_destroy(g_game_state->spectator);
+        live_shm_destroy(g_game_state->live_shm);
+        /* 状态和所有棋盘都在内存区中，一次释放 */
+        arena_destroy(&game_arena);
         g_game_state = NULL;
     }
 }
 
-/* 重置游戏状态 */
-void reset_game_state(void) {
-    if (!g_game_state) return;
-    
-    /* 释放旧的棋盘内存 */
-    if (g_game_state->board) {
-        free_board(g_game_state->board, BOARD_HEIGHT);
+/* 换入新关卡的棋盘：固定地图和棋盘包直接复制，使用缓存时查缓存，
+ * 否则优先使用预生成的棋盘，再否则在原棋盘上同步生成 */
+static void load_next_board(void) {
+    int total = 0;
+    unsigned int rng = 0;
+    void *indexes = NULL;
+    CellType **ready = pipeline_enabled() ?
+                       level_pipeline_acquire(BOARD_WIDTH, BOARD_HEIGHT, &total, &indexes,
+                                              game_seed_set) : NULL;
+    
+    if (game_map) {
+        total = map_fill_board(game_map, g_game_state->board);
+    } else if (game_pack) {
+        total = fill_from_pack();
+    } else if (level_cache_dir) {
+        rng = cache_seed;
+        total = cached_board(&rng);
+        cache_seed = level_next_seed(cache_seed);
+    } else if (ready) {
+        /* O(1)换入，旧棋盘连同它的索引交还给流水线复用 */
+        CellType **old = g_game_state->board;
+        g_game_state->board = ready;
+        level_pipeline_release(old, indexes ? live_indexes : NULL);
+        if (indexes) {
+            live_indexes = (WallIndexes*)indexes;
+            g_game_state->nexthop = live_indexes->nexthop;
+            g_game_state->hpa = live_indexes->hpa;
+        }
+    } else {
+        total = level_generate(g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT, ghost_count,
+                               board_rng, &board_scratch);
+        level_rand(&board_rng);
     }
     
-    /* 重新分配棋盘内存 */
-    g_game_state->board = allocate_board(BOARD_WIDTH, BOARD_HEIGHT);
-    if (!g_game_state->board) {
-        fprintf(stderr, "Error: Unable to reallocate memory for game board\n");
-        return;
+    board_serial++;
+    g_game_state->player_pos = g_game_state->player_spawn;
+    g_game_state->total_dots = total;
+    
+    /* 新棋盘上的幽灵表重新建立，受惊模式随之结束 */
+    g_game_state->frightened_ticks = 0;
+    g_game_state->frightened_combo = 0;
+    g_game_state->ghosts_eaten = 0;
+    
+    if (level_cache_dir && !game_map && !game_pack) {
+        cached_indexes(rng, total);
+    } else {
+        build_board_indexes(ready && indexes);
+    }
+}
+
+/* 重建依赖整块棋盘的索引：幽灵表、出口掩码、路口图、下一步表、分层图和可走位集
+ * 只在换入棋盘时调用，tick路径不扫描棋盘 */
+void rebuild_board_indexes(void) {
+    build_board_indexes(0);
+}
+
+/* 同上；walls_ready非0时下一步表和分层图已随棋盘由流水线建好，不再重建 */
+static void build_board_indexes(int walls_ready) {
+    if (!g_game_state) return;
+    ghost_registry_load(&g_game_state->ghosts, g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT,
+                        get_algorithm());
+    exits_build(g_game_state->exits, g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT);
+    if (g_game_state->nav) {
+        navgraph_build(g_game_state->nav, g_game_state->board, g_game_state->exits);
+    }
+    if (g_game_state->nexthop && !walls_ready) {
+        nexthop_build(g_game_state->nexthop, g_game_state->board, g_game_state->exits);
     }
+    if (g_game_state->hpa && !walls_ready) {
+        hpa_build(g_game_state->hpa, g_game_state->board, g_game_state->exits);
+    }
+    if (g_game_state->bits) {
+        bitbfs_build(g_game_state->bits, g_game_state->board);
+    }
+}
+
+/* 重置游戏状态 */
+void reset_game_state(void) {
+    if (!g_game_state || !g_game_state->board) return;
     
-    /* 重新初始化棋盘 */
-    init_board();
+    /* 重置路径只在原地重新初始化，不访问堆 */
+    ALLOC_CHECK_BEGIN();
     
-    /* 重置玩家位置 */
-    g_game_state->player_pos.x = 1;
-    g_game_state->player_pos.y = 1;
-    set_board_cell(1, 1, CELL_PLAYER);
+    /* 换入新棋盘（已包含玩家、幽灵和能量豆） */
+    load_next_board();
     
     /* 重置游戏统计 */
     g_game_state->dots_collected = 0;
@@ -172,139 +567,65 @@ void reset_game_state(void) {
     g_game_state->score = 0;        /* 重置分数 */
     g_game_state->level = 1;        /* 重置关卡 */
     g_game_state->auto_move_direction = DIR_RIGHT; /* 重置自动移动方向 */
+    g_game_state->player_dir = DIR_RIGHT;
     g_game_state->auto_move_enabled = 0;           /* 重置自动移动状态 */
     g_game_state->last_move_time = 0;
     
-    /* 豆子已在init_board中生成，无需额外生成 */
+    /* 回退不跨越关卡 */
+    if (g_game_state->journal) journal_reset(g_game_state->journal);
     
-    /* 重新添加幽灵 */
-    add_ghosts();
+    ALLOC_CHECK_END("reset_game_state");
+}
+
+/* 进入下一关：保留分数和生命值，换入新棋盘 */
+int advance_level(void) {
+    if (!g_game_state || !g_game_state->board) return 0;
+    if (!g_game_state->game_won) return 0;
     
-    /* 重新添加能量豆 */
-    add_power_dots();
+    load_next_board();
     
-    /* 重新计算总豆子数（包括能量豆） */
-    int total = 0;
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            if (g_game_state->board[i][j] == CELL_DOT || g_game_state->board[i][j] == CELL_POWER_DOT) {
-                total++;
-            }
-        }
+    g_game_state->dots_collected = 0;
+    g_game_state->moves_count = 0;
+    g_game_state->game_over = 0;
+    g_game_state->game_won = 0;
+    g_game_state->level++;
+    g_game_state->auto_move_enabled = 0;
+    g_game_state->last_move_time = 0;
+    if (g_game_state->journal) journal_reset(g_game_state->journal);
+    
+    LOG_INFO("进入第 %d 关", g_game_state->level);
+    return 1;
+}
+
+/* 一个模拟tick结束，提交本tick的回退记录 */
+void commit_game_tick(void) {
+    if (!g_game_state) return;
+    if (g_game_state->journal) journal_commit_tick(g_game_state->journal);
+    if (g_game_state->spectator) {
+        spectator_publish(g_game_state->spectator, g_game_state, board_serial);
     }
-    g_game_state->total_dots = total;
+    if (g_game_state->live_shm) {
+        live_shm_publish(g_game_state->live_shm, g_game_state, board_serial);
+    }
+}
+
+/* 回退ticks个tick（不超过保留的历史），返回实际回退的tick数 */
+int rewind_game(int ticks) {
+    if (!g_game_state || !g_game_state->journal) return 0;
+    return journal_rewind(g_game_state->journal, ticks);
+}
+
+/* 重做回退掉的tick，返回实际前进的tick数 */
+int replay_game(int ticks) {
+    if (!g_game_state || !g_game_state->journal) return 0;
+    return journal_forward(g_game_state->journal, ticks);
 }
 
 /* 初始化棋盘 */
 void init_board(void) {
     if (!g_game_state) return;
-    
-    /* 首先将所有格子设为空 */
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            g_game_state->board[i][j] = CELL_EMPTY;
-        }
-    }
-    
-    /* 生成四周边界墙壁 */
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            if (i == 0 || i == BOARD_HEIGHT-1 || j == 0 || j == BOARD_WIDTH-1) {
-                g_game_state->board[i][j] = CELL_WALL;
-            }
-        }
-    }
-    
-    /* 计算内部区域的格子数，并随机生成内部墙壁 */
-    int inner_width = BOARD_WIDTH - 2;
-    int inner_height = BOARD_HEIGHT - 2;
-    int inner_cells = inner_width * inner_height;
-    int inner_wall_count = (int)(inner_cells * 0.2); /* 内部墙壁数量为内部区域的20% */
-    
-    /* 确保内部墙壁数量不超过内部可用格子数 */
-    if (inner_wall_count > inner_cells - 1) { /* 至少保留玩家位置 */
-        inner_wall_count = inner_cells - 1;
-    }
-    
-    /* 在内部区域随机放置墙壁，确保不创建封闭区域 */
-    int placed_walls = 0;
-    int max_attempts = inner_wall_count * 10; /* 防止无限循环 */
-    int attempts = 0;
-    
-    while (placed_walls < inner_wall_count && attempts < max_attempts) {
-        int x = 1 + rand() % inner_width;  /* 内部区域x坐标 */
-        int y = 1 + rand() % inner_height; /* 内部区域y坐标 */
-        
-        /* 确保不在玩家初始位置(1,1)且该位置不是墙 */
-        if ((x != 1 || y != 1) && g_game_state->board[y][x] != CELL_WALL) {
-            /* 临时放置墙壁 */
-            g_game_state->board[y][x] = CELL_WALL;
-            
-            /* 检查是否会创建封闭区域 - 简单策略：确保周围至少有2个方向可通行 */
-            int passable_directions = 0;
-            int dx[] = {0, 1, 0, -1}; /* 右、下、左、上 */
-            int dy[] = {1, 0, -1, 0};
-            
-            for (int dir = 0; dir < 4; dir++) {
-                int nx = x + dx[dir];
-                int ny = y + dy[dir];
-                if (nx >= 1 && nx < BOARD_WIDTH-1 && ny >= 1 && ny < BOARD_HEIGHT-1) {
-                    if (g_game_state->board[ny][nx] != CELL_WALL) {
-                        passable_directions++;
-                    }
-                }
-            }
-            
-            /* 如果周围可通行方向少于2个，撤销墙壁放置 */
-            if (passable_directions < 2) {
-                g_game_state->board[y][x] = CELL_EMPTY;
-            } else {
-                placed_walls++;
-            }
-        }
-        attempts++;
-    }
-    
-    /* 先在所有非墙壁位置放置豆子 */
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            if (g_game_state->board[i][j] == CELL_EMPTY && (j != 1 || i != 1)) {
-                g_game_state->board[i][j] = CELL_DOT;
-            }
-        }
-    }
-    
-    /* 使用洪水填充算法标记从玩家位置可到达的区域 */
-    int visited[BOARD_HEIGHT][BOARD_WIDTH];
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            visited[i][j] = 0;
-        }
-    }
-    
-    /* 简单的递归洪水填充函数 */
-    void flood_fill(int x, int y) {
-        if (x < 0 || x >= BOARD_WIDTH || y < 0 || y >= BOARD_HEIGHT) return;
-        if (visited[y][x] || g_game_state->board[y][x] == CELL_WALL) return;
-        
-        visited[y][x] = 1;
-        flood_fill(x+1, y);
-        flood_fill(x-1, y);
-        flood_fill(x, y+1);
-        flood_fill(x, y-1);
-    }
-    
-    /* 从玩家起始位置开始洪水填充 */
-    flood_fill(1, 1);
-    
-    /* 清除不可到达区域的豆子 */
-    for (int i = 0; i < BOARD_HEIGHT; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            if (!visited[i][j] && (g_game_state->board[i][j] == CELL_DOT || g_game_state->board[i][j] == CELL_POWER_DOT)) {
-                g_game_state->board[i][j] = CELL_EMPTY;
-            }
-        }
-    }
+    level_generate_walls_and_dots(g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT, &board_rng,
+                                  &board_scratch);
 }
 
 /* 生成随机豆子 */
@@ -330,8 +651,7 @@ void generate_random_dots(int num_dots) {
 
 /* 清空棋盘单元格 */
 void clear_board_cell(int x, int y) {
-    if (!g_game_state || !is_within_bounds(x, y)) return;
-    g_game_state->board[y][x] = CELL_EMPTY;
+    set_board_cell(x, y, CELL_EMPTY);
 }
 
 /* 获取棋盘单元格类型 */
@@ -343,15 +663,40 @@ CellType get_board_cell(int x, int y) {
 /* 设置棋盘单元格类型 */
 void set_board_cell(int x, int y, CellType type) {
     if (!g_game_state || !is_within_bounds(x, y)) return;
+    CellType old_type = g_game_state->board[y][x];
     g_game_state->board[y][x] = type;
+    if (g_game_state->journal) {
+        journal_cell(g_game_state->journal, y * BOARD_WIDTH + x, old_type, type);
+    }
+    if (g_game_state->spectator) spectator_cell(g_game_state->spectator, y * BOARD_WIDTH + x);
+    if (g_game_state->live_shm) live_shm_cell(g_game_state->live_shm, y * BOARD_WIDTH + x);
+    /* 墙壁、幽灵等通行类别变化时更新相邻格的出口掩码 */
+    if (g_game_state->exits) {
+        exits_update_cell(g_game_state->exits, BOARD_WIDTH, BOARD_HEIGHT, x, y, old_type, type);
+    }
+    /* 路口图：墙壁变化时局部重建，其余只更新走廊计数 */
+    if (g_game_state->nav) {
+        navgraph_cell_changed(g_game_state->nav, g_game_state->board, g_game_state->exits,
+                              x, y, old_type, type);
+    }
+    /* 下一步表只看墙壁，墙壁变化后失效，下一次幽灵移动前重建 */
+    if (g_game_state->nexthop && (old_type == CELL_WALL) != (type == CELL_WALL)) {
+        nexthop_invalidate(g_game_state->nexthop);
+    }
+    /* 分层图：墙壁变化时标记受影响的分簇，下一次查询前重建 */
+    if (g_game_state->hpa) {
+        hpa_cell_changed(g_game_state->hpa, x, y, old_type, type);
+    }
+    /* 可走位集：墙壁变化时更新对应的位，距离场失效 */
+    if (g_game_state->bits) {
+        bitbfs_cell_changed(g_game_state->bits, x, y, old_type, type);
+    }
 }
 
 /* 检查是否碰到幽灵 */
 int is_ghost_collision(int x, int y) {
     if (!g_game_state || !is_within_bounds(x, y)) return 0;
-    CellType cell = g_game_state->board[y][x];
-    return (cell == CELL_GHOST_RED || cell == CELL_GHOST_BLUE || 
-            cell == CELL_GHOST_PURPLE || cell == CELL_GHOST_ORANGE);
+    return is_ghost_cell(g_game_state->board[y][x]);
 }
 
 /* 检查移动是否有效 */
@@ -363,7 +708,8 @@ int is_valid_move(int x, int y) {
 
 /* 处理玩家死亡 */
 void handle_player_death(void) {
-    if (!g_game_state) return;
+    /* 同一tick内多个幽灵抓到玩家时只结算一次 */
+    if (!g_game_state || g_game_state->game_over) return;
     
     g_game_state->lives--;
     
@@ -373,25 +719,19 @@ void handle_player_death(void) {
     if (g_game_state->lives <= 0) {
         /* 游戏结束 */
         g_game_state->game_over = 1;
-        printf("\n=== GAME OVER ===\n");
-        printf("你被幽灵抓住了！\n");
-        printf("最终分数: %d\n", g_game_state->score);
-        printf("总移动次数: %d\n", g_game_state->moves_count);
-        printf("================\n\n");
+        LOG_INFO("=== GAME OVER === 你被幽灵抓住了！最终分数: %d 总移动次数: %d",
+                 g_game_state->score, g_game_state->moves_count);
     } else {
         /* 还有生命，重置玩家位置 */
-        printf("\n=== 生命 -1 ===\n");
-        printf("剩余生命: %d\n", g_game_state->lives);
-        printf("==============\n\n");
+        LOG_INFO("=== 生命 -1 === 剩余生命: %d", g_game_state->lives);
         
         /* 重置玩家到起始位置 */
         int old_x = g_game_state->player_pos.x;
         int old_y = g_game_state->player_pos.y;
         set_board_cell(old_x, old_y, CELL_EMPTY);
         
-        g_game_state->player_pos.x = 1;
-        g_game_state->player_pos.y = 1;
-        set_board_cell(1, 1, CELL_PLAYER);
+        g_game_state->player_pos = g_game_state->player_spawn;
+        set_board_cell(g_game_state->player_pos.x, g_game_state->player_pos.y, CELL_PLAYER);
     }
 }
 
@@ -401,10 +741,13 @@ int move_player_to(int new_x, int new_y) {
         return 0; /* 移动失败 */
     }
     
-    /* 检查是否碰到幽灵 */
+    /* 检查是否碰到幽灵：受惊模式下吃掉幽灵后继续移动 */
     if (is_ghost_collision(new_x, new_y)) {
-        handle_player_death();
-        return 0; /* 移动失败，玩家死亡 */
+        if (!is_frightened()) {
+            handle_player_death();
+            return 0; /* 移动失败，玩家死亡 */
+        }
+        eat_ghost(ghost_registry_find(&g_game_state->ghosts, new_x, new_y));
     }
     
     /* 清除原位置的玩家 */
@@ -421,7 +764,11 @@ int move_player_to(int new_x, int new_y) {
         }
     }
     
-    /* 更新玩家位置 */
+    /* 更新玩家位置和朝向（伏击幽灵据此预判） */
+    if (new_y < old_y) g_game_state->player_dir = DIR_UP;
+    else if (new_y > old_y) g_game_state->player_dir = DIR_DOWN;
+    else if (new_x < old_x) g_game_state->player_dir = DIR_LEFT;
+    else if (new_x > old_x) g_game_state->player_dir = DIR_RIGHT;
     update_player_position(new_x, new_y);
     set_board_cell(new_x, new_y, CELL_PLAYER);
     
@@ -434,6 +781,26 @@ int move_player_to(int new_x, int new_y) {
     return 1; /* 移动成功 */
 }
 
+/* 玩家朝指定方向移动一步 */
+int step_player(Direction dir) {
+    if (!g_game_state || (unsigned)dir >= DIR_COUNT) return 0;
+    
+    /* 出口掩码查表代替边界和墙壁检查 */
+    int index = g_game_state->player_pos.y * BOARD_WIDTH + g_game_state->player_pos.x;
+    if (!(g_game_state->exits[index] & EXIT_BIT(dir))) return 0;
+    
+    int new_x = g_game_state->player_pos.x;
+    int new_y = g_game_state->player_pos.y;
+    switch (dir) {
+        case DIR_UP:    new_y--; break;
+        case DIR_DOWN:  new_y++; break;
+        case DIR_LEFT:  new_x--; break;
+        case DIR_RIGHT: new_x++; break;
+        default: return 0;
+    }
+    return move_player_to(new_x, new_y);
+}
+
 /* 更新玩家位置 */
 void update_player_position(int x, int y) {
     if (!g_game_state) return;
@@ -513,12 +880,71 @@ void collect_dot(void) {
     }
 }
 
-/* 收集能量豆 */
+/* 收集能量豆：幽灵进入受惊模式，重新开始计时和吃幽灵的连击 */
 void collect_power_dot(void) {
     if (g_game_state) {
         g_game_state->dots_collected++;
         g_game_state->score += 50;  /* 能量豆50分 */
+        g_game_state->frightened_ticks = FRIGHTENED_MOVES;
+        g_game_state->frightened_combo = 0;
+    }
+}
+
+/* 幽灵是否处于受惊模式 */
+int is_frightened(void) {
+    return g_game_state && g_game_state->frightened_ticks > 0;
+}
+
+/* 吃掉第index个幽灵：恢复它所在格的原始内容，离开棋盘等待受惊结束。
+ * 得分从200起，本次受惊每多吃一只翻倍，最多1600 */
+void eat_ghost(int index) {
+    if (!g_game_state) return;
+    GhostRegistry *g = &g_game_state->ghosts;
+    if (index < 0 || index >= g->count || g->state[index] != GHOST_STATE_ACTIVE) return;
+    
+    if (g_game_state->journal) journal_ghost(g_game_state->journal, g, index);
+    int x = g->x[index], y = g->y[index];
+    if (g_game_state->board[y][x] == (CellType)g->type[index]) {
+        set_board_cell(x, y, (CellType)g->under[index]);
+    }
+    g->state[index] = GHOST_STATE_EATEN;
+    g->next_dir[index] = DIR_COUNT;
+    
+    int combo = g_game_state->frightened_combo < 3 ? g_game_state->frightened_combo : 3;
+    g_game_state->score += GHOST_EAT_SCORE << combo;
+    g_game_state->frightened_combo++;
+    g_game_state->ghosts_eaten++;
+}
+
+/* 被吃掉的幽灵回到出生格；出生格被占用（玩家、其他幽灵、水果或墙壁）时留到下一次 */
+static void respawn_eaten_ghosts(void) {
+    GhostRegistry *g = &g_game_state->ghosts;
+    for (int i = 0; i < g->count && g_game_state->ghosts_eaten > 0; i++) {
+        if (g->state[i] != GHOST_STATE_EATEN) continue;
+        
+        int x = g->home_x[i], y = g->home_y[i];
+        CellType cell = g_game_state->board[y][x];
+        if (cell != CELL_EMPTY && cell != CELL_DOT && cell != CELL_POWER_DOT) continue;
+        
+        if (g_game_state->journal) journal_ghost(g_game_state->journal, g, i);
+        g->under[i] = (unsigned char)cell;
+        g->x[i] = x;
+        g->y[i] = y;
+        g->state[i] = GHOST_STATE_ACTIVE;
+        set_board_cell(x, y, (CellType)g->type[i]);
+        g_game_state->ghosts_eaten--;
+    }
+}
+
+/* 每次幽灵移动后调用：受惊计时减一，结束后让被吃掉的幽灵回到出生格 */
+void update_frightened_mode(void) {
+    if (!g_game_state) return;
+    if (g_game_state->frightened_ticks > 0) {
+        if (--g_game_state->frightened_ticks > 0) return;
+        /* 受惊结束：后退用的距离场不再更新，丢弃以免追踪幽灵读到过期的玩家位置 */
+        bitbfs_discard_field(g_game_state->bits);
     }
+    if (g_game_state->ghosts_eaten > 0) respawn_eaten_ghosts();
 }
 
 /* 检查胜利条件 */
@@ -535,56 +961,13 @@ void check_win_condition(void) {
 /* 添加幽灵到棋盘 */
 void add_ghosts(void) {
     if (!g_game_state) return;
-    
-    CellType ghost_types[] = {
-        CELL_GHOST_RED,
-        CELL_GHOST_BLUE, 
-        CELL_GHOST_PURPLE,
-        CELL_GHOST_ORANGE
-    };
-    
-    /* 随机放置4个幽灵 */
-    for (int i = 0; i < 4; i++) {
-        int placed = 0;
-        int attempts = 0;
-        int max_attempts = 100;
-        
-        while (!placed && attempts < max_attempts) {
-            int x = rand() % BOARD_WIDTH;
-            int y = rand() % BOARD_HEIGHT;
-            
-            /* 确保不在玩家位置且该位置是豆子 */
-            if ((x != 1 || y != 1) && g_game_state->board[y][x] == CELL_DOT) {
-                g_game_state->board[y][x] = ghost_types[i];
-                placed = 1;
-            }
-            attempts++;
-        }
-    }
+    level_place_ghosts(g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT, ghost_count, &board_rng);
 }
 
 /* 添加能量豆到棋盘 */
 void add_power_dots(void) {
     if (!g_game_state) return;
-    
-    /* 随机放置4个能量豆 */
-    for (int i = 0; i < 4; i++) {
-        int placed = 0;
-        int attempts = 0;
-        int max_attempts = 100;
-        
-        while (!placed && attempts < max_attempts) {
-            int x = rand() % BOARD_WIDTH;
-            int y = rand() % BOARD_HEIGHT;
-            
-            /* 确保不在玩家位置且该位置是豆子 */
-            if ((x != 1 || y != 1) && g_game_state->board[y][x] == CELL_DOT) {
-                g_game_state->board[y][x] = CELL_POWER_DOT;
-                placed = 1;
-            }
-            attempts++;
-        }
-    }
+    level_place_power_dots(g_game_state->board, BOARD_WIDTH, BOARD_HEIGHT, &board_rng);
 }
 
 /* 更新游戏统计 */
@@ -0,0 +1,117 @@
+#include <string.h>
+#include "ghost.h"
+
+/* 幽灵颜色按编号轮流使用 */
+static const CellType ghost_types[4] = {
+    CELL_GHOST_RED,
+    CELL_GHOST_BLUE,
+    CELL_GHOST_PURPLE,
+    CELL_GHOST_ORANGE
+};
+
+/* 第index个幽灵的显示颜色 */
+CellType ghost_type_for_index(int index) {
+    return ghost_types[index & 3];
+}
+
+/* 判断单元格是否是幽灵 */
+int is_ghost_cell(CellType cell) {
+    return cell >= CELL_GHOST_RED && cell <= CELL_GHOST_ORANGE;
+}
+
+/* 幽灵表所需的内存区字节数 */
+size_t ghost_registry_bytes(int capacity) {
+    size_t n = (size_t)capacity;
+    return 4 * arena_align(n * sizeof(int)) + 8 * arena_align(n) +
+           arena_align(n * sizeof(unsigned int));
+}
+
+/* 从内存区切分幽灵表的各个字段数组 */
+int ghost_registry_carve(Arena *arena, GhostRegistry *ghosts, int capacity) {
+    size_t n = (size_t)capacity;
+
+    memset(ghosts, 0, sizeof(*ghosts));
+    ghosts->x = (int*)arena_alloc(arena, n * sizeof(int));
+    ghosts->y = (int*)arena_alloc(arena, n * sizeof(int));
+    ghosts->dir = (unsigned char*)arena_alloc(arena, n);
+    ghosts->algo = (unsigned char*)arena_alloc(arena, n);
+    ghosts->state = (unsigned char*)arena_alloc(arena, n);
+    ghosts->type = (unsigned char*)arena_alloc(arena, n);
+    ghosts->under = (unsigned char*)arena_alloc(arena, n);
+    ghosts->home_x = (int*)arena_alloc(arena, n * sizeof(int));
+    ghosts->home_y = (int*)arena_alloc(arena, n * sizeof(int));
+    ghosts->zigzag_steps = (unsigned char*)arena_alloc(arena, n);
+    ghosts->zigzag_dir = (unsigned char*)arena_alloc(arena, n);
+    ghosts->next_dir = (unsigned char*)arena_alloc(arena, n);
+    ghosts->rng = (unsigned int*)arena_alloc(arena, n * sizeof(unsigned int));
+    if (!ghosts->x || !ghosts->y || !ghosts->dir ||
+        !ghosts->algo || !ghosts->state || !ghosts->type || !ghosts->under ||
+        !ghosts->home_x || !ghosts->home_y ||
+        !ghosts->zigzag_steps || !ghosts->zigzag_dir || !ghosts->next_dir || !ghosts->rng) {
+        return -1;
+    }
+    ghosts->capacity = capacity;
+    return 0;
+}
+
+/* 清空幽灵表（数组保留） */
+void ghost_registry_clear(GhostRegistry *ghosts) {
+    ghosts->count = 0;
+}
+
+/* 添加一个幽灵，表满时返回-1 */
+int ghost_registry_add(GhostRegistry *ghosts, int x, int y, CellType type, int algorithm) {
+    if (ghosts->count >= ghosts->capacity) return -1;
+
+    int i = ghosts->count++;
+    ghosts->x[i] = x;
+    ghosts->y[i] = y;
+    ghosts->dir[i] = DIR_RIGHT;
+    ghosts->algo[i] = (unsigned char)algorithm;
+    ghosts->state[i] = GHOST_STATE_ACTIVE;
+    ghosts->type[i] = (unsigned char)type;
+    ghosts->under[i] = CELL_EMPTY;
+    ghosts->home_x[i] = x;
+    ghosts->home_y[i] = y;
+    ghosts->zigzag_steps[i] = 0;
+    ghosts->zigzag_dir[i] = DIR_RIGHT;
+    ghosts->next_dir[i] = DIR_COUNT;
+    /* 随机数种子只取决于编号和出生位置，同一棋盘上的结果可复现 */
+    ghosts->rng[i] = (unsigned int)i * 0x9E3779B9u ^ (unsigned int)(y * 65536 + x) * 0x85EBCA6Bu;
+    return i;
+}
+
+/* 从新关卡的棋盘建立幽灵表，只在换入棋盘时调用一次，返回幽灵数 */
+int ghost_registry_load(GhostRegistry *ghosts, CellType **board, int width, int height,
+                        int algorithm) {
+    ghost_registry_clear(ghosts);
+    for (int y = 0; y < height; y++) {
+        const CellType *row = board[y];
+        for (int x = 0; x < width; x++) {
+            if (is_ghost_cell(row[x])) {
+                if (ghost_registry_add(ghosts, x, y, row[x], algorithm) < 0) {
+                    return ghosts->count;
+                }
+            }
+        }
+    }
+    return ghosts->count;
+}
+
+/* (x, y)处活动幽灵的编号，没有时返回-1；只在吃幽灵时调用 */
+int ghost_registry_find(const GhostRegistry *ghosts, int x, int y) {
+    for (int i = 0; i < ghosts->count; i++) {
+        if (ghosts->x[i] == x && ghosts->y[i] == y && ghosts->state[i] == GHOST_STATE_ACTIVE) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* 所有幽灵切换到同一算法，并重置算法状态 */
+void ghost_registry_set_algorithm(GhostRegistry *ghosts, int algorithm) {
+    size_t n = (size_t)ghosts->count;
+    memset(ghosts->algo, algorithm, n);
+    memset(ghosts->zigzag_steps, 0, n);
+    memset(ghosts->zigzag_dir, DIR_RIGHT, n);
+}
@@ -7,6 +7,10 @@
 #include "game.h"
 #include "types.h"
 #include "algorithms.h"
+#include "log.h"
+#include "arena.h"
+#include "tiles.h"
+#include "journal.h"
 #include <time.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -26,17 +30,38 @@ long get_current_time_ms(void) {
 #endif
 }
 
-/* 定时器回调函数 */
+/* 渲染插值实体：下标0为玩家，1+i对应幽灵表中的第i个幽灵 */
+#define RENDER_ENTITY_COUNT (1 + MAX_GUI_GHOST_COUNT)
+
+typedef struct {
+    CellType type;
+    int active;             /* 当前模拟状态中是否存在 */
+    int from_px, from_py;   /* 插值起点（像素） */
+    int to_px, to_py;       /* 插值终点（像素），即当前模拟状态的位置 */
+    int drawn;              /* 是否已绘制在屏幕上 */
+    int drawn_px, drawn_py; /* 上一帧的绘制位置 */
+} RenderEntity;
+
+static RenderEntity render_entities[RENDER_ENTITY_COUNT];
+static long interp_start_time = 0; /* 本段插值的起始时间（毫秒） */
+
+static void capture_entity_positions(void);
+static void render_frame(void);
+
+/* 定时器回调函数 - 固定步长的模拟tick */
 void timer_callback(void *data) {
     /* 避免编译器警告 */
     (void)data;
     
     /* 检查游戏状态 */
     if (!g_game_state || is_game_over()) {
-        AddTimeOut(100, timer_callback, NULL);
+        AddTimeOut(SIM_TICK_MS, timer_callback, NULL);
         return;
     }
     
+    /* 模拟tick路径不访问堆 */
+    ALLOC_CHECK_BEGIN();
+    
     /* 幽灵自动移动逻辑 */
     if (is_algorithm_enabled()) {
         update_ghost_movement();
@@ -44,12 +69,25 @@ void timer_callback(void *data) {
         /* 传统自动移动处理（玩家） */
         process_auto_move();
     }
+    commit_game_tick();
     
-    /* 定期更新显示 */
-    update_display();
+    ALLOC_CHECK_END("timer_callback");
+    
+    /* 记录新的模拟状态作为插值终点，绘制交给渲染定时器 */
+    capture_entity_positions();
+    update_status_display();
     
     /* 重新设置定时器，实现循环调用 */
-    AddTimeOut(100, timer_callback, NULL);
+    AddTimeOut(SIM_TICK_MS, timer_callback, NULL);
+}
+
+/* 渲染定时器回调函数 - 按显示刷新率绘制插值后的画面 */
+void render_timer_callback(void *data) {
+    (void)data;
+    
+    render_frame();
+    
+    AddTimeOut(RENDER_FRAME_MS, render_timer_callback, NULL);
 }
 
 /* 全局GUI组件 */
@@ -61,12 +99,14 @@ Widget g_status_label;
 static int color_black, color_white, color_blue, color_yellow, color_red;
 static int color_pink, color_cyan, color_purple, color_orange;
 static int color_dark_blue, color_light_blue, color_green;
+/* 图块调色板对应的libsx颜色，下标为TileColor */
+static int tile_colors[TILE_COLOR_COUNT];
 
 /* 初始化GUI */
 int init_gui(int argc, char *argv[]) {
     Widget button_up, button_down, button_left, button_right;
     Widget button_rejouer, button_aide, button_quit;
-    Widget button_random, button_zigzag, button_dfs, button_stop_algo;
+    Widget button_random, button_zigzag, button_dfs, button_classic, button_stop_algo;
     
     /* 初始化libsx */
     if (OpenDisplay(argc, argv) == 0) {
@@ -82,18 +122,21 @@ int init_gui(int argc, char *argv[]) {
     }
     
     /* 初始化颜色 */
-    color_black = GetNamedColor("black");
-    color_white = GetNamedColor("white");
-    color_blue = GetNamedColor("blue");
-    color_yellow = GetNamedColor("yellow");
-    color_red = GetNamedColor("red");
-    color_pink = GetNamedColor("pink");
-    color_cyan = GetNamedColor("cyan");
-    color_purple = GetNamedColor("purple");
-    color_orange = GetNamedColor("orange");
-    color_dark_blue = GetNamedColor("navy");
-    color_light_blue = GetNamedColor("lightblue");
-    color_green = GetNamedColor("green");
+    for (int i = 0; i < TILE_COLOR_COUNT; i++) {
+        tile_colors[i] = GetNamedColor((char*)get_tile_color_name((TileColor)i));
+    }
+    color_black = tile_colors[TILE_COLOR_BLACK];
+    color_white = tile_colors[TILE_COLOR_WHITE];
+    color_blue = tile_colors[TILE_COLOR_BLUE];
+    color_yellow = tile_colors[TILE_COLOR_YELLOW];
+    color_red = tile_colors[TILE_COLOR_RED];
+    color_pink = tile_colors[TILE_COLOR_PINK];
+    color_cyan = tile_colors[TILE_COLOR_CYAN];
+    color_purple = tile_colors[TILE_COLOR_PURPLE];
+    color_orange = tile_colors[TILE_COLOR_ORANGE];
+    color_dark_blue = tile_colors[TILE_COLOR_DARK_BLUE];
+    color_light_blue = tile_colors[TILE_COLOR_LIGHT_BLUE];
+    color_green = tile_colors[TILE_COLOR_GREEN];
     
     /* 检查颜色是否成功初始化 */
     if (color_black == -1 || color_white == -1 || color_blue == -1 || 
@@ -135,9 +178,10 @@ int init_gui(int argc, char *argv[]) {
     button_random = MakeButton("Random Ghost", button_random_callback, NULL);
     button_zigzag = MakeButton("ZigZag Ghost", button_zigzag_callback, NULL);
     button_dfs = MakeButton("Hunt Ghost", button_dfs_callback, NULL);
+    button_classic = MakeButton("Classic Ghost", button_classic_callback, NULL);
     button_stop_algo = MakeButton("Stop Ghost", button_stop_algo_callback, NULL);
     
-    if (!button_random || !button_zigzag || !button_dfs || !button_stop_algo) {
+    if (!button_random || !button_zigzag || !button_dfs || !button_classic || !button_stop_algo) {
         fprintf(stderr, "错误: 算法按钮创建失败\n");
         return -1;
     }
@@ -154,7 +198,7 @@ int init_gui(int argc, char *argv[]) {
     /* 检查所有widget是否有效 */
     if (!g_drawing_area || !button_up || !button_left || !button_down || !button_right ||
         !button_rejouer || !button_aide || !button_quit || !g_status_label ||
-        !button_random || !button_zigzag || !button_dfs || !button_stop_algo) {
+        !button_random || !button_zigzag || !button_dfs || !button_classic || !button_stop_algo) {
         fprintf(stderr, "错误: 某些GUI组件创建失败\n");
         return -1;
     }
@@ -206,8 +250,12 @@ int init_gui(int argc, char *argv[]) {
         SetWidgetPos(button_dfs, PLACE_UNDER, button_rejouer, PLACE_RIGHT, button_zigzag);
     }
     
+    if (button_classic && button_rejouer) {
+        SetWidgetPos(button_classic, PLACE_UNDER, button_rejouer, PLACE_RIGHT, button_dfs);
+    }
+    
     if (button_stop_algo && button_rejouer) {
-        SetWidgetPos(button_stop_algo, PLACE_UNDER, button_rejouer, PLACE_RIGHT, button_dfs);
+        SetWidgetPos(button_stop_algo, PLACE_UNDER, button_rejouer, PLACE_RIGHT, button_classic);
     }
     
     /* 状态标签布局 - 在算法按钮下方 */
@@ -231,8 +279,11 @@ int init_gui(int argc, char *argv[]) {
     /* 显示窗口 */
     ShowDisplay();
     
-    /* 设置定时器，每100毫秒检查一次自动移动 */
-    AddTimeOut(100, timer_callback, NULL);
+    /* 模拟定时器按固定步长推进游戏，每100毫秒检查一次自动移动 */
+    AddTimeOut(SIM_TICK_MS, timer_callback, NULL);
+    
+    /* 渲染定时器按显示刷新率绘制插值画面，与模拟步长解耦 */
+    AddTimeOut(RENDER_FRAME_MS, render_timer_callback, NULL);
     
     /* 确保窗口获得键盘焦点 - Linux/X11增强版 */
     SetWidgetState(g_main_window, 1); /* 激活窗口 */
@@ -259,6 +310,160 @@ void cleanup_gui(void) {
     /* libsx会自动清理资源 */
 }
 
+/* 执行图块的绘制图元，(x, y)为格子左上角的像素坐标 */
+static void draw_tile_shape(const TileShape *shape, int x, int y) {
+    for (int i = 0; i < shape->count; i++) {
+        const TilePrimitive *p = &shape->prims[i];
+        SetColor(tile_colors[p->color]);
+        if (p->filled) {
+            DrawFilledBox(x + p->x, y + p->y, p->w, p->h);
+        } else {
+            DrawBox(x + p->x, y + p->y, p->w, p->h);
+        }
+    }
+}
+
+/* 绘制实体精灵（玩家或幽灵），坐标为像素坐标，可以不对齐格子 */
+static void draw_entity_sprite(CellType type, int x, int y) {
+    /* 受惊模式下所有幽灵画成同一种深蓝色 */
+    if (type != CELL_PLAYER && g_game_state && g_game_state->frightened_ticks > 0) {
+        draw_tile_shape(get_tile_frightened_shape(), x, y);
+        return;
+    }
+    draw_tile_shape(get_tile_sprite_shape(type), x, y);
+}
+
+/* 绘制单元格的静态内容（墙壁、豆子等），实体所在格按空通道绘制 */
+static void draw_static_cell(int cx, int cy) {
+    draw_tile_shape(get_tile_static_shape(g_game_state->board[cy][cx]),
+                    cx * CELL_SIZE, cy * CELL_SIZE);
+}
+
+/* 计算插值进度，返回千分比 [0, 1000] */
+static int interp_alpha_permille(long now) {
+    long elapsed = now - interp_start_time;
+    if (elapsed <= 0) return 0;
+    if (elapsed >= SIM_TICK_MS) return 1000;
+    return (int)(elapsed * 1000 / SIM_TICK_MS);
+}
+
+/* 计算实体在给定插值进度下的像素位置 */
+static void interp_entity_position(const RenderEntity *e, int alpha, int *px, int *py) {
+    *px = e->from_px + (e->to_px - e->from_px) * alpha / 1000;
+    *py = e->from_py + (e->to_py - e->from_py) * alpha / 1000;
+}
+
+/* 记录当前模拟状态中的实体位置：新的插值起点取当前显示位置，终点取模拟位置 */
+static void capture_entity_positions(void) {
+    int found[RENDER_ENTITY_COUNT] = {0};
+    int target_x[RENDER_ENTITY_COUNT], target_y[RENDER_ENTITY_COUNT];
+    CellType target_type[RENDER_ENTITY_COUNT];
+    long now = get_current_time_ms();
+    int alpha = interp_alpha_permille(now);
+    
+    if (!g_game_state) return;
+    
+    /* 玩家 */
+    found[0] = 1;
+    target_x[0] = g_game_state->player_pos.x * CELL_SIZE;
+    target_y[0] = g_game_state->player_pos.y * CELL_SIZE;
+    target_type[0] = CELL_PLAYER;
+    
+    /* 幽灵：直接读取幽灵表，编号固定，不需要扫描棋盘 */
+    const GhostRegistry *ghosts = &g_game_state->ghosts;
+    for (int i = 0; i < ghosts->count && i < MAX_GUI_GHOST_COUNT; i++) {
+        if (ghosts->state[i] != GHOST_STATE_ACTIVE) continue;
+        found[1 + i] = 1;
+        target_x[1 + i] = ghosts->x[i] * CELL_SIZE;
+        target_y[1 + i] = ghosts->y[i] * CELL_SIZE;
+        target_type[1 + i] = (CellType)ghosts->type[i];
+    }
+    
+    for (int k = 0; k < RENDER_ENTITY_COUNT; k++) {
+        RenderEntity *e = &render_entities[k];
+        if (!found[k]) {
+            e->active = 0;
+            continue;
+        }
+        
+        if (e->active) {
+            /* 从当前显示位置继续插值，避免画面跳变 */
+            interp_entity_position(e, alpha, &e->from_px, &e->from_py);
+        }
+        e->type = target_type[k];
+        e->to_px = target_x[k];
+        e->to_py = target_y[k];
+        
+        /* 首次出现或跳跃超过一格（死亡复位、重新开始）时直接到位 */
+        if (!e->active || abs(e->to_px - e->from_px) > CELL_SIZE ||
+            abs(e->to_py - e->from_py) > CELL_SIZE) {
+            e->from_px = e->to_px;
+            e->from_py = e->to_py;
+        }
+        e->active = 1;
+    }
+    
+    interp_start_time = now;
+}
+
+/* 判断像素矩形是否覆盖指定格子 */
+static int sprite_covers_cell(int px, int py, int cx, int cy) {
+    return px < (cx + 1) * CELL_SIZE && px + CELL_SIZE > cx * CELL_SIZE &&
+           py < (cy + 1) * CELL_SIZE && py + CELL_SIZE > cy * CELL_SIZE;
+}
+
+/* 渲染一帧：只重绘移动实体经过的格子，再在插值位置绘制实体 */
+static void render_frame(void) {
+    int erased_x[RENDER_ENTITY_COUNT * 4], erased_y[RENDER_ENTITY_COUNT * 4];
+    int erased_count = 0;
+    int pos_x[RENDER_ENTITY_COUNT], pos_y[RENDER_ENTITY_COUNT];
+    int alpha;
+    
+    if (!g_drawing_area || !g_game_state) return;
+    
+    alpha = interp_alpha_permille(get_current_time_ms());
+    
+    /* 第一遍：擦除已移动或已消失实体的上一帧图像 */
+    for (int k = 0; k < RENDER_ENTITY_COUNT; k++) {
+        RenderEntity *e = &render_entities[k];
+        if (e->active) {
+            interp_entity_position(e, alpha, &pos_x[k], &pos_y[k]);
+        }
+        if (!e->drawn) continue;
+        if (e->active && pos_x[k] == e->drawn_px && pos_y[k] == e->drawn_py) continue;
+        
+        int cx0 = e->drawn_px / CELL_SIZE, cx1 = (e->drawn_px + CELL_SIZE - 1) / CELL_SIZE;
+        int cy0 = e->drawn_py / CELL_SIZE, cy1 = (e->drawn_py + CELL_SIZE - 1) / CELL_SIZE;
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                if (!is_within_bounds(cx, cy)) continue;
+                draw_static_cell(cx, cy);
+                erased_x[erased_count] = cx;
+                erased_y[erased_count] = cy;
+                erased_count++;
+            }
+        }
+        e->drawn = 0;
+    }
+    
+    /* 第二遍：绘制移动过的实体以及被擦除区域覆盖到的静止实体 */
+    for (int k = 0; k < RENDER_ENTITY_COUNT; k++) {
+        RenderEntity *e = &render_entities[k];
+        if (!e->active) continue;
+        
+        int need_draw = !e->drawn;
+        for (int n = 0; n < erased_count && !need_draw; n++) {
+            need_draw = sprite_covers_cell(pos_x[k], pos_y[k], erased_x[n], erased_y[n]);
+        }
+        if (!need_draw) continue;
+        
+        draw_entity_sprite(e->type, pos_x[k], pos_y[k]);
+        e->drawn = 1;
+        e->drawn_px = pos_x[k];
+        e->drawn_py = pos_y[k];
+    }
+}
+
 /* 绘制游戏棋盘 */
 void draw_board(Widget w, int width, int height, void *data) {
     int i, j;
@@ -270,7 +475,7 @@ void draw_board(Widget w, int width, int height, void *data) {
     
     /* 检查颜色是否有效 */
     if (color_white == -1 || color_black == -1 || color_blue == -1 || color_yellow == -1) {
-        printf("警告: 颜色未正确初始化，使用默认绘制\n");
+        LOG_WARN("颜色未正确初始化，使用默认绘制");
         /* 绘制一个简单的占位符 */
         DrawFilledBox(0, 0, width, height);
         return;
@@ -281,7 +486,7 @@ void draw_board(Widget w, int width, int height, void *data) {
     DrawFilledBox(0, 0, width, height);
     
     if (!g_game_state) {
-        printf("警告: 游戏状态未初始化，绘制空白棋盘\n");
+        LOG_WARN("游戏状态未初始化，绘制空白棋盘");
         /* 绘制网格线作为占位符 */
         SetColor(color_black);
         for (i = 0; i <= get_board_height(); i++) {
@@ -299,7 +504,7 @@ void draw_board(Widget w, int width, int height, void *data) {
         return;
     }
     
-    /* 绘制棋盘 */
+    /* 绘制棋盘静态内容 */
     for (i = 0; i < get_board_height(); i++) {
         for (j = 0; j < get_board_width(); j++) {
             x = j * CELL_SIZE;
@@ -308,132 +513,22 @@ void draw_board(Widget w, int width, int height, void *data) {
             /* 边界检查 */
             if (x >= width || y >= height) continue;
             
-            switch (g_game_state->board[i][j]) {
-                case CELL_WALL:
-                    /* 绘制粉色墙壁 */
-                    SetColor(color_pink);
-                    DrawFilledBox(x, y, CELL_SIZE, CELL_SIZE);
-                    /* 添加边框 */
-                    SetColor(color_blue);
-                    DrawBox(x, y, CELL_SIZE, CELL_SIZE);
-                    break;
-                    
-                case CELL_DOT:
-                    /* 绘制白色小圆点 */
-                    SetColor(color_white);
-                    if (CELL_SIZE >= 6) {
-                        int dot_size = 3;
-                        int center_x = x + CELL_SIZE/2;
-                        int center_y = y + CELL_SIZE/2;
-                        DrawFilledBox(center_x - dot_size/2, center_y - dot_size/2, dot_size, dot_size);
-                    }
-                    break;
-                    
-                case CELL_POWER_DOT:
-                    /* 绘制大能量豆 */
-                    SetColor(color_white);
-                    if (CELL_SIZE >= 8) {
-                        int dot_size = 6;
-                        int center_x = x + CELL_SIZE/2;
-                        int center_y = y + CELL_SIZE/2;
-                        DrawFilledBox(center_x - dot_size/2, center_y - dot_size/2, dot_size, dot_size);
-                    }
-                    break;
-                    
-                case CELL_PLAYER:
-                    /* 绘制黄色PacMan */
-                    SetColor(color_yellow);
-                    if (CELL_SIZE >= 8) {
-                        int pac_size = CELL_SIZE - 6;
-                        DrawFilledBox(x + 3, y + 3, pac_size, pac_size);
-                        /* 添加黑色边框 */
-                        SetColor(color_black);
-                        DrawBox(x + 3, y + 3, pac_size, pac_size);
-                    }
-                    break;
-                    
-                case CELL_GHOST_RED:
-                    /* 绘制红色幽灵 */
-                    SetColor(color_red);
-                    if (CELL_SIZE >= 8) {
-                        int ghost_size = CELL_SIZE - 4;
-                        DrawFilledBox(x + 2, y + 2, ghost_size, ghost_size);
-                        /* 添加眼睛 */
-                        SetColor(color_white);
-                        DrawFilledBox(x + 6, y + 6, 4, 4);
-                        DrawFilledBox(x + 14, y + 6, 4, 4);
-                        SetColor(color_black);
-                        DrawFilledBox(x + 7, y + 7, 2, 2);
-                        DrawFilledBox(x + 15, y + 7, 2, 2);
-                    }
-                    break;
-                    
-                case CELL_GHOST_BLUE:
-                    /* 绘制蓝色幽灵 */
-                    SetColor(color_cyan);
-                    if (CELL_SIZE >= 8) {
-                        int ghost_size = CELL_SIZE - 4;
-                        DrawFilledBox(x + 2, y + 2, ghost_size, ghost_size);
-                        /* 添加眼睛 */
-                        SetColor(color_white);
-                        DrawFilledBox(x + 6, y + 6, 4, 4);
-                        DrawFilledBox(x + 14, y + 6, 4, 4);
-                        SetColor(color_black);
-                        DrawFilledBox(x + 7, y + 7, 2, 2);
-                        DrawFilledBox(x + 15, y + 7, 2, 2);
-                    }
-                    break;
-                    
-                case CELL_GHOST_PURPLE:
-                    /* 绘制紫色幽灵 */
-                    SetColor(color_purple);
-                    if (CELL_SIZE >= 8) {
-                        int ghost_size = CELL_SIZE - 4;
-                        DrawFilledBox(x + 2, y + 2, ghost_size, ghost_size);
-                        /* 添加眼睛 */
-                        SetColor(color_white);
-                        DrawFilledBox(x + 6, y + 6, 4, 4);
-                        DrawFilledBox(x + 14, y + 6, 4, 4);
-                        SetColor(color_black);
-                        DrawFilledBox(x + 7, y + 7, 2, 2);
-                        DrawFilledBox(x + 15, y + 7, 2, 2);
-                    }
-                    break;
-                    
-                case CELL_GHOST_ORANGE:
-                    /* 绘制橙色幽灵 */
-                    SetColor(color_orange);
-                    if (CELL_SIZE >= 8) {
-                        int ghost_size = CELL_SIZE - 4;
-                        DrawFilledBox(x + 2, y + 2, ghost_size, ghost_size);
-                        /* 添加眼睛 */
-                        SetColor(color_white);
-                        DrawFilledBox(x + 6, y + 6, 4, 4);
-                        DrawFilledBox(x + 14, y + 6, 4, 4);
-                        SetColor(color_black);
-                        DrawFilledBox(x + 7, y + 7, 2, 2);
-                        DrawFilledBox(x + 15, y + 7, 2, 2);
-                    }
-                    break;
-                    
-                case CELL_FRUIT:
-                    /* 绘制水果奖励 */
-                    SetColor(color_green);
-                    if (CELL_SIZE >= 8) {
-                        int fruit_size = CELL_SIZE - 8;
-                        DrawFilledBox(x + 4, y + 4, fruit_size, fruit_size);
-                    }
-                    break;
-                    
-                case CELL_EMPTY:
-                default:
-                    /* 空格显示黑色通道 */
-                    SetColor(color_black);
-                    DrawFilledBox(x, y, CELL_SIZE, CELL_SIZE);
-                    break;
-            }
+            draw_static_cell(j, i);
         }
     }
+    
+    /* 在插值位置绘制玩家和幽灵 */
+    int alpha = interp_alpha_permille(get_current_time_ms());
+    for (int k = 0; k < RENDER_ENTITY_COUNT; k++) {
+        RenderEntity *e = &render_entities[k];
+        if (!e->active) {
+            e->drawn = 0;
+            continue;
+        }
+        interp_entity_position(e, alpha, &e->drawn_px, &e->drawn_py);
+        draw_entity_sprite(e->type, e->drawn_px, e->drawn_py);
+        e->drawn = 1;
+    }
 }
 
 /* 算法按钮回调函数 */
@@ -485,6 +580,22 @@ void button_dfs_callback(Widget w, void *data) {
     update_status_display();
 }
 
+void button_classic_callback(Widget w, void *data) {
+    (void)w; (void)data; /* 避免未使用参数警告 */
+    
+    if (!g_game_state) {
+        return;
+    }
+    
+    /* 停止当前自动移动 */
+    g_game_state->auto_move_enabled = 0;
+    
+    /* 启动经典个性幽灵：按颜色分别追击、伏击、包抄和躲避 */
+    set_algorithm(ALGO_CLASSIC);
+    
+    update_status_display();
+}
+
 void button_stop_algo_callback(Widget w, void *data) {
     (void)w; (void)data; /* 避免未使用参数警告 */
     
@@ -496,7 +607,7 @@ void button_stop_algo_callback(Widget w, void *data) {
     g_game_state->auto_move_enabled = 0;
     stop_algorithm();
     
-    printf("停止所有幽灵自动算法\n");
+    LOG_INFO("停止所有幽灵自动算法");
     update_status_display();
 }
 
@@ -505,6 +616,9 @@ void update_display(void) {
     /* 处理自动移动 - 在每次更新显示时检查 */
     process_auto_move();
     
+    /* 记录新的模拟状态，插值由渲染定时器完成 */
+    capture_entity_positions();
+    
     if (g_drawing_area && g_game_state) {
         /* 重新绘制棋盘 */
         draw_board(g_drawing_area, get_board_width() * CELL_SIZE, 
@@ -515,15 +629,12 @@ void update_display(void) {
 
 /* 显示胜利消息 */
 void show_victory_message(void) {
-    printf("\n=== VICTORY! ===\n");
-    printf("恭喜！你成功收集了所有豆子！\n");
-    printf("总移动次数: %d\n", get_moves_count());
-    printf("===============\n\n");
+    LOG_INFO("=== VICTORY! === 恭喜！你成功收集了所有豆子！总移动次数: %d", get_moves_count());
     
     /* 更新状态显示以显示胜利信息 */
     update_status_display();
     
-    printf("*** 游戏胜利！请点击主界面的 'Restart' 按钮重新开始游戏\n");
+    LOG_INFO("*** 游戏胜利！按 'N' 进入下一关，或点击主界面的 'Restart' 按钮重新开始游戏");
 }
 
 /* 更新状态显示 */
@@ -535,8 +646,8 @@ void update_status_display(void) {
     } else if (is_game_over()) {
         if (is_game_won()) {
             snprintf(status_text, sizeof(status_text), 
-                    "*** VICTORY! *** Score: %d | Lives: %d | Click 'Restart' for new game", 
-                    g_game_state->score, g_game_state->lives);
+                    "*** VICTORY! *** Level %d | Score: %d | Lives: %d | Press 'N' for next level or 'Restart'", 
+                    g_game_state->level, g_game_state->score, g_game_state->lives);
         } else {
             snprintf(status_text, sizeof(status_text), 
                     "*** GAME OVER *** Caught by Ghost! Final Score: %d | Moves: %d | Click 'Restart'", 
@@ -701,7 +812,8 @@ void button_aide_callback(Widget w, void *data) {
     printf("\n=== PacMan 游戏帮助 ===\n");
     printf("游戏目标: 收集所有蓝色圆点\n");
     printf("控制方式: WASD键或方向键移动\n");
-    printf("其他操作: R键重新开始，Q键退出\n");
+    printf("其他操作: R键重新开始，N键进入下一关（胜利后），Q键退出\n");
+    printf("回退: B键回退 %d 个tick，F键重做回退掉的tick\n", JOURNAL_GUI_STEP_TICKS);
     printf("======================\n");
 }
 
@@ -759,6 +871,23 @@ void key_press_callback(Widget w, char *input, int up_or_down, void *data) {
             case 'r': case 'R':
                 button_rejouer_callback(w, data);
                 break;
+            case 'n': case 'N':
+                /* 胜利后进入下一关，棋盘由后台预生成 */
+                if (advance_level()) {
+                    update_display();
+                }
+                break;
+            case 'b': case 'B':
+                /* 回退几秒，本关之内有效 */
+                if (rewind_game(JOURNAL_GUI_STEP_TICKS) > 0) {
+                    update_display();
+                }
+                break;
+            case 'f': case 'F':
+                if (replay_game(JOURNAL_GUI_STEP_TICKS) > 0) {
+                    update_display();
+                }
+                break;
             case 'h': case 'H':
                 button_aide_callback(w, data);
                 break;
@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "headless.h"
+#include "game.h"
+#include "algorithms.h"
+#include "term_render.h"
+#include "capture.h"
+#include "arena.h"
+#include "log.h"
+
+/* 连续这么多tick分数和移动次数都没有变化时，认为本局陷入僵局并结束 */
+#define HEADLESS_STALL_TICKS 5000
+
+/* 默认编码线程数：留一个核给模拟线程 */
+static int default_capture_workers(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 2) return 1;
+    return cpus - 1 > CAPTURE_MAX_WORKERS ? CAPTURE_MAX_WORKERS : (int)(cpus - 1);
+}
+
+/* 填充默认参数 */
+void headless_default_options(HeadlessOptions *options) {
+    options->ticks = 0;
+    options->tick_ms = SIM_TICK_MS;
+    options->algorithm = ALGO_RANDOM;
+    options->games = 1;
+    options->term = 0;
+    options->frame_every = 1;
+    options->capture_dir = NULL;
+    options->capture_format = CAPTURE_FORMAT_PNG;
+    options->capture_every = 1;
+    options->capture_workers = default_capture_workers();
+}
+
+/* 组装状态栏文本 */
+static void format_status(char *text, size_t size, long tick, int game) {
+    int n = snprintf(text, size,
+                     "Game %d | Tick %ld | Level %d | Score %d | Lives %d | Dots %d/%d | Ghosts: %s",
+                     game, tick, g_game_state->level, g_game_state->score, g_game_state->lives,
+                     g_game_state->dots_collected, g_game_state->total_dots, get_algorithm_name());
+    if (g_game_state->frightened_ticks > 0 && n > 0 && (size_t)n < size) {
+        snprintf(text + n, size - (size_t)n, " | Frightened %d", g_game_state->frightened_ticks);
+    }
+}
+
+/* 渲染一帧到终端 */
+static void render_term_frame(long tick, int game) {
+    char status[256];
+    PlayerPosition pos = get_player_position();
+    format_status(status, sizeof(status), tick, game);
+    term_render_frame(g_game_state->board, get_board_width(), get_board_height(),
+                      pos.x, pos.y, status);
+}
+
+/* 捕获当前棋盘，视口跟随玩家 */
+static void capture_current_frame(void) {
+    PlayerPosition pos = get_player_position();
+    capture_frame(g_game_state->board, get_board_width(), get_board_height(), pos.x, pos.y);
+}
+
+/* 无界面运行游戏：幽灵按选定算法移动，玩家由自动驾驶控制 */
+int run_headless(const HeadlessOptions *options) {
+    int game = 1;
+    long tick = 0;
+    long game_start_tick = 0;
+    struct timespec tick_sleep;
+    /* 玩家与幽灵按相同的间隔移动 */
+    int player_every = get_ghost_move_interval() / SIM_TICK_MS;
+    int frame_every = options->frame_every > 0 ? options->frame_every : 1;
+    int capture_every = options->capture_every > 0 ? options->capture_every : 1;
+    long progress_tick = 0;
+    int last_score = -1, last_moves = -1;
+
+    if (!g_game_state) return -1;
+    if (player_every < 1) player_every = 1;
+
+    tick_sleep.tv_sec = options->tick_ms / 1000;
+    tick_sleep.tv_nsec = (long)(options->tick_ms % 1000) * 1000000L;
+
+    if (options->term && term_render_init(STDOUT_FILENO) != 0) {
+        fprintf(stderr, "错误: 终端渲染器初始化失败\n");
+        return -1;
+    }
+    if (options->capture_dir &&
+        capture_start(options->capture_dir, options->capture_format,
+                      options->capture_workers) != 0) {
+        if (options->term) term_render_shutdown();
+        return -1;
+    }
+    if (options->algorithm != ALGO_NONE) {
+        set_algorithm(options->algorithm);
+    }
+    if (options->capture_dir) {
+        capture_current_frame();
+    }
+
+    while (options->ticks == 0 || tick < options->ticks) {
+        /* 玩家被幽灵堵住、无豆可吃时结束本局，避免批量运行卡死 */
+        if (g_game_state->score != last_score || g_game_state->moves_count != last_moves) {
+            last_score = g_game_state->score;
+            last_moves = g_game_state->moves_count;
+            progress_tick = tick;
+        } else if (tick - progress_tick >= HEADLESS_STALL_TICKS && !is_game_over()) {
+            LOG_WARN("第 %d 局在 %d 个tick内没有进展，按僵局结束", game, HEADLESS_STALL_TICKS);
+            g_game_state->game_over = 1;
+        }
+        
+        if (is_game_over()) {
+            LOG_INFO("第 %d 局结束: %s 分数: %d 关卡: %d 用时: %ld ticks", game,
+                     is_game_won() ? "胜利" : "失败", g_game_state->score,
+                     g_game_state->level, tick - game_start_tick);
+            if (game >= options->games) break;
+
+            game++;
+            game_start_tick = tick;
+            progress_tick = tick;
+            reset_game_state();
+            if (options->algorithm != ALGO_NONE) {
+                set_algorithm(options->algorithm);
+            }
+        }
+
+        /* 模拟tick路径不访问堆 */
+        ALLOC_CHECK_BEGIN();
+        if (is_algorithm_enabled()) {
+            update_ghost_movement();
+        }
+        if (tick % player_every == 0 && !is_game_over()) {
+            Direction dir = autopilot_next_direction();
+            if (dir != DIR_COUNT) {
+                step_player(dir);
+            }
+        }
+        commit_game_tick();
+        ALLOC_CHECK_END("headless tick");
+        tick++;
+
+        if (options->term && tick % frame_every == 0) {
+            render_term_frame(tick, game);
+        }
+        if (options->capture_dir && tick % capture_every == 0) {
+            capture_current_frame();
+        }
+        if (options->tick_ms > 0) {
+            nanosleep(&tick_sleep, NULL);
+        }
+    }
+
+    if (options->term) {
+        render_term_frame(tick, game);
+        term_render_shutdown();
+    }
+    if (options->capture_dir) {
+        capture_stop();
+    }
+
+    LOG_INFO("无界面运行结束: %d 局, %ld ticks, 最终分数: %d", game, tick, g_game_state->score);
+    return 0;
+}
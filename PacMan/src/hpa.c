@@ -0,0 +1,889 @@
+#include <string.h>
+#include "hpa.h"
+#include "exits.h"
+#include "ghost.h"
+#include "parallel.h"
+
+/* 每个分簇最多的节点数：每条边上的入口不超过 HPA_CLUSTER_SIZE / 2 个 */
+#define HPA_MAX_NODES (2 * HPA_CLUSTER_SIZE)
+#define HPA_CLUSTER_CELLS (HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE)
+
+/* 边界上通往同一对簇内连通分量的开口，在这个跨度内合并为一个入口 */
+#define HPA_ENTRANCE_SPAN 16
+
+/* 重建时每块处理的分簇数 */
+#define HPA_BUILD_CHUNK 4
+/* 追踪时每块展开的分簇数 */
+#define HPA_RESOLVE_CHUNK 2
+
+/* 簇内边：高6位为同分簇的节点序号，低10位为步数（分簇内的路径不超过1023步） */
+#define HPA_ADJ(j, d) ((unsigned short)(((j) << 10) | (d)))
+#define HPA_ADJ_NODE(a) ((a) >> 10)
+#define HPA_ADJ_DIST(a) ((a) & 0x3FFu)
+
+#define HPA_UNREACHED 0xFFFFu        /* 分簇内搜索未到达 */
+#define HPA_NO_COMP 0xFFFFu          /* 墙格不属于任何连通分量 */
+#define HPA_COMP_PENDING 0xFFFEu     /* 尚未标记的可走格 */
+#define HPA_INF 0x3FFFFFFFu
+
+static const int hpa_dx[4] = {0, 0, -1, 1};
+static const int hpa_dy[4] = {-1, 1, 0, 0};
+static const int hpa_opposite[4] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+static const int hpa_local_offset[4] = {-HPA_CLUSTER_SIZE, HPA_CLUSTER_SIZE, -1, 1};
+
+/* 分簇：位置和大小，节点按所在的边（下标为Direction）依次排列 */
+typedef struct {
+    int ox, oy, w, h;
+    int side_start[5];           /* 第d条边的节点为 side_start[d] .. side_start[d + 1] - 1 */
+    int dots;                    /* 豆子/能量豆/水果数 */
+    int dirty;
+} HpaCluster;
+
+/* 两个相邻分簇之间的边界：各入口沿边界的偏移。相邻的两个入口之间
+ * 要么隔着墙，要么相距至少两格，所以一条边界上不超过 HPA_CLUSTER_SIZE / 2 个 */
+typedef struct {
+    int count;
+    unsigned char pos[HPA_CLUSTER_SIZE / 2];
+} HpaBorder;
+
+/* 抽象图上一次搜索的距离记录，按轮次标记避免每次清空 */
+typedef struct {
+    unsigned int *dist;
+    unsigned int *stamp;
+    int *pred;                   /* 前驱节点，在起点分簇内直接播种的为-1；不需要时为NULL */
+    unsigned int round;
+} HpaSearch;
+
+/* 分簇内逐格搜索的结果，按分簇内坐标 y * HPA_CLUSTER_SIZE + x 存放 */
+typedef struct {
+    unsigned short dist[HPA_CLUSTER_CELLS];
+    unsigned char first[HPA_CLUSTER_CELLS];    /* 从起点出发的第一步方向 */
+    unsigned short queue[HPA_CLUSTER_CELLS];
+} HpaLocal;
+
+struct HpaGraph {
+    int width, height;
+    int cols, rows, cluster_count;
+    int cluster_offset[4];       /* 相邻分簇编号偏移，下标为Direction */
+    HpaCluster *clusters;
+    HpaBorder *right;            /* right[c]: 分簇c与右侧分簇之间的边界 */
+    HpaBorder *below;            /* below[c]: 分簇c与下方分簇之间的边界 */
+    int *dirty_list;
+    int dirty_count;
+
+    /* 按分簇存放的玩家出口掩码，去掉了通往分簇外的方向：
+     * local_exits[c * HPA_CLUSTER_CELLS + 分簇内坐标] */
+    unsigned char *local_exits;
+    unsigned short *local_comp;  /* 簇内连通分量编号，墙为HPA_NO_COMP */
+
+    /* 节点u = 分簇编号 * HPA_MAX_NODES + 分簇内序号 */
+    int node_capacity;
+    unsigned short *node_local;  /* 节点格的分簇内坐标 */
+    unsigned char *node_side;    /* 节点所在的边，也是通往相邻分簇的方向 */
+    unsigned char *node_degree;  /* 簇内边数 */
+    unsigned short *adj;         /* adj[u * HPA_MAX_NODES + k]: 第k条簇内边（HPA_ADJ） */
+
+    /* 重建期间使用的棋盘 */
+    CellType **board;
+    const unsigned char *exits;
+
+    /* 搜索：带位置索引的二叉堆，键为heap_owner的距离 */
+    HpaSearch search, chase;
+    int *heap, *heap_pos;
+    int heap_size;
+    HpaSearch *heap_owner;
+
+    /* 追踪距离场对应的玩家位置 */
+    int chase_valid, chase_x, chase_y;
+
+    /* 追踪距离场展开到格子：有幽灵的分簇各做一次簇内搜索，
+     * chase_cells[c * HPA_CLUSTER_CELLS + 分簇内坐标]为该格到玩家的距离，
+     * 只在cluster_round[c] == field_round时有效，距离场重新计算后全部失效 */
+    unsigned int *chase_cells;
+    unsigned int *cluster_round;
+    unsigned int field_round;
+    int *resolve_list;
+    int resolve_count;
+};
+
+/* 判断单元格是否是玩家要收集的目标 */
+static int hpa_is_target(CellType cell) {
+    return cell == CELL_DOT || cell == CELL_POWER_DOT || cell == CELL_FRUIT;
+}
+
+/* 分层图所需的内存区字节数，小于阈值的棋盘为0 */
+size_t hpa_bytes(int width, int height) {
+    if ((size_t)width * height < HPA_MIN_CELLS) return 0;
+    size_t clusters = (size_t)((width + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE) *
+                      ((height + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE);
+    size_t nodes = clusters * HPA_MAX_NODES;
+    return arena_align(sizeof(HpaGraph)) +
+           arena_align(clusters * sizeof(HpaCluster)) +
+           2 * arena_align(clusters * sizeof(HpaBorder)) +
+           arena_align(clusters * sizeof(int)) +
+           arena_align(clusters * HPA_CLUSTER_CELLS) +                         /* 簇内掩码 */
+           arena_align(clusters * HPA_CLUSTER_CELLS * sizeof(unsigned short)) +  /* 连通分量 */
+           arena_align(nodes * sizeof(unsigned short)) + 2 * arena_align(nodes) +  /* 节点 */
+           arena_align(nodes * HPA_MAX_NODES * sizeof(unsigned short)) +       /* 簇内边 */
+           4 * arena_align(nodes * sizeof(unsigned int)) +                     /* 两次搜索 */
+           3 * arena_align(nodes * sizeof(int)) +                              /* 前驱、堆 */
+           arena_align(clusters * HPA_CLUSTER_CELLS * sizeof(unsigned int)) +  /* 格子距离 */
+           arena_align(clusters * sizeof(unsigned int)) + arena_align(clusters * sizeof(int));
+}
+
+/* 从内存区切分分层图，小于阈值或分配失败时返回NULL */
+HpaGraph *hpa_carve(Arena *arena, int width, int height) {
+    if ((size_t)width * height < HPA_MIN_CELLS) return NULL;
+
+    HpaGraph *g = (HpaGraph*)arena_alloc(arena, sizeof(HpaGraph));
+    if (!g) return NULL;
+    memset(g, 0, sizeof(*g));
+    g->width = width;
+    g->height = height;
+    g->cols = (width + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+    g->rows = (height + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+    g->cluster_count = g->cols * g->rows;
+    g->cluster_offset[DIR_UP] = -g->cols;
+    g->cluster_offset[DIR_DOWN] = g->cols;
+    g->cluster_offset[DIR_LEFT] = -1;
+    g->cluster_offset[DIR_RIGHT] = 1;
+    g->node_capacity = g->cluster_count * HPA_MAX_NODES;
+
+    size_t clusters = (size_t)g->cluster_count;
+    size_t nodes = (size_t)g->node_capacity;
+    g->clusters = (HpaCluster*)arena_alloc(arena, clusters * sizeof(HpaCluster));
+    g->right = (HpaBorder*)arena_alloc(arena, clusters * sizeof(HpaBorder));
+    g->below = (HpaBorder*)arena_alloc(arena, clusters * sizeof(HpaBorder));
+    g->dirty_list = (int*)arena_alloc(arena, clusters * sizeof(int));
+    g->local_exits = (unsigned char*)arena_alloc(arena, clusters * HPA_CLUSTER_CELLS);
+    g->local_comp = (unsigned short*)arena_alloc(arena, clusters * HPA_CLUSTER_CELLS *
+                                                        sizeof(unsigned short));
+    g->node_local = (unsigned short*)arena_alloc(arena, nodes * sizeof(unsigned short));
+    g->node_side = (unsigned char*)arena_alloc(arena, nodes);
+    g->node_degree = (unsigned char*)arena_alloc(arena, nodes);
+    g->adj = (unsigned short*)arena_alloc(arena, nodes * HPA_MAX_NODES * sizeof(unsigned short));
+    g->search.dist = (unsigned int*)arena_alloc(arena, nodes * sizeof(unsigned int));
+    g->search.stamp = (unsigned int*)arena_alloc(arena, nodes * sizeof(unsigned int));
+    g->search.pred = (int*)arena_alloc(arena, nodes * sizeof(int));
+    g->chase.dist = (unsigned int*)arena_alloc(arena, nodes * sizeof(unsigned int));
+    g->chase.stamp = (unsigned int*)arena_alloc(arena, nodes * sizeof(unsigned int));
+    g->heap = (int*)arena_alloc(arena, nodes * sizeof(int));
+    g->heap_pos = (int*)arena_alloc(arena, nodes * sizeof(int));
+    g->chase_cells = (unsigned int*)arena_alloc(arena, clusters * HPA_CLUSTER_CELLS *
+                                                       sizeof(unsigned int));
+    g->cluster_round = (unsigned int*)arena_alloc(arena, clusters * sizeof(unsigned int));
+    g->resolve_list = (int*)arena_alloc(arena, clusters * sizeof(int));
+    if (!g->chase_cells || !g->cluster_round || !g->resolve_list) return NULL;
+    if (!g->clusters || !g->right || !g->below || !g->dirty_list || !g->local_exits ||
+        !g->local_comp ||
+        !g->node_local || !g->node_side || !g->node_degree || !g->adj || !g->search.dist ||
+        !g->search.stamp || !g->search.pred || !g->chase.dist || !g->chase.stamp || !g->heap || !g->heap_pos) {
+        return NULL;
+    }
+
+    memset(g->clusters, 0, clusters * sizeof(HpaCluster));
+    for (int c = 0; c < g->cluster_count; c++) {
+        HpaCluster *cl = &g->clusters[c];
+        cl->ox = (c % g->cols) * HPA_CLUSTER_SIZE;
+        cl->oy = (c / g->cols) * HPA_CLUSTER_SIZE;
+        cl->w = width - cl->ox < HPA_CLUSTER_SIZE ? width - cl->ox : HPA_CLUSTER_SIZE;
+        cl->h = height - cl->oy < HPA_CLUSTER_SIZE ? height - cl->oy : HPA_CLUSTER_SIZE;
+    }
+    memset(g->search.stamp, 0, nodes * sizeof(unsigned int));
+    memset(g->chase.stamp, 0, nodes * sizeof(unsigned int));
+    memset(g->heap_pos, 0xFF, nodes * sizeof(int));
+    memset(g->cluster_round, 0, clusters * sizeof(unsigned int));
+    return g;
+}
+
+/* 分簇记录中只有豆子数随棋盘内容变化，墙壁不变时整段复制分簇记录即可 */
+size_t hpa_counts_bytes(const HpaGraph *graph) {
+    return (size_t)graph->cluster_count * sizeof(HpaCluster);
+}
+
+void hpa_save_counts(const HpaGraph *graph, void *counts) {
+    memcpy(counts, graph->clusters, (size_t)graph->cluster_count * sizeof(HpaCluster));
+}
+
+void hpa_load_counts(HpaGraph *graph, const void *counts) {
+    memcpy(graph->clusters, counts, (size_t)graph->cluster_count * sizeof(HpaCluster));
+}
+
+/* 分簇数 */
+int hpa_cluster_count(const HpaGraph *graph) {
+    return graph->cluster_count;
+}
+
+/* 抽象图的节点数 */
+int hpa_node_count(const HpaGraph *graph) {
+    int total = 0;
+    for (int c = 0; c < graph->cluster_count; c++) {
+        total += graph->clusters[c].side_start[4];
+    }
+    return total;
+}
+
+/* 格子所在的分簇 */
+static int hpa_cluster_of(const HpaGraph *g, int x, int y) {
+    return (y / HPA_CLUSTER_SIZE) * g->cols + x / HPA_CLUSTER_SIZE;
+}
+
+/* 格子的分簇内坐标 */
+static int hpa_local_of(int x, int y) {
+    return (y % HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE + x % HPA_CLUSTER_SIZE;
+}
+
+/* 在分簇c内从分簇内坐标start开始逐格广度优先搜索，不离开分簇。
+ * cells为NULL时只看墙壁并搜索整个分簇，返回-1；否则绕开幽灵，
+ * 出队到豆子/能量豆/水果时停止并返回该格的分簇内坐标 */
+static int hpa_local_search(const HpaGraph *g, const CellType *cells, int c, int start,
+                            HpaLocal *out) {
+    const HpaCluster *cl = &g->clusters[c];
+    const unsigned char *mask = g->local_exits + (size_t)c * HPA_CLUSTER_CELLS;
+    const CellType *origin = cells ? cells + cl->oy * g->width + cl->ox : NULL;
+    int head = 0, tail = 0;
+
+    memset(out->dist, 0xFF, sizeof(out->dist));
+    out->dist[start] = 0;
+    out->first[start] = DIR_COUNT;
+    out->queue[tail++] = (unsigned short)start;
+    while (head < tail) {
+        int l = out->queue[head++];
+        const CellType *cell = origin ? origin + (l / HPA_CLUSTER_SIZE) * g->width +
+                                        l % HPA_CLUSTER_SIZE : NULL;
+        if (cell && hpa_is_target(*cell)) return l;
+
+        const ExitDirList *list = &exit_dir_lists[mask[l]];
+        for (int k = 0; k < list->count; k++) {
+            int dir = list->dirs[k];
+            int next = l + hpa_local_offset[dir];
+            if (out->dist[next] != HPA_UNREACHED) continue;
+            if (cell && is_ghost_cell(cell[hpa_dy[dir] * g->width + hpa_dx[dir]])) continue;
+            out->dist[next] = (unsigned short)(out->dist[l] + 1);
+            out->first[next] = (unsigned char)(l == start ? dir : out->first[l]);
+            out->queue[tail++] = (unsigned short)next;
+        }
+    }
+    return -1;
+}
+
+/* 扫描分簇c与右侧（vertical为1）或下方分簇之间的边界：两侧都不是墙的一对格子是开口，
+ * 两侧分别属于同一对簇内连通分量、且跨度不超过HPA_ENTRANCE_SPAN的开口合并为一个入口，
+ * 入口取这组开口中最靠近中点的一对。入口有变化时返回1 */
+static int hpa_scan_border(HpaGraph *g, int c, int vertical) {
+    const HpaCluster *cl = &g->clusters[c];
+    const unsigned short *comp_a = g->local_comp + (size_t)c * HPA_CLUSTER_CELLS;
+    const unsigned short *comp_b = g->local_comp +
+                                   (size_t)(c + (vertical ? 1 : g->cols)) * HPA_CLUSTER_CELLS;
+    HpaBorder *b = vertical ? &g->right[c] : &g->below[c];
+    HpaBorder old = *b;
+    int len = vertical ? cl->h : cl->w;
+    int step = vertical ? HPA_CLUSTER_SIZE : 1;
+    int side_a = vertical ? cl->w - 1 : (cl->h - 1) * HPA_CLUSTER_SIZE;
+    int lo[HPA_CLUSTER_SIZE], hi[HPA_CLUSTER_SIZE];
+    unsigned short pair_a[HPA_CLUSTER_SIZE], pair_b[HPA_CLUSTER_SIZE];
+    int groups = 0;
+
+    for (int k = 0; k < len; k++) {
+        unsigned short a = comp_a[side_a + k * step], bb = comp_b[k * step];
+        if (a == HPA_NO_COMP || bb == HPA_NO_COMP) continue;
+        int gi = groups - 1;
+        while (gi >= 0 && (pair_a[gi] != a || pair_b[gi] != bb)) gi--;
+        if (gi >= 0 && k - lo[gi] < HPA_ENTRANCE_SPAN) {
+            hi[gi] = k;
+        } else {
+            lo[groups] = hi[groups] = k;
+            pair_a[groups] = a;
+            pair_b[groups] = bb;
+            groups++;
+        }
+    }
+
+    b->count = groups;
+    for (int gi = 0; gi < groups; gi++) {
+        int center = (lo[gi] + hi[gi]) / 2, best = lo[gi];
+        for (int k = lo[gi]; k <= hi[gi]; k++) {
+            int diff = k > center ? k - center : center - k;
+            int best_diff = best > center ? best - center : center - best;
+            if (diff < best_diff && comp_a[side_a + k * step] == pair_a[gi] &&
+                comp_b[k * step] == pair_b[gi]) {
+                best = k;
+            }
+        }
+        b->pos[gi] = (unsigned char)best;
+    }
+    return old.count != b->count || memcmp(old.pos, b->pos, (size_t)b->count) != 0;
+}
+
+/* 把一条边界上的入口加入分簇c的节点表，返回新的节点数 */
+static int hpa_add_side(HpaGraph *g, int c, int side, const HpaBorder *b, int n) {
+    const HpaCluster *cl = &g->clusters[c];
+    int base = c * HPA_MAX_NODES;
+
+    for (int k = 0; k < b->count; k++, n++) {
+        int lx = b->pos[k], ly = b->pos[k];
+        if (side == DIR_UP) ly = 0;
+        if (side == DIR_DOWN) ly = cl->h - 1;
+        if (side == DIR_LEFT) lx = 0;
+        if (side == DIR_RIGHT) lx = cl->w - 1;
+        g->node_local[base + n] = (unsigned short)(ly * HPA_CLUSTER_SIZE + lx);
+        g->node_side[base + n] = (unsigned char)side;
+    }
+    return n;
+}
+
+/* 重建的第一步：分簇c的簇内掩码、连通分量和目标数，只读棋盘，只写分簇c自己的数据 */
+static void hpa_prepare_cluster(HpaGraph *g, int c) {
+    HpaCluster *cl = &g->clusters[c];
+    unsigned char *mask = g->local_exits + (size_t)c * HPA_CLUSTER_CELLS;
+    unsigned short *comp = g->local_comp + (size_t)c * HPA_CLUSTER_CELLS;
+    unsigned short queue[HPA_CLUSTER_CELLS];
+    unsigned short label = 0;
+
+    /* 簇内掩码：分簇边缘上去掉通往分簇外的方向，跨簇由抽象图负责 */
+    cl->dots = 0;
+    for (int ly = 0; ly < cl->h; ly++) {
+        const CellType *row = g->board[cl->oy + ly] + cl->ox;
+        const unsigned char *exits = g->exits + (size_t)(cl->oy + ly) * g->width + cl->ox;
+        for (int lx = 0; lx < cl->w; lx++) {
+            unsigned int m = row[lx] == CELL_WALL ? 0 : EXIT_PLAYER_MASK(exits[lx]);
+            if (ly == 0) m &= ~EXIT_BIT(DIR_UP);
+            if (ly == cl->h - 1) m &= ~EXIT_BIT(DIR_DOWN);
+            if (lx == 0) m &= ~EXIT_BIT(DIR_LEFT);
+            if (lx == cl->w - 1) m &= ~EXIT_BIT(DIR_RIGHT);
+            mask[ly * HPA_CLUSTER_SIZE + lx] = (unsigned char)m;
+            comp[ly * HPA_CLUSTER_SIZE + lx] = row[lx] == CELL_WALL ? HPA_NO_COMP : HPA_COMP_PENDING;
+            cl->dots += hpa_is_target(row[lx]);
+        }
+    }
+
+    /* 标记连通分量 */
+    for (int ly = 0; ly < cl->h; ly++) {
+        for (int lx = 0; lx < cl->w; lx++) {
+            int start = ly * HPA_CLUSTER_SIZE + lx;
+            if (comp[start] != HPA_COMP_PENDING) continue;
+            int head = 0, tail = 0;
+            comp[start] = label;
+            queue[tail++] = (unsigned short)start;
+            while (head < tail) {
+                int l = queue[head++];
+                const ExitDirList *list = &exit_dir_lists[mask[l]];
+                for (int k = 0; k < list->count; k++) {
+                    int next = l + hpa_local_offset[list->dirs[k]];
+                    if (comp[next] != HPA_COMP_PENDING) continue;
+                    comp[next] = label;
+                    queue[tail++] = (unsigned short)next;
+                }
+            }
+            label++;
+        }
+    }
+}
+
+/* 重建的第二步（边界已扫描）：分簇c的节点表和簇内边，只写分簇c自己的数据 */
+static void hpa_rebuild_cluster(HpaGraph *g, int c) {
+    HpaCluster *cl = &g->clusters[c];
+    int cx = c % g->cols, cy = c / g->cols;
+    int base = c * HPA_MAX_NODES;
+    int n = 0;
+    unsigned short dist[HPA_MAX_NODES][HPA_MAX_NODES];
+    HpaLocal local;
+
+    cl->side_start[DIR_UP] = n;
+    if (cy > 0) n = hpa_add_side(g, c, DIR_UP, &g->below[c - g->cols], n);
+    cl->side_start[DIR_DOWN] = n;
+    if (cy < g->rows - 1) n = hpa_add_side(g, c, DIR_DOWN, &g->below[c], n);
+    cl->side_start[DIR_LEFT] = n;
+    if (cx > 0) n = hpa_add_side(g, c, DIR_LEFT, &g->right[c - 1], n);
+    cl->side_start[DIR_RIGHT] = n;
+    if (cx < g->cols - 1) n = hpa_add_side(g, c, DIR_RIGHT, &g->right[c], n);
+    cl->side_start[4] = n;
+
+    /* 两两距离：距离对称，从每个节点搜索一次填一行 */
+    for (int i = 0; i < n; i++) {
+        hpa_local_search(g, NULL, c, g->node_local[base + i], &local);
+        for (int j = 0; j < n; j++) {
+            dist[i][j] = local.dist[g->node_local[base + j]];
+        }
+    }
+
+    /* 只保留不能由更短的两段拼出的簇内边：dist[i][k] + dist[k][j] == dist[i][j]
+     * 且两段都大于0时，经k走同样短，去掉i到j的边不影响抽象图上的最短距离 */
+    for (int i = 0; i < n; i++) {
+        unsigned short *adj = g->adj + (size_t)(base + i) * HPA_MAX_NODES;
+        int degree = 0;
+        for (int j = 0; j < n; j++) {
+            unsigned int d = dist[i][j];
+            if (j == i || d == HPA_UNREACHED) continue;
+            int implied = 0;
+            for (int k = 0; k < n && !implied; k++) {
+                unsigned int a = dist[i][k], b = dist[k][j];
+                implied = a > 0 && b > 0 && a != HPA_UNREACHED && b != HPA_UNREACHED &&
+                          a + b == d;
+            }
+            if (!implied) adj[degree++] = HPA_ADJ(j, d);
+        }
+        g->node_degree[base + i] = (unsigned char)degree;
+    }
+    cl->dirty = 0;
+}
+
+/* 并行准备一段待重建的分簇 */
+static void hpa_prepare_range(int begin, int end, void *context) {
+    HpaGraph *g = (HpaGraph*)context;
+    for (int k = begin; k < end; k++) {
+        hpa_prepare_cluster(g, g->dirty_list[k]);
+    }
+}
+
+/* 并行重建一段待重建的分簇 */
+static void hpa_rebuild_range(int begin, int end, void *context) {
+    HpaGraph *g = (HpaGraph*)context;
+    for (int k = begin; k < end; k++) {
+        hpa_rebuild_cluster(g, g->dirty_list[k]);
+    }
+}
+
+/* 标记分簇c待重建 */
+static void hpa_mark_dirty(HpaGraph *g, int c) {
+    if (g->clusters[c].dirty) return;
+    g->clusters[c].dirty = 1;
+    g->dirty_list[g->dirty_count++] = c;
+}
+
+/* 重建所有待重建的分簇：并行计算簇内掩码和连通分量，串行扫描它们的四条边界，
+ * 再并行重建节点和簇内边。连通分量变化可能改变边界上的入口，此时相邻分簇的
+ * 节点表也要重建，但它自己的掩码和连通分量不变 */
+static void hpa_refresh(HpaGraph *g, CellType **board, const unsigned char *exits) {
+    if (g->dirty_count == 0) return;
+
+    g->board = board;
+    g->exits = exits;
+    int changed = g->dirty_count;
+    parallel_for(changed, HPA_BUILD_CHUNK, hpa_prepare_range, g);
+    for (int k = 0; k < changed; k++) {
+        int c = g->dirty_list[k];
+        int cx = c % g->cols, cy = c / g->cols;
+        if (cx < g->cols - 1 && hpa_scan_border(g, c, 1)) hpa_mark_dirty(g, c + 1);
+        if (cy < g->rows - 1 && hpa_scan_border(g, c, 0)) hpa_mark_dirty(g, c + g->cols);
+        if (cx > 0 && hpa_scan_border(g, c - 1, 1)) hpa_mark_dirty(g, c - 1);
+        if (cy > 0 && hpa_scan_border(g, c - g->cols, 0)) hpa_mark_dirty(g, c - g->cols);
+    }
+    parallel_for(g->dirty_count, HPA_BUILD_CHUNK, hpa_rebuild_range, g);
+    g->dirty_count = 0;
+    g->board = NULL;
+    g->exits = NULL;
+    g->chase_valid = 0;
+}
+
+/* 根据整块棋盘重建所有分簇 */
+void hpa_build(HpaGraph *graph, CellType **board, const unsigned char *exits) {
+    for (int c = 0; c < graph->cluster_count; c++) {
+        hpa_mark_dirty(graph, c);
+    }
+    hpa_refresh(graph, board, exits);
+}
+
+/* 映像中依次存放的数组：地址和字节数 */
+static int hpa_image_parts(const HpaGraph *g, void **parts, size_t *sizes) {
+    size_t clusters = (size_t)g->cluster_count;
+    size_t nodes = (size_t)g->node_capacity;
+    parts[0] = g->clusters;    sizes[0] = clusters * sizeof(HpaCluster);
+    parts[1] = g->right;       sizes[1] = clusters * sizeof(HpaBorder);
+    parts[2] = g->below;       sizes[2] = clusters * sizeof(HpaBorder);
+    parts[3] = g->local_exits; sizes[3] = clusters * HPA_CLUSTER_CELLS;
+    parts[4] = g->local_comp;  sizes[4] = clusters * HPA_CLUSTER_CELLS * sizeof(unsigned short);
+    parts[5] = g->node_local;  sizes[5] = nodes * sizeof(unsigned short);
+    parts[6] = g->node_side;   sizes[6] = nodes;
+    parts[7] = g->node_degree; sizes[7] = nodes;
+    parts[8] = g->adj;         sizes[8] = nodes * HPA_MAX_NODES * sizeof(unsigned short);
+    return 9;
+}
+
+size_t hpa_image_bytes(const HpaGraph *graph) {
+    void *parts[9];
+    size_t sizes[9], total = 0;
+    int count = hpa_image_parts(graph, parts, sizes);
+    for (int i = 0; i < count; i++) total += sizes[i];
+    return total;
+}
+
+void hpa_save_image(const HpaGraph *graph, unsigned char *image) {
+    void *parts[9];
+    size_t sizes[9];
+    int count = hpa_image_parts(graph, parts, sizes);
+    for (int i = 0; i < count; i++) {
+        memcpy(image, parts[i], sizes[i]);
+        image += sizes[i];
+    }
+}
+
+/* 载入映像代替重建：分簇都不再待重建，追踪距离场需要重新计算 */
+int hpa_load_image(HpaGraph *graph, const unsigned char *image, size_t size) {
+    void *parts[9];
+    size_t sizes[9];
+    if (size != hpa_image_bytes(graph)) return -1;
+    int count = hpa_image_parts(graph, parts, sizes);
+    for (int i = 0; i < count; i++) {
+        memcpy(parts[i], image, sizes[i]);
+        image += sizes[i];
+    }
+    for (int c = 0; c < graph->cluster_count; c++) graph->clusters[c].dirty = 0;
+    graph->dirty_count = 0;
+    graph->chase_valid = 0;
+    return 0;
+}
+
+/* 格子(x, y)的类型改变：更新目标数；墙壁变化时标记所在分簇待重建，
+ * 边界上的入口是否变化在重建时扫描，相邻分簇按需跟着重建 */
+void hpa_cell_changed(HpaGraph *graph, int x, int y, CellType old_type, CellType new_type) {
+    HpaGraph *g = graph;
+    HpaCluster *cl = &g->clusters[hpa_cluster_of(g, x, y)];
+
+    cl->dots += hpa_is_target(new_type) - hpa_is_target(old_type);
+    if ((old_type == CELL_WALL) != (new_type == CELL_WALL)) {
+        hpa_mark_dirty(g, hpa_cluster_of(g, x, y));
+    }
+}
+
+/* 节点u经过边界到达的相邻分簇中的节点 */
+static int hpa_partner(const HpaGraph *g, int u) {
+    int c = u / HPA_MAX_NODES;
+    int side = g->node_side[u];
+    int k = u - c * HPA_MAX_NODES - g->clusters[c].side_start[side];
+    int c2 = c + g->cluster_offset[side];
+    return c2 * HPA_MAX_NODES + g->clusters[c2].side_start[hpa_opposite[side]] + k;
+}
+
+/* 节点u在搜索s中的距离，本轮未到达为HPA_INF */
+static unsigned int hpa_dist(const HpaSearch *s, int u) {
+    return s->stamp[u] == s->round ? s->dist[u] : HPA_INF;
+}
+
+/* 开始一次搜索，轮次计数回绕时清空标记 */
+static void hpa_search_begin(HpaGraph *g, HpaSearch *s) {
+    if (++s->round == 0) {
+        memset(s->stamp, 0, (size_t)g->node_capacity * sizeof(unsigned int));
+        s->round = 1;
+    }
+    g->heap_owner = s;
+}
+
+/* 堆中第i项上浮 */
+static void hpa_sift_up(HpaGraph *g, int i) {
+    const unsigned int *dist = g->heap_owner->dist;
+    int u = g->heap[i];
+    unsigned int d = dist[u];
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        int p = g->heap[parent];
+        if (dist[p] <= d) break;
+        g->heap[i] = p;
+        g->heap_pos[p] = i;
+        i = parent;
+    }
+    g->heap[i] = u;
+    g->heap_pos[u] = i;
+}
+
+/* 堆中第i项下沉 */
+static void hpa_sift_down(HpaGraph *g, int i) {
+    const unsigned int *dist = g->heap_owner->dist;
+    int u = g->heap[i];
+    unsigned int d = dist[u];
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= g->heap_size) break;
+        if (child + 1 < g->heap_size && dist[g->heap[child + 1]] < dist[g->heap[child]]) child++;
+        int v = g->heap[child];
+        if (dist[v] >= d) break;
+        g->heap[i] = v;
+        g->heap_pos[v] = i;
+        i = child;
+    }
+    g->heap[i] = u;
+    g->heap_pos[u] = i;
+}
+
+/* 以距离d、前驱pred尝试更新节点u */
+static void hpa_relax(HpaGraph *g, int u, unsigned int d, int pred) {
+    HpaSearch *s = g->heap_owner;
+    if (d >= hpa_dist(s, u)) return;
+
+    s->dist[u] = d;
+    s->stamp[u] = s->round;
+    if (s->pred) s->pred[u] = pred;
+    if (g->heap_pos[u] < 0) {
+        g->heap[g->heap_size] = u;
+        g->heap_pos[u] = g->heap_size++;
+    }
+    hpa_sift_up(g, g->heap_pos[u]);
+}
+
+/* 取出距离最小的节点 */
+static int hpa_pop(HpaGraph *g) {
+    int u = g->heap[0];
+    g->heap_pos[u] = -1;
+    if (--g->heap_size > 0) {
+        g->heap[0] = g->heap[g->heap_size];
+        hpa_sift_down(g, 0);
+    }
+    return u;
+}
+
+/* 提前结束搜索时清空堆 */
+static void hpa_search_end(HpaGraph *g) {
+    for (int i = 0; i < g->heap_size; i++) {
+        g->heap_pos[g->heap[i]] = -1;
+    }
+    g->heap_size = 0;
+}
+
+/* 从节点u（距离d）出发：跨过边界一步到相邻分簇，或按簇内距离到同分簇的其他节点 */
+static void hpa_expand(HpaGraph *g, int u, unsigned int d) {
+    int base = u / HPA_MAX_NODES * HPA_MAX_NODES;
+    const unsigned short *adj = g->adj + (size_t)u * HPA_MAX_NODES;
+
+    hpa_relax(g, hpa_partner(g, u), d + 1, u);
+    for (int k = 0; k < g->node_degree[u]; k++) {
+        hpa_relax(g, base + HPA_ADJ_NODE(adj[k]), d + HPA_ADJ_DIST(adj[k]), u);
+    }
+}
+
+/* 用起点分簇c内的搜索结果给该分簇的节点播种，只播种距离小于limit的节点 */
+static void hpa_seed(HpaGraph *g, int c, const HpaLocal *local, unsigned int limit) {
+    int base = c * HPA_MAX_NODES;
+    int n = g->clusters[c].side_start[4];
+
+    for (int j = 0; j < n; j++) {
+        unsigned int d = local->dist[g->node_local[base + j]];
+        if (d != HPA_UNREACHED && d < limit) hpa_relax(g, base + j, d, -1);
+    }
+}
+
+/* 两格之间的路径长度：起点分簇内的距离播种，到达终点分簇的节点时加上该节点到终点的簇内距离 */
+int hpa_distance(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                 int x0, int y0, int x1, int y1) {
+    HpaGraph *g = graph;
+    int c0 = hpa_cluster_of(g, x0, y0), c1 = hpa_cluster_of(g, x1, y1);
+    int l1 = hpa_local_of(x1, y1);
+    HpaLocal from, to;
+
+    hpa_refresh(g, board, exits);
+    hpa_local_search(g, NULL, c0, hpa_local_of(x0, y0), &from);
+    hpa_local_search(g, NULL, c1, l1, &to);
+
+    unsigned int best = (c0 == c1 && from.dist[l1] != HPA_UNREACHED) ? from.dist[l1] : HPA_INF;
+    hpa_search_begin(g, &g->search);
+    hpa_seed(g, c0, &from, best);
+    while (g->heap_size > 0) {
+        int u = hpa_pop(g);
+        unsigned int d = g->search.dist[u];
+        if (d >= best) break;
+        if (u / HPA_MAX_NODES == c1) {
+            unsigned int rest = to.dist[g->node_local[u]];
+            if (rest != HPA_UNREACHED && d + rest < best) best = d + rest;
+        }
+        hpa_expand(g, u, d);
+    }
+    hpa_search_end(g);
+    return best == HPA_INF ? -1 : (int)best;
+}
+
+/* 玩家自动驾驶：先在所在分簇内找最近的目标，再在抽象图上按距离展开，
+ * 进入有目标的分簇时从该入口在簇内找最近的目标，直到剩下的节点都不可能更近 */
+Direction hpa_autopilot(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                        int x, int y) {
+    HpaGraph *g = graph;
+    const CellType *cells = board[0];
+    int c = hpa_cluster_of(g, x, y);
+    HpaLocal start, scan;
+
+    hpa_refresh(g, board, exits);
+    int target = hpa_local_search(g, cells, c, hpa_local_of(x, y), &start);
+    unsigned int best = target >= 0 ? start.dist[target] : HPA_INF;
+    int best_node = -1;
+
+    hpa_search_begin(g, &g->search);
+    hpa_seed(g, c, &start, best);
+    while (g->heap_size > 0) {
+        int u = hpa_pop(g);
+        unsigned int d = g->search.dist[u];
+        int cu = u / HPA_MAX_NODES;
+        if (d >= best) break;
+        if (cu != c && g->clusters[cu].dots > 0) {
+            int t = hpa_local_search(g, cells, cu, g->node_local[u], &scan);
+            if (t >= 0 && d + scan.dist[t] < best) {
+                best = d + scan.dist[t];
+                best_node = u;
+            }
+        }
+        hpa_expand(g, u, d);
+    }
+    hpa_search_end(g);
+
+    if (best_node < 0) {
+        return target >= 0 ? (Direction)start.first[target] : DIR_COUNT;
+    }
+
+    /* 沿前驱找到路径上起点分簇内的第一个节点；玩家正站在该节点上时第一步是跨过边界 */
+    int node = best_node, child = -1;
+    while (g->search.pred[node] >= 0) {
+        child = node;
+        node = g->search.pred[node];
+    }
+    int l = g->node_local[node];
+    if (start.dist[l] > 0) return (Direction)start.first[l];
+    return child == hpa_partner(g, node) ? (Direction)g->node_side[node] : DIR_COUNT;
+}
+
+/* 从玩家位置计算抽象图上各节点到玩家的距离；墙壁和玩家位置都没变时沿用上一次的结果 */
+void hpa_chase_field(HpaGraph *graph, CellType **board, const unsigned char *exits,
+                     int player_x, int player_y) {
+    HpaGraph *g = graph;
+    int c = hpa_cluster_of(g, player_x, player_y);
+    HpaLocal local;
+
+    hpa_refresh(g, board, exits);
+    if (g->chase_valid && g->chase_x == player_x && g->chase_y == player_y) return;
+
+    hpa_local_search(g, NULL, c, hpa_local_of(player_x, player_y), &local);
+    hpa_search_begin(g, &g->chase);
+    hpa_seed(g, c, &local, HPA_INF);
+    while (g->heap_size > 0) {
+        int u = hpa_pop(g);
+        hpa_expand(g, u, g->chase.dist[u]);
+    }
+    if (++g->field_round == 0) {
+        memset(g->cluster_round, 0, (size_t)g->cluster_count * sizeof(unsigned int));
+        g->field_round = 1;
+    }
+    g->chase_valid = 1;
+    g->chase_x = player_x;
+    g->chase_y = player_y;
+}
+
+/* 把距离场展开到分簇c的每一格：以各节点到玩家的距离（玩家在簇内时还有玩家格的0）
+ * 为起点做一次簇内广度优先搜索。起点按距离排序，在队首的距离达到起点的距离时加入队列，
+ * 队列中的距离始终有序，每格第一次到达时的距离就是最短的 */
+static void hpa_resolve_cluster(HpaGraph *g, int c) {
+    const unsigned char *mask = g->local_exits + (size_t)c * HPA_CLUSTER_CELLS;
+    unsigned int *dist = g->chase_cells + (size_t)c * HPA_CLUSTER_CELLS;
+    unsigned short queue[HPA_CLUSTER_CELLS];
+    unsigned short seed_local[HPA_MAX_NODES + 1];
+    unsigned int seed_dist[HPA_MAX_NODES + 1];
+    int seeds = 0, base = c * HPA_MAX_NODES, n = g->clusters[c].side_start[4];
+
+    if (hpa_cluster_of(g, g->chase_x, g->chase_y) == c) {
+        seed_local[0] = (unsigned short)hpa_local_of(g->chase_x, g->chase_y);
+        seed_dist[0] = 0;
+        seeds = 1;
+    }
+    for (int j = 0; j < n; j++) {
+        unsigned int d = hpa_dist(&g->chase, base + j);
+        if (d == HPA_INF) continue;
+        int k = seeds++;
+        while (k > 0 && seed_dist[k - 1] > d) {
+            seed_dist[k] = seed_dist[k - 1];
+            seed_local[k] = seed_local[k - 1];
+            k--;
+        }
+        seed_dist[k] = d;
+        seed_local[k] = g->node_local[base + j];
+    }
+
+    for (int l = 0; l < HPA_CLUSTER_CELLS; l++) dist[l] = HPA_INF;
+    int head = 0, tail = 0, next_seed = 0;
+    for (;;) {
+        /* 距离不超过队首的起点先入队，队列为空时取下一个起点 */
+        unsigned int front = head < tail ? dist[queue[head]] : HPA_INF;
+        while (next_seed < seeds && seed_dist[next_seed] <= front) {
+            int l = seed_local[next_seed];
+            if (dist[l] == HPA_INF) {
+                dist[l] = seed_dist[next_seed];
+                queue[tail++] = (unsigned short)l;
+            }
+            next_seed++;
+            if (head == tail - 1) front = dist[queue[head]];
+        }
+        if (head == tail) break;
+
+        int l = queue[head++];
+        const ExitDirList *list = &exit_dir_lists[mask[l]];
+        for (int k = 0; k < list->count; k++) {
+            int next = l + hpa_local_offset[list->dirs[k]];
+            if (dist[next] != HPA_INF) continue;
+            dist[next] = dist[l] + 1;
+            queue[tail++] = (unsigned short)next;
+        }
+    }
+    g->cluster_round[c] = g->field_round;
+}
+
+static void hpa_resolve_range(int begin, int end, void *context) {
+    HpaGraph *g = (HpaGraph*)context;
+    for (int k = begin; k < end; k++) {
+        hpa_resolve_cluster(g, g->resolve_list[k]);
+    }
+}
+
+/* 把本次距离场展开到(xs[k], ys[k])所在的分簇，已展开的分簇跳过；各分簇并行展开 */
+void hpa_chase_resolve(HpaGraph *graph, const int *xs, const int *ys, int count) {
+    HpaGraph *g = graph;
+    if (!g->chase_valid) return;
+
+    g->resolve_count = 0;
+    for (int k = 0; k < count; k++) {
+        int c = hpa_cluster_of(g, xs[k], ys[k]);
+        if (g->cluster_round[c] == g->field_round) continue;
+        /* 先标记，避免同一分簇重复加入 */
+        g->cluster_round[c] = g->field_round;
+        g->resolve_list[g->resolve_count++] = c;
+    }
+    parallel_for(g->resolve_count, HPA_RESOLVE_CHUNK, hpa_resolve_range, g);
+}
+
+/* 幽灵在(x, y)时朝玩家的第一步：比较簇内相邻格展开后的距离，站在节点上时还比较
+ * 跨过边界到相邻分簇节点的距离，只在allowed掩码的方向中选最近的；
+ * 距离场未计算、所在分簇未展开或到不了玩家时返回DIR_COUNT。只读，可在决策阶段并行调用 */
+Direction hpa_chase_direction(const HpaGraph *graph, int x, int y, unsigned int allowed) {
+    const HpaGraph *g = graph;
+    if (!g || !g->chase_valid) return DIR_COUNT;
+
+    int c = hpa_cluster_of(g, x, y);
+    if (g->cluster_round[c] != g->field_round) return DIR_COUNT;
+
+    int l = hpa_local_of(x, y);
+    const unsigned int *dist = g->chase_cells + (size_t)c * HPA_CLUSTER_CELLS;
+    const ExitDirList *list = &exit_dir_lists[g->local_exits[(size_t)c * HPA_CLUSTER_CELLS + l]];
+    unsigned int cost[4] = {HPA_INF, HPA_INF, HPA_INF, HPA_INF};
+    for (int k = 0; k < list->count; k++) {
+        int dir = list->dirs[k];
+        cost[dir] = dist[l + hpa_local_offset[dir]];
+    }
+
+    /* 只有分簇边上的格子可能是节点 */
+    int lx = l % HPA_CLUSTER_SIZE, ly = l / HPA_CLUSTER_SIZE;
+    const HpaCluster *cl = &g->clusters[c];
+    if (lx == 0 || ly == 0 || lx == cl->w - 1 || ly == cl->h - 1) {
+        int base = c * HPA_MAX_NODES;
+        for (int j = 0; j < cl->side_start[4]; j++) {
+            int u = base + j;
+            if (g->node_local[u] != l) continue;
+            unsigned int across = hpa_dist(&g->chase, hpa_partner(g, u));
+            if (across < cost[g->node_side[u]]) cost[g->node_side[u]] = across;
+        }
+    }
+
+    Direction best_dir = DIR_COUNT;
+    unsigned int best = HPA_INF;
+    for (int d = 0; d < 4; d++) {
+        if ((allowed & EXIT_BIT(d)) && cost[d] < best) {
+            best = cost[d];
+            best_dir = (Direction)d;
+        }
+    }
+    return best_dir;
+}
@@ -0,0 +1,336 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "image.h"
+#include "arena.h"
+
+/* deflate参数 */
+#define DEFLATE_WINDOW 32768            /* LZ77滑动窗口大小（deflate允许的最大距离） */
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_HASH_SIZE (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_MAX_CHAIN 16            /* 每个位置最多比较的候选数 */
+
+/* PNG行过滤方式：Up，相同的行过滤后全为0，压缩效果最好 */
+#define PNG_FILTER_UP 2
+
+/* deflate长度码（257~285）和距离码（0~29）的基值与附加位数 */
+static const unsigned short length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const unsigned char length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const unsigned short dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const unsigned char dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* 查找表：CRC32和匹配长度到长度码的映射，首次使用时初始化一次 */
+static unsigned int crc_table[256];
+static unsigned char length_code[DEFLATE_MAX_MATCH + 1];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void init_tables(void) {
+    for (unsigned int n = 0; n < 256; n++) {
+        unsigned int c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+    for (int code = 0; code < 29; code++) {
+        int end = code < 28 ? length_base[code + 1] : DEFLATE_MAX_MATCH + 1;
+        for (int len = length_base[code]; len < end; len++) {
+            length_code[len] = (unsigned char)code;
+        }
+    }
+}
+
+static unsigned int crc32_update(unsigned int crc, const unsigned char *data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static unsigned int adler32(const unsigned char *data, size_t len) {
+    unsigned int a = 1, b = 0;
+    while (len > 0) {
+        /* 5552是保证b不溢出的最大块长度 */
+        size_t block = len < 5552 ? len : 5552;
+        len -= block;
+        while (block-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+/* 按位输出（deflate从低位开始填充字节） */
+typedef struct {
+    unsigned char *out;
+    size_t cap;
+    size_t len;
+    unsigned int bit_buf;
+    int bit_count;
+    int overflow;
+} BitWriter;
+
+static void put_bits(BitWriter *bw, unsigned int value, int count) {
+    bw->bit_buf |= value << bw->bit_count;
+    bw->bit_count += count;
+    while (bw->bit_count >= 8) {
+        if (bw->len < bw->cap) {
+            bw->out[bw->len++] = (unsigned char)(bw->bit_buf & 0xFF);
+        } else {
+            bw->overflow = 1;
+        }
+        bw->bit_buf >>= 8;
+        bw->bit_count -= 8;
+    }
+}
+
+/* 哈夫曼码从高位开始发送，需要先反转 */
+static void put_huffman(BitWriter *bw, unsigned int code, int length) {
+    unsigned int reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(bw, reversed, length);
+}
+
+/* 输出固定哈夫曼表中的字面量/长度符号 */
+static void put_symbol(BitWriter *bw, int symbol) {
+    if (symbol < 144) {
+        put_huffman(bw, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        put_huffman(bw, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        put_huffman(bw, symbol - 256, 7);
+    } else {
+        put_huffman(bw, 0xC0 + symbol - 280, 8);
+    }
+}
+
+static void put_match(BitWriter *bw, int length, int distance) {
+    int lcode = length_code[length];
+    put_symbol(bw, 257 + lcode);
+    if (length_extra[lcode]) {
+        put_bits(bw, length - length_base[lcode], length_extra[lcode]);
+    }
+
+    int dcode = 29;
+    while (dist_base[dcode] > distance) dcode--;
+    put_huffman(bw, dcode, 5);
+    if (dist_extra[dcode]) {
+        put_bits(bw, distance - dist_base[dcode], dist_extra[dcode]);
+    }
+}
+
+static unsigned int hash3(const unsigned char *p) {
+    unsigned int v = ((unsigned int)p[0] << 16) | ((unsigned int)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+/* zlib格式压缩：LZ77（哈希链查找）+ 单个固定哈夫曼块，返回输出长度，失败返回0 */
+static size_t zlib_compress(ImageEncoder *encoder, const unsigned char *data, size_t n) {
+    BitWriter bw = {encoder->compressed, encoder->out_cap, 0, 0, 0, 0};
+    int *head = encoder->hash_head;
+    int *prev = encoder->hash_prev;
+
+    for (int i = 0; i < DEFLATE_HASH_SIZE; i++) head[i] = -1;
+
+    /* zlib头：deflate，32K窗口，无预设字典 */
+    put_bits(&bw, 0x78, 8);
+    put_bits(&bw, 0x01, 8);
+    /* BFINAL=1，BTYPE=01（固定哈夫曼） */
+    put_bits(&bw, 1, 1);
+    put_bits(&bw, 1, 2);
+
+    size_t pos = 0;
+    while (pos < n) {
+        int best_len = 0, best_dist = 0;
+
+        if (pos + DEFLATE_MIN_MATCH <= n) {
+            size_t max_len = n - pos;
+            if (max_len > DEFLATE_MAX_MATCH) max_len = DEFLATE_MAX_MATCH;
+
+            unsigned int h = hash3(data + pos);
+            int candidate = head[h];
+            int chain = DEFLATE_MAX_CHAIN;
+            while (candidate >= 0 && pos - (size_t)candidate <= DEFLATE_WINDOW && chain-- > 0) {
+                const unsigned char *a = data + candidate;
+                const unsigned char *b = data + pos;
+                if (a[best_len] == b[best_len]) {
+                    size_t len = 0;
+                    while (len < max_len && a[len] == b[len]) len++;
+                    if ((int)len > best_len) {
+                        best_len = (int)len;
+                        best_dist = (int)(pos - (size_t)candidate);
+                        if (len == max_len) break;
+                    }
+                }
+                candidate = prev[candidate & (DEFLATE_WINDOW - 1)];
+            }
+        }
+
+        int advance = 1;
+        if (best_len >= DEFLATE_MIN_MATCH) {
+            put_match(&bw, best_len, best_dist);
+            advance = best_len;
+        } else {
+            put_symbol(&bw, data[pos]);
+        }
+
+        /* 把经过的位置都加入哈希链 */
+        for (int k = 0; k < advance; k++, pos++) {
+            if (pos + DEFLATE_MIN_MATCH <= n) {
+                unsigned int h = hash3(data + pos);
+                prev[pos & (DEFLATE_WINDOW - 1)] = head[h];
+                head[h] = (int)pos;
+            }
+        }
+    }
+
+    put_symbol(&bw, 256);          /* 块结束 */
+    if (bw.bit_count > 0) put_bits(&bw, 0, 8 - bw.bit_count);
+
+    unsigned int checksum = adler32(data, n);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        put_bits(&bw, (checksum >> shift) & 0xFF, 8);
+    }
+    return bw.overflow ? 0 : bw.len;
+}
+
+/* 分配编码缓冲区，尺寸按最大帧计算 */
+int image_encoder_init(ImageEncoder *encoder, int max_width, int max_height) {
+    pthread_once(&tables_once, init_tables);
+    memset(encoder, 0, sizeof(*encoder));
+
+    encoder->raw_cap = (size_t)max_height * ((size_t)max_width * 3 + 1);
+    /* 固定哈夫曼最坏每字节9位，再加头尾 */
+    encoder->out_cap = encoder->raw_cap + encoder->raw_cap / 8 + 64;
+    encoder->filtered = (unsigned char*)heap_alloc(encoder->raw_cap);
+    encoder->compressed = (unsigned char*)heap_alloc(encoder->out_cap);
+    encoder->hash_head = (int*)heap_alloc(sizeof(int) * DEFLATE_HASH_SIZE);
+    encoder->hash_prev = (int*)heap_alloc(sizeof(int) * DEFLATE_WINDOW);
+    if (!encoder->filtered || !encoder->compressed || !encoder->hash_head || !encoder->hash_prev) {
+        image_encoder_destroy(encoder);
+        return -1;
+    }
+    return 0;
+}
+
+void image_encoder_destroy(ImageEncoder *encoder) {
+    heap_free(encoder->filtered);
+    heap_free(encoder->compressed);
+    heap_free(encoder->hash_head);
+    heap_free(encoder->hash_prev);
+    memset(encoder, 0, sizeof(*encoder));
+}
+
+/* 写出二进制PPM（P6） */
+int image_write_ppm(const char *path, const unsigned char *rgb, int width, int height) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建图片文件 %s\n", path);
+        return -1;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    size_t bytes = (size_t)width * height * 3;
+    int ok = fwrite(rgb, 1, bytes, file) == bytes;
+    if (fclose(file) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+static void put_be32(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+/* 写出一个PNG数据块：长度、类型、数据、CRC */
+static int write_png_chunk(FILE *file, const char *type, const unsigned char *data, size_t len) {
+    unsigned char header[8];
+    unsigned char trailer[4];
+
+    put_be32(header, (unsigned int)len);
+    memcpy(header + 4, type, 4);
+    unsigned int crc = crc32_update(0, header + 4, 4);
+    if (len > 0) crc = crc32_update(crc, data, len);
+    put_be32(trailer, crc);
+
+    if (fwrite(header, 1, 8, file) != 8) return -1;
+    if (len > 0 && fwrite(data, 1, len, file) != len) return -1;
+    if (fwrite(trailer, 1, 4, file) != 4) return -1;
+    return 0;
+}
+
+/* 写出8位RGB的PNG */
+int image_write_png(const char *path, const unsigned char *rgb, int width, int height,
+                    ImageEncoder *encoder) {
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    size_t stride = (size_t)width * 3;
+    size_t raw_len = (size_t)height * (stride + 1);
+
+    if (raw_len > encoder->raw_cap) {
+        fprintf(stderr, "错误: 图片尺寸 %dx%d 超出编码缓冲区\n", width, height);
+        return -1;
+    }
+
+    /* 每行前加过滤类型字节，第一行的上一行视为全0 */
+    for (int y = 0; y < height; y++) {
+        const unsigned char *row = rgb + (size_t)y * stride;
+        unsigned char *out = encoder->filtered + (size_t)y * (stride + 1);
+        out[0] = PNG_FILTER_UP;
+        if (y == 0) {
+            memcpy(out + 1, row, stride);
+        } else {
+            const unsigned char *above = row - stride;
+            for (size_t i = 0; i < stride; i++) {
+                out[1 + i] = (unsigned char)(row[i] - above[i]);
+            }
+        }
+    }
+
+    size_t compressed_len = zlib_compress(encoder, encoder->filtered, raw_len);
+    if (compressed_len == 0) {
+        fprintf(stderr, "错误: PNG压缩失败 %s\n", path);
+        return -1;
+    }
+
+    unsigned char ihdr[13];
+    put_be32(ihdr, (unsigned int)width);
+    put_be32(ihdr + 4, (unsigned int)height);
+    ihdr[8] = 8;    /* 位深度 */
+    ihdr[9] = 2;    /* 颜色类型：RGB */
+    ihdr[10] = 0;   /* 压缩方法 */
+    ihdr[11] = 0;   /* 过滤方法 */
+    ihdr[12] = 0;   /* 不隔行 */
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建图片文件 %s\n", path);
+        return -1;
+    }
+    int ok = fwrite(signature, 1, 8, file) == 8 &&
+             write_png_chunk(file, "IHDR", ihdr, sizeof(ihdr)) == 0 &&
+             write_png_chunk(file, "IDAT", encoder->compressed, compressed_len) == 0 &&
+             write_png_chunk(file, "IEND", NULL, 0) == 0;
+    if (fclose(file) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,475 @@
+#include <string.h>
+#include "journal.h"
+#include "game.h"
+#include "algorithms.h"
+
+/* 记录种类放在key的高4位，低28位是格子编号、幽灵编号或计数器编号 */
+enum {
+    JOURNAL_CELL = 0,
+    JOURNAL_GHOST_POS,      /* x | y << 16 */
+    JOURNAL_GHOST_META,     /* 方向和之字形步数各4位，状态、下方格子、之字形方向各一个字节 */
+    JOURNAL_GHOST_RNG,
+    JOURNAL_FIELD
+};
+#define JOURNAL_KIND_SHIFT 28
+#define JOURNAL_INDEX_MASK 0x0FFFFFFFu
+
+/* 一条增量：原值和新值 */
+typedef struct {
+    uint32_t key;
+    uint32_t before;
+    uint32_t after;
+} JournalEntry;
+
+/* 每个tick比较一次的计数器：GameState中的int字段，最后再加上幽灵移动计时的相位 */
+static const size_t journal_field_offsets[] = {
+    offsetof(GameState, player_pos.x),
+    offsetof(GameState, player_pos.y),
+    offsetof(GameState, player_dir),
+    offsetof(GameState, frightened_ticks),
+    offsetof(GameState, frightened_combo),
+    offsetof(GameState, ghosts_eaten),
+    offsetof(GameState, dots_collected),
+    offsetof(GameState, total_dots),
+    offsetof(GameState, moves_count),
+    offsetof(GameState, game_over),
+    offsetof(GameState, game_won),
+    offsetof(GameState, lives),
+    offsetof(GameState, score),
+    offsetof(GameState, level),
+    offsetof(GameState, auto_move_direction),
+    offsetof(GameState, auto_move_enabled)
+};
+#define JOURNAL_STATE_FIELDS (int)(sizeof(journal_field_offsets) / sizeof(journal_field_offsets[0]))
+#define JOURNAL_FIELDS (JOURNAL_STATE_FIELDS + 1)
+
+/* 每个幽灵记录的字数（位置、状态、随机数） */
+#define JOURNAL_GHOST_WORDS 3
+
+/* 关键帧：某个tick开始时的完整状态 */
+typedef struct {
+    long tick;
+    int ghost_count;
+    unsigned char *cells;
+    uint32_t *ghosts;
+    uint32_t fields[JOURNAL_FIELDS];
+} JournalKeyframe;
+
+struct Journal {
+    int width, height;
+    size_t cells;
+    int ghost_capacity;
+    JournalEntry *entries;          /* 环形缓冲区，按序号取模存放 */
+    uint64_t capacity;
+    uint64_t head;                  /* 下一条记录的序号 */
+    uint64_t tail;                  /* 最早保留的记录序号 */
+    uint64_t *tick_start;           /* 环形：从第t个tick的状态出发的第一条记录序号 */
+    long tick_capacity;
+    long tick;                      /* 当前状态所在的tick */
+    long oldest;                    /* 可回退到的最早tick，即最早关键帧的tick */
+    long newest;                    /* 可前进到的最新tick */
+    long keyframe_interval;
+    JournalKeyframe keyframes[JOURNAL_KEYFRAMES];
+    int keyframe_first, keyframe_count;
+    uint32_t fields[JOURNAL_FIELDS];    /* 当前tick开始时的计数器 */
+    unsigned int *ghost_stamp;      /* 本tick已记录的幽灵标记为round */
+    unsigned int round;
+    int *touched;                   /* 本tick已记录的幽灵及其修改前的记录字 */
+    uint32_t *touched_words;
+    int touched_count;
+    int replaying;                  /* 回退和前进时不记录变化 */
+    int overflowed;                 /* 一个关键帧间隔内写满了缓冲区，提交时清空历史 */
+};
+
+/* 关键帧间隔：丢掉最旧的一帧后仍保留至少ticks个tick */
+static long journal_interval(int ticks) {
+    long interval = ((long)ticks + JOURNAL_KEYFRAMES - 2) / (JOURNAL_KEYFRAMES - 1);
+    return interval > 0 ? interval : 1;
+}
+
+/* 缓冲区记录数：每tick的计数器和玩家移动，加上每个幽灵的三条记录和两次格子变化 */
+static uint64_t journal_capacity(int ghost_capacity, int ticks) {
+    uint64_t per_tick = JOURNAL_FIELDS + 8 + 5 * (uint64_t)ghost_capacity;
+    uint64_t capacity = per_tick * (uint64_t)(ticks > 0 ? ticks : 1);
+    if (capacity < 1024) capacity = 1024;
+    if (capacity > JOURNAL_MAX_ENTRIES) capacity = JOURNAL_MAX_ENTRIES;
+    return capacity;
+}
+
+/* 回退日志所需的内存区字节数 */
+size_t journal_bytes(int width, int height, int ghost_capacity, int ticks) {
+    size_t cells = (size_t)width * height;
+    size_t ghosts = (size_t)ghost_capacity;
+    long tick_capacity = JOURNAL_KEYFRAMES * journal_interval(ticks) + 2;
+    return arena_align(sizeof(Journal)) +
+           arena_align(journal_capacity(ghost_capacity, ticks) * sizeof(JournalEntry)) +
+           arena_align((size_t)tick_capacity * sizeof(uint64_t)) +
+           JOURNAL_KEYFRAMES * (arena_align(cells) +
+                                arena_align(ghosts * JOURNAL_GHOST_WORDS * sizeof(uint32_t))) +
+           arena_align(ghosts * sizeof(unsigned int)) + arena_align(ghosts * sizeof(int)) +
+           arena_align(ghosts * JOURNAL_GHOST_WORDS * sizeof(uint32_t));
+}
+
+/* 从内存区切分回退日志，保留至少ticks个tick的历史（幽灵很多时受JOURNAL_MAX_ENTRIES限制） */
+Journal *journal_carve(Arena *arena, int width, int height, int ghost_capacity, int ticks) {
+    Journal *journal = (Journal*)arena_alloc(arena, sizeof(Journal));
+    if (!journal) return NULL;
+
+    size_t ghosts = (size_t)ghost_capacity;
+    journal->width = width;
+    journal->height = height;
+    journal->cells = (size_t)width * height;
+    journal->ghost_capacity = ghost_capacity;
+    journal->capacity = journal_capacity(ghost_capacity, ticks);
+    journal->keyframe_interval = journal_interval(ticks);
+    journal->tick_capacity = JOURNAL_KEYFRAMES * journal->keyframe_interval + 2;
+    journal->entries = (JournalEntry*)arena_alloc(arena, journal->capacity * sizeof(JournalEntry));
+    journal->tick_start = (uint64_t*)arena_alloc(arena,
+                                                 (size_t)journal->tick_capacity * sizeof(uint64_t));
+    for (int k = 0; k < JOURNAL_KEYFRAMES; k++) {
+        JournalKeyframe *keyframe = &journal->keyframes[k];
+        keyframe->cells = (unsigned char*)arena_alloc(arena, journal->cells);
+        keyframe->ghosts = (uint32_t*)arena_alloc(arena,
+                                                  ghosts * JOURNAL_GHOST_WORDS * sizeof(uint32_t));
+        if (!keyframe->cells || (ghosts > 0 && !keyframe->ghosts)) return NULL;
+    }
+    journal->ghost_stamp = (unsigned int*)arena_alloc(arena, ghosts * sizeof(unsigned int));
+    journal->touched = (int*)arena_alloc(arena, ghosts * sizeof(int));
+    journal->touched_words = (uint32_t*)arena_alloc(arena,
+                                                    ghosts * JOURNAL_GHOST_WORDS * sizeof(uint32_t));
+    if (!journal->entries || !journal->tick_start ||
+        (ghosts > 0 && (!journal->ghost_stamp || !journal->touched || !journal->touched_words))) {
+        return NULL;
+    }
+    journal->round = 1;
+    return journal;
+}
+
+/* 读取当前的计数器 */
+static void journal_read_fields(uint32_t *fields) {
+    const unsigned char *base = (const unsigned char*)g_game_state;
+    for (int f = 0; f < JOURNAL_STATE_FIELDS; f++) {
+        int value;
+        memcpy(&value, base + journal_field_offsets[f], sizeof(int));
+        fields[f] = (uint32_t)value;
+    }
+    fields[JOURNAL_STATE_FIELDS] = (uint32_t)get_ghost_timer_phase();
+}
+
+/* 写回一个计数器 */
+static void journal_write_field(int field, uint32_t value) {
+    int v = (int)value;
+    if (field == JOURNAL_STATE_FIELDS) {
+        set_ghost_timer_phase(v);
+        return;
+    }
+    memcpy((unsigned char*)g_game_state + journal_field_offsets[field], &v, sizeof(int));
+}
+
+/* 第index个幽灵的记录字 */
+static void journal_ghost_words(const GhostRegistry *g, int i, uint32_t *words) {
+    words[0] = (uint32_t)g->x[i] | (uint32_t)g->y[i] << 16;
+    words[1] = (uint32_t)g->dir[i] | (uint32_t)g->zigzag_steps[i] << 4 |
+               (uint32_t)g->state[i] << 8 | (uint32_t)g->under[i] << 16 |
+               (uint32_t)g->zigzag_dir[i] << 24;
+    words[2] = g->rng[i];
+}
+
+/* 写回幽灵的一个记录字 */
+static void journal_set_ghost_word(GhostRegistry *g, int i, int kind, uint32_t word) {
+    switch (kind) {
+        case JOURNAL_GHOST_POS:
+            g->x[i] = (int)(word & 0xFFFF);
+            g->y[i] = (int)(word >> 16);
+            break;
+        case JOURNAL_GHOST_META:
+            g->dir[i] = (unsigned char)(word & 0x0F);
+            g->zigzag_steps[i] = (unsigned char)((word >> 4) & 0x0F);
+            g->state[i] = (unsigned char)(word >> 8);
+            g->under[i] = (unsigned char)(word >> 16);
+            g->zigzag_dir[i] = (unsigned char)(word >> 24);
+            break;
+        default:
+            g->rng[i] = word;
+            break;
+    }
+}
+
+/* 开始新的一轮幽灵标记 */
+static void journal_next_round(Journal *journal) {
+    journal->touched_count = 0;
+    if (++journal->round == 0) {
+        memset(journal->ghost_stamp, 0, (size_t)journal->ghost_capacity * sizeof(unsigned int));
+        journal->round = 1;
+    }
+}
+
+static uint64_t *journal_tick_start(Journal *journal, long tick) {
+    return &journal->tick_start[tick % journal->tick_capacity];
+}
+
+/* 丢弃最旧的关键帧及其之后到下一关键帧为止的历史（至少保留一个关键帧） */
+static void journal_drop_keyframe(Journal *journal) {
+    journal->keyframe_first = (journal->keyframe_first + 1) % JOURNAL_KEYFRAMES;
+    journal->keyframe_count--;
+    journal->oldest = journal->keyframes[journal->keyframe_first].tick;
+    journal->tail = *journal_tick_start(journal, journal->oldest);
+}
+
+/* 回退之后又有变化：丢弃被回退的未来，从当前tick分支 */
+static void journal_branch(Journal *journal) {
+    journal->head = *journal_tick_start(journal, journal->tick);
+    journal->newest = journal->tick;
+    while (journal->keyframe_count > 1) {
+        int last = (journal->keyframe_first + journal->keyframe_count - 1) % JOURNAL_KEYFRAMES;
+        if (journal->keyframes[last].tick <= journal->tick) break;
+        journal->keyframe_count--;
+    }
+}
+
+/* 追加一条记录，返回其序号；缓冲区满时按关键帧丢弃最旧的历史 */
+static uint64_t journal_push(Journal *journal, uint32_t key, uint32_t before, uint32_t after) {
+    if (journal->tick < journal->newest) journal_branch(journal);
+    while (journal->head - journal->tail >= journal->capacity) {
+        if (journal->keyframe_count > 1) {
+            journal_drop_keyframe(journal);
+        } else {
+            journal->overflowed = 1;
+            journal->tail = journal->head - journal->capacity + 1;
+        }
+    }
+    JournalEntry *entry = &journal->entries[journal->head % journal->capacity];
+    entry->key = key;
+    entry->before = before;
+    entry->after = after;
+    return journal->head++;
+}
+
+/* 记录格子变化 */
+void journal_cell(Journal *journal, int index, CellType before, CellType after) {
+    if (journal->replaying || before == after) return;
+    journal_push(journal, (uint32_t)JOURNAL_CELL << JOURNAL_KIND_SHIFT | (uint32_t)index,
+                 (uint32_t)before, (uint32_t)after);
+}
+
+/* 在修改第index个幽灵之前把它的原值存入本tick的暂存区，提交时只记录变化了的字 */
+void journal_ghost(Journal *journal, const GhostRegistry *ghosts, int index) {
+    if (journal->replaying || journal->ghost_stamp[index] == journal->round) return;
+    journal->ghost_stamp[index] = journal->round;
+
+    int t = journal->touched_count++;
+    journal->touched[t] = index;
+    journal_ghost_words(ghosts, index, &journal->touched_words[(size_t)t * JOURNAL_GHOST_WORDS]);
+}
+
+/* 把本tick记录过的幽灵恢复为暂存的原值（回退尚未提交的tick时使用） */
+static void journal_restore_touched(Journal *journal) {
+    GhostRegistry *g = &g_game_state->ghosts;
+    for (int t = 0; t < journal->touched_count; t++) {
+        const uint32_t *words = &journal->touched_words[(size_t)t * JOURNAL_GHOST_WORDS];
+        for (int w = 0; w < JOURNAL_GHOST_WORDS; w++) {
+            journal_set_ghost_word(g, journal->touched[t], JOURNAL_GHOST_POS + w, words[w]);
+        }
+    }
+}
+
+/* 幽灵决策之前记录所有活动幽灵（决策会推进随机数和之字形状态） */
+void journal_active_ghosts(Journal *journal, const GhostRegistry *ghosts) {
+    for (int i = 0; i < ghosts->count; i++) {
+        if (ghosts->state[i] == GHOST_STATE_ACTIVE) journal_ghost(journal, ghosts, i);
+    }
+}
+
+/* 保存当前状态为关键帧，槽位用完时复用最旧的一个 */
+static void journal_keyframe(Journal *journal) {
+    if (journal->keyframe_count == JOURNAL_KEYFRAMES) journal_drop_keyframe(journal);
+    int slot = (journal->keyframe_first + journal->keyframe_count++) % JOURNAL_KEYFRAMES;
+    JournalKeyframe *keyframe = &journal->keyframes[slot];
+    const CellType *cells = g_game_state->board[0];
+    const GhostRegistry *g = &g_game_state->ghosts;
+
+    keyframe->tick = journal->tick;
+    for (size_t i = 0; i < journal->cells; i++) keyframe->cells[i] = (unsigned char)cells[i];
+    keyframe->ghost_count = g->count;
+    for (int i = 0; i < g->count; i++) {
+        journal_ghost_words(g, i, &keyframe->ghosts[(size_t)i * JOURNAL_GHOST_WORDS]);
+    }
+    memcpy(keyframe->fields, journal->fields, sizeof(keyframe->fields));
+}
+
+/* 清空历史，当前状态作为第一个关键帧 */
+void journal_reset(Journal *journal) {
+    journal->overflowed = 0;
+    journal->tail = journal->head;
+    journal->keyframe_first = 0;
+    journal->keyframe_count = 0;
+    journal->oldest = journal->newest = journal->tick;
+    *journal_tick_start(journal, journal->tick) = journal->head;
+    journal_next_round(journal);
+    journal_read_fields(journal->fields);
+    journal_keyframe(journal);
+}
+
+/* 一个tick结束 */
+void journal_commit_tick(Journal *journal) {
+    if (journal->tick < journal->newest) journal_branch(journal);
+
+    /* 本tick记录过的幽灵与暂存的原值比较，只追加变化了的字（原地不动的幽灵不占记录） */
+    const GhostRegistry *g = &g_game_state->ghosts;
+    for (int t = 0; t < journal->touched_count; t++) {
+        int index = journal->touched[t];
+        const uint32_t *before = &journal->touched_words[(size_t)t * JOURNAL_GHOST_WORDS];
+        uint32_t words[JOURNAL_GHOST_WORDS];
+        journal_ghost_words(g, index, words);
+        for (int w = 0; w < JOURNAL_GHOST_WORDS; w++) {
+            if (words[w] == before[w]) continue;
+            journal_push(journal, (uint32_t)(JOURNAL_GHOST_POS + w) << JOURNAL_KIND_SHIFT |
+                                  (uint32_t)index, before[w], words[w]);
+        }
+    }
+    journal_next_round(journal);
+
+    /* 变化了的计数器 */
+    uint32_t fields[JOURNAL_FIELDS];
+    journal_read_fields(fields);
+    for (int f = 0; f < JOURNAL_FIELDS; f++) {
+        if (fields[f] == journal->fields[f]) continue;
+        journal_push(journal, (uint32_t)JOURNAL_FIELD << JOURNAL_KIND_SHIFT | (uint32_t)f,
+                     journal->fields[f], fields[f]);
+        journal->fields[f] = fields[f];
+    }
+
+    journal->tick++;
+    journal->newest = journal->tick;
+    if (journal->overflowed) {
+        journal_reset(journal);
+        return;
+    }
+    *journal_tick_start(journal, journal->tick) = journal->head;
+
+    /* tick表快满时丢弃最旧的关键帧；间隔到了或本段变化占了半个缓冲区时保存关键帧 */
+    while (journal->tick - journal->oldest >= journal->tick_capacity - 1 &&
+           journal->keyframe_count > 1) {
+        journal_drop_keyframe(journal);
+    }
+    int last = (journal->keyframe_first + journal->keyframe_count - 1) % JOURNAL_KEYFRAMES;
+    long since = journal->keyframes[last].tick;
+    if (journal->tick - since >= journal->keyframe_interval ||
+        journal->head - *journal_tick_start(journal, since) >= journal->capacity / 2) {
+        journal_keyframe(journal);
+    }
+}
+
+int journal_history(const Journal *journal) {
+    if (journal->overflowed) return 0;
+    return (int)(journal->tick - journal->oldest);
+}
+
+int journal_future(const Journal *journal) {
+    return (int)(journal->newest - journal->tick);
+}
+
+/* 把一条记录的原值或新值写回状态 */
+static void journal_apply(const Journal *journal, const JournalEntry *entry, uint32_t value) {
+    int kind = (int)(entry->key >> JOURNAL_KIND_SHIFT);
+    int index = (int)(entry->key & JOURNAL_INDEX_MASK);
+    if (kind == JOURNAL_CELL) {
+        set_board_cell(index % journal->width, index / journal->width, (CellType)value);
+    } else if (kind == JOURNAL_FIELD) {
+        journal_write_field(index, value);
+    } else {
+        journal_set_ghost_word(&g_game_state->ghosts, index, kind, value);
+    }
+}
+
+/* 按相反顺序撤销序号[from, to)的记录 */
+static void journal_undo(const Journal *journal, uint64_t from, uint64_t to) {
+    for (uint64_t seq = to; seq > from; seq--) {
+        const JournalEntry *entry = &journal->entries[(seq - 1) % journal->capacity];
+        journal_apply(journal, entry, entry->before);
+    }
+}
+
+/* 按顺序重做序号[from, to)的记录 */
+static void journal_redo(const Journal *journal, uint64_t from, uint64_t to) {
+    for (uint64_t seq = from; seq < to; seq++) {
+        const JournalEntry *entry = &journal->entries[seq % journal->capacity];
+        journal_apply(journal, entry, entry->after);
+    }
+}
+
+/* 恢复关键帧：只改写与当前不同的格子 */
+static void journal_load_keyframe(const Journal *journal, const JournalKeyframe *keyframe) {
+    const CellType *cells = g_game_state->board[0];
+    for (size_t i = 0; i < journal->cells; i++) {
+        if ((unsigned char)cells[i] != keyframe->cells[i]) {
+            set_board_cell((int)(i % journal->width), (int)(i / journal->width),
+                           (CellType)keyframe->cells[i]);
+        }
+    }
+    GhostRegistry *g = &g_game_state->ghosts;
+    for (int i = 0; i < keyframe->ghost_count; i++) {
+        const uint32_t *words = &keyframe->ghosts[(size_t)i * JOURNAL_GHOST_WORDS];
+        for (int w = 0; w < JOURNAL_GHOST_WORDS; w++) {
+            journal_set_ghost_word(g, i, JOURNAL_GHOST_POS + w, words[w]);
+        }
+    }
+    for (int f = 0; f < JOURNAL_FIELDS; f++) journal_write_field(f, keyframe->fields[f]);
+}
+
+/* 回退：先撤销本tick尚未提交的变化，再撤销之前的tick；
+ * 撤销的记录比从最近的关键帧重做还多时改为恢复关键帧再前进（逐格比较按每16格一条记录计） */
+int journal_rewind(Journal *journal, int ticks) {
+    if (ticks <= 0 || journal->overflowed) return 0;
+    long target = journal->tick - ticks;
+    if (target < journal->oldest) target = journal->oldest;
+
+    journal->replaying = 1;
+    uint64_t now = *journal_tick_start(journal, journal->tick);
+    if (journal->tick == journal->newest) {
+        journal_undo(journal, now, journal->head);
+        journal->head = now;
+    }
+    journal_restore_touched(journal);
+    for (int f = 0; f < JOURNAL_FIELDS; f++) journal_write_field(f, journal->fields[f]);
+    journal_next_round(journal);
+
+    const JournalKeyframe *keyframe = NULL;
+    for (int k = 0; k < journal->keyframe_count; k++) {
+        const JournalKeyframe *candidate =
+            &journal->keyframes[(journal->keyframe_first + k) % JOURNAL_KEYFRAMES];
+        if (candidate->tick <= target) keyframe = candidate;
+    }
+    uint64_t start = *journal_tick_start(journal, target);
+    uint64_t undo_cost = now - start;
+    if (keyframe && keyframe->tick < target &&
+        journal->cells / 16 + (start - *journal_tick_start(journal, keyframe->tick)) < undo_cost) {
+        journal_load_keyframe(journal, keyframe);
+        journal_redo(journal, *journal_tick_start(journal, keyframe->tick), start);
+    } else {
+        journal_undo(journal, start, now);
+    }
+
+    int moved = (int)(journal->tick - target);
+    journal->tick = target;
+    journal_read_fields(journal->fields);
+    journal->replaying = 0;
+    return moved;
+}
+
+/* 前进：重做被回退的tick */
+int journal_forward(Journal *journal, int ticks) {
+    if (ticks <= 0 || journal->tick >= journal->newest) return 0;
+    long target = journal->tick + ticks;
+    if (target > journal->newest) target = journal->newest;
+
+    journal->replaying = 1;
+    journal_redo(journal, *journal_tick_start(journal, journal->tick),
+                 *journal_tick_start(journal, target));
+    int moved = (int)(target - journal->tick);
+    journal->tick = target;
+    journal_read_fields(journal->fields);
+    journal_next_round(journal);
+    journal->replaying = 0;
+    return moved;
+}
@@ -0,0 +1,511 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "level.h"
+#include "types.h"
+#include "arena.h"
+#include "log.h"
+#include "ghost.h"
+#include "parallel.h"
+
+/* 棋盘所需字节数：行指针表 + 连续的格子数据 */
+size_t level_board_bytes(int width, int height) {
+    return arena_align(height * sizeof(CellType*)) +
+           arena_align((size_t)width * height * sizeof(CellType));
+}
+
+/* 从内存区切分棋盘，行指针指向同一块连续的格子数据 */
+CellType** level_board_carve(Arena *arena, int width, int height) {
+    CellType **board = (CellType**)arena_alloc(arena, height * sizeof(CellType*));
+    CellType *cells = (CellType*)arena_alloc(arena, (size_t)width * height * sizeof(CellType));
+    if (!board || !cells) return NULL;
+
+    for (int i = 0; i < height; i++) {
+        board[i] = cells + (size_t)i * width;
+    }
+    return board;
+}
+
+/* 生成棋盘所需的临时缓冲区字节数 */
+size_t level_scratch_bytes(int width, int height) {
+    return arena_align((size_t)width * height) +
+           arena_align((size_t)width * height * sizeof(int));
+}
+
+/* 从内存区切分生成用的临时缓冲区 */
+int level_scratch_carve(Arena *arena, LevelScratch *scratch, int width, int height) {
+    scratch->visited = (unsigned char*)arena_alloc(arena, (size_t)width * height);
+    scratch->stack = (int*)arena_alloc(arena, (size_t)width * height * sizeof(int));
+    return (scratch->visited && scratch->stack) ? 0 : -1;
+}
+
+/* 可重入随机数生成器，每个生成任务持有自己的状态 */
+unsigned int level_rand(unsigned int *state) {
+    unsigned int x = (*state += 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return x & 0x7FFFFFFFu;
+}
+
+/* 生成墙壁和豆子 */
+void level_generate_walls_and_dots(CellType **board, int width, int height, unsigned int *rng,
+                                   LevelScratch *scratch) {
+    /* 首先将所有格子设为空 */
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            board[i][j] = CELL_EMPTY;
+        }
+    }
+
+    /* 生成四周边界墙壁 */
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (i == 0 || i == height-1 || j == 0 || j == width-1) {
+                board[i][j] = CELL_WALL;
+            }
+        }
+    }
+
+    /* 计算内部区域的格子数，并随机生成内部墙壁 */
+    int inner_width = width - 2;
+    int inner_height = height - 2;
+    int inner_cells = inner_width * inner_height;
+    int inner_wall_count = inner_cells * LEVEL_WALL_DENSITY_PERMILLE / 1000; /* 内部墙壁数量为内部区域的20% */
+
+    /* 确保内部墙壁数量不超过内部可用格子数 */
+    if (inner_wall_count > inner_cells - 1) { /* 至少保留玩家位置 */
+        inner_wall_count = inner_cells - 1;
+    }
+
+    /* 在内部区域随机放置墙壁，确保不创建封闭区域 */
+    int placed_walls = 0;
+    int max_attempts = inner_wall_count * 10; /* 防止无限循环 */
+    int attempts = 0;
+
+    while (placed_walls < inner_wall_count && attempts < max_attempts) {
+        int x = 1 + level_rand(rng) % inner_width;  /* 内部区域x坐标 */
+        int y = 1 + level_rand(rng) % inner_height; /* 内部区域y坐标 */
+
+        /* 确保不在玩家初始位置(1,1)且该位置不是墙 */
+        if ((x != 1 || y != 1) && board[y][x] != CELL_WALL) {
+            /* 临时放置墙壁 */
+            board[y][x] = CELL_WALL;
+
+            /* 检查是否会创建封闭区域 - 简单策略：确保周围至少有2个方向可通行 */
+            int passable_directions = 0;
+            int dx[] = {0, 1, 0, -1}; /* 右、下、左、上 */
+            int dy[] = {1, 0, -1, 0};
+
+            for (int dir = 0; dir < 4; dir++) {
+                int nx = x + dx[dir];
+                int ny = y + dy[dir];
+                if (nx >= 1 && nx < width-1 && ny >= 1 && ny < height-1) {
+                    if (board[ny][nx] != CELL_WALL) {
+                        passable_directions++;
+                    }
+                }
+            }
+
+            /* 如果周围可通行方向少于2个，撤销墙壁放置 */
+            if (passable_directions < 2) {
+                board[y][x] = CELL_EMPTY;
+            } else {
+                placed_walls++;
+            }
+        }
+        attempts++;
+    }
+
+    /* 先在所有非墙壁位置放置豆子 */
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (board[i][j] == CELL_EMPTY && (j != 1 || i != 1)) {
+                board[i][j] = CELL_DOT;
+            }
+        }
+    }
+
+    /* 使用洪水填充算法标记从玩家位置可到达的区域 */
+    unsigned char *visited = scratch->visited;
+    int *stack = scratch->stack;
+    int top = 0;
+    memset(visited, 0, (size_t)width * height);
+
+    /* 显式栈的洪水填充，从玩家起始位置开始，大棋盘也不会耗尽线程栈 */
+    if (board[1][1] != CELL_WALL) {
+        visited[width + 1] = 1;
+        stack[top++] = width + 1;
+    }
+    while (top > 0) {
+        int index = stack[--top];
+        int x = index % width;
+        int y = index / width;
+        int neighbors[4] = {index + 1, index - 1, index + width, index - width};
+        int valid[4] = {x + 1 < width, x > 0, y + 1 < height, y > 0};
+
+        for (int dir = 0; dir < 4; dir++) {
+            int n = neighbors[dir];
+            if (valid[dir] && !visited[n] && board[n / width][n % width] != CELL_WALL) {
+                visited[n] = 1;
+                stack[top++] = n;
+            }
+        }
+    }
+
+    /* 清除不可到达区域的豆子 */
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (!visited[i * width + j] && (board[i][j] == CELL_DOT || board[i][j] == CELL_POWER_DOT)) {
+                board[i][j] = CELL_EMPTY;
+            }
+        }
+    }
+}
+
+/* 在豆子位置上随机放置count个幽灵，颜色按编号轮流使用 */
+void level_place_ghosts(CellType **board, int width, int height, int count, unsigned int *rng) {
+    for (int i = 0; i < count; i++) {
+        int placed = 0;
+        int attempts = 0;
+        int max_attempts = 100;
+
+        while (!placed && attempts < max_attempts) {
+            int x = level_rand(rng) % width;
+            int y = level_rand(rng) % height;
+
+            /* 确保不在玩家位置且该位置是豆子 */
+            if ((x != 1 || y != 1) && board[y][x] == CELL_DOT) {
+                board[y][x] = ghost_type_for_index(i);
+                placed = 1;
+            }
+            attempts++;
+        }
+    }
+}
+
+/* 在豆子位置上随机放置LEVEL_POWER_DOT_COUNT个能量豆 */
+void level_place_power_dots(CellType **board, int width, int height, unsigned int *rng) {
+    /* 随机放置能量豆 */
+    for (int i = 0; i < LEVEL_POWER_DOT_COUNT; i++) {
+        int placed = 0;
+        int attempts = 0;
+        int max_attempts = 100;
+
+        while (!placed && attempts < max_attempts) {
+            int x = level_rand(rng) % width;
+            int y = level_rand(rng) % height;
+
+            /* 确保不在玩家位置且该位置是豆子 */
+            if ((x != 1 || y != 1) && board[y][x] == CELL_DOT) {
+                board[y][x] = CELL_POWER_DOT;
+                placed = 1;
+            }
+            attempts++;
+        }
+    }
+}
+
+/* 统计棋盘上的豆子数（包括能量豆） */
+int level_count_dots(CellType **board, int width, int height) {
+    int total = 0;
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (board[i][j] == CELL_DOT || board[i][j] == CELL_POWER_DOT) {
+                total++;
+            }
+        }
+    }
+    return total;
+}
+
+/* 生成完整关卡：墙壁、豆子、玩家、幽灵和能量豆，返回总豆子数 */
+int level_generate(CellType **board, int width, int height, int ghost_count,
+                   unsigned int seed, LevelScratch *scratch) {
+    unsigned int rng = seed;
+    return level_generate_rng(board, width, height, ghost_count, &rng, scratch);
+}
+
+/* 生成完整关卡，使用并推进调用者的随机数状态 */
+int level_generate_rng(CellType **board, int width, int height, int ghost_count,
+                       unsigned int *rng, LevelScratch *scratch) {
+    level_generate_walls_and_dots(board, width, height, rng, scratch);
+    board[1][1] = CELL_PLAYER;
+    level_place_ghosts(board, width, height, ghost_count, rng);
+    level_place_power_dots(board, width, height, rng);
+
+    return level_count_dots(board, width, height);
+}
+
+/* 流水线的第一个种子 */
+unsigned int level_pipeline_first_seed(unsigned int seed) {
+    return seed ^ 0x5A17C0DEu;
+}
+
+/* 下一关的种子 */
+unsigned int level_next_seed(unsigned int seed) {
+    return seed * 1664525u + 1013904223u;
+}
+
+/* 校验棋盘：从出生点按层广度优先搜索，同时检查出生点附近的幽灵；
+ * 再扫描一遍，统计豆子和幽灵并确认它们都能到达 */
+LevelCheck level_validate(CellType **board, int width, int height, int ghost_count,
+                          LevelScratch *scratch) {
+    if (width < 3 || height < 3 || board[1][1] != CELL_PLAYER) return LEVEL_BAD_SPAWN;
+
+    unsigned char *visited = scratch->visited;
+    int *queue = scratch->stack;
+    int head = 0, tail = 0;
+    memset(visited, 0, (size_t)width * height);
+    visited[width + 1] = 1;
+    queue[tail++] = width + 1;
+
+    int distance = 0;
+    int layer_end = tail;
+    while (head < tail) {
+        if (head == layer_end) {
+            distance++;
+            layer_end = tail;
+        }
+        int index = queue[head++];
+        int x = index % width;
+        int y = index / width;
+        if (distance < LEVEL_SAFE_SPAWN_DISTANCE && is_ghost_cell(board[y][x])) {
+            return LEVEL_UNSAFE_SPAWN;
+        }
+        int neighbors[4] = {index + 1, index - 1, index + width, index - width};
+        int valid[4] = {x + 1 < width, x > 0, y + 1 < height, y > 0};
+
+        for (int dir = 0; dir < 4; dir++) {
+            int n = neighbors[dir];
+            if (valid[dir] && !visited[n] && board[n / width][n % width] != CELL_WALL) {
+                visited[n] = 1;
+                queue[tail++] = n;
+            }
+        }
+    }
+
+    int dots = 0, power_dots = 0, ghosts = 0;
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            CellType cell = board[i][j];
+            if (cell == CELL_EMPTY || cell == CELL_WALL) continue;
+            if (!visited[i * width + j]) return LEVEL_UNREACHABLE;
+            if (cell == CELL_PLAYER && (i != 1 || j != 1)) return LEVEL_BAD_SPAWN;
+            if (cell == CELL_DOT) dots++;
+            else if (cell == CELL_POWER_DOT) power_dots++;
+            else if (is_ghost_cell(cell)) ghosts++;
+        }
+    }
+    if (dots == 0 || power_dots != LEVEL_POWER_DOT_COUNT) return LEVEL_BAD_DOTS;
+    if (ghosts != ghost_count) return LEVEL_BAD_GHOSTS;
+    return LEVEL_VALID;
+}
+
+/* 校验结果的名称 */
+const char *level_check_name(LevelCheck check) {
+    switch (check) {
+        case LEVEL_VALID: return "有效";
+        case LEVEL_BAD_SPAWN: return "出生点";
+        case LEVEL_UNREACHABLE: return "不连通";
+        case LEVEL_BAD_DOTS: return "豆子数";
+        case LEVEL_BAD_GHOSTS: return "幽灵数";
+        case LEVEL_UNSAFE_SPAWN: return "出生点不安全";
+        default: return "未知";
+    }
+}
+
+/* ---------------- 关卡预生成流水线 ---------------- */
+
+/* 池中的一个棋盘和它附带的索引 */
+typedef struct {
+    CellType **board;
+    void *indexes;
+} PipelineSlot;
+
+/* 就绪队列中的一个棋盘 */
+typedef struct {
+    PipelineSlot slot;
+    int total_dots;
+} ReadyLevel;
+
+/* 流水线状态：后台线程生成，GUI线程取用，由互斥锁保护
+ * 棋盘池在启动时从内存区切分，之后只在空闲表、就绪队列和当前游戏之间流转 */
+static struct {
+    int running;
+    int width;
+    int height;
+    int ghost_count;
+    int depth;
+    unsigned int next_seed;
+    ReadyLevel ready[LEVEL_PIPELINE_DEPTH];
+    int ready_head;
+    int ready_count;
+    PipelineSlot spare[LEVEL_PIPELINE_POOL + 1]; /* 空闲棋盘（含换下的旧棋盘） */
+    int spare_count;
+    LevelScratch scratch;                    /* 后台线程专用的生成缓冲区 */
+    LevelIndexFn build;                      /* 为生成的棋盘建立索引，可为NULL */
+    void *build_context;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} pipeline = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+/* 后台生成线程：队列未满且有空闲棋盘时生成下一关棋盘，再建立它的索引 */
+static void *pipeline_worker(void *arg) {
+    (void)arg;
+
+    /* 线程池只服务模拟线程，建立索引时在本线程串行执行 */
+    parallel_serial_thread();
+
+    pthread_mutex_lock(&pipeline.lock);
+    while (pipeline.running) {
+        if (pipeline.ready_count >= pipeline.depth || pipeline.spare_count == 0) {
+            pthread_cond_wait(&pipeline.cond, &pipeline.lock);
+            continue;
+        }
+
+        PipelineSlot slot = pipeline.spare[--pipeline.spare_count];
+        int width = pipeline.width;
+        int height = pipeline.height;
+        int ghost_count = pipeline.ghost_count;
+        unsigned int seed = pipeline.next_seed;
+        pipeline.next_seed = level_next_seed(seed);
+        pthread_mutex_unlock(&pipeline.lock);
+
+        /* 生成和建立索引都在锁外进行，不阻塞GUI线程 */
+        int total = level_generate(slot.board, width, height, ghost_count, seed,
+                                   &pipeline.scratch);
+        if (pipeline.build) pipeline.build(slot.board, slot.indexes, pipeline.build_context);
+
+        pthread_mutex_lock(&pipeline.lock);
+        if (!pipeline.running) {
+            pipeline.spare[pipeline.spare_count++] = slot;
+            break;
+        }
+        int tail = (pipeline.ready_head + pipeline.ready_count) % LEVEL_PIPELINE_DEPTH;
+        pipeline.ready[tail].slot = slot;
+        pipeline.ready[tail].total_dots = total;
+        pipeline.ready_count++;
+        pthread_cond_broadcast(&pipeline.cond);
+    }
+    pthread_mutex_unlock(&pipeline.lock);
+    return NULL;
+}
+
+/* 流水线所需的内存区字节数 */
+size_t level_pipeline_bytes(int width, int height) {
+    return LEVEL_PIPELINE_POOL * level_board_bytes(width, height) +
+           level_scratch_bytes(width, height);
+}
+
+/* 启动关卡预生成流水线，棋盘池和生成缓冲区从内存区切分，
+ * 池中第i个棋盘附带indexes[i]（build为NULL时indexes可为NULL） */
+int level_pipeline_start(Arena *arena, int width, int height, int ghost_count, int depth,
+                         unsigned int seed, void *const *indexes, LevelIndexFn build,
+                         void *context) {
+    if (pipeline.running) {
+        level_pipeline_stop();
+    }
+    if (depth < 1) depth = 1;
+    if (depth > LEVEL_PIPELINE_DEPTH) depth = LEVEL_PIPELINE_DEPTH;
+
+    pipeline.spare_count = 0;
+    for (int i = 0; i < LEVEL_PIPELINE_POOL; i++) {
+        CellType **board = level_board_carve(arena, width, height);
+        if (!board) {
+            LOG_WARN("关卡预生成: 内存区空间不足，将同步生成关卡");
+            return -1;
+        }
+        pipeline.spare[pipeline.spare_count].board = board;
+        pipeline.spare[pipeline.spare_count].indexes = build ? indexes[i] : NULL;
+        pipeline.spare_count++;
+    }
+    if (level_scratch_carve(arena, &pipeline.scratch, width, height) != 0) {
+        LOG_WARN("关卡预生成: 内存区空间不足，将同步生成关卡");
+        return -1;
+    }
+
+    pipeline.width = width;
+    pipeline.height = height;
+    pipeline.ghost_count = ghost_count;
+    pipeline.depth = depth;
+    pipeline.build = build;
+    pipeline.build_context = context;
+    pipeline.next_seed = level_pipeline_first_seed(seed);
+    pipeline.ready_head = 0;
+    pipeline.ready_count = 0;
+    pipeline.running = 1;
+
+    if (pthread_create(&pipeline.thread, NULL, pipeline_worker, NULL) != 0) {
+        pipeline.running = 0;
+        LOG_WARN("关卡预生成线程启动失败，将同步生成关卡");
+        return -1;
+    }
+    return 0;
+}
+
+/* 停止流水线，棋盘内存随内存区一起释放 */
+void level_pipeline_stop(void) {
+    pthread_mutex_lock(&pipeline.lock);
+    if (!pipeline.running) {
+        pthread_mutex_unlock(&pipeline.lock);
+        return;
+    }
+    pipeline.running = 0;
+    pthread_cond_broadcast(&pipeline.cond);
+    pthread_mutex_unlock(&pipeline.lock);
+
+    pthread_join(pipeline.thread, NULL);
+
+    pipeline.ready_head = 0;
+    pipeline.ready_count = 0;
+    pipeline.spare_count = 0;
+}
+
+/* 取出一个已生成的棋盘和它的索引（O(1)），没有就绪棋盘或尺寸不符时返回NULL
+ * wait非0时等待后台线程生成完成，保证指定种子时关卡序列与时序无关 */
+CellType** level_pipeline_acquire(int width, int height, int *total_dots, void **indexes,
+                                  int wait) {
+    CellType **board = NULL;
+
+    pthread_mutex_lock(&pipeline.lock);
+    while (wait && pipeline.running && pipeline.ready_count == 0 &&
+           pipeline.width == width && pipeline.height == height) {
+        pthread_cond_wait(&pipeline.cond, &pipeline.lock);
+    }
+    if (pipeline.running && pipeline.ready_count > 0 &&
+        pipeline.width == width && pipeline.height == height) {
+        board = pipeline.ready[pipeline.ready_head].slot.board;
+        if (indexes) *indexes = pipeline.ready[pipeline.ready_head].slot.indexes;
+        if (total_dots) {
+            *total_dots = pipeline.ready[pipeline.ready_head].total_dots;
+        }
+        pipeline.ready_head = (pipeline.ready_head + 1) % LEVEL_PIPELINE_DEPTH;
+        pipeline.ready_count--;
+        pthread_cond_signal(&pipeline.cond);
+    }
+    pthread_mutex_unlock(&pipeline.lock);
+
+    return board;
+}
+
+/* 归还被换下的旧棋盘和它的索引（必须与流水线尺寸相同），供后台线程复用 */
+void level_pipeline_release(CellType **board, void *indexes) {
+    if (!board) return;
+
+    pthread_mutex_lock(&pipeline.lock);
+    if (pipeline.running && pipeline.spare_count < LEVEL_PIPELINE_POOL + 1) {
+        pipeline.spare[pipeline.spare_count].board = board;
+        pipeline.spare[pipeline.spare_count].indexes = indexes;
+        pipeline.spare_count++;
+        pthread_cond_signal(&pipeline.cond);
+    }
+    pthread_mutex_unlock(&pipeline.lock);
+}
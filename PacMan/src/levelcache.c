@@ -0,0 +1,214 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "levelcache.h"
+#include "level.h"
+#include "map.h"
+#include "log.h"
+#include "navgraph.h"
+#include "nexthop.h"
+#include "hpa.h"
+
+/* 缓存文件路径：目录加上键的FNV-1a散列 */
+static void level_cache_path(char *path, size_t size, const char *dir, const LevelCacheKey *key) {
+    const unsigned char *bytes = (const unsigned char*)key;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < sizeof(*key); i++) {
+        h = (h ^ bytes[i]) * 1099511628211ULL;
+    }
+    snprintf(path, size, "%s/%016llx.plc", dir, (unsigned long long)h);
+}
+
+static uint64_t level_cache_align(uint64_t offset) {
+    return (offset + LEVEL_CACHE_ALIGN - 1) & ~(uint64_t)(LEVEL_CACHE_ALIGN - 1);
+}
+
+/* 生成键：其余字段取当前生成器的常量 */
+void level_cache_key(LevelCacheKey *key, unsigned int seed, int width, int height,
+                     int ghost_count) {
+    memset(key, 0, sizeof(*key));
+    key->generator_version = LEVEL_GENERATOR_VERSION;
+    key->seed = seed;
+    key->width = (uint32_t)width;
+    key->height = (uint32_t)height;
+    key->wall_density = LEVEL_WALL_DENSITY_PERMILLE;
+    key->ghost_count = (uint32_t)ghost_count;
+}
+
+/* 查找缓存条目：文件不存在是正常的未命中，内容无效时记录警告 */
+int level_cache_open(const char *dir, const LevelCacheKey *key, LevelCacheEntry *entry) {
+    char path[4096];
+    memset(entry, 0, sizeof(*entry));
+    level_cache_path(path, sizeof(path), dir, key);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(LevelCacheHeader)) {
+        close(fd);
+        LOG_WARN("关卡缓存 %s 不完整，将重新生成", path);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return -1;
+    entry->mapping = mapping;
+    entry->mapping_size = (size_t)st.st_size;
+
+    const LevelCacheHeader *header = (const LevelCacheHeader*)mapping;
+    int valid = memcmp(header->magic, LEVEL_CACHE_MAGIC, 4) == 0 &&
+                header->version == LEVEL_CACHE_VERSION && header->byte_order == MAP_BYTE_ORDER &&
+                memcmp(&header->key, key, sizeof(*key)) == 0 &&
+                header->sections[LEVEL_CACHE_BOARD].size == (uint64_t)key->width * key->height &&
+                header->sections[LEVEL_CACHE_EXITS].size == (uint64_t)key->width * key->height;
+    uint64_t data_start = level_cache_align(sizeof(LevelCacheHeader));
+    for (int s = 0; s < LEVEL_CACHE_SECTIONS && valid; s++) {
+        const LevelCacheSection *section = &header->sections[s];
+        valid = section->offset >= data_start && section->offset <= entry->mapping_size &&
+                entry->mapping_size - section->offset >= section->size;
+    }
+    if (valid) {
+        valid = entry->mapping_size >= data_start &&
+                map_checksum((const unsigned char*)mapping + data_start,
+                             entry->mapping_size - data_start) == header->checksum;
+    }
+    if (!valid) {
+        LOG_WARN("关卡缓存 %s 无效，将重新生成", path);
+        level_cache_close(entry);
+        return -1;
+    }
+    entry->header = header;
+    return 0;
+}
+
+/* 解除映射 */
+void level_cache_close(LevelCacheEntry *entry) {
+    if (entry->mapping) munmap(entry->mapping, entry->mapping_size);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/* 段数据的地址 */
+static const unsigned char *level_cache_section(const LevelCacheEntry *entry, int section) {
+    return (const unsigned char*)entry->mapping + entry->header->sections[section].offset;
+}
+
+/* 复制棋盘 */
+int level_cache_fill_board(const LevelCacheEntry *entry, CellType **board,
+                           unsigned int *rng_state) {
+    const LevelCacheHeader *header = entry->header;
+    const unsigned char *cells = level_cache_section(entry, LEVEL_CACHE_BOARD);
+    int width = (int)header->key.width;
+    for (int y = 0; y < (int)header->key.height; y++) {
+        const unsigned char *src = cells + (size_t)y * width;
+        CellType *dst = board[y];
+        for (int x = 0; x < width; x++) dst[x] = (CellType)src[x];
+    }
+    *rng_state = header->rng_state;
+    return (int)header->total_dots;
+}
+
+/* 复制出口掩码和各索引的映像 */
+int level_cache_load_indexes(const LevelCacheEntry *entry, GameState *state) {
+    const LevelCacheSection *sections = entry->header->sections;
+
+    memcpy(state->exits, level_cache_section(entry, LEVEL_CACHE_EXITS),
+           sections[LEVEL_CACHE_EXITS].size);
+    if (state->nav &&
+        navgraph_load_image(state->nav, level_cache_section(entry, LEVEL_CACHE_NAVGRAPH),
+                            sections[LEVEL_CACHE_NAVGRAPH].size) != 0) {
+        return -1;
+    }
+    if (state->nexthop &&
+        nexthop_load_image(state->nexthop, level_cache_section(entry, LEVEL_CACHE_NEXTHOP),
+                           sections[LEVEL_CACHE_NEXTHOP].size) != 0) {
+        return -1;
+    }
+    if (state->hpa &&
+        hpa_load_image(state->hpa, level_cache_section(entry, LEVEL_CACHE_HPA),
+                       sections[LEVEL_CACHE_HPA].size) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* 写入缓存：临时文件扩展到完整大小后映射，各段直接写入映射，不经过堆；
+ * 写完后改名，同时运行的多个进程不会读到写了一半的文件 */
+int level_cache_store(const char *dir, const LevelCacheKey *key, const GameState *state,
+                      unsigned int rng_state, int total_dots) {
+    size_t cells = (size_t)key->width * key->height;
+    LevelCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LEVEL_CACHE_MAGIC, 4);
+    header.version = LEVEL_CACHE_VERSION;
+    header.byte_order = MAP_BYTE_ORDER;
+    header.key = *key;
+    header.rng_state = rng_state;
+    header.total_dots = (uint32_t)total_dots;
+    header.sections[LEVEL_CACHE_BOARD].size = cells;
+    header.sections[LEVEL_CACHE_EXITS].size = cells;
+    if (state->nav) header.sections[LEVEL_CACHE_NAVGRAPH].size = navgraph_image_bytes(state->nav);
+    if (nexthop_is_valid(state->nexthop)) {
+        header.sections[LEVEL_CACHE_NEXTHOP].size = nexthop_image_bytes(state->nexthop);
+    }
+    if (state->hpa) header.sections[LEVEL_CACHE_HPA].size = hpa_image_bytes(state->hpa);
+
+    uint64_t data_start = level_cache_align(sizeof(LevelCacheHeader));
+    uint64_t offset = data_start;
+    for (int s = 0; s < LEVEL_CACHE_SECTIONS; s++) {
+        header.sections[s].offset = offset;
+        offset = level_cache_align(offset + header.sections[s].size);
+    }
+    size_t file_size = (size_t)offset;
+
+    char path[4096], temp[4200];
+    level_cache_path(path, sizeof(path), dir, key);
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    mkdir(dir, 0755);
+
+    int fd = open(temp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)file_size) != 0) {
+        LOG_WARN("关卡缓存: 无法创建 %s", temp);
+        if (fd >= 0) {
+            close(fd);
+            unlink(temp);
+        }
+        return -1;
+    }
+    unsigned char *file = (unsigned char*)mmap(NULL, file_size, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        LOG_WARN("关卡缓存: 无法映射 %s", temp);
+        unlink(temp);
+        return -1;
+    }
+
+    unsigned char *board = file + header.sections[LEVEL_CACHE_BOARD].offset;
+    for (size_t i = 0; i < cells; i++) {
+        board[i] = (unsigned char)state->board[i / key->width][i % key->width];
+    }
+    memcpy(file + header.sections[LEVEL_CACHE_EXITS].offset, state->exits, cells);
+    if (header.sections[LEVEL_CACHE_NAVGRAPH].size > 0) {
+        navgraph_save_image(state->nav, file + header.sections[LEVEL_CACHE_NAVGRAPH].offset);
+    }
+    if (header.sections[LEVEL_CACHE_NEXTHOP].size > 0) {
+        nexthop_save_image(state->nexthop, file + header.sections[LEVEL_CACHE_NEXTHOP].offset);
+    }
+    if (header.sections[LEVEL_CACHE_HPA].size > 0) {
+        hpa_save_image(state->hpa, file + header.sections[LEVEL_CACHE_HPA].offset);
+    }
+    header.checksum = map_checksum(file + data_start, file_size - data_start);
+    memcpy(file, &header, sizeof(header));
+    munmap(file, file_size);
+
+    if (rename(temp, path) != 0) {
+        LOG_WARN("关卡缓存: 写入 %s 失败", path);
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "liveshm.h"
+#include "arena.h"
+#include "log.h"
+
+/* 读者取快照的最多尝试次数 */
+#define LIVE_SHM_RETRIES 1000
+
+struct LiveShm {
+    char name[256];
+    int width, height;
+    size_t cells;
+    LiveShmHeader *header;
+    unsigned char *board;           /* 段内的棋盘 */
+    size_t size;
+    int *dirty_list;                /* 本tick变化的格子（可能重复，重复写入无害） */
+    int dirty_count, dirty_capacity;
+    int resync;                     /* 下一次发布复制整个棋盘 */
+    unsigned int board_serial;
+    uint32_t sum;                   /* 段内棋盘的校验和 */
+    uint32_t tick;
+};
+
+struct LiveShmReader {
+    const LiveShmHeader *header;
+    const unsigned char *board;
+    size_t size;
+    int width, height;
+};
+
+/* 棋盘从头部之后的第一个64字节边界开始 */
+static size_t live_shm_board_offset(void) {
+    return (sizeof(LiveShmHeader) + 63) & ~(size_t)63;
+}
+
+LiveShm *live_shm_create(const char *name, int width, int height) {
+    if (name[0] != '/' || strlen(name) >= sizeof(((LiveShm*)0)->name) || strchr(name + 1, '/')) {
+        fprintf(stderr, "错误: 共享内存名必须以 / 开头且不含其他 /: %s\n", name);
+        return NULL;
+    }
+    LiveShm *shm = (LiveShm*)heap_calloc(1, sizeof(LiveShm));
+    if (!shm) return NULL;
+    strcpy(shm->name, name);
+    shm->width = width;
+    shm->height = height;
+    shm->cells = (size_t)width * height;
+    shm->dirty_capacity = (int)(shm->cells / 4) + 1;
+    shm->dirty_list = (int*)heap_alloc((size_t)shm->dirty_capacity * sizeof(int));
+    shm->size = live_shm_board_offset() + shm->cells;
+    shm->resync = 1;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (!shm->dirty_list || fd < 0 || ftruncate(fd, (off_t)shm->size) != 0) {
+        fprintf(stderr, "错误: 无法创建共享内存段 %s: %s\n", name, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(name);
+        }
+        heap_free(shm->dirty_list);
+        heap_free(shm);
+        return NULL;
+    }
+    void *map = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射共享内存段 %s: %s\n", name, strerror(errno));
+        shm_unlink(name);
+        heap_free(shm->dirty_list);
+        heap_free(shm);
+        return NULL;
+    }
+
+    /* 新段全为0，先填好其余字段，最后写入标识，读者看到标识时头部已完整 */
+    shm->header = (LiveShmHeader*)map;
+    shm->board = (unsigned char*)map + live_shm_board_offset();
+    shm->header->version = LIVE_SHM_VERSION;
+    shm->header->header_bytes = (uint32_t)sizeof(LiveShmHeader);
+    shm->header->board_offset = (uint32_t)live_shm_board_offset();
+    shm->header->width = (uint32_t)width;
+    shm->header->height = (uint32_t)height;
+    shm->header->writer_pid = (uint32_t)getpid();
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(shm->header->magic, LIVE_SHM_MAGIC, 4);
+    LOG_INFO("状态导出到共享内存 %s（%zu 字节）", name, shm->size);
+    return shm;
+}
+
+void live_shm_destroy(LiveShm *shm) {
+    if (!shm) return;
+    munmap(shm->header, shm->size);
+    shm_unlink(shm->name);
+    heap_free(shm->dirty_list);
+    heap_free(shm);
+}
+
+void live_shm_cell(LiveShm *shm, int index) {
+    if (shm->dirty_count == shm->dirty_capacity) {
+        shm->resync = 1;
+        return;
+    }
+    shm->dirty_list[shm->dirty_count++] = index;
+}
+
+void live_shm_resync(LiveShm *shm) {
+    shm->resync = 1;
+}
+
+void live_shm_publish(LiveShm *shm, const GameState *state, unsigned int board_serial) {
+    LiveShmHeader *h = shm->header;
+    const CellType *cells = state->board[0];
+    uint32_t sequence = h->sequence;
+    shm->tick++;
+    if (board_serial != shm->board_serial) {
+        shm->board_serial = board_serial;
+        shm->resync = 1;
+    }
+
+    /* 进入写区：sequence为奇数，之后的写入不会排到它前面 */
+    __atomic_store_n(&h->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (shm->resync) {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < shm->cells; i++) {
+            shm->board[i] = (unsigned char)cells[i];
+            sum += (uint32_t)cells[i] * (uint32_t)(i + 1);
+        }
+        shm->sum = sum;
+    } else {
+        for (int k = 0; k < shm->dirty_count; k++) {
+            int index = shm->dirty_list[k];
+            unsigned char value = (unsigned char)cells[index];
+            shm->sum += ((uint32_t)value - shm->board[index]) * (uint32_t)(index + 1);
+            shm->board[index] = value;
+        }
+    }
+
+    LiveShmStats *stats = &h->stats;
+    stats->tick = shm->tick;
+    stats->board_serial = board_serial;
+    stats->board_sum = shm->sum;
+    stats->level = state->level;
+    stats->score = state->score;
+    stats->lives = state->lives;
+    stats->dots_collected = state->dots_collected;
+    stats->total_dots = state->total_dots;
+    stats->player_x = state->player_pos.x;
+    stats->player_y = state->player_pos.y;
+    stats->frightened_ticks = state->frightened_ticks;
+    stats->game_over = state->game_over;
+    stats->game_won = state->game_won;
+    stats->ghost_count = state->ghosts.count;
+
+    /* 离开写区：之前的写入全部可见后sequence才变回偶数 */
+    __atomic_store_n(&h->sequence, sequence + 2, __ATOMIC_RELEASE);
+    shm->dirty_count = 0;
+    shm->resync = 0;
+}
+
+LiveShmReader *live_shm_open(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法打开共享内存段 %s: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(LiveShmHeader)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射共享内存段 %s\n", name);
+        return NULL;
+    }
+
+    const LiveShmHeader *h = (const LiveShmHeader*)map;
+    size_t size = (size_t)st.st_size;
+    int valid = memcmp(h->magic, LIVE_SHM_MAGIC, 4) == 0;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (!valid || h->version != LIVE_SHM_VERSION || h->header_bytes < sizeof(LiveShmHeader) ||
+        h->board_offset < h->header_bytes ||
+        h->board_offset + (size_t)h->width * h->height > size) {
+        fprintf(stderr, "错误: %s 不是状态导出段或版本不符\n", name);
+        munmap(map, size);
+        return NULL;
+    }
+    LiveShmReader *reader = (LiveShmReader*)heap_calloc(1, sizeof(LiveShmReader));
+    if (!reader) {
+        munmap(map, size);
+        return NULL;
+    }
+    reader->header = h;
+    reader->board = (const unsigned char*)map + h->board_offset;
+    reader->size = size;
+    reader->width = (int)h->width;
+    reader->height = (int)h->height;
+    return reader;
+}
+
+void live_shm_close(LiveShmReader *reader) {
+    if (!reader) return;
+    munmap((void*)reader->header, reader->size);
+    heap_free(reader);
+}
+
+int live_shm_width(const LiveShmReader *reader) {
+    return reader->width;
+}
+
+int live_shm_height(const LiveShmReader *reader) {
+    return reader->height;
+}
+
+unsigned int live_shm_writer_pid(const LiveShmReader *reader) {
+    return reader->header->writer_pid;
+}
+
+int live_shm_snapshot(LiveShmReader *reader, LiveShmStats *stats, unsigned char *cells,
+                      size_t size) {
+    const LiveShmHeader *h = reader->header;
+    size_t count = (size_t)reader->width * reader->height;
+    if (cells && size < count) return -1;
+    for (int attempt = 0; attempt < LIVE_SHM_RETRIES; attempt++) {
+        uint32_t before = __atomic_load_n(&h->sequence, __ATOMIC_ACQUIRE);
+        if (!(before & 1)) {
+            memcpy(stats, &h->stats, sizeof(LiveShmStats));
+            if (cells) memcpy(cells, reader->board, count);
+            /* 复制的读取不会排到第二次读sequence之后 */
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&h->sequence, __ATOMIC_RELAXED) == before) return 0;
+        }
+        sched_yield();
+    }
+    return -1;
+}
@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "log.h"
+
+/* 日志缓冲区参数 */
+#define LOG_RING_SLOTS 256      /* 每个线程的环形缓冲区槽位数（2的幂） */
+#define LOG_MSG_MAX 200         /* 单条日志最大长度 */
+#define LOG_MAX_THREADS 32      /* 最多支持的写日志线程数 */
+#define LOG_WRITE_BATCH 16384   /* 后台线程单次write()的批量大小 */
+#define LOG_IDLE_SLEEP_NS 2000000L /* 缓冲区为空时后台线程休眠2毫秒 */
+
+/* 单条日志记录 */
+typedef struct {
+    int level;
+    long timestamp_ms;
+    char text[LOG_MSG_MAX];
+} LogRecord;
+
+/* 单生产者单消费者的无锁环形缓冲区：游戏线程写入，后台线程读出 */
+typedef struct {
+    unsigned int head;          /* 下一条待读出的位置（后台线程更新） */
+    unsigned int tail;          /* 下一条待写入的位置（生产线程更新） */
+    int thread_index;
+    LogRecord slots[LOG_RING_SLOTS];
+} LogRing;
+
+/* 全局日志状态 */
+int g_log_level = LOG_LEVEL_INFO;
+static LogRing *rings[LOG_MAX_THREADS];
+static LogRing *ring_storage = NULL;    /* log_init时一次分配全部线程的缓冲区，进程结束前不释放 */
+static int ring_count = 0;
+static unsigned long dropped_count = 0;
+static int writer_running = 0;
+static pthread_t writer_thread;
+static __thread LogRing *tls_ring = NULL;
+
+static const char *level_names[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+
+/* 获取单调时钟毫秒数 */
+static long log_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* 获取（必要时注册）当前线程的环形缓冲区 */
+static LogRing *get_thread_ring(void) {
+    if (tls_ring) return tls_ring;
+
+    int index = __atomic_fetch_add(&ring_count, 1, __ATOMIC_ACQ_REL);
+    if (index >= LOG_MAX_THREADS) {
+        return NULL;
+    }
+
+    /* 缓冲区在log_init中预先分配，写日志的路径不访问堆 */
+    LogRing *ring = &ring_storage[index];
+    ring->thread_index = index;
+    __atomic_store_n(&rings[index], ring, __ATOMIC_RELEASE);
+    tls_ring = ring;
+    return ring;
+}
+
+/* 将一条记录格式化为输出行，返回写入的字节数 */
+static int format_record(char *out, size_t size, const LogRecord *rec, int thread_index) {
+    int n = snprintf(out, size, "[%ld.%03ld] %s T%d %s\n",
+                     rec->timestamp_ms / 1000, rec->timestamp_ms % 1000,
+                     level_names[rec->level], thread_index, rec->text);
+    if (n < 0) return 0;
+    return (n < (int)size) ? n : (int)size - 1;
+}
+
+/* 将缓冲区完整写到标准输出 */
+static void write_all(const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, buf, len);
+        if (n <= 0) return;
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+/* 把所有线程缓冲区中的日志汇总输出，返回处理的记录数 */
+static int drain_rings(void) {
+    static char batch[LOG_WRITE_BATCH];
+    size_t used = 0;
+    int drained = 0;
+    int count = __atomic_load_n(&ring_count, __ATOMIC_ACQUIRE);
+    if (count > LOG_MAX_THREADS) count = LOG_MAX_THREADS;
+
+    for (int i = 0; i < count; i++) {
+        LogRing *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (!ring) continue;
+
+        unsigned int head = ring->head;
+        unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            if (LOG_WRITE_BATCH - used < LOG_MSG_MAX + 64) {
+                write_all(batch, used);
+                used = 0;
+            }
+            const LogRecord *rec = &ring->slots[head & (LOG_RING_SLOTS - 1)];
+            used += format_record(batch + used, LOG_WRITE_BATCH - used, rec, ring->thread_index);
+            head++;
+            drained++;
+        }
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    }
+
+    if (used > 0) {
+        write_all(batch, used);
+    }
+    return drained;
+}
+
+/* 后台写线程：轮询各线程缓冲区并批量写出 */
+static void *writer_main(void *arg) {
+    (void)arg;
+    struct timespec idle = {0, LOG_IDLE_SLEEP_NS};
+
+    while (__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        if (drain_rings() == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    /* 退出前写出剩余日志 */
+    drain_rings();
+    return NULL;
+}
+
+/* 启动日志系统的后台写线程 */
+int log_init(void) {
+    if (writer_running) return 0;
+
+    /* 标准输出的stdio缓冲可能还有内容，先刷新以保证顺序 */
+    fflush(stdout);
+
+    /* 线程首次写日志时从这里取缓冲区，未触及的页不占用物理内存 */
+    if (!ring_storage) {
+        ring_storage = (LogRing*)calloc(LOG_MAX_THREADS, sizeof(LogRing));
+        if (!ring_storage) {
+            fprintf(stderr, "Warning: Unable to allocate log buffers, logging synchronously\n");
+            return -1;
+        }
+    }
+
+    __atomic_store_n(&writer_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        writer_running = 0;
+        fprintf(stderr, "Warning: Unable to start log writer thread, logging synchronously\n");
+        return -1;
+    }
+
+    /* exit()路径（如Quit按钮）也要写出缓冲中的日志 */
+    atexit(log_shutdown);
+    return 0;
+}
+
+/* 停止后台写线程并写出剩余日志 */
+void log_shutdown(void) {
+    if (!__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) return;
+    __atomic_store_n(&writer_running, 0, __ATOMIC_RELEASE);
+    pthread_join(writer_thread, NULL);
+}
+
+/* 设置运行期日志级别，LOG_LEVEL_OFF关闭所有日志 */
+void log_set_level(int level) {
+    if (level < LOG_LEVEL_DEBUG) level = LOG_LEVEL_DEBUG;
+    if (level > LOG_LEVEL_OFF) level = LOG_LEVEL_OFF;
+    g_log_level = level;
+}
+
+/* 获取运行期日志级别 */
+int log_get_level(void) {
+    return g_log_level;
+}
+
+/* 获取因缓冲区满而丢弃的日志条数 */
+unsigned long log_dropped_count(void) {
+    return __atomic_load_n(&dropped_count, __ATOMIC_RELAXED);
+}
+
+/* 写入一条日志：只在本线程缓冲区中格式化，不做系统调用 */
+void log_write(int level, const char *fmt, ...) {
+    va_list args;
+
+    if (level < g_log_level || level < LOG_LEVEL_DEBUG || level >= LOG_LEVEL_OFF) return;
+
+    /* 后台线程未启动时（如工具程序）直接同步输出 */
+    if (!__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        LogRecord rec;
+        char line[LOG_MSG_MAX + 64];
+        rec.level = level;
+        rec.timestamp_ms = log_time_ms();
+        va_start(args, fmt);
+        vsnprintf(rec.text, sizeof(rec.text), fmt, args);
+        va_end(args);
+        format_record(line, sizeof(line), &rec, 0);
+        fputs(line, stdout);
+        return;
+    }
+
+    LogRing *ring = get_thread_ring();
+    if (!ring) {
+        __atomic_fetch_add(&dropped_count, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    unsigned int tail = ring->tail;
+    unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail - head >= LOG_RING_SLOTS) {
+        /* 缓冲区已满：丢弃而不是阻塞游戏线程 */
+        __atomic_fetch_add(&dropped_count, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    LogRecord *rec = &ring->slots[tail & (LOG_RING_SLOTS - 1)];
+    rec->level = level;
+    rec->timestamp_ms = log_time_ms();
+    va_start(args, fmt);
+    vsnprintf(rec->text, sizeof(rec->text), fmt, args);
+    va_end(args);
+
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
@@ -4,6 +4,16 @@
 #include "types.h"
 #include "gui.h"
 #include "game.h"
+#include "log.h"
+#include "algorithms.h"
+#include "headless.h"
+#include "capture.h"
+#include "parallel.h"
+#include "nexthop.h"
+#include "hpa.h"
+#include "map.h"
+#include "pack.h"
+#include "journal.h"
 
 /* 打印使用说明 */
 void print_usage(const char *program_name) {
@@ -12,6 +22,33 @@ void print_usage(const char *program_name) {
     printf("  -h, --help    显示此帮助信息\n");
     printf("  -v, --version 显示版本信息\n");
     printf("  -s, --size    指定网格大小 (格式: -s 宽度 高度)\n");
+    printf("  -q, --quiet   关闭游戏日志输出\n");
+    printf("  -g, --ghosts N 每关的幽灵数 (默认: %d，图形界面最多 %d)\n",
+           DEFAULT_GHOST_COUNT, MAX_GUI_GHOST_COUNT);
+    printf("  --seed N      随机种子，相同种子生成相同的关卡和幽灵行为\n");
+    printf("  --threads N   幽灵决策使用的线程数 (默认: CPU核数)\n");
+    printf("  --no-nexthop  不为小棋盘 (不超过 %d 格) 预计算全源下一步表\n", NEXTHOP_MAX_CELLS);
+    printf("  --no-hpa      不为大棋盘 (不少于 %d 格) 建立分层寻路图\n", HPA_MIN_CELLS);
+    printf("  --map FILE    从文件加载固定地图 (文本或 .pmap 二进制格式)，网格大小和幽灵数取自地图\n");
+    printf("  --pack FILE   依次使用棋盘包 (.ppak，由mapgen生成) 里预生成的棋盘，网格大小和幽灵数取自棋盘包\n");
+    printf("  --cache DIR   随机关卡先查目录DIR下的关卡缓存，未命中时生成并写入 (不用于 --map/--pack)\n");
+    printf("  --rewind N    回退日志保留N个tick的历史，0为关闭 (默认: 图形界面 %d，无界面模式 0)\n",
+           JOURNAL_DEFAULT_TICKS);
+    printf("  --spectate PATH 在Unix域套接字PATH上向观战客户端 (pacman_spectate) 广播游戏\n");
+    printf("  --shm NAME      把棋盘和计数器导出到POSIX共享内存段NAME (如 /pacman，读取见 pacman_watch)\n");
+    printf("\n");
+    printf("无界面模式:\n");
+    printf("  --headless        不打开窗口，玩家由自动驾驶控制\n");
+    printf("  --term            无界面运行并用ANSI终端实时显示\n");
+    printf("  --ticks N         最多运行N个tick (默认: 不限)\n");
+    printf("  --tick-ms N       每个tick的间隔毫秒数，0为全速 (默认: %d)\n", SIM_TICK_MS);
+    printf("  --algo NAME       幽灵算法: none, random, zigzag, hunt, classic (默认: random)\n");
+    printf("  --games N         连续运行N局 (默认: 1)\n");
+    printf("  --capture DIR     无界面运行并把每帧保存为图片到DIR目录\n");
+    printf("  --capture-format F  图片格式: png, ppm (默认: png)\n");
+    printf("  --capture-every N   每N个tick捕获一帧 (默认: 1)\n");
+    printf("  --capture-workers N 编码线程数 (默认: CPU核数-1)\n");
+    printf("  无界面模式下网格最大为 %d x %d\n", MAX_HEADLESS_BOARD_WIDTH, MAX_HEADLESS_BOARD_HEIGHT);
     printf("\n");
     printf("网格大小:\n");
     printf("  宽度范围: %d - %d (默认: %d)\n", MIN_BOARD_WIDTH, MAX_BOARD_WIDTH, DEFAULT_BOARD_WIDTH);
@@ -26,12 +63,33 @@ void print_usage(const char *program_name) {
     printf("  Quit: 退出游戏\n");
 }
 
+/* 解析幽灵算法名称，未知名称返回-1 */
+static int parse_algorithm_name(const char *name) {
+    if (strcmp(name, "none") == 0) return ALGO_NONE;
+    if (strcmp(name, "random") == 0) return ALGO_RANDOM;
+    if (strcmp(name, "zigzag") == 0) return ALGO_ZIGZAG;
+    if (strcmp(name, "hunt") == 0) return ALGO_DFS;
+    if (strcmp(name, "classic") == 0) return ALGO_CLASSIC;
+    return -1;
+}
+
 /* 主函数 */
 int main(int argc, char *argv[]) {
     int i;
     int board_width = DEFAULT_BOARD_WIDTH;
     int board_height = DEFAULT_BOARD_HEIGHT;
     int size_specified = 0;
+    int headless = 0;
+    int ghost_count = DEFAULT_GHOST_COUNT;
+    int threads = 0;
+    const char *map_path = NULL;
+    const char *pack_path = NULL;
+    int rewind_ticks = -1;
+    GameMap map;
+    BoardPack pack;
+    HeadlessOptions headless_options;
+    
+    headless_default_options(&headless_options);
     
     /* 处理命令行参数 */
     for (i = 1; i < argc; i++) {
@@ -52,6 +110,88 @@ int main(int argc, char *argv[]) {
             board_width = atoi(argv[++i]);
             board_height = atoi(argv[++i]);
             size_specified = 1;
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
+            log_set_level(LOG_LEVEL_OFF);
+        } else if (strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--ghosts") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: %s 选项需要一个参数\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            ghost_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 || strcmp(argv[i], "--threads") == 0 ||
+                   strcmp(argv[i], "--map") == 0 || strcmp(argv[i], "--pack") == 0 ||
+                   strcmp(argv[i], "--cache") == 0 || strcmp(argv[i], "--rewind") == 0 ||
+                   strcmp(argv[i], "--spectate") == 0 || strcmp(argv[i], "--shm") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: %s 选项需要一个参数\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[i], "--seed") == 0) {
+                set_game_seed((unsigned int)strtoul(argv[i + 1], NULL, 10));
+            } else if (strcmp(argv[i], "--map") == 0) {
+                map_path = argv[i + 1];
+            } else if (strcmp(argv[i], "--pack") == 0) {
+                pack_path = argv[i + 1];
+            } else if (strcmp(argv[i], "--cache") == 0) {
+                set_level_cache_dir(argv[i + 1]);
+            } else if (strcmp(argv[i], "--rewind") == 0) {
+                rewind_ticks = atoi(argv[i + 1]);
+            } else if (strcmp(argv[i], "--spectate") == 0) {
+                set_spectate_socket(argv[i + 1]);
+            } else if (strcmp(argv[i], "--shm") == 0) {
+                set_live_shm_name(argv[i + 1]);
+            } else {
+                threads = atoi(argv[i + 1]);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--no-nexthop") == 0) {
+            set_nexthop_enabled(0);
+        } else if (strcmp(argv[i], "--no-hpa") == 0) {
+            set_hpa_enabled(0);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if (strcmp(argv[i], "--term") == 0) {
+            headless = 1;
+            headless_options.term = 1;
+        } else if ((strcmp(argv[i], "--ticks") == 0 || strcmp(argv[i], "--tick-ms") == 0 ||
+                    strcmp(argv[i], "--algo") == 0 || strcmp(argv[i], "--games") == 0 ||
+                    strcmp(argv[i], "--capture") == 0 || strcmp(argv[i], "--capture-format") == 0 ||
+                    strcmp(argv[i], "--capture-every") == 0 ||
+                    strcmp(argv[i], "--capture-workers") == 0)) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: %s 选项需要一个参数\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *option = argv[i++];
+            if (strcmp(option, "--ticks") == 0) {
+                headless_options.ticks = atol(argv[i]);
+            } else if (strcmp(option, "--tick-ms") == 0) {
+                headless_options.tick_ms = atoi(argv[i]);
+            } else if (strcmp(option, "--games") == 0) {
+                headless_options.games = atoi(argv[i]);
+            } else if (strcmp(option, "--capture") == 0) {
+                headless = 1;
+                headless_options.capture_dir = argv[i];
+            } else if (strcmp(option, "--capture-format") == 0) {
+                headless_options.capture_format = capture_parse_format(argv[i]);
+                if (headless_options.capture_format < 0) {
+                    fprintf(stderr, "错误: 未知的图片格式: %s\n", argv[i]);
+                    return 1;
+                }
+            } else if (strcmp(option, "--capture-every") == 0) {
+                headless_options.capture_every = atoi(argv[i]);
+            } else if (strcmp(option, "--capture-workers") == 0) {
+                headless_options.capture_workers = atoi(argv[i]);
+            } else {
+                headless_options.algorithm = parse_algorithm_name(argv[i]);
+                if (headless_options.algorithm < 0) {
+                    fprintf(stderr, "错误: 未知的幽灵算法: %s\n", argv[i]);
+                    return 1;
+                }
+            }
         } else if (argv[i][0] != '-' && !size_specified) {
             /* 直接指定宽度和高度 */
             if (i + 1 < argc && argv[i+1][0] != '-') {
@@ -71,26 +211,92 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    /* 验证网格大小 */
-    if (board_width < MIN_BOARD_WIDTH || board_width > MAX_BOARD_WIDTH) {
-        fprintf(stderr, "错误: 宽度必须在 %d 到 %d 之间\n", MIN_BOARD_WIDTH, MAX_BOARD_WIDTH);
+    /* 固定地图决定网格大小和幽灵数 */
+    if (map_path) {
+        if (map_load(map_path, &map) != 0) {
+            return 1;
+        }
+        board_width = map.width;
+        board_height = map.height;
+        ghost_count = map.ghost_count;
+    }
+    
+    /* 棋盘包同样决定网格大小和幽灵数，与固定地图不能同时使用 */
+    if (pack_path) {
+        if (map_path) {
+            fprintf(stderr, "错误: --map 和 --pack 不能同时使用\n");
+            return 1;
+        }
+        if (pack_open(pack_path, &pack) != 0) {
+            return 1;
+        }
+        board_width = pack.width;
+        board_height = pack.height;
+        ghost_count = pack.ghost_count;
+    }
+    
+    /* 验证网格大小，无界面模式不受窗口大小限制 */
+    int max_width = headless ? MAX_HEADLESS_BOARD_WIDTH : MAX_BOARD_WIDTH;
+    int max_height = headless ? MAX_HEADLESS_BOARD_HEIGHT : MAX_BOARD_HEIGHT;
+    if (board_width < MIN_BOARD_WIDTH || board_width > max_width) {
+        fprintf(stderr, "错误: 宽度必须在 %d 到 %d 之间\n", MIN_BOARD_WIDTH, max_width);
         return 1;
     }
-    if (board_height < MIN_BOARD_HEIGHT || board_height > MAX_BOARD_HEIGHT) {
-        fprintf(stderr, "错误: 高度必须在 %d 到 %d 之间\n", MIN_BOARD_HEIGHT, MAX_BOARD_HEIGHT);
+    if (board_height < MIN_BOARD_HEIGHT || board_height > max_height) {
+        fprintf(stderr, "错误: 高度必须在 %d 到 %d 之间\n", MIN_BOARD_HEIGHT, max_height);
         return 1;
     }
+    int max_ghosts = headless ? MAX_GHOST_COUNT : MAX_GUI_GHOST_COUNT;
+    if (ghost_count < 0 || ghost_count > max_ghosts) {
+        fprintf(stderr, "错误: 幽灵数必须在 0 到 %d 之间\n", max_ghosts);
+        return 1;
+    }
+    if (headless_options.games < 1) {
+        headless_options.games = 1;
+    }
+    
+    /* 终端渲染占用标准输出，关闭日志避免干扰画面 */
+    if (headless_options.term) {
+        log_set_level(LOG_LEVEL_OFF);
+    }
     
     /* 设置网格大小 */
     set_board_size(board_width, board_height);
+    set_ghost_count(ghost_count);
+    set_journal_ticks(rewind_ticks >= 0 ? rewind_ticks : (headless ? 0 : JOURNAL_DEFAULT_TICKS));
+    if (map_path) {
+        set_game_map(&map);
+        printf("地图: %s\n", map_path);
+    }
+    if (pack_path) {
+        set_game_pack(&pack);
+        printf("棋盘包: %s (%d 个棋盘)\n", pack_path, pack.board_count);
+    }
     printf("游戏网格大小: %d x %d\n", board_width, board_height);
     
+    /* 启动后台日志线程，游戏路径上的日志不再直接写标准输出 */
+    log_init();
+    
+    /* 启动幽灵决策用的线程池 */
+    parallel_init(threads);
+    
     /* 先初始化游戏状态 */
     if (init_game_state_with_size(board_width, board_height) != 0) {
         fprintf(stderr, "游戏状态初始化失败\n");
         return 1;
     }
     
+    /* 无界面模式直接运行模拟，不打开显示 */
+    if (headless) {
+        int result = run_headless(&headless_options);
+        parallel_shutdown();
+        cleanup_game_state();
+        if (map_path) map_close(&map);
+        if (pack_path) pack_close(&pack);
+        log_shutdown();
+        return result == 0 ? 0 : 1;
+    }
+    
     /* 然后初始化GUI */
     if (init_gui(argc, argv) != 0) {
         fprintf(stderr, "GUI初始化失败\n");
@@ -104,6 +310,9 @@ int main(int argc, char *argv[]) {
     /* 清理资源 */
     cleanup_gui();
     cleanup_game_state();
+    if (map_path) map_close(&map);
+    if (pack_path) pack_close(&pack);
+    log_shutdown();
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,305 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "map.h"
+#include "tiles.h"
+#include "arena.h"
+
+/* 格子数据的校验和：FNV-1a按8字节一组计算，不足8字节的结尾逐字节计算 */
+uint64_t map_checksum(const unsigned char *cells, size_t count) {
+    uint64_t h = 1469598103934665603ULL;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t word;
+        memcpy(&word, cells + i, sizeof(word));
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    for (; i < count; i++) {
+        h = (h ^ cells[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/* 校验格子内容并统计玩家、幽灵和豆子，玩家出生点不是恰好一个时返回-1
+ * 先按取值计数（四组计数表交替使用，没有分支），只有出错时才逐格定位 */
+static int map_scan_cells(GameMap *map, const char *path) {
+    size_t count = (size_t)map->width * map->height;
+    const unsigned char *cells = map->cells;
+    size_t histogram[4][256];
+    memset(histogram, 0, sizeof(histogram));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        histogram[0][cells[i]]++;
+        histogram[1][cells[i + 1]]++;
+        histogram[2][cells[i + 2]]++;
+        histogram[3][cells[i + 3]]++;
+    }
+    for (; i < count; i++) histogram[0][cells[i]]++;
+
+    size_t total[256];
+    size_t invalid = 0;
+    for (int v = 0; v < 256; v++) {
+        total[v] = histogram[0][v] + histogram[1][v] + histogram[2][v] + histogram[3][v];
+        if (v >= TILE_TYPE_COUNT) invalid += total[v];
+    }
+    if (invalid > 0) {
+        for (i = 0; cells[i] < TILE_TYPE_COUNT; i++) {}
+        fprintf(stderr, "错误: 地图 %s 第 %d 行第 %d 列的格子类型无效: %d\n", path,
+                (int)(i / map->width) + 1, (int)(i % map->width) + 1, cells[i]);
+        return -1;
+    }
+    if (total[CELL_PLAYER] != 1) {
+        fprintf(stderr, "错误: 地图 %s 需要恰好一个玩家出生点 'P'，实际有 %zu 个\n", path,
+                total[CELL_PLAYER]);
+        return -1;
+    }
+
+    size_t player = (size_t)((const unsigned char*)memchr(cells, CELL_PLAYER, count) - cells);
+    map->player_x = (int)(player % map->width);
+    map->player_y = (int)(player / map->width);
+    map->ghost_count = (int)(total[CELL_GHOST_RED] + total[CELL_GHOST_BLUE] +
+                             total[CELL_GHOST_PURPLE] + total[CELL_GHOST_ORANGE]);
+    map->dot_count = (int)(total[CELL_DOT] + total[CELL_POWER_DOT]);
+    return 0;
+}
+
+/* 加载地图，按文件开头的标识选择格式 */
+int map_load(const char *path, GameMap *map) {
+    char magic[4] = {0};
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开地图文件 %s\n", path);
+        return -1;
+    }
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (got == sizeof(magic) && memcmp(magic, MAP_MAGIC, sizeof(magic)) == 0) {
+        return map_load_binary(path, map);
+    }
+    return map_load_text(path, map);
+}
+
+/* 文本格式：整个文件读入后扫描两遍，先确定宽高，再逐字符查表得到格子类型 */
+int map_load_text(const char *path, GameMap *map) {
+    memset(map, 0, sizeof(*map));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开地图文件 %s\n", path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size >= 0 ? (char*)heap_alloc((size_t)size + 1) : NULL;
+    if (!text || fread(text, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "错误: 无法读取地图文件 %s\n", path);
+        heap_free(text);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    text[size] = '\n';
+
+    /* 第一遍：行数和最长行，注释行不计 */
+    int width = 0, height = 0;
+    for (long i = 0; i < size; ) {
+        long end = i;
+        while (text[end] != '\n') end++;
+        long len = end - i;
+        if (len > 0 && text[end - 1] == '\r') len--;
+        if (text[i] != ';') {
+            if (len > width) width = (int)len;
+            height++;
+        }
+        i = end + 1;
+    }
+    if (width == 0 || height == 0) {
+        fprintf(stderr, "错误: 地图文件 %s 是空的\n", path);
+        heap_free(text);
+        return -1;
+    }
+
+    /* 字符到格子类型的查表，取自渲染用的外观表 */
+    int glyph_type[256];
+    for (int c = 0; c < 256; c++) glyph_type[c] = -1;
+    for (int t = 0; t < TILE_TYPE_COUNT; t++) {
+        glyph_type[(unsigned char)get_tile_style((CellType)t)->glyph] = t;
+    }
+
+    /* 第二遍：逐字符填入格子，短行末尾为空通道（heap_calloc已清零） */
+    map->owned = (unsigned char*)heap_calloc((size_t)width * height, 1);
+    if (!map->owned) {
+        fprintf(stderr, "错误: 无法为 %d x %d 的地图分配内存\n", width, height);
+        heap_free(text);
+        return -1;
+    }
+    int y = 0;
+    for (long i = 0; i < size && y < height; ) {
+        long end = i;
+        while (text[end] != '\n') end++;
+        long len = end - i;
+        if (len > 0 && text[end - 1] == '\r') len--;
+        if (text[i] != ';') {
+            unsigned char *row = map->owned + (size_t)y * width;
+            for (long x = 0; x < len; x++) {
+                int type = glyph_type[(unsigned char)text[i + x]];
+                if (type < 0) {
+                    fprintf(stderr, "错误: 地图 %s 第 %d 行第 %ld 列有未知字符 '%c'\n",
+                            path, y + 1, x + 1, text[i + x]);
+                    heap_free(text);
+                    map_close(map);
+                    return -1;
+                }
+                row[x] = (unsigned char)type;
+            }
+            y++;
+        }
+        i = end + 1;
+    }
+    heap_free(text);
+
+    map->width = width;
+    map->height = height;
+    map->cells = map->owned;
+    if (map_scan_cells(map, path) != 0) {
+        map_close(map);
+        return -1;
+    }
+    return 0;
+}
+
+/* 二进制格式：映射整个文件，在映射上校验文件头、长度、校验和与格子内容 */
+int map_load_binary(const char *path, GameMap *map) {
+    memset(map, 0, sizeof(*map));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法打开地图文件 %s\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MapFileHeader)) {
+        fprintf(stderr, "错误: 地图文件 %s 不完整\n", path);
+        close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射地图文件 %s\n", path);
+        return -1;
+    }
+    map->mapping = mapping;
+    map->mapping_size = (size_t)st.st_size;
+
+    const MapFileHeader *header = (const MapFileHeader*)mapping;
+    const unsigned char *cells = (const unsigned char*)mapping + sizeof(MapFileHeader);
+    size_t count = (size_t)header->width * header->height;
+    if (memcmp(header->magic, MAP_MAGIC, 4) != 0 || header->version != MAP_VERSION ||
+        header->byte_order != MAP_BYTE_ORDER) {
+        fprintf(stderr, "错误: 地图文件 %s 的格式、版本或字节序不受支持\n", path);
+        map_close(map);
+        return -1;
+    }
+    if (header->width == 0 || header->height == 0 ||
+        header->width > MAX_HEADLESS_BOARD_WIDTH || header->height > MAX_HEADLESS_BOARD_HEIGHT ||
+        map->mapping_size != sizeof(MapFileHeader) + count) {
+        fprintf(stderr, "错误: 地图文件 %s 的大小与文件头不符\n", path);
+        map_close(map);
+        return -1;
+    }
+    if (map_checksum(cells, count) != header->checksum) {
+        fprintf(stderr, "错误: 地图文件 %s 的校验和不符\n", path);
+        map_close(map);
+        return -1;
+    }
+
+    map->width = (int)header->width;
+    map->height = (int)header->height;
+    map->cells = cells;
+    if (map_scan_cells(map, path) != 0) {
+        map_close(map);
+        return -1;
+    }
+    if ((uint32_t)map->player_x != header->player_x || (uint32_t)map->player_y != header->player_y ||
+        (uint32_t)map->ghost_count != header->ghost_count ||
+        (uint32_t)map->dot_count != header->dot_count) {
+        fprintf(stderr, "错误: 地图文件 %s 的统计与格子内容不符\n", path);
+        map_close(map);
+        return -1;
+    }
+    return 0;
+}
+
+/* 释放地图：解除映射或释放解析出的格子 */
+void map_close(GameMap *map) {
+    if (map->mapping) munmap(map->mapping, map->mapping_size);
+    heap_free(map->owned);
+    memset(map, 0, sizeof(*map));
+}
+
+/* 保存为文本格式，首行注释记录大小 */
+int map_save_text(const GameMap *map, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建地图文件 %s\n", path);
+        return -1;
+    }
+    char glyph[TILE_TYPE_COUNT];
+    for (int t = 0; t < TILE_TYPE_COUNT; t++) glyph[t] = get_tile_style((CellType)t)->glyph;
+
+    fprintf(file, "; PacMan map %d x %d\n", map->width, map->height);
+    int ok = 1;
+    for (int y = 0; y < map->height && ok; y++) {
+        const unsigned char *row = map->cells + (size_t)y * map->width;
+        for (int x = 0; x < map->width; x++) putc(glyph[row[x]], file);
+        ok = putc('\n', file) != EOF;
+    }
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "错误: 写入地图文件 %s 失败\n", path);
+    return ok ? 0 : -1;
+}
+
+/* 保存为二进制格式 */
+int map_save_binary(const GameMap *map, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建地图文件 %s\n", path);
+        return -1;
+    }
+    size_t count = (size_t)map->width * map->height;
+    MapFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAP_MAGIC, 4);
+    header.version = MAP_VERSION;
+    header.byte_order = MAP_BYTE_ORDER;
+    header.width = (uint32_t)map->width;
+    header.height = (uint32_t)map->height;
+    header.player_x = (uint32_t)map->player_x;
+    header.player_y = (uint32_t)map->player_y;
+    header.ghost_count = (uint32_t)map->ghost_count;
+    header.dot_count = (uint32_t)map->dot_count;
+    header.checksum = map_checksum(map->cells, count);
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(map->cells, 1, count, file) == count;
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "错误: 写入地图文件 %s 失败\n", path);
+    return ok ? 0 : -1;
+}
+
+/* 把地图写入棋盘，返回豆子总数 */
+int map_fill_board(const GameMap *map, CellType **board) {
+    for (int y = 0; y < map->height; y++) {
+        const unsigned char *src = map->cells + (size_t)y * map->width;
+        CellType *dst = board[y];
+        for (int x = 0; x < map->width; x++) dst[x] = (CellType)src[x];
+    }
+    return map->dot_count;
+}
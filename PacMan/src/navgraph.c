@@ -0,0 +1,749 @@
+#include <string.h>
+#include "navgraph.h"
+#include "exits.h"
+#include "ghost.h"
+
+/* cell_ref的取值：墙、尚未归属、节点编号（>=0）或走廊所属的边 */
+#define NAV_WALL (-1)
+#define NAV_UNASSIGNED (-2)
+#define NAV_EDGE_REF(e) (-3 - (e))
+#define NAV_REF_EDGE(r) (-3 - (r))
+#define NAV_IS_EDGE(r) ((r) <= -3)
+
+/* 空闲链表：已释放的节点/边在node_cell/edges[].a中存放 -2 - 下一个空闲编号 */
+#define NAV_FREE_LINK(next) (-2 - (next))
+#define NAV_NONE (-1)
+
+#define NAV_INF 0x3FFFFFFF
+
+static const int nav_opposite[4] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+
+/* 边：起点a沿dir_a出发，经len步到达终点b，从b出发的方向为dir_b
+ * 搜索时一条边的字段一起读取，放在同一个结构中 */
+typedef struct {
+    int a, b, len;
+    int targets;                 /* 走廊格中豆子/能量豆/水果的数量 */
+    int ghosts;                  /* 走廊格中幽灵的数量 */
+    unsigned char dir_a, dir_b;
+} NavEdge;
+
+/* 节点的搜索记录：距离、轮次标记和桶链表指针放在一起 */
+typedef struct {
+    int dist;
+    unsigned int stamp;
+    int next, prev;              /* 所在桶的双向链表 */
+    int slot;                    /* 所在桶的下标，不在队列中为-1 */
+    int first_dir;               /* 从起点出发的第一步方向 */
+} NavSearch;
+
+struct NavGraph {
+    int width, height;
+    int offset[4];               /* 相邻格下标偏移，下标为Direction */
+
+    /* 每格信息 */
+    int *cell_ref;
+    int *cell_pos;               /* 走廊格到边起点a的步数 */
+    unsigned char *cell_dir_a;   /* 走廊格朝向边起点a的方向 */
+    int *work;                   /* 增量重建时释放出的格子 */
+
+    int open_cells;              /* 可走格数 */
+
+    /* 节点 */
+    int node_count, node_high, node_free;
+    int *node_cell;
+
+    /* 边（已释放的边在a中存放空闲链表） */
+    int edge_count, edge_high, edge_free;
+    int max_len;                 /* 最长边长，决定桶的个数 */
+    NavEdge *edges;
+
+    /* 搜索：边长是小整数，用按距离分桶的循环桶队列代替二叉堆 */
+    NavSearch *search;
+    unsigned int round;
+    int *bucket;                 /* 桶头节点，距离cursor + k的节点在(cursor_slot + k) % bucket_count */
+    int bucket_count;
+    int cursor, cursor_slot;     /* 当前出队的距离及其桶 */
+    int queued;
+
+    /* 追踪距离场：玩家所在的边和位置（玩家在节点上时chase_edge为-1） */
+    unsigned int chase_round;
+    int chase_edge, chase_pos;
+};
+
+/* 判断单元格是否是玩家要收集的目标 */
+static int nav_is_target(CellType cell) {
+    return cell == CELL_DOT || cell == CELL_POWER_DOT || cell == CELL_FRUIT;
+}
+
+/* 路口图所需的内存区字节数：节点和边的数量都不会超过格子数 */
+size_t navgraph_bytes(int width, int height) {
+    size_t cells = (size_t)width * height;
+    return arena_align(sizeof(NavGraph)) +
+           3 * arena_align(cells * sizeof(int)) + arena_align(cells) +  /* 每格 */
+           arena_align(cells * sizeof(int)) +                           /* 节点 */
+           arena_align(cells * sizeof(NavEdge)) +                       /* 边 */
+           arena_align(cells * sizeof(NavSearch)) +                     /* 搜索 */
+           arena_align(cells * sizeof(int));
+}
+
+/* 从内存区切分路口图 */
+NavGraph *navgraph_carve(Arena *arena, int width, int height) {
+    size_t cells = (size_t)width * height;
+    NavGraph *g = (NavGraph*)arena_alloc(arena, sizeof(NavGraph));
+    if (!g) return NULL;
+
+    memset(g, 0, sizeof(*g));
+    g->width = width;
+    g->height = height;
+    g->offset[DIR_UP] = -width;
+    g->offset[DIR_DOWN] = width;
+    g->offset[DIR_LEFT] = -1;
+    g->offset[DIR_RIGHT] = 1;
+
+    g->cell_ref = (int*)arena_alloc(arena, cells * sizeof(int));
+    g->cell_pos = (int*)arena_alloc(arena, cells * sizeof(int));
+    g->work = (int*)arena_alloc(arena, cells * sizeof(int));
+    g->cell_dir_a = (unsigned char*)arena_alloc(arena, cells);
+    g->node_cell = (int*)arena_alloc(arena, cells * sizeof(int));
+    g->edges = (NavEdge*)arena_alloc(arena, cells * sizeof(NavEdge));
+    g->search = (NavSearch*)arena_alloc(arena, cells * sizeof(NavSearch));
+    g->bucket = (int*)arena_alloc(arena, cells * sizeof(int));
+    if (!g->cell_ref || !g->cell_pos || !g->work || !g->cell_dir_a || !g->node_cell ||
+        !g->edges || !g->search || !g->bucket) {
+        return NULL;
+    }
+    memset(g->search, 0, cells * sizeof(NavSearch));
+    memset(g->bucket, 0xFF, cells * sizeof(int));
+    g->chase_edge = -1;
+    return g;
+}
+
+/* 节点数 */
+int navgraph_node_count(const NavGraph *graph) {
+    return graph->node_count;
+}
+
+/* 边数（不含相邻节点之间的隐式边） */
+int navgraph_edge_count(const NavGraph *graph) {
+    return graph->edge_count;
+}
+
+/* 图是否足够紧凑，值得代替逐格搜索 */
+int navgraph_is_compact(const NavGraph *graph) {
+    return graph && graph->open_cells >= NAVGRAPH_MIN_COMPRESSION * graph->node_count;
+}
+
+/* 格子的出口数（只看墙壁） */
+static int nav_degree(const unsigned char *exits, int cell) {
+    return exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])].count;
+}
+
+/* 分配节点编号 */
+static int nav_new_node(NavGraph *g, int cell) {
+    int n;
+    if (g->node_free != NAV_NONE) {
+        n = g->node_free;
+        g->node_free = NAV_FREE_LINK(g->node_cell[n]);
+    } else {
+        n = g->node_high++;
+    }
+    g->node_cell[n] = cell;
+    g->cell_ref[cell] = n;
+    g->node_count++;
+    return n;
+}
+
+/* 释放节点编号，调用前该节点的边必须已全部删除 */
+static void nav_free_node(NavGraph *g, int n) {
+    g->cell_ref[g->node_cell[n]] = NAV_UNASSIGNED;
+    g->node_cell[n] = NAV_FREE_LINK(g->node_free);
+    g->node_free = n;
+    g->node_count--;
+}
+
+/* 分配边编号 */
+static int nav_new_edge(NavGraph *g) {
+    int e;
+    if (g->edge_free != NAV_NONE) {
+        e = g->edge_free;
+        g->edge_free = NAV_FREE_LINK(g->edges[e].a);
+    } else {
+        e = g->edge_high++;
+    }
+    g->edge_count++;
+    return e;
+}
+
+/* 从节点n沿方向dir追踪一条走廊，把经过的未归属格子记入新边 */
+static void nav_trace(NavGraph *g, const CellType *cells, const unsigned char *exits,
+                      int n, int dir) {
+    int e = nav_new_edge(g);
+    int ref = NAV_EDGE_REF(e);
+    int came = dir;
+    int cur = g->node_cell[n] + g->offset[dir];
+    int len = 1, targets = 0, ghosts = 0;
+
+    while (g->cell_ref[cur] == NAV_UNASSIGNED) {
+        int back = nav_opposite[came];
+        g->cell_ref[cur] = ref;
+        g->cell_pos[cur] = len;
+        g->cell_dir_a[cur] = (unsigned char)back;
+        targets += nav_is_target(cells[cur]);
+        ghosts += is_ghost_cell(cells[cur]);
+
+        /* 走廊格恰有两个出口，去掉来路剩下的就是去路 */
+        came = exit_dir_lists[EXIT_PLAYER_MASK(exits[cur]) & ~EXIT_BIT(back)].dirs[0];
+        cur += g->offset[came];
+        len++;
+    }
+
+    NavEdge *edge = &g->edges[e];
+    edge->a = n;
+    edge->b = g->cell_ref[cur];
+    edge->dir_a = (unsigned char)dir;
+    edge->dir_b = (unsigned char)nav_opposite[came];
+    edge->len = len;
+    edge->targets = targets;
+    edge->ghosts = ghosts;
+    if (len > g->max_len) g->max_len = len;
+}
+
+/* 为节点n所有通向未归属格子的出口追踪走廊 */
+static void nav_trace_node(NavGraph *g, const CellType *cells, const unsigned char *exits, int n) {
+    int cell = g->node_cell[n];
+    const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+    for (int k = 0; k < list->count; k++) {
+        int dir = list->dirs[k];
+        if (g->cell_ref[cell + g->offset[dir]] == NAV_UNASSIGNED) {
+            nav_trace(g, cells, exits, n, dir);
+        }
+    }
+}
+
+/* 根据棋盘和出口掩码整体建立路口图 */
+void navgraph_build(NavGraph *graph, CellType **board, const unsigned char *exits) {
+    NavGraph *g = graph;
+    const CellType *cells = board[0];
+    int total = g->width * g->height;
+
+    g->node_count = g->node_high = 0;
+    g->edge_count = g->edge_high = 0;
+    g->node_free = g->edge_free = NAV_NONE;
+    g->max_len = 1;
+    g->open_cells = 0;
+    g->chase_round = 0;
+
+    /* 路口和死路（出口数不为2）成为节点，其余可走格等待归入走廊 */
+    for (int i = 0; i < total; i++) {
+        if (cells[i] == CELL_WALL) {
+            g->cell_ref[i] = NAV_WALL;
+            continue;
+        }
+        g->open_cells++;
+        if (nav_degree(exits, i) != 2) {
+            nav_new_node(g, i);
+        } else {
+            g->cell_ref[i] = NAV_UNASSIGNED;
+        }
+    }
+
+    int nodes = g->node_high;
+    for (int n = 0; n < nodes; n++) {
+        nav_trace_node(g, cells, exits, n);
+    }
+
+    /* 没有路口的环形走廊：任取一格作为节点 */
+    for (int i = 0; i < total; i++) {
+        if (g->cell_ref[i] == NAV_UNASSIGNED) {
+            nav_trace_node(g, cells, exits, nav_new_node(g, i));
+        }
+    }
+}
+
+/* 映像：计数之后是每格的归属、位置和方向，再是已用的节点和边 */
+typedef struct {
+    int open_cells;
+    int node_count, node_high, node_free;
+    int edge_count, edge_high, edge_free;
+    int max_len;
+} NavImageHeader;
+
+static size_t nav_image_bytes(int cells, int node_high, int edge_high) {
+    return sizeof(NavImageHeader) + (size_t)cells * (2 * sizeof(int) + 1) +
+           (size_t)node_high * sizeof(int) + (size_t)edge_high * sizeof(NavEdge);
+}
+
+size_t navgraph_image_bytes(const NavGraph *graph) {
+    return nav_image_bytes(graph->width * graph->height, graph->node_high, graph->edge_high);
+}
+
+void navgraph_save_image(const NavGraph *graph, unsigned char *image) {
+    const NavGraph *g = graph;
+    size_t cells = (size_t)g->width * g->height;
+    NavImageHeader header = {g->open_cells, g->node_count, g->node_high, g->node_free,
+                             g->edge_count, g->edge_high, g->edge_free, g->max_len};
+    memcpy(image, &header, sizeof(header));
+    image += sizeof(header);
+    memcpy(image, g->cell_ref, cells * sizeof(int));
+    image += cells * sizeof(int);
+    memcpy(image, g->cell_pos, cells * sizeof(int));
+    image += cells * sizeof(int);
+    memcpy(image, g->cell_dir_a, cells);
+    image += cells;
+    memcpy(image, g->node_cell, (size_t)g->node_high * sizeof(int));
+    image += (size_t)g->node_high * sizeof(int);
+    memcpy(image, g->edges, (size_t)g->edge_high * sizeof(NavEdge));
+}
+
+/* 载入映像代替重建，追踪距离场需要重新计算 */
+int navgraph_load_image(NavGraph *graph, const unsigned char *image, size_t size) {
+    NavGraph *g = graph;
+    int cells = g->width * g->height;
+    NavImageHeader header;
+    if (size < sizeof(header)) return -1;
+    memcpy(&header, image, sizeof(header));
+    if (header.node_high < 0 || header.node_high > cells || header.edge_high < 0 ||
+        header.edge_high > cells ||
+        size != nav_image_bytes(cells, header.node_high, header.edge_high)) {
+        return -1;
+    }
+    image += sizeof(header);
+    memcpy(g->cell_ref, image, (size_t)cells * sizeof(int));
+    image += (size_t)cells * sizeof(int);
+    memcpy(g->cell_pos, image, (size_t)cells * sizeof(int));
+    image += (size_t)cells * sizeof(int);
+    memcpy(g->cell_dir_a, image, (size_t)cells);
+    image += cells;
+    memcpy(g->node_cell, image, (size_t)header.node_high * sizeof(int));
+    image += (size_t)header.node_high * sizeof(int);
+    memcpy(g->edges, image, (size_t)header.edge_high * sizeof(NavEdge));
+
+    g->open_cells = header.open_cells;
+    g->node_count = header.node_count;
+    g->node_high = header.node_high;
+    g->node_free = header.node_free;
+    g->edge_count = header.edge_count;
+    g->edge_high = header.edge_high;
+    g->edge_free = header.edge_free;
+    g->max_len = header.max_len;
+    g->chase_round = 0;
+    return 0;
+}
+
+/* 边记录中的目标数和幽灵数随棋盘内容变化，其余字段只取决于墙壁；
+ * 墙壁不变时整段复制边记录即可保存和恢复这些计数 */
+size_t navgraph_counts_bytes(const NavGraph *graph) {
+    return (size_t)graph->edge_high * sizeof(NavEdge);
+}
+
+void navgraph_save_counts(const NavGraph *graph, void *counts) {
+    memcpy(counts, graph->edges, (size_t)graph->edge_high * sizeof(NavEdge));
+}
+
+void navgraph_load_counts(NavGraph *graph, const void *counts) {
+    memcpy(graph->edges, counts, (size_t)graph->edge_high * sizeof(NavEdge));
+}
+
+/* 相邻格下标，越界返回-1 */
+static int nav_neighbor(const NavGraph *g, int cell, int dir) {
+    int x = cell % g->width, y = cell / g->width;
+    switch (dir) {
+        case DIR_UP: return y > 0 ? cell - g->width : -1;
+        case DIR_DOWN: return y < g->height - 1 ? cell + g->width : -1;
+        case DIR_LEFT: return x > 0 ? cell - 1 : -1;
+        default: return x < g->width - 1 ? cell + 1 : -1;
+    }
+}
+
+/* 删除一条边，其走廊格变为未归属并加入工作列表 */
+static void nav_remove_edge(NavGraph *g, int e, int *freed) {
+    int ref = NAV_EDGE_REF(e);
+    int cur = g->node_cell[g->edges[e].a] + g->offset[g->edges[e].dir_a];
+
+    /* 墙壁可能已经变化，按位置序号而不是出口掩码沿走廊前进 */
+    for (int pos = 1; cur >= 0 && g->cell_ref[cur] == ref && g->cell_pos[cur] == pos; pos++) {
+        int next = -1;
+        g->cell_ref[cur] = NAV_UNASSIGNED;
+        g->work[(*freed)++] = cur;
+        for (int d = 0; d < 4; d++) {
+            int cand = nav_neighbor(g, cur, d);
+            if (cand >= 0 && g->cell_ref[cand] == ref && g->cell_pos[cand] == pos + 1) {
+                next = cand;
+                break;
+            }
+        }
+        cur = next;
+    }
+
+    g->edges[e].a = NAV_FREE_LINK(g->edge_free);
+    g->edge_free = e;
+    g->edge_count--;
+}
+
+/* 删除节点及其所有边；与节点相邻的走廊格一定是以该节点为端点的边的首尾格 */
+static void nav_remove_node(NavGraph *g, int n, int *freed) {
+    int cell = g->node_cell[n];
+
+    for (int d = 0; d < 4; d++) {
+        int next = nav_neighbor(g, cell, d);
+        if (next >= 0 && NAV_IS_EDGE(g->cell_ref[next])) {
+            nav_remove_edge(g, NAV_REF_EDGE(g->cell_ref[next]), freed);
+        }
+    }
+    nav_free_node(g, n);
+    g->work[(*freed)++] = cell;
+}
+
+/* 墙壁变化后只重建(x, y)及相邻格涉及的节点和边 */
+static void nav_rebuild_around(NavGraph *g, CellType **board, const unsigned char *exits,
+                               int x, int y) {
+    const CellType *cells = board[0];
+    int center = y * g->width + x;
+    int affected[5], count = 0, freed = 0;
+
+    affected[count++] = center;
+    for (int d = 0; d < 4; d++) {
+        int next = nav_neighbor(g, center, d);
+        if (next >= 0) affected[count++] = next;
+    }
+
+    /* 拆除受影响格所在的节点和边 */
+    for (int k = 0; k < count; k++) {
+        int r = g->cell_ref[affected[k]];
+        if (r >= 0) {
+            nav_remove_node(g, r, &freed);
+        } else if (NAV_IS_EDGE(r)) {
+            nav_remove_edge(g, NAV_REF_EDGE(r), &freed);
+        }
+    }
+
+    /* 受影响格按新的墙壁重新归类 */
+    for (int k = 0; k < count; k++) {
+        int cell = affected[k];
+        if (cells[cell] == CELL_WALL) {
+            g->cell_ref[cell] = NAV_WALL;
+        } else if (g->cell_ref[cell] == NAV_WALL) {
+            g->cell_ref[cell] = NAV_UNASSIGNED;
+            g->work[freed++] = cell;
+        }
+    }
+
+    /* 释放出的格子中出口数不为2的重新成为节点 */
+    for (int k = 0; k < freed; k++) {
+        int cell = g->work[k];
+        if (g->cell_ref[cell] == NAV_UNASSIGNED && nav_degree(exits, cell) != 2) {
+            nav_new_node(g, cell);
+        }
+    }
+
+    /* 从释放区域内和与之相邻的节点出发补齐走廊 */
+    for (int k = 0; k < freed; k++) {
+        int cell = g->work[k];
+        if (g->cell_ref[cell] >= 0) nav_trace_node(g, cells, exits, g->cell_ref[cell]);
+
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+        for (int j = 0; j < list->count; j++) {
+            int r = g->cell_ref[cell + g->offset[list->dirs[j]]];
+            if (r >= 0) nav_trace_node(g, cells, exits, r);
+        }
+    }
+    for (int k = 0; k < freed; k++) {
+        int cell = g->work[k];
+        if (g->cell_ref[cell] == NAV_UNASSIGNED) {
+            nav_trace_node(g, cells, exits, nav_new_node(g, cell));
+        }
+    }
+    g->chase_round = 0;
+}
+
+/* 格子(x, y)的类型改变：墙壁变化时局部重建，否则只更新走廊上的目标和幽灵计数 */
+void navgraph_cell_changed(NavGraph *graph, CellType **board, const unsigned char *exits,
+                           int x, int y, CellType old_type, CellType new_type) {
+    if ((old_type == CELL_WALL) != (new_type == CELL_WALL)) {
+        graph->open_cells += (old_type == CELL_WALL) ? 1 : -1;
+        nav_rebuild_around(graph, board, exits, x, y);
+        return;
+    }
+
+    int r = graph->cell_ref[y * graph->width + x];
+    if (NAV_IS_EDGE(r)) {
+        int e = NAV_REF_EDGE(r);
+        graph->edges[e].targets += nav_is_target(new_type) - nav_is_target(old_type);
+        graph->edges[e].ghosts += is_ghost_cell(new_type) - is_ghost_cell(old_type);
+    }
+}
+
+/* 开始新一轮搜索：队列中的距离总在[cursor, cursor + max_len]内，
+ * 桶数取max_len + 1即可保证同一个桶里只有同一距离的节点 */
+static void nav_search_begin(NavGraph *g) {
+    if (++g->round == 0) {
+        for (int n = 0; n < g->node_high; n++) g->search[n].stamp = 0;
+        g->round = 1;
+    }
+    g->bucket_count = g->max_len + 1;
+    g->cursor = 0;
+    g->cursor_slot = 0;
+    g->queued = 0;
+}
+
+/* 把节点从所在的桶中摘下 */
+static void nav_unlink(NavGraph *g, int n) {
+    NavSearch *s = &g->search[n];
+    if (s->prev >= 0) {
+        g->search[s->prev].next = s->next;
+    } else {
+        g->bucket[s->slot] = s->next;
+    }
+    if (s->next >= 0) g->search[s->next].prev = s->prev;
+    s->slot = -1;
+    g->queued--;
+}
+
+/* 取出距离最小的节点，队列为空时返回-1 */
+static int nav_pop(NavGraph *g) {
+    if (g->queued == 0) return -1;
+    while (g->bucket[g->cursor_slot] < 0) {
+        g->cursor++;
+        if (++g->cursor_slot == g->bucket_count) g->cursor_slot = 0;
+    }
+    int n = g->bucket[g->cursor_slot];
+    nav_unlink(g, n);
+    return n;
+}
+
+/* 提前结束的搜索清空剩余的桶，下一轮从空队列开始 */
+static void nav_search_end(NavGraph *g) {
+    while (nav_pop(g) >= 0) {
+    }
+}
+
+/* 松弛节点n：距离更短时更新并放入对应的桶 */
+static void nav_relax(NavGraph *g, int n, int d, int first) {
+    NavSearch *s = &g->search[n];
+    if (s->stamp != g->round) {
+        s->stamp = g->round;
+    } else if (d >= s->dist) {
+        return;
+    } else if (s->slot >= 0) {
+        nav_unlink(g, n);
+    } else {
+        return; /* 已出队，距离已确定 */
+    }
+    int slot = g->cursor_slot + (d - g->cursor);
+    if (slot >= g->bucket_count) slot -= g->bucket_count;
+    s->dist = d;
+    s->first_dir = first;
+    s->slot = slot;
+    s->prev = -1;
+    s->next = g->bucket[slot];
+    if (s->next >= 0) g->search[s->next].prev = n;
+    g->bucket[slot] = n;
+    g->queued++;
+}
+
+/* 节点n沿方向dir离开时对应的边端：返回另一端节点和边长，
+ * 相邻格也是节点时为长度1的隐式边；side_a指出n是否是该边的起点a */
+static int nav_follow(const NavGraph *g, int n, int dir, int *edge_id, int *len, int *side_a) {
+    int next = g->node_cell[n] + g->offset[dir];
+    int r = g->cell_ref[next];
+
+    if (r >= 0) {
+        *edge_id = -1;
+        *len = 1;
+        *side_a = 1;
+        return r;
+    }
+    int e = NAV_REF_EDGE(r);
+    const NavEdge *edge = &g->edges[e];
+    *edge_id = e;
+    *len = edge->len;
+    *side_a = (edge->a == n && edge->dir_a == dir);
+    return *side_a ? edge->b : edge->a;
+}
+
+/* 沿走廊从cur（方向came进入）向前走steps格，找到第一个目标返回步数，
+ * 遇到幽灵返回-1，都没有返回0 */
+static int nav_scan(const NavGraph *g, const CellType *cells, const unsigned char *exits,
+                    int cur, int came, int steps) {
+    for (int i = 1; i <= steps; i++) {
+        if (is_ghost_cell(cells[cur])) return -1;
+        if (nav_is_target(cells[cur])) return i;
+        int back = EXIT_BIT(nav_opposite[came]);
+        came = exit_dir_lists[EXIT_PLAYER_MASK(exits[cur]) & ~back].dirs[0];
+        cur += g->offset[came];
+    }
+    return 0;
+}
+
+/* 玩家自动驾驶：以节点为单位的最短路搜索，走廊只在含有目标或幽灵时逐格扫描 */
+Direction navgraph_autopilot(NavGraph *graph, CellType **board, const unsigned char *exits,
+                             int x, int y) {
+    NavGraph *g = graph;
+    const CellType *cells = board[0];
+    int start = y * g->width + x;
+    int best = NAV_INF;
+    Direction best_dir = DIR_COUNT;
+
+    nav_search_begin(g);
+
+    int r = g->cell_ref[start];
+    if (r >= 0) {
+        nav_relax(g, r, 0, DIR_COUNT);
+    } else if (NAV_IS_EDGE(r)) {
+        /* 起点在走廊中：分别向两端扫描 */
+        const NavEdge *edge = &g->edges[NAV_REF_EDGE(r)];
+        int pos = g->cell_pos[start];
+        int dir_a = g->cell_dir_a[start];
+        int dir_b = exit_dir_lists[EXIT_PLAYER_MASK(exits[start]) & ~EXIT_BIT(dir_a)].dirs[0];
+
+        for (int side = 0; side < 2; side++) {
+            int dir = side ? dir_b : dir_a;
+            int n = side ? edge->b : edge->a;
+            int steps = side ? edge->len - pos : pos;
+            int hit = nav_scan(g, cells, exits, start + g->offset[dir], dir, steps - 1);
+            if (hit > 0) {
+                if (hit < best) {
+                    best = hit;
+                    best_dir = (Direction)dir;
+                }
+                continue;
+            }
+            CellType end = cells[g->node_cell[n]];
+            if (hit < 0 || is_ghost_cell(end)) continue;
+            if (nav_is_target(end) && steps < best) {
+                best = steps;
+                best_dir = (Direction)dir;
+            }
+            nav_relax(g, n, steps, dir);
+        }
+    } else {
+        return DIR_COUNT;
+    }
+
+    for (int u = nav_pop(g); u >= 0; u = nav_pop(g)) {
+        int du = g->search[u].dist;
+        if (du >= best) break;
+
+        int cell = g->node_cell[u];
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell])];
+        for (int k = 0; k < list->count; k++) {
+            int dir = list->dirs[k];
+            int first = (g->search[u].first_dir == DIR_COUNT) ? dir : g->search[u].first_dir;
+            int e, len, side_a;
+            int v = nav_follow(g, u, dir, &e, &len, &side_a);
+
+            if (e >= 0 && (g->edges[e].targets > 0 || g->edges[e].ghosts > 0)) {
+                int hit = nav_scan(g, cells, exits, cell + g->offset[dir], dir, len - 1);
+                if (hit > 0 && du + hit < best) {
+                    best = du + hit;
+                    best_dir = (Direction)first;
+                }
+                if (hit != 0) continue;
+            }
+
+            CellType end = cells[g->node_cell[v]];
+            if (is_ghost_cell(end)) continue;
+            if (nav_is_target(end) && du + len < best) {
+                best = du + len;
+                best_dir = (Direction)first;
+            }
+            nav_relax(g, v, du + len, first);
+        }
+    }
+
+    nav_search_end(g);
+    return best_dir;
+}
+
+/* 从玩家位置出发计算半径内各节点的步数（只看墙壁，不考虑幽灵） */
+void navgraph_chase_field(NavGraph *graph, const unsigned char *exits, int player_x, int player_y,
+                          int radius) {
+    NavGraph *g = graph;
+    int start = player_y * g->width + player_x;
+    int r = g->cell_ref[start];
+
+    nav_search_begin(g);
+    g->chase_round = g->round;
+    g->chase_edge = -1;
+
+    if (r >= 0) {
+        nav_relax(g, r, 0, DIR_COUNT);
+    } else if (NAV_IS_EDGE(r)) {
+        const NavEdge *edge = &g->edges[NAV_REF_EDGE(r)];
+        g->chase_edge = NAV_REF_EDGE(r);
+        g->chase_pos = g->cell_pos[start];
+        nav_relax(g, edge->a, g->chase_pos, DIR_COUNT);
+        nav_relax(g, edge->b, edge->len - g->chase_pos, DIR_COUNT);
+    } else {
+        return;
+    }
+
+    for (int u = nav_pop(g); u >= 0; u = nav_pop(g)) {
+        int du = g->search[u].dist;
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[g->node_cell[u]])];
+
+        for (int k = 0; k < list->count; k++) {
+            int e, len, side_a;
+            int v = nav_follow(g, u, list->dirs[k], &e, &len, &side_a);
+            if (du + len <= radius) nav_relax(g, v, du + len, DIR_COUNT);
+        }
+    }
+}
+
+/* 距离场中节点n到玩家的步数，不在半径内为NAV_INF */
+static int nav_chase_dist(const NavGraph *g, int n) {
+    return g->search[n].stamp == g->chase_round ? g->search[n].dist : NAV_INF;
+}
+
+/* 幽灵在(x, y)时朝玩家的最短路第一步，只在allowed掩码的方向中选择；
+ * 距离场未覆盖该幽灵时返回DIR_COUNT。只读，可在决策阶段并行调用 */
+Direction navgraph_chase_direction(const NavGraph *graph, const unsigned char *exits,
+                                   int x, int y, unsigned int allowed) {
+    const NavGraph *g = graph;
+    int cell = y * g->width + x;
+    int r = g->cell_ref[cell];
+    int cost[4] = {NAV_INF, NAV_INF, NAV_INF, NAV_INF};
+
+    if (g->chase_round == 0 || g->chase_round != g->round) return DIR_COUNT;
+
+    if (r >= 0) {
+        const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(exits[cell]) & allowed];
+        for (int k = 0; k < list->count; k++) {
+            int dir = list->dirs[k];
+            int e, len, side_a;
+            int v = nav_follow(g, r, dir, &e, &len, &side_a);
+            int c = len + nav_chase_dist(g, v);
+            if (e >= 0 && e == g->chase_edge) {
+                int along = side_a ? g->chase_pos : len - g->chase_pos;
+                if (along < c) c = along;
+            }
+            cost[dir] = c;
+        }
+    } else if (NAV_IS_EDGE(r)) {
+        int e = NAV_REF_EDGE(r);
+        const NavEdge *edge = &g->edges[e];
+        int pos = g->cell_pos[cell];
+        int len = edge->len;
+        int dir_a = g->cell_dir_a[cell];
+        int dir_b = exit_dir_lists[EXIT_PLAYER_MASK(exits[cell]) & ~EXIT_BIT(dir_a)].dirs[0];
+
+        if (allowed & EXIT_BIT(dir_a)) {
+            cost[dir_a] = pos + nav_chase_dist(g, edge->a);
+            if (e == g->chase_edge && g->chase_pos < pos) cost[dir_a] = pos - g->chase_pos;
+        }
+        if (allowed & EXIT_BIT(dir_b)) {
+            cost[dir_b] = len - pos + nav_chase_dist(g, edge->b);
+            if (e == g->chase_edge && g->chase_pos > pos) cost[dir_b] = g->chase_pos - pos;
+        }
+    }
+
+    Direction best_dir = DIR_COUNT;
+    int best = NAV_INF;
+    for (int d = 0; d < 4; d++) {
+        if (cost[d] < best) {
+            best = cost[d];
+            best_dir = (Direction)d;
+        }
+    }
+    return best_dir;
+}
@@ -0,0 +1,159 @@
+#include <string.h>
+#include "nexthop.h"
+#include "exits.h"
+#include "parallel.h"
+
+/* 建表时每块处理的终点数 */
+#define NEXTHOP_BUILD_CHUNK 16
+
+static const int nexthop_opposite[4] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+
+struct NextHopTable {
+    int width, height, cells;
+    int row_bytes;               /* 每个终点一行，按字节对齐，并行建表时各行互不重叠 */
+    int valid;
+    int offset[4];               /* 相邻格下标偏移，下标为Direction */
+    int *component;              /* 连通分量编号，墙为-1 */
+    unsigned char *hops;         /* hops[to * row_bytes + from / 4] 的第 (from % 4) * 2 位 */
+    const unsigned char *exits;  /* 建表期间使用的出口掩码 */
+};
+
+/* 下一步表所需的内存区字节数，超过阈值时为0 */
+size_t nexthop_bytes(int width, int height) {
+    size_t cells = (size_t)width * height;
+    if (cells > NEXTHOP_MAX_CELLS) return 0;
+    return arena_align(sizeof(NextHopTable)) +
+           arena_align(cells * sizeof(int)) +
+           arena_align(cells * ((cells + 3) / 4));
+}
+
+/* 从内存区切分下一步表，超过阈值或分配失败时返回NULL */
+NextHopTable *nexthop_carve(Arena *arena, int width, int height) {
+    int cells = width * height;
+    if (cells > NEXTHOP_MAX_CELLS) return NULL;
+
+    NextHopTable *t = (NextHopTable*)arena_alloc(arena, sizeof(NextHopTable));
+    if (!t) return NULL;
+    memset(t, 0, sizeof(*t));
+    t->width = width;
+    t->height = height;
+    t->cells = cells;
+    t->row_bytes = (cells + 3) / 4;
+    t->offset[DIR_UP] = -width;
+    t->offset[DIR_DOWN] = width;
+    t->offset[DIR_LEFT] = -1;
+    t->offset[DIR_RIGHT] = 1;
+    t->component = (int*)arena_alloc(arena, (size_t)cells * sizeof(int));
+    t->hops = (unsigned char*)arena_alloc(arena, (size_t)cells * t->row_bytes);
+    if (!t->component || !t->hops) return NULL;
+    return t;
+}
+
+/* 标记连通分量：同一分量内的格子互相可达。墙格自身的出口掩码同样记录了
+ * 通向相邻空格的方向，所以要先按棋盘排除墙格 */
+static void nexthop_label_components(NextHopTable *t, CellType **board) {
+    int queue[NEXTHOP_MAX_CELLS];
+    int label = 0;
+
+    for (int i = 0; i < t->cells; i++) t->component[i] = -1;
+    for (int i = 0; i < t->cells; i++) {
+        if (t->component[i] >= 0 || board[i / t->width][i % t->width] == CELL_WALL) continue;
+
+        int head = 0, tail = 0;
+        t->component[i] = label;
+        queue[tail++] = i;
+        while (head < tail) {
+            int cell = queue[head++];
+            const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(t->exits[cell])];
+            for (int k = 0; k < list->count; k++) {
+                int next = cell + t->offset[list->dirs[k]];
+                if (t->component[next] < 0) {
+                    t->component[next] = label;
+                    queue[tail++] = next;
+                }
+            }
+        }
+        label++;
+    }
+}
+
+/* 为[begin, end)中的每个终点做一次广度优先搜索，填写该行：
+ * 从u经方向d第一次到达v时，v走向终点的第一步就是d的反方向 */
+static void nexthop_build_range(int begin, int end, void *context) {
+    NextHopTable *t = (NextHopTable*)context;
+    int queue[NEXTHOP_MAX_CELLS];
+    unsigned char seen[NEXTHOP_MAX_CELLS];
+
+    for (int to = begin; to < end; to++) {
+        unsigned char *row = t->hops + (size_t)to * t->row_bytes;
+        memset(row, 0, (size_t)t->row_bytes);
+        if (t->component[to] < 0) continue;
+
+        memset(seen, 0, (size_t)t->cells);
+        int head = 0, tail = 0;
+        seen[to] = 1;
+        queue[tail++] = to;
+        while (head < tail) {
+            int cell = queue[head++];
+            const ExitDirList *list = &exit_dir_lists[EXIT_PLAYER_MASK(t->exits[cell])];
+            for (int k = 0; k < list->count; k++) {
+                int dir = list->dirs[k];
+                int next = cell + t->offset[dir];
+                if (seen[next]) continue;
+                seen[next] = 1;
+                row[next >> 2] |= (unsigned char)(nexthop_opposite[dir] << ((next & 3) * 2));
+                queue[tail++] = next;
+            }
+        }
+    }
+}
+
+/* 根据出口掩码重建整张表，各终点的搜索分配到线程池并行执行 */
+void nexthop_build(NextHopTable *table, CellType **board, const unsigned char *exits) {
+    table->exits = exits;
+    nexthop_label_components(table, board);
+    parallel_for(table->cells, NEXTHOP_BUILD_CHUNK, nexthop_build_range, table);
+    table->exits = NULL;
+    table->valid = 1;
+}
+
+/* 映像：连通分量数组之后紧跟下一步表 */
+size_t nexthop_image_bytes(const NextHopTable *table) {
+    return (size_t)table->cells * sizeof(int) + (size_t)table->cells * table->row_bytes;
+}
+
+void nexthop_save_image(const NextHopTable *table, unsigned char *image) {
+    memcpy(image, table->component, (size_t)table->cells * sizeof(int));
+    memcpy(image + (size_t)table->cells * sizeof(int), table->hops,
+           (size_t)table->cells * table->row_bytes);
+}
+
+/* 载入映像代替重建，表随即有效 */
+int nexthop_load_image(NextHopTable *table, const unsigned char *image, size_t size) {
+    if (size != nexthop_image_bytes(table)) return -1;
+    memcpy(table->component, image, (size_t)table->cells * sizeof(int));
+    memcpy(table->hops, image + (size_t)table->cells * sizeof(int),
+           (size_t)table->cells * table->row_bytes);
+    table->valid = 1;
+    return 0;
+}
+
+/* 墙壁变化后表失效，由调用者择机重建 */
+void nexthop_invalidate(NextHopTable *table) {
+    table->valid = 0;
+}
+
+/* 表是否与当前墙壁一致 */
+int nexthop_is_valid(const NextHopTable *table) {
+    return table && table->valid;
+}
+
+/* 查表得到from走向to的第一步 */
+Direction nexthop_direction(const NextHopTable *table, int from, int to) {
+    const NextHopTable *t = table;
+    if (!t || !t->valid || from == to) return DIR_COUNT;
+    if (t->component[from] < 0 || t->component[from] != t->component[to]) return DIR_COUNT;
+
+    unsigned int bits = t->hops[(size_t)to * t->row_bytes + (from >> 2)];
+    return (Direction)((bits >> ((from & 3) * 2)) & 3u);
+}
@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pack.h"
+#include "map.h"
+#include "tiles.h"
+#include "arena.h"
+
+struct PackWriter {
+    FILE *file;
+    const char *path;
+    int width, height;
+    int ghost_count;
+    int board_count;
+    int written;
+    PackEntry *entries;
+    int failed;
+};
+
+/* 与地图载入相同的格子统计：每格都是有效的格子类型，恰好一个玩家且在出生点(1, 1)，
+ * 豆子数与索引一致。四组直方图交替计数，减少相邻相同格子的写后读依赖 */
+static int pack_scan_board(const unsigned char *cells, int width, size_t count,
+                           const PackEntry *entry, const char *path, uint32_t index) {
+    size_t histogram[4][256];
+    memset(histogram, 0, sizeof(histogram));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        histogram[0][cells[i]]++;
+        histogram[1][cells[i + 1]]++;
+        histogram[2][cells[i + 2]]++;
+        histogram[3][cells[i + 3]]++;
+    }
+    for (; i < count; i++) histogram[0][cells[i]]++;
+
+    size_t total[256];
+    size_t invalid = 0;
+    for (int v = 0; v < 256; v++) {
+        total[v] = histogram[0][v] + histogram[1][v] + histogram[2][v] + histogram[3][v];
+        if (v >= TILE_TYPE_COUNT) invalid += total[v];
+    }
+    if (invalid > 0) {
+        for (i = 0; cells[i] < TILE_TYPE_COUNT; i++) {}
+        fprintf(stderr, "错误: 棋盘包 %s 的第 %u 个棋盘第 %d 行第 %d 列的格子类型无效: %d\n",
+                path, index, (int)(i / width) + 1, (int)(i % width) + 1, cells[i]);
+        return -1;
+    }
+    if (total[CELL_PLAYER] != 1 || cells[width + 1] != CELL_PLAYER) {
+        fprintf(stderr, "错误: 棋盘包 %s 的第 %u 个棋盘需要恰好一个位于(1, 1)的玩家出生点\n",
+                path, index);
+        return -1;
+    }
+    if (total[CELL_DOT] + total[CELL_POWER_DOT] != entry->dot_count) {
+        fprintf(stderr, "错误: 棋盘包 %s 的第 %u 个棋盘豆子数与索引不符\n", path, index);
+        return -1;
+    }
+    return 0;
+}
+
+/* 载入棋盘包：映射整个文件，校验文件头、索引范围，以及每个棋盘的校验和与格子内容 */
+int pack_open(const char *path, BoardPack *pack) {
+    memset(pack, 0, sizeof(*pack));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法打开棋盘包 %s\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackFileHeader)) {
+        fprintf(stderr, "错误: 棋盘包 %s 不完整\n", path);
+        close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射棋盘包 %s\n", path);
+        return -1;
+    }
+    pack->mapping = mapping;
+    pack->mapping_size = (size_t)st.st_size;
+
+    const PackFileHeader *header = (const PackFileHeader*)mapping;
+    if (memcmp(header->magic, PACK_MAGIC, 4) != 0 || header->version != PACK_VERSION ||
+        header->byte_order != MAP_BYTE_ORDER) {
+        fprintf(stderr, "错误: 棋盘包 %s 的格式、版本或字节序不受支持\n", path);
+        pack_close(pack);
+        return -1;
+    }
+    size_t cells = (size_t)header->width * header->height;
+    size_t data_offset = sizeof(PackFileHeader) + (size_t)header->board_count * sizeof(PackEntry);
+    if (header->width < 3 || header->height < 3 || header->board_count == 0 ||
+        header->width > MAX_HEADLESS_BOARD_WIDTH || header->height > MAX_HEADLESS_BOARD_HEIGHT ||
+        header->board_count > 0x7FFFFFFFu || header->ghost_count > MAX_GHOST_COUNT ||
+        pack->mapping_size < data_offset) {
+        fprintf(stderr, "错误: 棋盘包 %s 的大小与文件头不符\n", path);
+        pack_close(pack);
+        return -1;
+    }
+
+    const PackEntry *entries = (const PackEntry*)((const unsigned char*)mapping +
+                                                  sizeof(PackFileHeader));
+    for (uint32_t i = 0; i < header->board_count; i++) {
+        const PackEntry *entry = &entries[i];
+        if (entry->offset < data_offset || entry->offset > pack->mapping_size ||
+            pack->mapping_size - entry->offset < cells || entry->dot_count > cells) {
+            fprintf(stderr, "错误: 棋盘包 %s 的第 %u 条索引越界\n", path, i);
+            pack_close(pack);
+            return -1;
+        }
+        if (map_checksum((const unsigned char*)mapping + entry->offset, cells) != entry->checksum) {
+            fprintf(stderr, "错误: 棋盘包 %s 的第 %u 个棋盘校验和不符\n", path, i);
+            pack_close(pack);
+            return -1;
+        }
+        if (pack_scan_board((const unsigned char*)mapping + entry->offset, (int)header->width,
+                            cells, entry, path, i) != 0) {
+            pack_close(pack);
+            return -1;
+        }
+    }
+
+    pack->width = (int)header->width;
+    pack->height = (int)header->height;
+    pack->ghost_count = (int)header->ghost_count;
+    pack->board_count = (int)header->board_count;
+    pack->entries = entries;
+    return 0;
+}
+
+/* 解除映射 */
+void pack_close(BoardPack *pack) {
+    if (pack->mapping) munmap(pack->mapping, pack->mapping_size);
+    memset(pack, 0, sizeof(*pack));
+}
+
+const unsigned char *pack_board_cells(const BoardPack *pack, int index) {
+    return (const unsigned char*)pack->mapping + pack->entries[index].offset;
+}
+
+/* 把第index个棋盘写入棋盘，返回豆子总数 */
+int pack_fill_board(const BoardPack *pack, int index, CellType **board) {
+    const unsigned char *cells = pack_board_cells(pack, index);
+    for (int y = 0; y < pack->height; y++) {
+        const unsigned char *src = cells + (size_t)y * pack->width;
+        CellType *dst = board[y];
+        for (int x = 0; x < pack->width; x++) dst[x] = (CellType)src[x];
+    }
+    return (int)pack->entries[index].dot_count;
+}
+
+/* 打开棋盘包准备写入：文件头和索引的位置先空出来，棋盘从其后顺序写入 */
+PackWriter *pack_writer_open(const char *path, int width, int height, int ghost_count,
+                             int board_count) {
+    if (width <= 0 || height <= 0 || board_count <= 0) {
+        fprintf(stderr, "错误: 棋盘包参数无效: %d x %d, %d 个棋盘\n", width, height, board_count);
+        return NULL;
+    }
+    PackWriter *writer = (PackWriter*)heap_calloc(1, sizeof(PackWriter));
+    if (writer) writer->entries = (PackEntry*)heap_calloc((size_t)board_count, sizeof(PackEntry));
+    if (!writer || !writer->entries) {
+        fprintf(stderr, "错误: 无法为 %d 个棋盘的索引分配内存\n", board_count);
+        if (writer) heap_free(writer);
+        return NULL;
+    }
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "错误: 无法创建棋盘包 %s\n", path);
+        heap_free(writer->entries);
+        heap_free(writer);
+        return NULL;
+    }
+    writer->path = path;
+    writer->width = width;
+    writer->height = height;
+    writer->ghost_count = ghost_count;
+    writer->board_count = board_count;
+
+    long data_offset = (long)(sizeof(PackFileHeader) + (size_t)board_count * sizeof(PackEntry));
+    if (fseek(writer->file, data_offset, SEEK_SET) != 0) writer->failed = 1;
+    return writer;
+}
+
+/* 添加下一个棋盘：统计豆子、计算校验和并写入格子 */
+int pack_writer_add(PackWriter *writer, const unsigned char *cells, unsigned int seed) {
+    if (writer->written >= writer->board_count) {
+        fprintf(stderr, "错误: 棋盘包 %s 已写满 %d 个棋盘\n", writer->path, writer->board_count);
+        writer->failed = 1;
+        return -1;
+    }
+    size_t count = (size_t)writer->width * writer->height;
+    uint32_t dots = 0;
+    for (size_t i = 0; i < count; i++) {
+        dots += cells[i] == CELL_DOT || cells[i] == CELL_POWER_DOT;
+    }
+
+    PackEntry *entry = &writer->entries[writer->written++];
+    entry->offset = sizeof(PackFileHeader) + (uint64_t)writer->board_count * sizeof(PackEntry) +
+                    (uint64_t)(writer->written - 1) * count;
+    entry->checksum = map_checksum(cells, count);
+    entry->seed = seed;
+    entry->dot_count = dots;
+    if (fwrite(cells, 1, count, writer->file) != count) writer->failed = 1;
+    return writer->failed ? -1 : 0;
+}
+
+/* 写入文件头和索引后关闭，棋盘数不足或写入失败时返回-1 */
+int pack_writer_close(PackWriter *writer) {
+    if (!writer) return -1;
+    PackFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.byte_order = MAP_BYTE_ORDER;
+    header.width = (uint32_t)writer->width;
+    header.height = (uint32_t)writer->height;
+    header.ghost_count = (uint32_t)writer->ghost_count;
+    header.board_count = (uint32_t)writer->board_count;
+
+    int ok = !writer->failed && writer->written == writer->board_count &&
+             fseek(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+             fwrite(writer->entries, sizeof(PackEntry), (size_t)writer->board_count,
+                    writer->file) == (size_t)writer->board_count;
+    if (fclose(writer->file) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "错误: 写入棋盘包 %s 失败\n", writer->path);
+    heap_free(writer->entries);
+    heap_free(writer);
+    return ok ? 0 : -1;
+}
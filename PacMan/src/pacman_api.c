@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <string.h>
+#include "pacman.h"
+#include "types.h"
+#include "arena.h"
+#include "game.h"
+#include "algorithms.h"
+#include "level.h"
+#include "parallel.h"
+#include "clone.h"
+#include "env.h"
+#include "log.h"
+
+/* 导出的常量与内部定义一致（不一致时数组大小为负，编译失败） */
+typedef char pacman_check_actions[(PACMAN_ACTION_UP == DIR_UP && PACMAN_ACTION_DOWN == DIR_DOWN &&
+                                   PACMAN_ACTION_LEFT == DIR_LEFT &&
+                                   PACMAN_ACTION_RIGHT == DIR_RIGHT &&
+                                   PACMAN_ACTION_NONE == ENV_ACTION_NONE) ? 1 : -1];
+typedef char pacman_check_cells[(PACMAN_CELL_WALL == CELL_WALL &&
+                                 PACMAN_CELL_PLAYER == CELL_PLAYER &&
+                                 PACMAN_CELL_GHOST_ORANGE == CELL_GHOST_ORANGE &&
+                                 PACMAN_CELL_FRUIT == CELL_FRUIT) ? 1 : -1];
+typedef char pacman_check_planes[(PACMAN_PLANES == ENV_PLANES &&
+                                  PACMAN_PLANE_GHOST == ENV_PLANE_GHOST &&
+                                  PACMAN_PLANE_PLAYER == ENV_PLANE_PLAYER) ? 1 : -1];
+typedef char pacman_check_ghosts[(PACMAN_GHOSTS_CLASSIC == ALGO_CLASSIC) ? 1 : -1];
+typedef char pacman_check_log[(PACMAN_LOG_OFF == LOG_LEVEL_OFF) ? 1 : -1];
+
+/* 游戏句柄：引擎状态是全局的，句柄只记录创建参数 */
+struct PacmanGame {
+    PacmanConfig config;
+};
+
+/* 全局引擎是否已被一个游戏或一批环境占用 */
+static int engine_in_use = 0;
+
+unsigned int pacman_version(void) {
+    return (PACMAN_VERSION_MAJOR << 16) | PACMAN_VERSION_MINOR;
+}
+
+void pacman_set_log_level(int level) {
+    log_set_level(level);
+}
+
+void pacman_config_init(PacmanConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->width = DEFAULT_BOARD_WIDTH;
+    config->height = DEFAULT_BOARD_HEIGHT;
+    config->ghosts = DEFAULT_GHOST_COUNT;
+    config->algorithm = PACMAN_GHOSTS_RANDOM;
+    config->threads = 1;
+    config->seed = 1;
+    config->batch = 1;
+    config->max_steps = 0;
+}
+
+/* 检查创建参数：网格大小与无界面模式的范围相同，幽灵数和算法在内部定义的范围内。
+ * 库不向stderr输出，无效时只返回0 */
+static int pacman_config_valid(const PacmanConfig *config) {
+    return config->width >= MIN_BOARD_WIDTH && config->width <= MAX_HEADLESS_BOARD_WIDTH &&
+           config->height >= MIN_BOARD_HEIGHT && config->height <= MAX_HEADLESS_BOARD_HEIGHT &&
+           config->ghosts >= 0 && config->ghosts <= MAX_GHOST_COUNT &&
+           config->algorithm >= PACMAN_GHOSTS_NONE && config->algorithm <= PACMAN_GHOSTS_CLASSIC;
+}
+
+/* 引擎只有一份，已被占用时创建失败 */
+static int pacman_claim_engine(void) {
+    if (engine_in_use) {
+        LOG_ERROR("同一进程中只能有一个游戏或一批环境");
+        return -1;
+    }
+    engine_in_use = 1;
+    return 0;
+}
+
+/* 开始幽灵算法：玩家和幽灵按同样的节奏每步各走一次 */
+static void pacman_start_ghosts(int algorithm) {
+    set_ghost_move_interval(SIM_TICK_MS);
+    if (algorithm != ALGO_NONE) {
+        set_algorithm(algorithm);
+    } else {
+        stop_algorithm();
+    }
+}
+
+PacmanGame *pacman_game_create(const PacmanConfig *config) {
+    if (!pacman_config_valid(config) || pacman_claim_engine() != 0) return NULL;
+    PacmanGame *game = (PacmanGame*)heap_calloc(1, sizeof(PacmanGame));
+    if (!game) {
+        engine_in_use = 0;
+        return NULL;
+    }
+    game->config = *config;
+
+    parallel_init(config->threads);
+    set_game_seed(config->seed);
+    set_ghost_count(config->ghosts);
+    if (init_game_state_with_size(config->width, config->height) != 0) {
+        parallel_shutdown();
+        heap_free(game);
+        engine_in_use = 0;
+        return NULL;
+    }
+    pacman_start_ghosts(config->algorithm);
+    return game;
+}
+
+void pacman_game_destroy(PacmanGame *game) {
+    if (!game) return;
+    stop_algorithm();
+    cleanup_game_state();
+    parallel_shutdown();
+    heap_free(game);
+    engine_in_use = 0;
+}
+
+int pacman_game_step(PacmanGame *game, int action) {
+    (void)game;
+    if (is_game_over()) return 1;
+    if (is_algorithm_enabled()) update_ghost_movement();
+    if (!is_game_over()) {
+        Direction dir = action == PACMAN_ACTION_AUTOPILOT ? autopilot_next_direction() :
+                        (Direction)action;
+        if ((unsigned)dir < DIR_COUNT) step_player(dir);
+    }
+    commit_game_tick();
+    return is_game_over();
+}
+
+void pacman_game_reset(PacmanGame *game) {
+    reset_game_state();
+    pacman_start_ghosts(game->config.algorithm);
+}
+
+int pacman_game_next_level(PacmanGame *game) {
+    (void)game;
+    return advance_level();
+}
+
+int pacman_game_width(const PacmanGame *game) {
+    (void)game;
+    return get_board_width();
+}
+
+int pacman_game_height(const PacmanGame *game) {
+    (void)game;
+    return get_board_height();
+}
+
+void pacman_game_stats(const PacmanGame *game, PacmanStats *stats) {
+    const GameState *s = g_game_state;
+    (void)game;
+    stats->score = s->score;
+    stats->lives = s->lives;
+    stats->level = s->level;
+    stats->dots_collected = s->dots_collected;
+    stats->total_dots = s->total_dots;
+    stats->moves = s->moves_count;
+    stats->player_x = s->player_pos.x;
+    stats->player_y = s->player_pos.y;
+    stats->frightened_ticks = s->frightened_ticks;
+    stats->game_over = s->game_over;
+    stats->game_won = s->game_won;
+}
+
+int pacman_game_cells(const PacmanGame *game, unsigned char *cells, size_t size) {
+    size_t count = (size_t)get_board_width() * get_board_height();
+    const CellType *board = g_game_state->board[0];
+    (void)game;
+    if (size < count) return -1;
+    for (size_t i = 0; i < count; i++) cells[i] = (unsigned char)board[i];
+    return 0;
+}
+
+/* 快照就是状态克隆对象 */
+PacmanSnapshot *pacman_snapshot_create(PacmanGame *game) {
+    (void)game;
+    return (PacmanSnapshot*)game_clone_create();
+}
+
+void pacman_snapshot_destroy(PacmanSnapshot *snapshot) {
+    game_clone_destroy((GameClone*)snapshot);
+}
+
+int pacman_snapshot_save(PacmanGame *game, PacmanSnapshot *snapshot) {
+    (void)game;
+    return game_clone_into((GameClone*)snapshot);
+}
+
+int pacman_snapshot_restore(PacmanGame *game, const PacmanSnapshot *snapshot) {
+    (void)game;
+    return game_restore_from((const GameClone*)snapshot);
+}
+
+/* 环境句柄就是环境批次 */
+PacmanEnv *pacman_env_create(const PacmanConfig *config) {
+    EnvConfig env_config;
+    env_default_config(&env_config);
+    env_config.width = config->width;
+    env_config.height = config->height;
+    env_config.ghosts = config->ghosts;
+    env_config.batch = config->batch;
+    env_config.algorithm = config->algorithm;
+    env_config.threads = config->threads;
+    env_config.max_steps = config->max_steps;
+    if (!pacman_config_valid(config) || config->batch < 1 || config->max_steps < 0 ||
+        pacman_claim_engine() != 0) {
+        return NULL;
+    }
+
+    EnvBatch *env = env_create(&env_config);
+    if (!env || env_reset(env, config->seed, NULL) != 0) {
+        env_destroy(env);
+        engine_in_use = 0;
+        return NULL;
+    }
+    return (PacmanEnv*)env;
+}
+
+void pacman_env_destroy(PacmanEnv *env) {
+    if (!env) return;
+    env_destroy((EnvBatch*)env);
+    engine_in_use = 0;
+}
+
+size_t pacman_env_observation_bytes(const PacmanEnv *env) {
+    return env_observation_bytes((const EnvBatch*)env);
+}
+
+int pacman_env_reset(PacmanEnv *env, unsigned int seed, unsigned char *observations) {
+    return env_reset((EnvBatch*)env, seed, observations);
+}
+
+void pacman_env_step(PacmanEnv *env, const unsigned char *actions, unsigned char *observations,
+                     float *rewards, unsigned char *dones) {
+    env_step((EnvBatch*)env, actions, observations, rewards, dones);
+}
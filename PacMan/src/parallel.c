@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "parallel.h"
+#include "log.h"
+
+/* 线程池状态：每次parallel_for递增generation唤醒工作线程，
+ * 各线程通过原子计数器领取块，全部完成后唤醒调用线程 */
+static struct {
+    int threads;                /* 参与计算的线程总数（含调用线程） */
+    int worker_count;
+    int running;
+    unsigned long generation;
+    pthread_t workers[PARALLEL_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    /* 当前任务：fn为NULL时每个工作线程各执行一次each */
+    ParallelRangeFn fn;
+    ParallelWorkerFn each;
+    void *context;
+    int count;
+    int chunk;
+    int next;                   /* 下一个待领取块的起点 */
+    int active;                 /* 尚未完成当前任务的工作线程数 */
+} pool = {
+    .threads = 1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+/* 非0时本线程的parallel_for串行执行，不使用线程池：工作线程始终如此，
+ * 调用线程在处理自己领取的块期间如此（任务中嵌套的parallel_for） */
+static __thread int thread_serial = 0;
+
+/* 领取并执行块，直到没有剩余 */
+static void run_chunks(void) {
+    for (;;) {
+        int begin = __atomic_fetch_add(&pool.next, pool.chunk, __ATOMIC_RELAXED);
+        if (begin >= pool.count) break;
+        int end = begin + pool.chunk < pool.count ? begin + pool.chunk : pool.count;
+        pool.fn(begin, end, pool.context);
+    }
+}
+
+/* arg为创建线程时的generation：线程真正开始运行前调用线程可能已经发布了任务，
+ * 不能等到这里再读取，否则会把新任务当成已处理过的而一直等待 */
+static void *parallel_worker(void *arg) {
+    unsigned long seen = (unsigned long)(uintptr_t)arg;
+
+    thread_serial = 1;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.running && pool.generation == seen) {
+            pthread_cond_wait(&pool.start, &pool.lock);
+        }
+        if (!pool.running) break;
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        if (pool.fn) {
+            run_chunks();
+        } else {
+            pool.each(pool.context);
+        }
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) {
+            pthread_cond_signal(&pool.done);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/* 启动线程池，threads<=0时使用全部CPU核，返回实际线程数 */
+int parallel_init(int threads) {
+    parallel_shutdown();
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > PARALLEL_MAX_THREADS) threads = PARALLEL_MAX_THREADS;
+
+    pool.running = 1;
+    pool.worker_count = 0;
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&pool.workers[i], NULL, parallel_worker,
+                           (void*)(uintptr_t)pool.generation) != 0) {
+            LOG_WARN("并行线程池: 只启动了 %d 个工作线程", i);
+            break;
+        }
+        pool.worker_count++;
+    }
+    pool.threads = pool.worker_count + 1;
+    return pool.threads;
+}
+
+/* 停止线程池，之后parallel_for在调用线程中串行执行 */
+void parallel_shutdown(void) {
+    pthread_mutex_lock(&pool.lock);
+    if (!pool.running) {
+        pthread_mutex_unlock(&pool.lock);
+        return;
+    }
+    pool.running = 0;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.worker_count; i++) {
+        pthread_join(pool.workers[i], NULL);
+    }
+    pool.worker_count = 0;
+    pool.threads = 1;
+}
+
+/* 参与计算的线程总数 */
+int parallel_thread_count(void) {
+    return pool.threads;
+}
+
+/* 调用线程不是模拟线程（如关卡预生成线程）：之后它的parallel_for在本线程串行执行 */
+void parallel_serial_thread(void) {
+    thread_serial = 1;
+}
+
+/* 等待工作线程完成当前任务 */
+static void parallel_wait(void) {
+    pthread_mutex_lock(&pool.lock);
+    while (pool.active > 0) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* 并行执行fn，返回时所有块都已完成；任务不足两块时直接串行执行 */
+void parallel_for(int count, int chunk, ParallelRangeFn fn, void *context) {
+    if (count <= 0) return;
+    if (chunk < 1) chunk = 1;
+    if (pool.worker_count == 0 || count <= chunk || thread_serial) {
+        fn(0, count, context);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.context = context;
+    pool.count = count;
+    pool.chunk = chunk;
+    pool.next = 0;
+    pool.active = pool.worker_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+
+    thread_serial = 1;
+    run_chunks();
+    thread_serial = 0;
+
+    parallel_wait();
+}
+
+/* 在每个工作线程上各执行一次fn，调用线程不执行；返回时全部完成。
+ * 用于建立或释放工作线程各自的线程局部状态 */
+void parallel_each_worker(ParallelWorkerFn fn, void *context) {
+    if (pool.worker_count == 0 || thread_serial) return;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = NULL;
+    pool.each = fn;
+    pool.context = context;
+    pool.active = pool.worker_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+
+    parallel_wait();
+}
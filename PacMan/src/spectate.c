@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "spectate.h"
+#include "arena.h"
+#include "log.h"
+
+/* 帧前面为帧长度预留的字节数（变长编码的最大长度） */
+#define SPECTATE_LENGTH_BYTES 5
+#define SPECTATE_HEADER_BYTES (1 + SPECTATE_STATS * 5)
+/* 流头：标识和版本 */
+#define SPECTATE_STREAM_BYTES 5
+
+typedef struct {
+    int fd;                         /* -1表示空闲 */
+    int want_keyframe;              /* 等缓冲区放得下时发关键帧 */
+    unsigned char *buffer;          /* 待发送的数据为buffer[head, tail)，只含完整的帧 */
+    size_t head, tail;
+} SpectatorClient;
+
+struct Spectator {
+    int listen_fd;
+    struct sockaddr_un address;
+    int width, height;
+    size_t cells;
+    unsigned char *dirty;           /* 每格一个标记：本tick已记录 */
+    int *dirty_list;
+    int dirty_count, dirty_capacity;
+    int resync;                     /* 本tick所有客户端改发关键帧 */
+    unsigned int board_serial;
+    unsigned int tick;
+    unsigned char *key_frame, *delta_frame;
+    size_t key_capacity, delta_capacity, buffer_capacity;
+    int client_count;
+    unsigned long dropped;          /* 因缓冲区已满丢弃的帧数 */
+    SpectatorClient clients[SPECTATE_MAX_CLIENTS];
+};
+
+static size_t spectate_put_varint(unsigned char *out, unsigned int value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+size_t spectate_read_varint(const unsigned char *data, size_t size, unsigned int *value) {
+    unsigned int result = 0;
+    for (size_t i = 0; i < size && i < 5; i++) {
+        result |= (unsigned int)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+Spectator *spectator_create(const char *path, int width, int height) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "错误: 观战套接字路径过长: %s\n", path);
+        return NULL;
+    }
+    Spectator *s = (Spectator*)heap_calloc(1, sizeof(Spectator));
+    if (!s) return NULL;
+    s->listen_fd = -1;
+    s->width = width;
+    s->height = height;
+    s->cells = (size_t)width * height;
+    s->dirty_capacity = (int)(s->cells / 4) + 1;
+    s->key_capacity = SPECTATE_LENGTH_BYTES + SPECTATE_HEADER_BYTES + 10 + 2 * s->cells;
+    s->delta_capacity = SPECTATE_LENGTH_BYTES + SPECTATE_HEADER_BYTES + 5 +
+                        (size_t)s->dirty_capacity * 6;
+    /* 空缓冲区总能放下流头和一个关键帧 */
+    s->buffer_capacity = SPECTATE_STREAM_BYTES + s->key_capacity + s->delta_capacity;
+    s->dirty = (unsigned char*)heap_calloc(s->cells, 1);
+    s->dirty_list = (int*)heap_alloc((size_t)s->dirty_capacity * sizeof(int));
+    s->key_frame = (unsigned char*)heap_alloc(s->key_capacity);
+    s->delta_frame = (unsigned char*)heap_alloc(s->delta_capacity);
+    int ok = s->dirty && s->dirty_list && s->key_frame && s->delta_frame;
+    for (int c = 0; c < SPECTATE_MAX_CLIENTS; c++) {
+        s->clients[c].fd = -1;
+        if (ok) {
+            s->clients[c].buffer = (unsigned char*)heap_alloc(s->buffer_capacity);
+            ok = s->clients[c].buffer != NULL;
+        }
+    }
+    if (!ok) {
+        spectator_destroy(s);
+        return NULL;
+    }
+
+    /* 非阻塞监听，新连接在tick结束时接受 */
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    s->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s->listen_fd < 0 ||
+        fcntl(s->listen_fd, F_SETFL, fcntl(s->listen_fd, F_GETFL) | O_NONBLOCK) != 0 ||
+        bind(s->listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(s->listen_fd, SPECTATE_MAX_CLIENTS) != 0) {
+        fprintf(stderr, "错误: 无法在 %s 上监听: %s\n", path, strerror(errno));
+        spectator_destroy(s);
+        return NULL;
+    }
+    s->address = address;
+    return s;
+}
+
+static void spectator_close_client(Spectator *s, SpectatorClient *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->head = client->tail = 0;
+    s->client_count--;
+    LOG_INFO("观战客户端断开，剩余 %d 个", s->client_count);
+}
+
+void spectator_destroy(Spectator *spectator) {
+    Spectator *s = spectator;
+    if (!s) return;
+    if (s->dropped > 0) LOG_INFO("观战: 慢客户端共丢弃 %lu 帧并重新同步", s->dropped);
+    for (int c = 0; c < SPECTATE_MAX_CLIENTS; c++) {
+        if (s->clients[c].fd >= 0) close(s->clients[c].fd);
+        heap_free(s->clients[c].buffer);
+    }
+    if (s->listen_fd >= 0) {
+        close(s->listen_fd);
+        unlink(s->address.sun_path);
+    }
+    heap_free(s->dirty);
+    heap_free(s->dirty_list);
+    heap_free(s->key_frame);
+    heap_free(s->delta_frame);
+    heap_free(s);
+}
+
+void spectator_cell(Spectator *spectator, int index) {
+    Spectator *s = spectator;
+    if (s->client_count == 0 || s->dirty[index]) return;
+    if (s->dirty_count == s->dirty_capacity) {
+        s->resync = 1;
+        return;
+    }
+    s->dirty[index] = 1;
+    s->dirty_list[s->dirty_count++] = index;
+}
+
+void spectator_resync(Spectator *spectator) {
+    spectator->resync = 1;
+}
+
+/* 接受所有等待中的连接，没有空位时直接关闭 */
+static void spectator_accept(Spectator *s) {
+    for (;;) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        int slot = -1;
+        for (int c = 0; c < SPECTATE_MAX_CLIENTS && slot < 0; c++) {
+            if (s->clients[c].fd < 0) slot = c;
+        }
+        if (slot < 0 || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+            LOG_WARN("观战客户端已满（%d 个），拒绝新连接", SPECTATE_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+        SpectatorClient *client = &s->clients[slot];
+        client->fd = fd;
+        client->want_keyframe = 1;
+        memcpy(client->buffer, SPECTATE_MAGIC, 4);
+        client->buffer[4] = SPECTATE_VERSION;
+        client->head = 0;
+        client->tail = SPECTATE_STREAM_BYTES;
+        s->client_count++;
+        LOG_INFO("观战客户端接入，共 %d 个", s->client_count);
+    }
+}
+
+/* 尽量写出缓冲区中的数据，套接字写满时留到下一个tick */
+static void spectator_flush(Spectator *s, SpectatorClient *client) {
+    while (client->head < client->tail) {
+        ssize_t n = send(client->fd, client->buffer + client->head, client->tail - client->head,
+                         MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            client->head += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            spectator_close_client(s, client);
+            return;
+        }
+    }
+    client->head = client->tail = 0;
+}
+
+/* 把一帧追加到客户端缓冲区，放不下时返回-1 */
+static int spectator_append(Spectator *s, SpectatorClient *client, const unsigned char *frame,
+                            size_t size) {
+    if (client->tail - client->head + size > s->buffer_capacity) return -1;
+    if (client->tail + size > s->buffer_capacity) {
+        memmove(client->buffer, client->buffer + client->head, client->tail - client->head);
+        client->tail -= client->head;
+        client->head = 0;
+    }
+    memcpy(client->buffer + client->tail, frame, size);
+    client->tail += size;
+    return 0;
+}
+
+/* 帧头：类型和计数器，写在预留的长度字节之后 */
+static size_t spectator_encode_header(const Spectator *s, unsigned char *out, char type,
+                                      const GameState *state) {
+    const unsigned int stats[SPECTATE_STATS] = {
+        s->tick, (unsigned int)state->level, (unsigned int)state->score,
+        (unsigned int)state->lives, (unsigned int)state->dots_collected,
+        (unsigned int)state->total_dots, (unsigned int)state->player_pos.x,
+        (unsigned int)state->player_pos.y, (unsigned int)state->frightened_ticks,
+        (unsigned int)state->game_over
+    };
+    size_t n = 0;
+    out[n++] = (unsigned char)type;
+    for (int i = 0; i < SPECTATE_STATS; i++) n += spectate_put_varint(out + n, stats[i]);
+    return n;
+}
+
+/* 在帧内容前面补上长度，返回帧的起始位置 */
+static unsigned char *spectator_finish(unsigned char *buffer, size_t content, size_t *size) {
+    unsigned char length[SPECTATE_LENGTH_BYTES];
+    size_t n = spectate_put_varint(length, (unsigned int)content);
+    unsigned char *start = buffer + SPECTATE_LENGTH_BYTES - n;
+    memcpy(start, length, n);
+    *size = n + content;
+    return start;
+}
+
+static unsigned char *spectator_encode_key(Spectator *s, const GameState *state, size_t *size) {
+    unsigned char *out = s->key_frame + SPECTATE_LENGTH_BYTES;
+    size_t n = spectator_encode_header(s, out, 'K', state);
+    n += spectate_put_varint(out + n, (unsigned int)s->width);
+    n += spectate_put_varint(out + n, (unsigned int)s->height);
+    const CellType *cells = state->board[0];
+    for (size_t i = 0; i < s->cells;) {
+        size_t run = 1;
+        while (i + run < s->cells && cells[i + run] == cells[i]) run++;
+        n += spectate_put_varint(out + n, (unsigned int)run);
+        out[n++] = (unsigned char)cells[i];
+        i += run;
+    }
+    return spectator_finish(s->key_frame, n, size);
+}
+
+static unsigned char *spectator_encode_delta(Spectator *s, const GameState *state, size_t *size) {
+    unsigned char *out = s->delta_frame + SPECTATE_LENGTH_BYTES;
+    size_t n = spectator_encode_header(s, out, 'D', state);
+    const CellType *cells = state->board[0];
+    int previous = -1;
+    n += spectate_put_varint(out + n, (unsigned int)s->dirty_count);
+    for (int k = 0; k < s->dirty_count; k++) {
+        int index = s->dirty_list[k];
+        int gap = index - previous;
+        n += spectate_put_varint(out + n, ((unsigned int)gap << 1) ^ (unsigned int)(gap >> 31));
+        out[n++] = (unsigned char)cells[index];
+        previous = index;
+    }
+    return spectator_finish(s->delta_frame, n, size);
+}
+
+void spectator_publish(Spectator *spectator, const GameState *state, unsigned int board_serial) {
+    Spectator *s = spectator;
+    spectator_accept(s);
+    s->tick++;
+    if (board_serial != s->board_serial) {
+        s->board_serial = board_serial;
+        s->resync = 1;
+    }
+
+    if (s->client_count > 0) {
+        unsigned char *key = NULL, *delta = NULL;
+        size_t key_size = 0, delta_size = 0;
+        if (!s->resync) delta = spectator_encode_delta(s, state, &delta_size);
+        for (int c = 0; c < SPECTATE_MAX_CLIENTS; c++) {
+            SpectatorClient *client = &s->clients[c];
+            if (client->fd < 0) continue;
+            spectator_flush(s, client);
+            if (client->fd < 0) continue;
+            if (s->resync) client->want_keyframe = 1;
+            if (client->want_keyframe) {
+                if (!key) key = spectator_encode_key(s, state, &key_size);
+                if (spectator_append(s, client, key, key_size) == 0) client->want_keyframe = 0;
+            } else if (spectator_append(s, client, delta, delta_size) != 0) {
+                /* 慢客户端：丢弃本帧，等缓冲区腾出空间后重新同步 */
+                client->want_keyframe = 1;
+                s->dropped++;
+            }
+            spectator_flush(s, client);
+        }
+    }
+
+    for (int k = 0; k < s->dirty_count; k++) s->dirty[s->dirty_list[k]] = 0;
+    s->dirty_count = 0;
+    s->resync = 0;
+}
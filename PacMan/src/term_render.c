@@ -0,0 +1,179 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "term_render.h"
+#include "tiles.h"
+#include "arena.h"
+
+/* 终端尺寸未知时的默认值 */
+#define TERM_DEFAULT_COLS 80
+#define TERM_DEFAULT_ROWS 24
+#define TERM_STATUS_MAX 256
+#define TERM_UNKNOWN_CELL 0xFF   /* 上一帧内容未知，必须重绘 */
+#define TERM_BYTES_PER_CELL 32   /* 单个格子最坏情况下的输出字节数 */
+
+/* 渲染器状态 */
+static struct {
+    int fd;
+    int view_cols;          /* 视口宽度（格子数，每格占两列字符） */
+    int view_rows;          /* 视口高度（格子数，最后一行留给状态栏） */
+    unsigned char *prev;    /* 每个屏幕格子上一帧显示的单元格类型 */
+    char *out;              /* 单帧输出缓冲区 */
+    size_t out_cap;
+    size_t out_len;
+    char status[TERM_STATUS_MAX];
+    int initialized;
+} term;
+
+/* 向输出缓冲区追加数据 */
+static void out_append(const char *data, size_t len) {
+    if (term.out_len + len > term.out_cap) return;
+    memcpy(term.out + term.out_len, data, len);
+    term.out_len += len;
+}
+
+static void out_append_str(const char *text) {
+    out_append(text, strlen(text));
+}
+
+/* 追加光标定位序列（行列从1开始） */
+static void out_cursor(int row, int col) {
+    char seq[32];
+    int n = snprintf(seq, sizeof(seq), "\x1b[%d;%dH", row, col);
+    out_append(seq, (size_t)n);
+}
+
+/* 一次性写出整帧 */
+static void out_flush(void) {
+    const char *p = term.out;
+    size_t left = term.out_len;
+    while (left > 0) {
+        ssize_t n = write(term.fd, p, left);
+        if (n <= 0) break;
+        p += n;
+        left -= (size_t)n;
+    }
+    term.out_len = 0;
+}
+
+/* 查询终端尺寸并计算视口大小 */
+static void query_view_size(void) {
+    struct winsize ws;
+    int cols = TERM_DEFAULT_COLS;
+    int rows = TERM_DEFAULT_ROWS;
+
+    if (ioctl(term.fd, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+        cols = ws.ws_col;
+        rows = ws.ws_row;
+    }
+    term.view_cols = cols / 2;
+    term.view_rows = rows > 1 ? rows - 1 : 1;
+}
+
+/* 初始化终端渲染器：分配帧缓冲区，清屏并隐藏光标 */
+int term_render_init(int fd) {
+    term.fd = fd;
+    query_view_size();
+
+    size_t cells = (size_t)term.view_cols * term.view_rows;
+    term.prev = (unsigned char*)heap_alloc(cells);
+    term.out_cap = cells * TERM_BYTES_PER_CELL + TERM_STATUS_MAX + 64;
+    term.out = (char*)heap_alloc(term.out_cap);
+    if (!term.prev || !term.out) {
+        heap_free(term.prev);
+        heap_free(term.out);
+        term.prev = NULL;
+        term.out = NULL;
+        return -1;
+    }
+    term.out_len = 0;
+    term.initialized = 1;
+    term_render_invalidate();
+    return 0;
+}
+
+/* 使下一帧完整重绘 */
+void term_render_invalidate(void) {
+    if (!term.initialized) return;
+    memset(term.prev, TERM_UNKNOWN_CELL, (size_t)term.view_cols * term.view_rows);
+    term.status[0] = '\0';
+    out_append_str("\x1b[?25l\x1b[0m\x1b[2J");
+}
+
+/* 渲染一帧：只输出与上一帧不同的格子 */
+void term_render_frame(CellType **board, int width, int height,
+                       int focus_x, int focus_y, const char *status_text) {
+    if (!term.initialized || !board) return;
+
+    int view_w = width < term.view_cols ? width : term.view_cols;
+    int view_h = height < term.view_rows ? height : term.view_rows;
+
+    /* 视口跟随焦点（一般是玩家），并限制在棋盘范围内 */
+    int origin_x = focus_x - view_w / 2;
+    int origin_y = focus_y - view_h / 2;
+    if (origin_x > width - view_w) origin_x = width - view_w;
+    if (origin_y > height - view_h) origin_y = height - view_h;
+    if (origin_x < 0) origin_x = 0;
+    if (origin_y < 0) origin_y = 0;
+
+    int cursor_row = -1, cursor_col = -1;
+    int current_type = -1;
+
+    for (int sy = 0; sy < view_h; sy++) {
+        const CellType *row = board[origin_y + sy] + origin_x;
+        unsigned char *prev_row = term.prev + (size_t)sy * term.view_cols;
+
+        for (int sx = 0; sx < view_w; sx++) {
+            CellType type = row[sx];
+            if (prev_row[sx] == (unsigned char)type) continue;
+            prev_row[sx] = (unsigned char)type;
+
+            /* 相邻格子连续输出时省略光标定位 */
+            if (cursor_row != sy || cursor_col != sx) {
+                out_cursor(sy + 1, sx * 2 + 1);
+            }
+            const TileStyle *style = get_tile_style(type);
+            if (current_type != (int)type) {
+                out_append_str("\x1b[0;");
+                out_append_str(style->ansi);
+                out_append_str("m");
+                current_type = (int)type;
+            }
+            char pair[2] = {style->glyph, type == CELL_WALL ? style->glyph : ' '};
+            out_append(pair, 2);
+            cursor_row = sy;
+            cursor_col = sx + 1;
+        }
+    }
+
+    /* 状态栏只在内容变化时重绘 */
+    if (status_text && strcmp(status_text, term.status) != 0) {
+        snprintf(term.status, sizeof(term.status), "%s", status_text);
+        out_cursor(view_h + 1, 1);
+        out_append_str("\x1b[0m\x1b[2K");
+        out_append_str(term.status);
+        current_type = -1;
+    }
+
+    if (current_type != -1) {
+        out_append_str("\x1b[0m");
+    }
+    out_flush();
+}
+
+/* 恢复终端状态并释放缓冲区 */
+void term_render_shutdown(void) {
+    if (!term.initialized) return;
+
+    out_cursor(term.view_rows + 1, 1);
+    out_append_str("\x1b[0m\x1b[?25h\n");
+    out_flush();
+
+    heap_free(term.prev);
+    heap_free(term.out);
+    term.prev = NULL;
+    term.out = NULL;
+    term.initialized = 0;
+}
@@ -0,0 +1,138 @@
+#include "tiles.h"
+#include "types.h"
+
+/* 单元格外观表，按CellType顺序排列 */
+static const TileStyle tile_styles[TILE_TYPE_COUNT] = {
+    /* CELL_EMPTY */        {' ', "0",       "black"},
+    /* CELL_WALL */         {'#', "35;45",   "pink"},
+    /* CELL_DOT */          {'.', "37",      "white"},
+    /* CELL_PLAYER */       {'P', "1;33",    "yellow"},
+    /* CELL_GHOST_RED */    {'R', "1;31",    "red"},
+    /* CELL_GHOST_BLUE */   {'B', "1;36",    "cyan"},
+    /* CELL_GHOST_PURPLE */ {'V', "35",      "purple"},
+    /* CELL_GHOST_ORANGE */ {'O', "1;38;5;208", "orange"},
+    /* CELL_POWER_DOT */    {'o', "1;37",    "white"},
+    /* CELL_FRUIT */        {'F', "1;32",    "green"}
+};
+
+/* 获取单元格类型对应的外观，未知类型按空格处理 */
+const TileStyle *get_tile_style(CellType type) {
+    if ((int)type < 0 || (int)type >= TILE_TYPE_COUNT) {
+        return &tile_styles[CELL_EMPTY];
+    }
+    return &tile_styles[type];
+}
+
+/* 调色板：名称与X11颜色名一致，RGB取自X11 rgb.txt */
+static const struct {
+    const char *name;
+    unsigned char rgb[3];
+} tile_palette[TILE_COLOR_COUNT] = {
+    /* TILE_COLOR_BLACK */      {"black",     {0, 0, 0}},
+    /* TILE_COLOR_WHITE */      {"white",     {255, 255, 255}},
+    /* TILE_COLOR_BLUE */       {"blue",      {0, 0, 255}},
+    /* TILE_COLOR_YELLOW */     {"yellow",    {255, 255, 0}},
+    /* TILE_COLOR_RED */        {"red",       {255, 0, 0}},
+    /* TILE_COLOR_PINK */       {"pink",      {255, 192, 203}},
+    /* TILE_COLOR_CYAN */       {"cyan",      {0, 255, 255}},
+    /* TILE_COLOR_PURPLE */     {"purple",    {160, 32, 240}},
+    /* TILE_COLOR_ORANGE */     {"orange",    {255, 165, 0}},
+    /* TILE_COLOR_DARK_BLUE */  {"navy",      {0, 0, 128}},
+    /* TILE_COLOR_LIGHT_BLUE */ {"lightblue", {173, 216, 230}},
+    /* TILE_COLOR_GREEN */      {"green",     {0, 255, 0}}
+};
+
+/* 常用尺寸 */
+#define TILE_DOT_SIZE 3
+#define TILE_POWER_DOT_SIZE 6
+#define TILE_CENTER (CELL_SIZE / 2)
+#define TILE_BACKGROUND {1, TILE_COLOR_BLACK, 0, 0, CELL_SIZE, CELL_SIZE}
+
+/* 静态层图块，按CellType顺序排列；实体所在格按空通道绘制 */
+static const TileShape static_shapes[TILE_TYPE_COUNT] = {
+    /* CELL_EMPTY */  {1, {TILE_BACKGROUND}},
+    /* CELL_WALL：粉色墙壁加蓝色边框 */
+    {2, {{1, TILE_COLOR_PINK, 0, 0, CELL_SIZE, CELL_SIZE},
+         {0, TILE_COLOR_BLUE, 0, 0, CELL_SIZE, CELL_SIZE}}},
+    /* CELL_DOT：白色小圆点 */
+    {2, {TILE_BACKGROUND,
+         {1, TILE_COLOR_WHITE, TILE_CENTER - TILE_DOT_SIZE / 2, TILE_CENTER - TILE_DOT_SIZE / 2,
+          TILE_DOT_SIZE, TILE_DOT_SIZE}}},
+    /* CELL_PLAYER */       {1, {TILE_BACKGROUND}},
+    /* CELL_GHOST_RED */    {1, {TILE_BACKGROUND}},
+    /* CELL_GHOST_BLUE */   {1, {TILE_BACKGROUND}},
+    /* CELL_GHOST_PURPLE */ {1, {TILE_BACKGROUND}},
+    /* CELL_GHOST_ORANGE */ {1, {TILE_BACKGROUND}},
+    /* CELL_POWER_DOT：大能量豆 */
+    {2, {TILE_BACKGROUND,
+         {1, TILE_COLOR_WHITE, TILE_CENTER - TILE_POWER_DOT_SIZE / 2,
+          TILE_CENTER - TILE_POWER_DOT_SIZE / 2, TILE_POWER_DOT_SIZE, TILE_POWER_DOT_SIZE}}},
+    /* CELL_FRUIT：绿色水果 */
+    {2, {TILE_BACKGROUND,
+         {1, TILE_COLOR_GREEN, 4, 4, CELL_SIZE - 8, CELL_SIZE - 8}}}
+};
+
+/* 幽灵精灵：身体加一双眼睛 */
+#define GHOST_SHAPE(color) \
+    {5, {{1, (color), 2, 2, CELL_SIZE - 4, CELL_SIZE - 4}, \
+         {1, TILE_COLOR_WHITE, 6, 6, 4, 4}, \
+         {1, TILE_COLOR_WHITE, 14, 6, 4, 4}, \
+         {1, TILE_COLOR_BLACK, 7, 7, 2, 2}, \
+         {1, TILE_COLOR_BLACK, 15, 7, 2, 2}}}
+
+/* 实体精灵，按CellType顺序排列；非实体类型为空 */
+static const TileShape sprite_shapes[TILE_TYPE_COUNT] = {
+    /* CELL_EMPTY */  {0, {{0, 0, 0, 0, 0, 0}}},
+    /* CELL_WALL */   {0, {{0, 0, 0, 0, 0, 0}}},
+    /* CELL_DOT */    {0, {{0, 0, 0, 0, 0, 0}}},
+    /* CELL_PLAYER：黄色PacMan加黑色边框 */
+    {2, {{1, TILE_COLOR_YELLOW, 3, 3, CELL_SIZE - 6, CELL_SIZE - 6},
+         {0, TILE_COLOR_BLACK, 3, 3, CELL_SIZE - 6, CELL_SIZE - 6}}},
+    /* CELL_GHOST_RED */    GHOST_SHAPE(TILE_COLOR_RED),
+    /* CELL_GHOST_BLUE */   GHOST_SHAPE(TILE_COLOR_CYAN),
+    /* CELL_GHOST_PURPLE */ GHOST_SHAPE(TILE_COLOR_PURPLE),
+    /* CELL_GHOST_ORANGE */ GHOST_SHAPE(TILE_COLOR_ORANGE),
+    /* CELL_POWER_DOT */    {0, {{0, 0, 0, 0, 0, 0}}},
+    /* CELL_FRUIT */        {0, {{0, 0, 0, 0, 0, 0}}}
+};
+
+/* 受惊的幽灵：不分颜色，深蓝身体加粉色眼睛 */
+static const TileShape frightened_shape =
+    {3, {{1, TILE_COLOR_DARK_BLUE, 2, 2, CELL_SIZE - 4, CELL_SIZE - 4},
+         {1, TILE_COLOR_PINK, 7, 7, 2, 2},
+         {1, TILE_COLOR_PINK, 15, 7, 2, 2}}};
+
+/* 获取颜色名 */
+const char *get_tile_color_name(TileColor color) {
+    if ((int)color < 0 || color >= TILE_COLOR_COUNT) color = TILE_COLOR_BLACK;
+    return tile_palette[color].name;
+}
+
+/* 获取颜色的RGB值 */
+const unsigned char *get_tile_color_rgb(TileColor color) {
+    if ((int)color < 0 || color >= TILE_COLOR_COUNT) color = TILE_COLOR_BLACK;
+    return tile_palette[color].rgb;
+}
+
+/* 判断单元格是否为实体（玩家或幽灵） */
+int tile_is_entity(CellType type) {
+    return type == CELL_PLAYER ||
+           (type >= CELL_GHOST_RED && type <= CELL_GHOST_ORANGE);
+}
+
+/* 获取静态层图块 */
+const TileShape *get_tile_static_shape(CellType type) {
+    if ((int)type < 0 || (int)type >= TILE_TYPE_COUNT) type = CELL_EMPTY;
+    return &static_shapes[type];
+}
+
+/* 获取实体精灵图块 */
+const TileShape *get_tile_sprite_shape(CellType type) {
+    if ((int)type < 0 || (int)type >= TILE_TYPE_COUNT) type = CELL_EMPTY;
+    return &sprite_shapes[type];
+}
+
+/* 获取受惊幽灵的精灵图块 */
+const TileShape *get_tile_frightened_shape(void) {
+    return &frightened_shape;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <string.h>
+#include "map.h"
+
+/* 地图格式转换工具
+ * 用法: mapconv [--text|--binary] 输入 输出
+ * 不指定输出格式时转换为与输入相反的格式 */
+
+static void print_usage(const char *program_name) {
+    printf("使用方法: %s [--text|--binary] 输入 输出\n", program_name);
+    printf("  --text    输出文本格式\n");
+    printf("  --binary  输出二进制格式 (.pmap)\n");
+    printf("  不指定时转换为与输入相反的格式，输入格式按文件开头的标识识别\n");
+}
+
+int main(int argc, char *argv[]) {
+    int to_binary = -1;
+    const char *paths[2] = {NULL, NULL};
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--text") == 0) {
+            to_binary = 0;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            to_binary = 1;
+        } else if (argv[i][0] != '-' && path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path_count != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    GameMap map;
+    if (map_load(paths[0], &map) != 0) return 1;
+    if (to_binary < 0) to_binary = map.mapping == NULL;
+
+    int result = to_binary ? map_save_binary(&map, paths[1]) : map_save_text(&map, paths[1]);
+    if (result == 0) {
+        printf("%s -> %s: %d x %d, %d 个幽灵, %d 个豆子 (%s)\n", paths[0], paths[1],
+               map.width, map.height, map.ghost_count, map.dot_count,
+               to_binary ? "二进制" : "文本");
+    }
+    map_close(&map);
+    return result == 0 ? 0 : 1;
+}
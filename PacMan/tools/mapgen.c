@@ -0,0 +1,293 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "types.h"
+#include "level.h"
+#include "arena.h"
+#include "parallel.h"
+#include "pack.h"
+
+/* 批量棋盘生成和校验工具
+ * 用法: mapgen [选项] 输出.ppak    生成棋盘包
+ *       mapgen --verify 棋盘包     重新校验棋盘包里的每个棋盘
+ * 生成与游戏相同（level_generate），每个棋盘的种子只取决于基础种子和编号，
+ * 所以同样的参数在任意线程数下写出的文件完全相同 */
+
+/* 一个棋盘最多尝试的种子数，都不合格时放弃 */
+#define MAPGEN_MAX_ATTEMPTS 64
+/* 每批棋盘占用的内存上限，超出的部分分批生成和写入 */
+#define MAPGEN_BATCH_BYTES (64u << 20)
+
+/* 一批生成或校验任务，各线程处理不同编号的棋盘 */
+typedef struct {
+    int width, height;
+    int ghost_count;
+    unsigned int base_seed;
+    int first;                      /* 本批第一个棋盘的编号 */
+    unsigned char *cells;           /* 本批棋盘的格子，每个width * height字节 */
+    unsigned int *seeds;            /* 本批棋盘最终采用的种子 */
+    const BoardPack *pack;          /* 校验模式：要校验的棋盘包 */
+    unsigned long checks[LEVEL_CHECK_COUNT];    /* 各校验结果的次数 */
+    int failed;
+} MapgenBatch;
+
+static double mapgen_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 第index个棋盘第attempt次尝试的种子 */
+static unsigned int mapgen_seed(unsigned int base, int index, int attempt) {
+    unsigned int state = base + (unsigned int)index * 0x632BE5ABu +
+                         (unsigned int)attempt * 0x85157AF5u;
+    return level_rand(&state);
+}
+
+/* 每个任务块自带棋盘和生成缓冲区 */
+static int mapgen_carve(Arena *arena, CellType ***board, LevelScratch *scratch, int width,
+                        int height) {
+    if (arena_init(arena, level_board_bytes(width, height) +
+                          level_scratch_bytes(width, height)) != 0) {
+        return -1;
+    }
+    *board = level_board_carve(arena, width, height);
+    if (!*board || level_scratch_carve(arena, scratch, width, height) != 0) {
+        arena_destroy(arena);
+        return -1;
+    }
+    return 0;
+}
+
+/* 生成[begin, end)号棋盘：不合格时换下一个种子重试 */
+static void generate_range(int begin, int end, void *context) {
+    MapgenBatch *batch = (MapgenBatch*)context;
+    int width = batch->width, height = batch->height;
+    Arena arena;
+    CellType **board;
+    LevelScratch scratch;
+    if (mapgen_carve(&arena, &board, &scratch, width, height) != 0) {
+        __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int i = begin; i < end; i++) {
+        LevelCheck check = LEVEL_VALID;
+        unsigned int seed = 0;
+        for (int attempt = 0; attempt < MAPGEN_MAX_ATTEMPTS; attempt++) {
+            seed = mapgen_seed(batch->base_seed, batch->first + i, attempt);
+            level_generate(board, width, height, batch->ghost_count, seed, &scratch);
+            check = level_validate(board, width, height, batch->ghost_count, &scratch);
+            __atomic_fetch_add(&batch->checks[check], 1, __ATOMIC_RELAXED);
+            if (check == LEVEL_VALID) break;
+        }
+        if (check != LEVEL_VALID) {
+            __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+            break;
+        }
+
+        unsigned char *cells = batch->cells + (size_t)i * width * height;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) cells[(size_t)y * width + x] = (unsigned char)board[y][x];
+        }
+        batch->seeds[i] = seed;
+    }
+    arena_destroy(&arena);
+}
+
+/* 校验[begin, end)号棋盘 */
+static void verify_range(int begin, int end, void *context) {
+    MapgenBatch *batch = (MapgenBatch*)context;
+    const BoardPack *pack = batch->pack;
+    Arena arena;
+    CellType **board;
+    LevelScratch scratch;
+    if (mapgen_carve(&arena, &board, &scratch, pack->width, pack->height) != 0) {
+        __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int i = begin; i < end; i++) {
+        pack_fill_board(pack, i, board);
+        LevelCheck check = level_validate(board, pack->width, pack->height, pack->ghost_count,
+                                          &scratch);
+        __atomic_fetch_add(&batch->checks[check], 1, __ATOMIC_RELAXED);
+        if (check != LEVEL_VALID) {
+            fprintf(stderr, "第 %d 个棋盘 (种子 %u) 不合格: %s\n", i, pack->entries[i].seed,
+                    level_check_name(check));
+        }
+    }
+    arena_destroy(&arena);
+}
+
+/* 任务块大小：每个线程大约分到8块 */
+static int mapgen_chunk(int count) {
+    int chunk = count / (parallel_thread_count() * 8);
+    return chunk > 0 ? chunk : 1;
+}
+
+static void print_checks(const unsigned long *checks) {
+    for (int c = LEVEL_VALID + 1; c < LEVEL_CHECK_COUNT; c++) {
+        if (checks[c] > 0) printf("  %s: %lu\n", level_check_name((LevelCheck)c), checks[c]);
+    }
+}
+
+/* 生成count个棋盘写入棋盘包 */
+static int run_generate(const char *path, int count, int width, int height, int ghost_count,
+                        unsigned int seed) {
+    size_t board_bytes = (size_t)width * height;
+    int batch_size = (int)(MAPGEN_BATCH_BYTES / board_bytes);
+    if (batch_size < 1) batch_size = 1;
+    if (batch_size > count) batch_size = count;
+
+    MapgenBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.width = width;
+    batch.height = height;
+    batch.ghost_count = ghost_count;
+    batch.base_seed = seed;
+    batch.cells = (unsigned char*)heap_alloc((size_t)batch_size * board_bytes);
+    batch.seeds = (unsigned int*)heap_alloc((size_t)batch_size * sizeof(unsigned int));
+    PackWriter *writer = batch.cells && batch.seeds ?
+                         pack_writer_open(path, width, height, ghost_count, count) : NULL;
+    if (!writer) {
+        heap_free(batch.cells);
+        heap_free(batch.seeds);
+        return -1;
+    }
+
+    double generate_seconds = 0;
+    double start = mapgen_now();
+    for (int first = 0; first < count && !batch.failed; first += batch_size) {
+        int n = count - first < batch_size ? count - first : batch_size;
+        batch.first = first;
+        double batch_start = mapgen_now();
+        parallel_for(n, mapgen_chunk(n), generate_range, &batch);
+        generate_seconds += mapgen_now() - batch_start;
+        for (int i = 0; i < n && !batch.failed; i++) {
+            if (pack_writer_add(writer, batch.cells + (size_t)i * board_bytes, batch.seeds[i]) != 0) {
+                batch.failed = 1;
+            }
+        }
+    }
+    if (batch.failed) {
+        fprintf(stderr, "错误: 有棋盘连续 %d 个种子都不合格，或内存不足\n", MAPGEN_MAX_ATTEMPTS);
+    }
+    int result = pack_writer_close(writer);
+    double total_seconds = mapgen_now() - start;
+    heap_free(batch.cells);
+    heap_free(batch.seeds);
+    if (batch.failed || result != 0) return -1;
+
+    unsigned long rejected = 0;
+    for (int c = LEVEL_VALID + 1; c < LEVEL_CHECK_COUNT; c++) rejected += batch.checks[c];
+    printf("%s: %d 个棋盘, %d x %d, %d 个幽灵, 种子 %u, %d 个线程\n", path, count, width, height,
+           ghost_count, seed, parallel_thread_count());
+    printf("生成和校验: %.3f 秒, %.0f 个/秒; 含写入: %.3f 秒, %.0f 个/秒\n", generate_seconds,
+           count / generate_seconds, total_seconds, count / total_seconds);
+    printf("不合格后重试: %lu 次 (%.1f%%)\n", rejected,
+           100.0 * rejected / (rejected + batch.checks[LEVEL_VALID]));
+    print_checks(batch.checks);
+    return 0;
+}
+
+/* 重新校验棋盘包里的每个棋盘 */
+static int run_verify(const char *path) {
+    BoardPack pack;
+    double start = mapgen_now();
+    if (pack_open(path, &pack) != 0) return -1;
+    double open_seconds = mapgen_now() - start;
+
+    MapgenBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.pack = &pack;
+    start = mapgen_now();
+    parallel_for(pack.board_count, mapgen_chunk(pack.board_count), verify_range, &batch);
+    double verify_seconds = mapgen_now() - start;
+
+    printf("%s: %d 个棋盘, %d x %d, %d 个幽灵\n", path, pack.board_count, pack.width, pack.height,
+           pack.ghost_count);
+    printf("载入并核对校验和: %.3f 秒; 校验: %.3f 秒, %.0f 个/秒\n", open_seconds, verify_seconds,
+           pack.board_count / verify_seconds);
+    printf("合格 %lu 个, 不合格 %d 个\n", batch.checks[LEVEL_VALID],
+           pack.board_count - (int)batch.checks[LEVEL_VALID]);
+    print_checks(batch.checks);
+    int result = !batch.failed && (int)batch.checks[LEVEL_VALID] == pack.board_count ? 0 : -1;
+    pack_close(&pack);
+    return result;
+}
+
+static void print_usage(const char *program_name) {
+    printf("使用方法: %s [选项] 输出.ppak\n", program_name);
+    printf("          %s --verify 棋盘包\n", program_name);
+    printf("  -n, --count N     生成的棋盘数 (默认: 1000)\n");
+    printf("  -s, --size W H    棋盘大小 (默认: %d x %d)\n", DEFAULT_BOARD_WIDTH,
+           DEFAULT_BOARD_HEIGHT);
+    printf("  -g, --ghosts N    每个棋盘的幽灵数 (默认: %d)\n", DEFAULT_GHOST_COUNT);
+    printf("  --seed N          基础种子 (默认: 1)\n");
+    printf("  --threads N       线程数 (默认: CPU核数)\n");
+    printf("  --verify          重新校验已有的棋盘包：连通性、豆子数、幽灵数和出生点安全\n");
+}
+
+int main(int argc, char *argv[]) {
+    int count = 1000;
+    int width = DEFAULT_BOARD_WIDTH, height = DEFAULT_BOARD_HEIGHT;
+    int ghost_count = DEFAULT_GHOST_COUNT;
+    unsigned int seed = 1;
+    int threads = 0;
+    int verify = 0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--size") == 0) &&
+                   i + 2 < argc) {
+            width = atoi(argv[++i]);
+            height = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--count") == 0 ||
+                    strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--ghosts") == 0 ||
+                    strcmp(argv[i], "--seed") == 0 || strcmp(argv[i], "--threads") == 0) &&
+                   i + 1 < argc) {
+            const char *option = argv[i++];
+            if (strcmp(option, "-n") == 0 || strcmp(option, "--count") == 0) {
+                count = atoi(argv[i]);
+            } else if (strcmp(option, "-g") == 0 || strcmp(option, "--ghosts") == 0) {
+                ghost_count = atoi(argv[i]);
+            } else if (strcmp(option, "--seed") == 0) {
+                seed = (unsigned int)strtoul(argv[i], NULL, 10);
+            } else {
+                threads = atoi(argv[i]);
+            }
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!verify && (count < 1 || width < MIN_BOARD_WIDTH || height < MIN_BOARD_HEIGHT ||
+                    width > MAX_HEADLESS_BOARD_WIDTH || height > MAX_HEADLESS_BOARD_HEIGHT ||
+                    ghost_count < 0 || ghost_count > MAX_GHOST_COUNT)) {
+        fprintf(stderr, "错误: 棋盘数至少为1，大小在 %d x %d 到 %d x %d 之间，幽灵数在 0 到 %d 之间\n",
+                MIN_BOARD_WIDTH, MIN_BOARD_HEIGHT, MAX_HEADLESS_BOARD_WIDTH,
+                MAX_HEADLESS_BOARD_HEIGHT, MAX_GHOST_COUNT);
+        return 1;
+    }
+
+    parallel_init(threads);
+    int result = verify ? run_verify(path) :
+                 run_generate(path, count, width, height, ghost_count, seed);
+    parallel_shutdown();
+    return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "spectate.h"
+#include "term_render.h"
+#include "arena.h"
+
+/* 观战客户端：连接游戏的观战套接字（pacman --spectate PATH），用终端渲染器实时显示
+ * 用法: pacman_spectate [--stats] 套接字路径
+ * --stats 不渲染，每个关键帧输出一行，断开时输出收到的帧数和字节数 */
+
+typedef struct {
+    int width, height;
+    CellType *cells;
+    CellType **rows;
+    unsigned int stats[SPECTATE_STATS];
+    unsigned long keyframes, deltas, bytes;
+} SpectateView;
+
+static void print_usage(const char *program_name) {
+    printf("使用方法: %s [--stats] 套接字路径\n", program_name);
+    printf("  --stats   不渲染，只输出关键帧和收到的帧数统计\n");
+}
+
+/* 按关键帧的大小（重新）分配棋盘 */
+static int view_resize(SpectateView *view, int width, int height) {
+    if (view->cells && view->width == width && view->height == height) return 0;
+    heap_free(view->cells);
+    heap_free(view->rows);
+    view->cells = (CellType*)heap_alloc((size_t)width * height * sizeof(CellType));
+    view->rows = (CellType**)heap_alloc((size_t)height * sizeof(CellType*));
+    if (!view->cells || !view->rows) return -1;
+    for (int y = 0; y < height; y++) view->rows[y] = view->cells + (size_t)y * width;
+    view->width = width;
+    view->height = height;
+    return 0;
+}
+
+/* 解码一帧，格式错误返回-1 */
+static int view_apply(SpectateView *view, const unsigned char *frame, size_t size) {
+    size_t pos = 1, n;
+    unsigned int value;
+    if (size < 1 || (frame[0] != 'K' && frame[0] != 'D')) return -1;
+    for (int i = 0; i < SPECTATE_STATS; i++) {
+        if (!(n = spectate_read_varint(frame + pos, size - pos, &view->stats[i]))) return -1;
+        pos += n;
+    }
+
+    if (frame[0] == 'K') {
+        unsigned int width, height;
+        if (!(n = spectate_read_varint(frame + pos, size - pos, &width))) return -1;
+        pos += n;
+        if (!(n = spectate_read_varint(frame + pos, size - pos, &height))) return -1;
+        pos += n;
+        if (width == 0 || height == 0 || view_resize(view, (int)width, (int)height) != 0) {
+            return -1;
+        }
+        size_t cells = (size_t)width * height, filled = 0;
+        while (filled < cells) {
+            if (!(n = spectate_read_varint(frame + pos, size - pos, &value)) ||
+                pos + n >= size || value > cells - filled) {
+                return -1;
+            }
+            pos += n;
+            for (unsigned int k = 0; k < value; k++) view->cells[filled++] = (CellType)frame[pos];
+            pos++;
+        }
+        view->keyframes++;
+        return 0;
+    }
+
+    if (!view->cells || !(n = spectate_read_varint(frame + pos, size - pos, &value))) return -1;
+    pos += n;
+    long index = -1, cells = (long)view->width * view->height;
+    for (unsigned int k = 0; k < value; k++) {
+        unsigned int gap;
+        if (!(n = spectate_read_varint(frame + pos, size - pos, &gap)) || pos + n >= size) {
+            return -1;
+        }
+        pos += n;
+        index += (long)(gap >> 1) ^ -(long)(gap & 1);
+        if (index < 0 || index >= cells) return -1;
+        view->cells[index] = (CellType)frame[pos++];
+    }
+    view->deltas++;
+    return 0;
+}
+
+static void view_render(const SpectateView *view, int stats_only, const unsigned char *frame) {
+    const unsigned int *s = view->stats;
+    if (stats_only) {
+        if (frame[0] == 'K') {
+            printf("keyframe tick %u level %u score %u lives %u dots %u/%u\n",
+                   s[0], s[1], s[2], s[3], s[4], s[5]);
+        }
+        return;
+    }
+    char status[256];
+    int n = snprintf(status, sizeof(status),
+                     "Spectating | Tick %u | Level %u | Score %u | Lives %u | Dots %u/%u",
+                     s[0], s[1], s[2], s[3], s[4], s[5]);
+    if (s[8] > 0 && n > 0 && (size_t)n < sizeof(status)) {
+        snprintf(status + n, sizeof(status) - (size_t)n, " | Frightened %u", s[8]);
+    }
+    term_render_frame(view->rows, view->width, view->height, (int)s[6], (int)s[7], status);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int stats_only = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_only = 1;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "错误: 套接字路径过长: %s\n", path);
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "错误: 无法连接 %s\n", path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    if (!stats_only && term_render_init(STDOUT_FILENO) != 0) {
+        fprintf(stderr, "错误: 终端渲染器初始化失败\n");
+        close(fd);
+        return 1;
+    }
+
+    /* 接收缓冲区：帧比缓冲区大时扩大 */
+    size_t capacity = 1 << 16, length = 0;
+    unsigned char *buffer = (unsigned char*)heap_alloc(capacity);
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    int header_ok = 0, error = 0;
+
+    while (buffer && !error) {
+        if (length == capacity) {
+            unsigned char *larger = (unsigned char*)heap_alloc(capacity * 2);
+            if (!larger) break;
+            memcpy(larger, buffer, length);
+            heap_free(buffer);
+            buffer = larger;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, buffer + length, capacity - length);
+        if (n <= 0) break;
+        length += (size_t)n;
+        view.bytes += (unsigned long)n;
+
+        size_t pos = 0;
+        if (!header_ok) {
+            if (length < 5) continue;
+            if (memcmp(buffer, SPECTATE_MAGIC, 4) != 0 || buffer[4] != SPECTATE_VERSION) {
+                fprintf(stderr, "错误: 不是观战流或版本不符\n");
+                error = 1;
+                break;
+            }
+            header_ok = 1;
+            pos = 5;
+        }
+        for (;;) {
+            unsigned int frame_size;
+            size_t used = spectate_read_varint(buffer + pos, length - pos, &frame_size);
+            if (!used || length - pos - used < frame_size) break;
+            const unsigned char *frame = buffer + pos + used;
+            if (view_apply(&view, frame, frame_size) != 0) {
+                fprintf(stderr, "错误: 帧格式错误\n");
+                error = 1;
+                break;
+            }
+            view_render(&view, stats_only, frame);
+            pos += used + frame_size;
+        }
+        memmove(buffer, buffer + pos, length - pos);
+        length -= pos;
+    }
+
+    if (!stats_only) term_render_shutdown();
+    printf("观战结束: 关键帧 %lu, 增量帧 %lu, 共 %lu 字节\n", view.keyframes, view.deltas,
+           view.bytes);
+    heap_free(buffer);
+    heap_free(view.cells);
+    heap_free(view.rows);
+    close(fd);
+    return error;
+}
@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "liveshm.h"
+#include "term_render.h"
+#include "arena.h"
+
+/* 共享内存观察程序：映射游戏导出的状态段（pacman --shm NAME），按固定间隔取快照并用终端渲染器显示
+ * 用法: pacman_watch [--stats] [--interval MS] 共享内存名
+ * --stats 不渲染，每个新tick输出一行并核对棋盘校验和，写者退出后输出快照统计 */
+
+static void print_usage(const char *program_name) {
+    printf("使用方法: %s [--stats] [--interval MS] 共享内存名\n", program_name);
+    printf("  --stats         不渲染，输出每个新tick的计数器并核对棋盘校验和\n");
+    printf("  --interval MS   取快照的间隔毫秒数 (默认: 20)\n");
+}
+
+static uint32_t board_sum(const unsigned char *cells, size_t count) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++) sum += (uint32_t)cells[i] * (uint32_t)(i + 1);
+    return sum;
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = NULL;
+    int stats_only = 0, interval_ms = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_only = 1;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval_ms = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !name) {
+            name = argv[i];
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!name || interval_ms < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    LiveShmReader *reader = live_shm_open(name);
+    if (!reader) return 1;
+    int width = live_shm_width(reader), height = live_shm_height(reader);
+    size_t count = (size_t)width * height;
+    CellType *cells = (CellType*)heap_alloc(count * sizeof(CellType));
+    CellType **rows = (CellType**)heap_alloc((size_t)height * sizeof(CellType*));
+    unsigned char *raw = (unsigned char*)heap_alloc(count);
+    if (!cells || !rows || !raw) {
+        fprintf(stderr, "错误: 内存不足\n");
+        live_shm_close(reader);
+        return 1;
+    }
+    for (int y = 0; y < height; y++) rows[y] = cells + (size_t)y * width;
+    if (!stats_only && term_render_init(STDOUT_FILENO) != 0) {
+        fprintf(stderr, "错误: 终端渲染器初始化失败\n");
+        live_shm_close(reader);
+        return 1;
+    }
+
+    LiveShmStats stats;
+    uint32_t last_tick = 0;
+    unsigned long snapshots = 0, failed = 0, mismatched = 0;
+    struct timespec interval = { interval_ms / 1000, (long)(interval_ms % 1000) * 1000000L };
+    pid_t writer = (pid_t)live_shm_writer_pid(reader);
+
+    for (;;) {
+        if (live_shm_snapshot(reader, &stats, raw, count) != 0) {
+            failed++;
+        } else if (stats.tick != last_tick) {
+            last_tick = stats.tick;
+            snapshots++;
+            if (stats_only) {
+                int ok = board_sum(raw, count) == stats.board_sum;
+                if (!ok) mismatched++;
+                printf("tick %u level %d score %d lives %d dots %d/%d player (%d,%d)%s\n",
+                       stats.tick, stats.level, stats.score, stats.lives, stats.dots_collected,
+                       stats.total_dots, stats.player_x, stats.player_y,
+                       ok ? "" : " 校验和不符");
+            } else {
+                char status[256];
+                for (size_t i = 0; i < count; i++) cells[i] = (CellType)raw[i];
+                int n = snprintf(status, sizeof(status),
+                                 "Watching | Tick %u | Level %d | Score %d | Lives %d | Dots %d/%d",
+                                 stats.tick, stats.level, stats.score, stats.lives,
+                                 stats.dots_collected, stats.total_dots);
+                if (stats.frightened_ticks > 0 && n > 0 && (size_t)n < sizeof(status)) {
+                    snprintf(status + n, sizeof(status) - (size_t)n, " | Frightened %d",
+                             stats.frightened_ticks);
+                }
+                term_render_frame(rows, width, height, stats.player_x, stats.player_y, status);
+            }
+        }
+        /* 写者进程退出后结束 */
+        if (kill(writer, 0) != 0) break;
+        nanosleep(&interval, NULL);
+    }
+
+    if (!stats_only) term_render_shutdown();
+    printf("观察结束: 快照 %lu 个, 取快照失败 %lu 次, 校验和不符 %lu 个\n", snapshots, failed,
+           mismatched);
+    heap_free(cells);
+    heap_free(rows);
+    heap_free(raw);
+    live_shm_close(reader);
+    return mismatched > 0;
+}